@@ -2,7 +2,9 @@
  * RKMPP MJPEG Encoder/Decoder Library
  * 
  * A C library wrapper for Rockchip MPP hardware MJPEG encoding and decoding
- * Supports NV12 input format for encoding and NV12 output for decoding
+ * Supports NV12, NV16, YUYV, grayscale and packed RGB input for encoding and
+ * NV12, NV16, grayscale, packed RGB or planar float RGB output for decoding,
+ * and scaled MJPEG-to-MJPEG transcoding
  * 
  * Author: RKMPP MJPEG Library
  * License: MIT
@@ -17,6 +19,7 @@ extern "C" {
 
 #include <stdint.h>
 #include <stddef.h>
+#include <sys/uio.h>
 
 /* ============================================================================
  * Type Definitions and Constants
@@ -35,6 +38,19 @@ typedef enum {
     RKMPP_ERR_UNKNOWN = -99            /* Unknown error */
 } RkmppStatus;
 
+/* Raw frame pixel formats */
+typedef enum {
+    RKMPP_FORMAT_NV12 = 0,             /* 4:2:0, Y plane + interleaved CbCr plane */
+    RKMPP_FORMAT_NV16 = 1,             /* 4:2:2, Y plane + interleaved CbCr plane */
+    RKMPP_FORMAT_YUYV = 2,             /* 4:2:2 packed, Y0 Cb Y1 Cr */
+    RKMPP_FORMAT_GRAY = 3,             /* Y plane only (also the start of NV12/NV16) */
+    RKMPP_FORMAT_RGB888 = 4,           /* Packed R G B */
+    RKMPP_FORMAT_BGR888 = 5,           /* Packed B G R */
+    RKMPP_FORMAT_RGBA8888 = 6,         /* Packed R G B A (A ignored on input) */
+    RKMPP_FORMAT_BGRA8888 = 7,         /* Packed B G R A (A ignored on input, BGRX) */
+    RKMPP_FORMAT_RGB_F32_PLANAR = 8    /* Float R, G, B planes in [0, 1] (decode only) */
+} RkmppFormat;
+
 /* Encoder/Decoder handle (opaque pointer) */
 typedef struct RkmppEncoder RkmppEncoder;
 typedef struct RkmppDecoder RkmppDecoder;
@@ -43,6 +59,30 @@ typedef struct RkmppDecoder RkmppDecoder;
  * MJPEG Encoder Interface
  * ============================================================================ */
 
+/* Codec backend */
+typedef enum {
+    RKMPP_BACKEND_MPP = 0,             /* Rockchip MPP hardware codec */
+    RKMPP_BACKEND_CPU = 1              /* Software baseline JPEG codec */
+} RkmppBackend;
+
+/* Encoder rate control mode */
+typedef enum {
+    RKMPP_RC_MODE_VBR = 0,             /* Hold the window average, quality capped */
+    RKMPP_RC_MODE_CBR = 1,             /* Hold every frame near the per-frame budget */
+    RKMPP_RC_MODE_FIXQP = 2            /* Fixed quality, bitrate ignored */
+} RkmppRcMode;
+
+/* Geometric transforms (encoder input orientation, lossless transcoding) */
+typedef enum {
+    RKMPP_TRANSFORM_NONE = 0,          /* Keep the orientation */
+    RKMPP_TRANSFORM_HFLIP = 1,         /* Mirror left-right */
+    RKMPP_TRANSFORM_VFLIP = 2,         /* Mirror top-bottom */
+    RKMPP_TRANSFORM_TRANSPOSE = 3,     /* Mirror across the top-left to bottom-right diagonal */
+    RKMPP_TRANSFORM_ROT90 = 4,         /* Rotate 90 degrees clockwise */
+    RKMPP_TRANSFORM_ROT180 = 5,        /* Rotate 180 degrees */
+    RKMPP_TRANSFORM_ROT270 = 6         /* Rotate 270 degrees clockwise */
+} RkmppTransform;
+
 /**
  * Encoder configuration structure
  */
@@ -50,9 +90,22 @@ typedef struct {
     uint32_t width;                    /* Image width in pixels */
     uint32_t height;                   /* Image height in pixels */
     uint32_t fps;                      /* Frames per second */
-    uint32_t bitrate;                  /* Target bitrate in bps (0 for auto) */
-    uint32_t quality;                  /* JPEG quality (0-100, default 80) */
-    uint32_t gop;                      /* GOP size (for future use) */
+    uint32_t bitrate;                  /* Target bitrate in bps (0 = fixed quality) */
+    uint32_t quality;                  /* JPEG quality (0-100, default 80); ceiling under rate control */
+    uint32_t gop;                      /* Rate control window in frames (0 = fps) */
+    uint32_t rc_mode;                  /* Rate control mode (RkmppRcMode) */
+    uint32_t backend;                  /* Codec backend (RkmppBackend) */
+    uint32_t huffman_refresh;          /* CPU backend: rebuild optimal Huffman tables
+                                          every N frames (0 = standard tables) */
+    uint32_t input_format;             /* Input pixel format (RkmppFormat, default NV12);
+                                          4:2:2 input is encoded as 4:2:2 JPEG,
+                                          GRAY as single-component JPEG, RGB as 4:2:0 */
+    uint32_t transform;                /* CPU backend: orientation applied to the input
+                                          (RkmppTransform, default NONE); width and
+                                          height stay those of the input */
+    uint32_t static_threshold;         /* Repeat the last JPEG instead of encoding a frame
+                                          whose 4x4 luma averages all moved by less than
+                                          this many levels (0 = off, 1-255) */
 } RkmppEncoderConfig;
 
 /**
@@ -66,17 +119,45 @@ RkmppEncoder* rkmpp_encoder_create(const RkmppEncoderConfig* config);
 /**
  * Destroy encoder and release resources
  * 
+ * With the context cache enabled (rkmpp_set_context_cache_size()), the
+ * encoder may be parked for reuse instead, keeping its memory until a
+ * later create takes it or the cache is shrunk.
+ * 
  * @param encoder Encoder handle
  * @return RKMPP_OK on success, error code on failure
  */
 RkmppStatus rkmpp_encoder_destroy(RkmppEncoder* encoder);
 
 /**
- * Encode NV12 frame to MJPEG
+ * Change the frame size and quality of an encoder in place
+ * 
+ * Format, backend, transform and the other settings stay. The MPP context
+ * and buffer groups are kept, and the CPU backend reallocates its buffers
+ * only when the new frame is larger than any before. Statistics carry on;
+ * the first frame at the new size is always encoded in full.
+ * 
+ * @param encoder Encoder handle
+ * @param width New frame width (16-4096)
+ * @param height New frame height (16-4096)
+ * @param quality New quality (1-100, 0 = keep the current one)
+ * @return RKMPP_OK on success, RKMPP_ERR_MEMORY if buffers could not grow
+ *         (the encoder keeps its previous settings)
+ */
+RkmppStatus rkmpp_encoder_reconfigure(
+    RkmppEncoder* encoder,
+    uint32_t width,
+    uint32_t height,
+    uint32_t quality
+);
+
+/**
+ * Encode a raw frame to MJPEG
+ * 
+ * Frames are read in the configured input_format.
  * 
  * @param encoder Encoder handle
- * @param nv12_data NV12 frame data (Y plane followed by UV plane)
- * @param nv12_size Total size of NV12 data in bytes
+ * @param nv12_data Frame data (for NV12: Y plane followed by UV plane)
+ * @param nv12_size Total size of frame data in bytes
  * @param jpeg_data Output buffer for JPEG data
  * @param jpeg_size Maximum size of output buffer
  * @param jpeg_len Output parameter: actual size of encoded JPEG
@@ -91,6 +172,90 @@ RkmppStatus rkmpp_encoder_encode(
     uint32_t* jpeg_len
 );
 
+/**
+ * Per-frame encode parameters
+ */
+typedef struct {
+    uint32_t max_size;                 /* JPEG byte budget (0 = no limit) */
+    const uint8_t* dirty_map;          /* Changed MCUs since the previous frame, one
+                                          byte per MCU of the output grid, row-major,
+                                          non-zero = changed (NULL = whole frame) */
+} RkmppEncodeParams;
+
+/**
+ * Per-frame encode result
+ */
+typedef struct {
+    uint32_t quality;                  /* Quality the frame was encoded with */
+    uint32_t passes;                   /* Quantization passes used (0 for a duplicate) */
+    uint32_t duplicate;                /* 1 if the frame was static and the output is
+                                          the previous JPEG again */
+} RkmppEncodeResult;
+
+/**
+ * Encode a raw frame to MJPEG with per-frame parameters
+ *
+ * With params->max_size set, the frame is encoded at the highest quality
+ * (up to the current one) whose JPEG fits the budget. The first guess comes
+ * from a size model of previous frames; on the CPU backend each retry only
+ * re-quantizes the cached DCT coefficients, and at most three passes run.
+ *
+ * With params->dirty_map set, the CPU backend transforms and quantizes
+ * only the flagged MCUs and keeps the previous frame's levels for the
+ * rest; the whole frame is still entropy coded. The map covers the grid
+ * rkmpp_encoder_get_mcu_grid() reports and must flag every MCU that
+ * differs from the frame passed before, or stale blocks are repeated.
+ * The first frame, and any frame after a quality change, is encoded in
+ * full regardless. The MPP backend ignores the map.
+ *
+ * With static_threshold configured, a frame that has not changed since
+ * the last encoded one is not encoded: the previous JPEG is copied to the
+ * output and result->duplicate is set, so callers can also skip storing it.
+ * The map of the frame after a duplicate still only needs to cover changes
+ * since the duplicate: that frame is transformed in full.
+ *
+ * @param encoder Encoder handle
+ * @param nv12_data Frame data in the configured input_format
+ * @param nv12_size Total size of frame data in bytes
+ * @param jpeg_data Output buffer for JPEG data
+ * @param jpeg_size Maximum size of output buffer
+ * @param jpeg_len Output parameter: actual size of encoded JPEG
+ * @param params Per-frame parameters (NULL for defaults)
+ * @param result Output: per-frame result (may be NULL)
+ * @return RKMPP_OK on success, RKMPP_ERR_ENCODE if nothing fits the budget
+ */
+RkmppStatus rkmpp_encoder_encode_ex(
+    RkmppEncoder* encoder,
+    const uint8_t* nv12_data,
+    uint32_t nv12_size,
+    uint8_t* jpeg_data,
+    uint32_t jpeg_size,
+    uint32_t* jpeg_len,
+    const RkmppEncodeParams* params,
+    RkmppEncodeResult* result
+);
+
+/**
+ * Get the MCU grid a dirty map covers
+ *
+ * The grid is that of the JPEG, so with an input transform it follows
+ * the output orientation rather than the input frame.
+ *
+ * @param encoder Encoder handle (CPU backend)
+ * @param mcu_width Output: MCU width in pixels (may be NULL)
+ * @param mcu_height Output: MCU height in pixels (may be NULL)
+ * @param mcus_x Output: MCUs per row
+ * @param mcus_y Output: MCU rows
+ * @return RKMPP_OK on success, RKMPP_ERR_INIT for the MPP backend
+ */
+RkmppStatus rkmpp_encoder_get_mcu_grid(
+    RkmppEncoder* encoder,
+    uint32_t* mcu_width,
+    uint32_t* mcu_height,
+    uint32_t* mcus_x,
+    uint32_t* mcus_y
+);
+
 /**
  * Get encoder statistics
  * 
@@ -105,6 +270,39 @@ RkmppStatus rkmpp_encoder_get_stats(
     uint64_t* bytes_encoded
 );
 
+/**
+ * Set the JPEG quality for subsequent frames
+ *
+ * Without rate control this is the quality of every frame; with a bitrate
+ * set it is the ceiling the rate controller works under.
+ *
+ * @param encoder Encoder handle
+ * @param quality JPEG quality (1-100)
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_encoder_set_quality(RkmppEncoder* encoder, uint32_t quality);
+
+/**
+ * Set the target bitrate for subsequent frames
+ *
+ * The rate controller restarts its window from the next frame. A bitrate
+ * of 0 switches back to fixed quality.
+ *
+ * @param encoder Encoder handle
+ * @param bitrate Target bitrate in bps
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_encoder_set_bitrate(RkmppEncoder* encoder, uint32_t bitrate);
+
+/**
+ * Get the quality the next frame will be encoded with
+ *
+ * @param encoder Encoder handle
+ * @param quality Output: JPEG quality (1-100)
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_encoder_get_quality(RkmppEncoder* encoder, uint32_t* quality);
+
 /* ============================================================================
  * MJPEG Decoder Interface
  * ============================================================================ */
@@ -113,9 +311,11 @@ RkmppStatus rkmpp_encoder_get_stats(
  * Decoder configuration structure
  */
 typedef struct {
-    uint32_t max_width;                /* Maximum image width */
-    uint32_t max_height;               /* Maximum image height */
-    uint32_t output_format;            /* Output format (currently only NV12) */
+    uint32_t max_width;                /* Expected maximum image width: sizes the
+                                          frame pool, which grows for larger frames */
+    uint32_t max_height;               /* Expected maximum image height */
+    uint32_t output_format;            /* Output format (RkmppFormat, not YUYV) */
+    uint32_t backend;                  /* Codec backend (RkmppBackend) */
 } RkmppDecoderConfig;
 
 /**
@@ -124,8 +324,10 @@ typedef struct {
 typedef struct {
     uint32_t width;                    /* Actual frame width */
     uint32_t height;                   /* Actual frame height */
-    uint32_t format;                   /* Frame format (NV12) */
+    uint32_t format;                   /* Frame format (RkmppFormat) */
     uint64_t timestamp;                /* Frame timestamp */
+    uint32_t info_change;              /* 1 if the size differs from the previous
+                                          decoded frame (and on the first frame) */
 } RkmppFrameInfo;
 
 /**
@@ -139,18 +341,33 @@ RkmppDecoder* rkmpp_decoder_create(const RkmppDecoderConfig* config);
 /**
  * Destroy decoder and release resources
  * 
+ * With the context cache enabled (rkmpp_set_context_cache_size()), the
+ * decoder may be parked for reuse instead, keeping its memory until a
+ * later create takes it or the cache is shrunk.
+ * 
  * @param decoder Decoder handle
  * @return RKMPP_OK on success, error code on failure
  */
 RkmppStatus rkmpp_decoder_destroy(RkmppDecoder* decoder);
 
 /**
- * Decode MJPEG to NV12 frame
+ * Decode MJPEG to a raw frame
+ * 
+ * Frames are written in the configured output_format. On the CPU backend
+ * chroma is resampled to it while each MCU row is written out, so 4:2:2
+ * JPEG decodes to NV12 (or 4:2:0 JPEG to NV16) without a separate pass.
+ * 
+ * The stream may change resolution at any frame, up to 4096x4096.
+ * frame_info->info_change flags the first frame of a new size, and the
+ * frame pool is reallocated only when a frame exceeds every earlier one.
+ * If nv12_size is too small for a new size, RKMPP_ERR_INVALID_PARAM is
+ * returned with the new width, height and info_change already in
+ * frame_info, so the caller can grow its buffer and decode again.
  * 
  * @param decoder Decoder handle
  * @param jpeg_data JPEG data buffer
  * @param jpeg_size Size of JPEG data
- * @param nv12_data Output buffer for NV12 data
+ * @param nv12_data Output buffer for the decoded frame
  * @param nv12_size Maximum size of output buffer
  * @param nv12_len Output parameter: actual size of decoded NV12
  * @param frame_info Output parameter: decoded frame information
@@ -180,6 +397,699 @@ RkmppStatus rkmpp_decoder_get_stats(
     uint64_t* bytes_decoded
 );
 
+/* ============================================================================
+ * MJPEG Transcoder
+ * ============================================================================ */
+
+/* Transcoder handle (opaque pointer) */
+typedef struct RkmppTranscoder RkmppTranscoder;
+
+/**
+ * Transcoder configuration structure
+ */
+typedef struct {
+    uint32_t max_width;                /* Maximum source width */
+    uint32_t max_height;               /* Maximum source height */
+    RkmppEncoderConfig output;         /* Output stream: size, fps, quality, rate control
+                                          and orientation (input_format and backend
+                                          ignored); 0x0 for DCT-domain operations only */
+} RkmppTranscoderConfig;
+
+/**
+ * Per-frame transcode result
+ */
+typedef struct {
+    uint32_t src_width;                /* Source frame width */
+    uint32_t src_height;               /* Source frame height */
+    uint32_t width;                    /* Output frame width */
+    uint32_t height;                   /* Output frame height */
+    uint32_t quality;                  /* Quality the output was encoded with
+                                          (0 when the source's tables were kept) */
+    uint64_t decode_us;                /* Decode and scale time */
+    uint64_t encode_us;                /* Encode time */
+    uint64_t latency_us;               /* End-to-end time */
+} RkmppTranscodeResult;
+
+/**
+ * Transcoder statistics
+ */
+typedef struct {
+    uint64_t frames_transcoded;        /* Frames transcoded successfully */
+    uint64_t bytes_in;                 /* Source JPEG bytes */
+    uint64_t bytes_out;                /* Output JPEG bytes */
+    uint64_t latency_min_us;           /* Minimum end-to-end latency */
+    uint64_t latency_max_us;           /* Maximum end-to-end latency */
+    uint64_t latency_avg_us;           /* Mean end-to-end latency */
+} RkmppTranscoderStats;
+
+/**
+ * Create an MJPEG transcoder (decode, scale, re-encode)
+ *
+ * Both codecs run on the CPU backend. The source is decoded one MCU row at
+ * a time and each row is area-averaged straight into an output-sized NV12
+ * frame, so the full-size decoded frame is never stored.
+ *
+ * An output size of 0x0 creates a transcoder that only requantizes and
+ * transforms; its output.huffman_refresh still selects the Huffman tables
+ * it codes with.
+ *
+ * @param config Transcoder configuration
+ * @return Transcoder handle on success, NULL on failure
+ */
+RkmppTranscoder* rkmpp_transcoder_create(const RkmppTranscoderConfig* config);
+
+/**
+ * Destroy transcoder and release resources
+ *
+ * @param transcoder Transcoder handle
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_transcoder_destroy(RkmppTranscoder* transcoder);
+
+/**
+ * Transcode one MJPEG frame to the configured output size
+ *
+ * @param transcoder Transcoder handle
+ * @param jpeg_in Source JPEG data
+ * @param in_size Size of source JPEG data
+ * @param jpeg_out Output buffer for the scaled JPEG
+ * @param out_size Maximum size of output buffer
+ * @param out_len Output parameter: actual size of the scaled JPEG
+ * @param result Output: per-frame result and timing (may be NULL)
+ * @return RKMPP_OK on success, RKMPP_ERR_DECODE for unsupported or corrupt
+ *         sources, RKMPP_ERR_ENCODE if the output buffer is too small,
+ *         RKMPP_ERR_INVALID_PARAM for a transcoder without output size
+ */
+RkmppStatus rkmpp_transcoder_transcode(
+    RkmppTranscoder* transcoder,
+    const uint8_t* jpeg_in,
+    uint32_t in_size,
+    uint8_t* jpeg_out,
+    uint32_t out_size,
+    uint32_t* out_len,
+    RkmppTranscodeResult* result
+);
+
+/**
+ * Re-encode one MJPEG frame at a lower quality without decoding pixels
+ *
+ * Coefficients are entropy-decoded, requantized with the tables of the
+ * requested quality and entropy-coded again; no IDCT, FDCT or color
+ * conversion runs, and resolution and sampling are kept. Asking for a
+ * higher quality than the source was coded with grows the stream without
+ * adding detail. Sources must be grayscale or Y/Cb/Cr in one interleaved
+ * scan at 4:2:0, 4:2:2 or 4:4:4.
+ *
+ * @param transcoder Transcoder handle
+ * @param jpeg_in Source JPEG data
+ * @param in_size Size of source JPEG data
+ * @param quality Output quality (1-100)
+ * @param jpeg_out Output buffer for the requantized JPEG
+ * @param out_size Maximum size of output buffer
+ * @param out_len Output parameter: actual size of the requantized JPEG
+ * @param result Output: per-frame result and timing (may be NULL)
+ * @return RKMPP_OK on success, RKMPP_ERR_DECODE for unsupported or corrupt
+ *         sources, RKMPP_ERR_ENCODE if the output buffer is too small
+ */
+RkmppStatus rkmpp_transcoder_requantize(
+    RkmppTranscoder* transcoder,
+    const uint8_t* jpeg_in,
+    uint32_t in_size,
+    uint32_t quality,
+    uint8_t* jpeg_out,
+    uint32_t out_size,
+    uint32_t* out_len,
+    RkmppTranscodeResult* result
+);
+
+/**
+ * Rotate or flip one MJPEG frame without generation loss
+ *
+ * Blocks are moved and their coefficients transposed or negated in the
+ * DCT domain, then entropy-coded again with the source's quantization
+ * tables, so the pixels are exactly those of the source, rearranged. An
+ * edge that ends up on the left or top is trimmed to whole MCUs (16 pixels
+ * at 4:2:0) because its padding cannot move with it; result reports the
+ * output size. Sources are accepted as by rkmpp_transcoder_requantize(),
+ * except that 4:2:2 cannot be transposed or rotated by 90 or 270 degrees.
+ *
+ * @param transcoder Transcoder handle
+ * @param jpeg_in Source JPEG data
+ * @param in_size Size of source JPEG data
+ * @param transform Transform to apply (RkmppTransform)
+ * @param jpeg_out Output buffer for the transformed JPEG
+ * @param out_size Maximum size of output buffer
+ * @param out_len Output parameter: actual size of the transformed JPEG
+ * @param result Output: per-frame result and timing (may be NULL)
+ * @return RKMPP_OK on success, RKMPP_ERR_DECODE for unsupported or corrupt
+ *         sources, RKMPP_ERR_ENCODE if the output buffer is too small
+ */
+RkmppStatus rkmpp_transcoder_transform(
+    RkmppTranscoder* transcoder,
+    const uint8_t* jpeg_in,
+    uint32_t in_size,
+    uint32_t transform,
+    uint8_t* jpeg_out,
+    uint32_t out_size,
+    uint32_t* out_len,
+    RkmppTranscodeResult* result
+);
+
+/**
+ * Get transcoder statistics
+ *
+ * @param transcoder Transcoder handle
+ * @param stats Output: transcoder statistics
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_transcoder_get_stats(
+    RkmppTranscoder* transcoder,
+    RkmppTranscoderStats* stats
+);
+
+/* ============================================================================
+ * MJPEG Simulcast Encoder
+ * ============================================================================ */
+
+/* Resolution layers: full, 1/2, 1/4 and 1/8 */
+#define RKMPP_SIMULCAST_MAX_LAYERS 4
+
+/* Simulcast encoder handle (opaque pointer) */
+typedef struct RkmppSimulcast RkmppSimulcast;
+
+/**
+ * Simulcast encoder configuration structure
+ */
+typedef struct {
+    uint32_t width;                    /* Input (full-resolution) width */
+    uint32_t height;                   /* Input (full-resolution) height */
+    uint32_t num_layers;               /* Layers to encode (1-4); layer i is 1/2^i size */
+    uint32_t quality[RKMPP_SIMULCAST_MAX_LAYERS];  /* Per-layer quality (0 = 80) */
+    uint32_t huffman_refresh;          /* Optimal Huffman tables every N frames (0 = off) */
+} RkmppSimulcastConfig;
+
+/**
+ * One layer's output buffer
+ */
+typedef struct {
+    uint8_t* data;                     /* Output buffer for the JPEG */
+    uint32_t size;                     /* Size of output buffer */
+    uint32_t len;                      /* Output: size of the JPEG */
+    uint32_t width;                    /* Output: layer width */
+    uint32_t height;                   /* Output: layer height */
+} RkmppSimulcastOutput;
+
+/**
+ * Create a simulcast encoder (CPU backend, NV12 input, 4:2:0 output)
+ *
+ * Every layer halves the previous one, so width and height must be
+ * multiples of 2^num_layers and the smallest layer at least 16x16.
+ *
+ * @param config Simulcast configuration
+ * @return Simulcast handle on success, NULL on failure
+ */
+RkmppSimulcast* rkmpp_simulcast_create(const RkmppSimulcastConfig* config);
+
+/**
+ * Destroy simulcast encoder and release resources
+ *
+ * @param simulcast Simulcast handle
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_simulcast_destroy(RkmppSimulcast* simulcast);
+
+/**
+ * Encode one NV12 frame at every layer's resolution
+ *
+ * The input is read once, one MCU row at a time: the row is encoded at
+ * full resolution and averaged 2x2 into the next layer's row buffer while
+ * it is in cache, and each smaller layer is encoded and halved again as
+ * its rows complete. No downscaled frame is ever stored.
+ *
+ * @param simulcast Simulcast handle
+ * @param nv12_data NV12 frame at the configured size
+ * @param nv12_size Size of the frame data
+ * @param outputs One output per layer, largest first
+ * @return RKMPP_OK on success, RKMPP_ERR_ENCODE if a layer's output did not
+ *         fit (its len then estimates the size needed)
+ */
+RkmppStatus rkmpp_simulcast_encode(
+    RkmppSimulcast* simulcast,
+    const uint8_t* nv12_data,
+    uint32_t nv12_size,
+    RkmppSimulcastOutput* outputs
+);
+
+/* ============================================================================
+ * MJPEG Tiled Encoder
+ * ============================================================================ */
+
+/* Tiled encoder handle (opaque pointer) */
+typedef struct RkmppTiledEncoder RkmppTiledEncoder;
+
+/**
+ * Tiled encoder configuration structure
+ */
+typedef struct {
+    uint32_t width;                    /* Frame width (16-16384) */
+    uint32_t height;                   /* Frame height (16-16384) */
+    uint32_t input_format;             /* RkmppFormat of the input frame */
+    uint32_t quality;                  /* JPEG quality (1-100, 0 = 80) */
+    uint32_t tile_width;               /* Largest tile width (0 = 4096) */
+    uint32_t tile_height;              /* Largest tile height (0 = 4096) */
+    uint32_t num_threads;              /* Tiles encoded at once (0 = one per CPU) */
+} RkmppTiledEncoderConfig;
+
+/**
+ * Create a tiled encoder (CPU backend)
+ *
+ * The frame is cut into tiles no larger than tile_width x tile_height,
+ * each tile is encoded by its own encoder instance on a pool of threads,
+ * and the tiles are stitched into one baseline JPEG whose restart
+ * intervals end on tile edges.
+ *
+ * @param config Tiled encoder configuration
+ * @return Tiled encoder handle on success, NULL on failure
+ */
+RkmppTiledEncoder* rkmpp_tiled_encoder_create(const RkmppTiledEncoderConfig* config);
+
+/**
+ * Destroy tiled encoder and release resources
+ *
+ * @param encoder Tiled encoder handle
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_tiled_encoder_destroy(RkmppTiledEncoder* encoder);
+
+/**
+ * Encode one frame into a single JPEG
+ *
+ * @param encoder Tiled encoder handle
+ * @param frame_data Input frame in the configured format
+ * @param frame_size Size of the frame data
+ * @param jpeg_out Output buffer for the JPEG
+ * @param out_size Size of output buffer
+ * @param out_len Output: size of the JPEG
+ * @return RKMPP_OK on success, RKMPP_ERR_ENCODE if the JPEG does not fit
+ */
+RkmppStatus rkmpp_tiled_encoder_encode(
+    RkmppTiledEncoder* encoder,
+    const uint8_t* frame_data,
+    uint32_t frame_size,
+    uint8_t* jpeg_out,
+    uint32_t out_size,
+    uint32_t* out_len
+);
+
+/* ============================================================================
+ * Batched File Sink
+ * ============================================================================ */
+
+/* File sink handle (opaque pointer) */
+typedef struct RkmppFileSink RkmppFileSink;
+
+/**
+ * File sink I/O engine
+ */
+typedef enum {
+    RKMPP_SINK_ENGINE_AUTO = 0,        /* io_uring when available, else threads */
+    RKMPP_SINK_ENGINE_IO_URING = 1,    /* io_uring only (create fails if unavailable) */
+    RKMPP_SINK_ENGINE_THREADS = 2      /* Thread-pool pwrite */
+} RkmppSinkEngine;
+
+/**
+ * File sink configuration structure
+ */
+typedef struct {
+    uint32_t engine;                   /* RkmppSinkEngine (default AUTO) */
+    uint32_t num_buffers;              /* Packet buffers in the pool (default 16) */
+    uint32_t buffer_size;              /* Size of each packet buffer (default 1 MiB) */
+    uint32_t batch_size;               /* Files queued per submission (default 8) */
+    uint32_t num_threads;              /* Worker threads for the fallback engine (default 4) */
+} RkmppFileSinkConfig;
+
+/**
+ * File sink statistics
+ *
+ * Latency is measured from submission to the file being closed.
+ */
+typedef struct {
+    uint32_t engine;                   /* Engine in use (IO_URING or THREADS) */
+    uint64_t files_written;            /* Files written successfully */
+    uint64_t bytes_written;            /* Payload bytes written */
+    uint64_t write_errors;             /* Failed open/write/close operations */
+    uint64_t submissions;              /* Batches handed to the engine */
+    uint64_t latency_min_us;           /* Minimum write latency */
+    uint64_t latency_max_us;           /* Maximum write latency */
+    uint64_t latency_avg_us;           /* Mean write latency */
+    uint64_t latency_p99_us;           /* 99th percentile (power-of-two bucket bound) */
+} RkmppFileSinkStats;
+
+/**
+ * Create a batched file sink
+ *
+ * The sink owns a pool of packet buffers which are registered with the
+ * kernel when the io_uring engine is used. Encode directly into a buffer
+ * obtained from rkmpp_file_sink_get_buffer() to avoid any copy.
+ *
+ * @param config Sink configuration (NULL for defaults)
+ * @return Sink handle on success, NULL on failure
+ */
+RkmppFileSink* rkmpp_file_sink_create(const RkmppFileSinkConfig* config);
+
+/**
+ * Flush pending writes, destroy sink and release resources
+ *
+ * @param sink Sink handle
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_file_sink_destroy(RkmppFileSink* sink);
+
+/**
+ * Acquire a free packet buffer, waiting for in-flight writes if needed
+ *
+ * @param sink Sink handle
+ * @param buffer Output parameter: packet buffer
+ * @param capacity Output parameter: size of the packet buffer
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_file_sink_get_buffer(
+    RkmppFileSink* sink,
+    uint8_t** buffer,
+    uint32_t* capacity
+);
+
+/**
+ * Queue a packet buffer to be written to a new file
+ *
+ * Ownership of the buffer returns to the sink. The file is created (or
+ * truncated) and closed asynchronously; writes are submitted in batches.
+ *
+ * @param sink Sink handle
+ * @param path Destination file path
+ * @param buffer Buffer obtained from rkmpp_file_sink_get_buffer()
+ * @param length Number of bytes to write
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_file_sink_submit(
+    RkmppFileSink* sink,
+    const char* path,
+    uint8_t* buffer,
+    uint32_t length
+);
+
+/**
+ * Copy data into a packet buffer and queue it to be written
+ *
+ * @param sink Sink handle
+ * @param path Destination file path
+ * @param data Data to write
+ * @param length Number of bytes to write
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_file_sink_write(
+    RkmppFileSink* sink,
+    const char* path,
+    const uint8_t* data,
+    uint32_t length
+);
+
+/**
+ * Submit queued writes and wait until all of them have completed
+ *
+ * @param sink Sink handle
+ * @return RKMPP_OK on success, RKMPP_ERR_UNKNOWN if any write failed
+ *         since the previous flush
+ */
+RkmppStatus rkmpp_file_sink_flush(RkmppFileSink* sink);
+
+/**
+ * Get file sink statistics
+ *
+ * @param sink Sink handle
+ * @param stats Output: sink statistics
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_file_sink_get_stats(
+    RkmppFileSink* sink,
+    RkmppFileSinkStats* stats
+);
+
+/* ============================================================================
+ * RTP/JPEG Packetizer (RFC 2435)
+ * ============================================================================ */
+
+/* RTP packetizer handle (opaque pointer) */
+typedef struct RkmppRtpPacketizer RkmppRtpPacketizer;
+
+/* Largest RTP + JPEG + restart + quantization table header */
+#define RKMPP_RTP_MAX_HEADER 288
+
+/**
+ * RTP packetizer configuration structure
+ */
+typedef struct {
+    uint32_t mtu;                      /* Max RTP packet size incl. headers (default 1400) */
+    uint32_t payload_type;             /* RTP payload type (default 26, JPEG) */
+    uint32_t ssrc;                     /* RTP synchronization source */
+    uint32_t initial_sequence;         /* First RTP sequence number */
+    uint32_t qtable_interval;          /* Resend unchanged tables every N frames (0 = never) */
+} RkmppRtpConfig;
+
+/**
+ * One RTP packet as a scatter list
+ *
+ * iov[0] points at the header bytes stored in this structure, iov[1] at the
+ * scan data inside the caller's JPEG buffer, so the structure must not be
+ * copied and the JPEG buffer must outlive the packet.
+ */
+typedef struct {
+    uint8_t header[RKMPP_RTP_MAX_HEADER];
+    struct iovec iov[2];               /* Headers, scan data fragment */
+    uint32_t iovcnt;                   /* Number of valid iov entries */
+    uint32_t size;                     /* Total packet size in bytes */
+    uint32_t marker;                   /* Last packet of the frame */
+} RkmppRtpPacket;
+
+/**
+ * Create an RTP/JPEG packetizer
+ *
+ * @param config Packetizer configuration (NULL for defaults)
+ * @return Packetizer handle on success, NULL on failure
+ */
+RkmppRtpPacketizer* rkmpp_rtp_packetizer_create(const RkmppRtpConfig* config);
+
+/**
+ * Destroy packetizer and release resources
+ *
+ * @param packetizer Packetizer handle
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_rtp_packetizer_destroy(RkmppRtpPacketizer* packetizer);
+
+/**
+ * Start packetizing a baseline 4:2:0 or 4:2:2 JPEG frame
+ *
+ * Only the marker segments in front of the scan are inspected; the scan
+ * data itself is referenced, never copied or re-parsed. Quantization tables
+ * are sent in-band only when they differ from the previous frame (or every
+ * qtable_interval frames).
+ *
+ * RFC 2435 carries no Huffman tables: receivers rebuild the header with
+ * the Annex K tables, so a frame whose DHT segments define any other
+ * table (such as encoder output with huffman_refresh set) is rejected.
+ *
+ * @param packetizer Packetizer handle
+ * @param jpeg_data Encoded JPEG frame (must stay valid until the last packet)
+ * @param jpeg_len Size of the JPEG frame
+ * @param timestamp RTP timestamp (90 kHz clock)
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_rtp_packetizer_begin_frame(
+    RkmppRtpPacketizer* packetizer,
+    const uint8_t* jpeg_data,
+    uint32_t jpeg_len,
+    uint32_t timestamp
+);
+
+/**
+ * Produce the next RTP packet of the current frame
+ *
+ * @param packetizer Packetizer handle
+ * @param packet Output: packet scatter list
+ * @return RKMPP_OK when a packet was produced, RKMPP_ERR_NOT_READY when
+ *         the frame is complete, error code on failure
+ */
+RkmppStatus rkmpp_rtp_packetizer_next_packet(
+    RkmppRtpPacketizer* packetizer,
+    RkmppRtpPacket* packet
+);
+
+/* ============================================================================
+ * Multipart (x-mixed-replace) Writer
+ * ============================================================================ */
+
+/* Multipart writer handle (opaque pointer) */
+typedef struct RkmppMultipartWriter RkmppMultipartWriter;
+
+/* Largest per-frame part header (boundary line and part headers) */
+#define RKMPP_MULTIPART_MAX_HEADER 256
+
+/**
+ * Multipart writer configuration structure
+ */
+typedef struct {
+    const char* boundary;              /* Boundary token (default "rkmppframe", max 70) */
+    const char* content_type;          /* Part content type (default "image/jpeg") */
+} RkmppMultipartConfig;
+
+/**
+ * One multipart part as a scatter list
+ *
+ * iov[0] points at the header stored in this structure and iov[1] at the
+ * caller's JPEG buffer, so one frame can be sent to any number of viewers
+ * without copying. The structure must not be copied while in use.
+ */
+typedef struct {
+    char header[RKMPP_MULTIPART_MAX_HEADER];
+    struct iovec iov[3];               /* Part header, JPEG data, trailing CRLF */
+    uint32_t iovcnt;                   /* Number of valid iov entries */
+    uint32_t size;                     /* Total part size in bytes */
+} RkmppMultipartFrame;
+
+/**
+ * Create a multipart/x-mixed-replace writer
+ *
+ * @param config Writer configuration (NULL for defaults)
+ * @return Writer handle on success, NULL on failure
+ */
+RkmppMultipartWriter* rkmpp_multipart_create(const RkmppMultipartConfig* config);
+
+/**
+ * Destroy writer and release resources
+ *
+ * @param writer Writer handle
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_multipart_destroy(RkmppMultipartWriter* writer);
+
+/**
+ * Get the HTTP Content-Type value announcing the stream
+ *
+ * A boundary containing spaces or RFC 2045 tspecials is quoted.
+ *
+ * @param writer Writer handle
+ * @return "multipart/x-mixed-replace; boundary=..." or NULL
+ */
+const char* rkmpp_multipart_get_content_type(RkmppMultipartWriter* writer);
+
+/**
+ * Wrap an encoded frame in a multipart part
+ *
+ * @param writer Writer handle
+ * @param jpeg_data Encoded frame (must stay valid while the part is sent)
+ * @param jpeg_len Size of the encoded frame
+ * @param frame Output: part scatter list
+ * @return RKMPP_OK on success, error code on failure
+ */
+RkmppStatus rkmpp_multipart_build_frame(
+    RkmppMultipartWriter* writer,
+    const uint8_t* jpeg_data,
+    uint32_t jpeg_len,
+    RkmppMultipartFrame* frame
+);
+
+/**
+ * Send a part (or the rest of it) to one viewer
+ *
+ * Works with blocking and non-blocking descriptors. Keep one offset per
+ * viewer, starting at 0; it is advanced past the bytes written.
+ *
+ * @param frame Part built by rkmpp_multipart_build_frame()
+ * @param fd Socket, pipe or file descriptor
+ * @param offset In/out: bytes of this part already sent to fd
+ * @return RKMPP_OK when the part is complete, RKMPP_ERR_NOT_READY if the
+ *         descriptor would block, RKMPP_ERR_UNKNOWN on write errors
+ */
+RkmppStatus rkmpp_multipart_send(
+    const RkmppMultipartFrame* frame,
+    int fd,
+    uint32_t* offset
+);
+
+/* ============================================================================
+ * Context Cache
+ * ============================================================================ */
+
+/**
+ * Set how many destroyed contexts the process keeps for reuse
+ *
+ * rkmpp_encoder_destroy() and rkmpp_decoder_destroy() park the context
+ * with its backend, buffers and tables instead of tearing it down, and the
+ * next create with the same geometry, format and backend takes it back.
+ * Rate control, statistics and stream state start afresh. Each codec type
+ * keeps up to this many contexts, dropping the oldest. Caching is off by
+ * default: a parked CPU encoder keeps its frame-sized coefficient and level
+ * buffers, which reach tens of megabytes at 4096x4096.
+ *
+ * @param contexts Contexts kept per codec type (0-16, 0 = off, which also
+ *                 frees every parked context)
+ * @return RKMPP_OK on success, RKMPP_ERR_INVALID_PARAM above 16
+ */
+RkmppStatus rkmpp_set_context_cache_size(uint32_t contexts);
+
+/* ============================================================================
+ * Logging
+ * ============================================================================ */
+
+/**
+ * Log levels, from quietest to most verbose
+ */
+typedef enum {
+    RKMPP_LOG_NONE = 0,                /* Deliver nothing */
+    RKMPP_LOG_ERROR = 1,               /* Failed calls and rejected configurations */
+    RKMPP_LOG_WARN = 2,                /* Recoverable problems */
+    RKMPP_LOG_INFO = 3,                /* Creation and configuration of codecs */
+    RKMPP_LOG_DEBUG = 4                /* Internal decisions */
+} RkmppLogLevel;
+
+/**
+ * Log callback
+ *
+ * Called from whichever thread logs, possibly several at once. The
+ * message has no trailing newline and is only valid during the call.
+ */
+typedef void (*RkmppLogCallback)(RkmppLogLevel level, const char* message, void* opaque);
+
+/**
+ * Route library messages to a callback
+ *
+ * @param callback Message sink (NULL restores the default, which writes
+ *                 errors and warnings to stderr and the rest to stdout)
+ * @param opaque Passed to every call of callback
+ */
+void rkmpp_set_log_callback(RkmppLogCallback callback, void* opaque);
+
+/**
+ * Set the most verbose level delivered (RKMPP_LOG_WARN by default)
+ *
+ * Messages above the level are counted but never formatted.
+ *
+ * @param level RKMPP_LOG_NONE to RKMPP_LOG_DEBUG
+ * @return RKMPP_OK on success, RKMPP_ERR_INVALID_PARAM for an unknown level
+ */
+RkmppStatus rkmpp_set_log_level(RkmppLogLevel level);
+
+/**
+ * Get message counts of one level since the process started
+ *
+ * @param level RKMPP_LOG_ERROR to RKMPP_LOG_DEBUG
+ * @param emitted Output: messages delivered to the callback (may be NULL)
+ * @param suppressed Output: messages dropped by the level filter (may be NULL)
+ * @return RKMPP_OK on success, RKMPP_ERR_INVALID_PARAM for an unknown level
+ */
+RkmppStatus rkmpp_get_log_stats(RkmppLogLevel level, uint64_t* emitted, uint64_t* suppressed);
+
 /* ============================================================================
  * Utility Functions
  * ============================================================================ */
@@ -193,6 +1103,16 @@ RkmppStatus rkmpp_decoder_get_stats(
  */
 uint32_t rkmpp_get_nv12_size(uint32_t width, uint32_t height);
 
+/**
+ * Get required buffer size of a raw frame
+ * 
+ * @param format Pixel format (RkmppFormat)
+ * @param width Image width
+ * @param height Image height
+ * @return Required buffer size in bytes, 0 for an unknown format
+ */
+uint32_t rkmpp_get_frame_size(uint32_t format, uint32_t width, uint32_t height);
+
 /**
  * Get error message string
  * 
@@ -0,0 +1,121 @@
+/*
+ * Codec Context Cache Implementation
+ *
+ * Services that create an encoder or decoder per request pay for backend
+ * initialization, buffer group allocation and table setup every time.
+ * Destroyed contexts are parked here instead and handed back to the next
+ * create with the same configuration.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rkmpp_mjpeg.h"
+#include "context_cache_internal.h"
+#include "encoder_internal.h"
+#include "decoder_internal.h"
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+/**
+ * Destroy a parked encoder
+ */
+static void destroy_encoder(void* ctx)
+{
+    encoder_release((struct RkmppEncoder*)ctx);
+}
+
+/**
+ * Destroy a parked decoder
+ */
+static void destroy_decoder(void* ctx)
+{
+    decoder_release((struct RkmppDecoder*)ctx);
+}
+
+/**
+ * Destroy the oldest contexts until at most limit remain (lock held)
+ */
+static void trim(ContextCache* cache, uint32_t limit)
+{
+    while (cache->count > limit) {
+        cache->destroy(cache->entries[0]);
+        cache->count--;
+        memmove(&cache->entries[0], &cache->entries[1], cache->count * sizeof(void*));
+    }
+}
+
+/* ============================================================================
+ * Internal Implementation Functions
+ * ============================================================================ */
+
+ContextCache context_cache_encoders = {
+    PTHREAD_MUTEX_INITIALIZER, destroy_encoder, { NULL }, 0, CONTEXT_CACHE_DEFAULT
+};
+
+ContextCache context_cache_decoders = {
+    PTHREAD_MUTEX_INITIALIZER, destroy_decoder, { NULL }, 0, CONTEXT_CACHE_DEFAULT
+};
+
+void* context_cache_take(ContextCache* cache, ContextMatch match, const void* key)
+{
+    void* ctx = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    for (uint32_t i = cache->count; i-- > 0;) {
+        if (match(cache->entries[i], key)) {
+            ctx = cache->entries[i];
+            cache->count--;
+            memmove(&cache->entries[i], &cache->entries[i + 1],
+                    (cache->count - i) * sizeof(void*));
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return ctx;
+}
+
+int context_cache_put(ContextCache* cache, void* ctx)
+{
+    int ret = -1;
+
+    pthread_mutex_lock(&cache->lock);
+
+    /* A full cache makes room by dropping its oldest context */
+    if (cache->limit > 0) {
+        trim(cache, cache->limit - 1);
+        cache->entries[cache->count++] = ctx;
+        ret = 0;
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return ret;
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+RkmppStatus rkmpp_set_context_cache_size(uint32_t contexts)
+{
+    ContextCache* caches[] = { &context_cache_encoders, &context_cache_decoders };
+
+    if (contexts > CONTEXT_CACHE_MAX) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    for (size_t i = 0; i < sizeof(caches) / sizeof(caches[0]); i++) {
+        pthread_mutex_lock(&caches[i]->lock);
+        caches[i]->limit = contexts;
+        trim(caches[i], contexts);
+        pthread_mutex_unlock(&caches[i]->lock);
+    }
+
+    return RKMPP_OK;
+}
@@ -0,0 +1,58 @@
+/*
+ * Codec Context Cache Internal Implementation
+ */
+
+#ifndef CONTEXT_CACHE_INTERNAL_H
+#define CONTEXT_CACHE_INTERNAL_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#define CONTEXT_CACHE_MAX       16     /* Slots per cache */
+#define CONTEXT_CACHE_DEFAULT   0      /* Off until rkmpp_set_context_cache_size() */
+
+/**
+ * Whether a parked context can serve a configuration
+ */
+typedef int (*ContextMatch)(const void* ctx, const void* key);
+
+/**
+ * Tear a context down for good
+ */
+typedef void (*ContextDestroy)(void* ctx);
+
+/**
+ * Process-wide cache of initialized codec contexts
+ *
+ * Destroying a codec parks its context here with backend, buffers and
+ * tables intact; creating one with a matching configuration takes it
+ * back, so only per-stream state has to be reset.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    ContextDestroy destroy;
+    void* entries[CONTEXT_CACHE_MAX];  /* Oldest first */
+    uint32_t count;
+    uint32_t limit;                    /* Contexts kept (0 = caching off) */
+} ContextCache;
+
+/* One cache per codec type */
+extern ContextCache context_cache_encoders;
+extern ContextCache context_cache_decoders;
+
+/**
+ * Take the most recently parked context that matches key
+ *
+ * @return The context, or NULL if none matches
+ */
+void* context_cache_take(ContextCache* cache, ContextMatch match, const void* key);
+
+/**
+ * Park a context
+ *
+ * @return 0 if the cache took it, -1 if it is full or disabled (the
+ *         caller destroys the context)
+ */
+int context_cache_put(ContextCache* cache, void* ctx);
+
+#endif /* CONTEXT_CACHE_INTERNAL_H */
@@ -1,10 +1,10 @@
 /*
  * MJPEG Decoder Implementation
  * 
- * Implements MJPEG to NV12 hardware decoding using Rockchip MPP
+ * Implements MJPEG to NV12, NV16, grayscale and RGB hardware decoding using
+ * Rockchip MPP, with the software baseline decoder as the CPU backend.
  */
 
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
@@ -12,6 +12,8 @@
 
 #include "rkmpp_mjpeg.h"
 #include "decoder_internal.h"
+#include "log_internal.h"
+#include "context_cache_internal.h"
 
 /* Mock MPP API definitions */
 typedef struct MppCtx MppCtx;
@@ -57,12 +59,55 @@ static int mpp_buffer_group_put(MppBufferGroup* group);
  * Helper Functions
  * ============================================================================ */
 
+
+/**
+ * Name of an output pixel format
+ */
+static const char* format_name(uint32_t format)
+{
+    switch (format) {
+        case RKMPP_FORMAT_NV16:
+            return "NV16";
+        case RKMPP_FORMAT_GRAY:
+            return "GRAY";
+        case RKMPP_FORMAT_RGB888:
+            return "RGB888";
+        case RKMPP_FORMAT_BGR888:
+            return "BGR888";
+        case RKMPP_FORMAT_RGBA8888:
+            return "RGBA8888";
+        case RKMPP_FORMAT_BGRA8888:
+            return "BGRA8888";
+        case RKMPP_FORMAT_RGB_F32_PLANAR:
+            return "RGB_F32_PLANAR";
+        default:
+            return "NV12";
+    }
+}
+
 /**
- * Calculate NV12 buffer size
+ * Software decoder layout of an output pixel format
  */
-static uint32_t calculate_nv12_size(uint32_t width, uint32_t height)
+static JpegOutputFormat output_layout(uint32_t format)
 {
-    return (width * height * 3) / 2;
+    switch (format) {
+        case RKMPP_FORMAT_NV16:
+            return JPEG_OUTPUT_NV16;
+        case RKMPP_FORMAT_GRAY:
+            return JPEG_OUTPUT_GRAY;
+        case RKMPP_FORMAT_RGB888:
+            return JPEG_OUTPUT_RGB888;
+        case RKMPP_FORMAT_BGR888:
+            return JPEG_OUTPUT_BGR888;
+        case RKMPP_FORMAT_RGBA8888:
+            return JPEG_OUTPUT_RGBA8888;
+        case RKMPP_FORMAT_BGRA8888:
+            return JPEG_OUTPUT_BGRA8888;
+        case RKMPP_FORMAT_RGB_F32_PLANAR:
+            return JPEG_OUTPUT_RGB_F32;
+        default:
+            return JPEG_OUTPUT_NV12;
+    }
 }
 
 /**
@@ -76,14 +121,146 @@ static int validate_decoder_config(const RkmppDecoderConfig* config)
     
     if (config->max_width < 16 || config->max_width > 4096 ||
         config->max_height < 16 || config->max_height > 4096) {
-        fprintf(stderr, "Invalid max resolution: %ux%u\n", 
-                config->max_width, config->max_height);
+        LOG_ERROR("Invalid max resolution: %ux%u",
+                  config->max_width, config->max_height);
+        return -1;
+    }
+    
+    if (config->backend > RKMPP_BACKEND_CPU) {
+        LOG_ERROR("Invalid backend: %u", config->backend);
+        return -1;
+    }
+    
+    /* Every format except packed 4:2:2 */
+    if (config->output_format > RKMPP_FORMAT_RGB_F32_PLANAR ||
+        config->output_format == RKMPP_FORMAT_YUYV) {
+        LOG_ERROR("Invalid output format: %u", config->output_format);
         return -1;
     }
     
     return 0;
 }
 
+/**
+ * Report the size of the frame being decoded and make room for it
+ * (lock held)
+ *
+ * Sizes are compared with the last frame actually delivered, so a frame
+ * rejected for a small output buffer still flags the change when retried.
+ */
+static RkmppStatus track_frame_size(
+    struct RkmppDecoder* decoder,
+    uint32_t width,
+    uint32_t height,
+    RkmppFrameInfo* frame_info)
+{
+    if (width > DECODER_MAX_DIMENSION || height > DECODER_MAX_DIMENSION) {
+        LOG_ERROR("JPEG %ux%u exceeds max resolution %ux%u",
+                  width, height, DECODER_MAX_DIMENSION, DECODER_MAX_DIMENSION);
+        return RKMPP_ERR_DECODE;
+    }
+    
+    frame_info->width = width;
+    frame_info->height = height;
+    frame_info->format = decoder->output_format;
+    frame_info->timestamp = 0;
+    frame_info->info_change = width != decoder->frame_width || height != decoder->frame_height;
+    
+    if (width > decoder->pool_width || height > decoder->pool_height) {
+        uint32_t pool_width = width > decoder->pool_width ? width : decoder->pool_width;
+        uint32_t pool_height = height > decoder->pool_height ? height : decoder->pool_height;
+        
+        if (decoder_resize_pool(decoder, pool_width, pool_height) != 0) {
+            LOG_ERROR("failed to grow frame pool to %ux%u",
+                      pool_width, pool_height);
+            return RKMPP_ERR_MEMORY;
+        }
+    }
+    
+    return RKMPP_OK;
+}
+
+/**
+ * Decode with the software decoder (lock held)
+ */
+static RkmppStatus decode_cpu(
+    struct RkmppDecoder* decoder,
+    const uint8_t* jpeg_data,
+    uint32_t jpeg_size,
+    uint8_t* nv12_data,
+    uint32_t nv12_size,
+    uint32_t* nv12_len,
+    RkmppFrameInfo* frame_info)
+{
+    JpegDecoder* jpeg = decoder->jpeg;
+    uint32_t frame_size = 0;
+    RkmppStatus status = RKMPP_OK;
+    
+    if (jpeg_decoder_read_header(jpeg, jpeg_data, jpeg_size) != 0) {
+        LOG_ERROR("unsupported or corrupt JPEG header");
+        return RKMPP_ERR_DECODE;
+    }
+    
+    status = track_frame_size(decoder, jpeg->width, jpeg->height, frame_info);
+    if (status != RKMPP_OK) {
+        return status;
+    }
+    
+    frame_size = rkmpp_get_frame_size(decoder->output_format, jpeg->width, jpeg->height);
+    if (nv12_size < frame_size) {
+        LOG_ERROR("output buffer too small: %u < %u", nv12_size, frame_size);
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+    
+    if (jpeg_decoder_decode(jpeg, jpeg_data, jpeg_size, output_layout(decoder->output_format),
+                            nv12_data) != 0) {
+        LOG_ERROR("corrupt JPEG entropy-coded data");
+        return RKMPP_ERR_DECODE;
+    }
+    
+    *nv12_len = frame_size;
+    decoder->frame_width = jpeg->width;
+    decoder->frame_height = jpeg->height;
+    
+    decoder->frames_decoded++;
+    decoder->bytes_decoded += frame_size;
+    
+    return RKMPP_OK;
+}
+
+/**
+ * Whether a parked decoder was created with a configuration
+ */
+static int decoder_matches(const void* ctx, const void* key)
+{
+    const struct RkmppDecoder* decoder = (const struct RkmppDecoder*)ctx;
+    const RkmppDecoderConfig* config = (const RkmppDecoderConfig*)key;
+    
+    return decoder->max_width == config->max_width &&
+           decoder->max_height == config->max_height &&
+           decoder->output_format == config->output_format &&
+           decoder->backend == config->backend;
+}
+
+/**
+ * Start a new stream on a cached decoder
+ *
+ * The frame pool keeps whatever size it grew to.
+ *
+ * @return 0 on success, -1 if the default tables cannot be rebuilt
+ */
+static int decoder_restart(struct RkmppDecoder* decoder)
+{
+    decoder->frame_width = 0;
+    decoder->frame_height = 0;
+    decoder->frames_decoded = 0;
+    decoder->bytes_decoded = 0;
+    decoder->eos_received = 0;
+    
+    /* Tables of the previous stream must not leak into this one */
+    return decoder->jpeg ? jpeg_decoder_reset(decoder->jpeg) : 0;
+}
+
 /* ============================================================================
  * Public API Implementation
  * ============================================================================ */
@@ -94,19 +271,29 @@ RkmppDecoder* rkmpp_decoder_create(const RkmppDecoderConfig* config)
     int ret = 0;
     
     if (!config) {
-        fprintf(stderr, "Error: config is NULL\n");
+        LOG_ERROR("config is NULL");
         return NULL;
     }
     
     if (validate_decoder_config(config) != 0) {
-        fprintf(stderr, "Error: invalid decoder configuration\n");
+        LOG_ERROR("invalid decoder configuration");
         return NULL;
     }
     
+    /* A parked context skips backend setup altogether */
+    decoder = (RkmppDecoder*)context_cache_take(&context_cache_decoders,
+                                                decoder_matches, config);
+    if (decoder) {
+        if (decoder_restart(decoder) == 0) {
+            return decoder;
+        }
+        decoder_release(decoder);
+    }
+    
     /* Allocate decoder structure */
     decoder = (RkmppDecoder*)malloc(sizeof(RkmppDecoder));
     if (!decoder) {
-        fprintf(stderr, "Error: failed to allocate decoder structure\n");
+        LOG_ERROR("failed to allocate decoder structure");
         return NULL;
     }
     
@@ -119,11 +306,20 @@ RkmppDecoder* rkmpp_decoder_create(const RkmppDecoderConfig* config)
     decoder->max_width = config->max_width;
     decoder->max_height = config->max_height;
     decoder->output_format = config->output_format;
-    
-    /* Initialize MPP */
-    ret = decoder_init_mpp(decoder);
+    decoder->backend = config->backend;
+    decoder->pool_width = config->max_width;
+    decoder->pool_height = config->max_height;
+    
+    /* Initialize the codec backend */
+    if (decoder->backend == RKMPP_BACKEND_CPU) {
+        decoder->jpeg = jpeg_decoder_create();
+        ret = decoder->jpeg ? 0 : -1;
+    } else {
+        ret = decoder_init_mpp(decoder);
+    }
     if (ret != 0) {
-        fprintf(stderr, "Error: failed to initialize MPP\n");
+        LOG_ERROR("failed to initialize %s backend",
+                  decoder->backend == RKMPP_BACKEND_CPU ? "CPU" : "MPP");
         pthread_mutex_destroy(&decoder->lock);
         free(decoder);
         return NULL;
@@ -132,7 +328,7 @@ RkmppDecoder* rkmpp_decoder_create(const RkmppDecoderConfig* config)
     /* Configure decoder */
     ret = decoder_configure(decoder);
     if (ret != 0) {
-        fprintf(stderr, "Error: failed to configure decoder\n");
+        LOG_ERROR("failed to configure decoder");
         decoder_cleanup_mpp(decoder);
         pthread_mutex_destroy(&decoder->lock);
         free(decoder);
@@ -141,8 +337,8 @@ RkmppDecoder* rkmpp_decoder_create(const RkmppDecoderConfig* config)
     
     decoder->initialized = 1;
     
-    printf("MJPEG Decoder created: max resolution %ux%u\n",
-           decoder->max_width, decoder->max_height);
+    LOG_INFO("MJPEG Decoder created: max resolution %ux%u",
+             decoder->max_width, decoder->max_height);
     
     return decoder;
 }
@@ -153,16 +349,14 @@ RkmppStatus rkmpp_decoder_destroy(RkmppDecoder* decoder)
         return RKMPP_ERR_INVALID_PARAM;
     }
     
+    /* Wait out any call still holding the decoder before parking it */
     pthread_mutex_lock(&decoder->lock);
-    
-    if (decoder->initialized) {
-        decoder_cleanup_mpp(decoder);
-    }
-    
     pthread_mutex_unlock(&decoder->lock);
-    pthread_mutex_destroy(&decoder->lock);
     
-    free(decoder);
+    if (!decoder->initialized ||
+        context_cache_put(&context_cache_decoders, decoder) != 0) {
+        decoder_release(decoder);
+    }
     
     return RKMPP_OK;
 }
@@ -190,6 +384,13 @@ RkmppStatus rkmpp_decoder_decode(
     
     pthread_mutex_lock(&decoder->lock);
     
+    if (decoder->backend == RKMPP_BACKEND_CPU) {
+        RkmppStatus status = decode_cpu(decoder, jpeg_data, jpeg_size,
+                                        nv12_data, nv12_size, nv12_len, frame_info);
+        pthread_mutex_unlock(&decoder->lock);
+        return status;
+    }
+    
     /* In a real implementation, this would:
      * 1. Create MppPacket from JPEG data
      * 2. Put packet to decoder via mpi->decode_put_packet
@@ -202,15 +403,19 @@ RkmppStatus rkmpp_decoder_decode(
     /* Mock implementation: simulate JPEG decoding */
     /* For testing, we'll use a simplified approach */
     
+    /* Mock frame info: the mock does not parse the stream */
+    RkmppStatus status = track_frame_size(decoder, decoder->max_width, decoder->max_height,
+                                          frame_info);
+    if (status != RKMPP_OK) {
+        pthread_mutex_unlock(&decoder->lock);
+        return status;
+    }
+    
     uint32_t copy_size = (nv12_size < jpeg_size) ? nv12_size : jpeg_size;
     memcpy(nv12_data, jpeg_data, copy_size);
     *nv12_len = copy_size;
-    
-    /* Mock frame info */
-    frame_info->width = decoder->max_width;
-    frame_info->height = decoder->max_height;
-    frame_info->format = 0; /* NV12 */
-    frame_info->timestamp = 0;
+    decoder->frame_width = frame_info->width;
+    decoder->frame_height = frame_info->height;
     
     decoder->frames_decoded++;
     decoder->bytes_decoded += copy_size;
@@ -259,14 +464,14 @@ int decoder_init_mpp(struct RkmppDecoder* decoder)
     /* Create MPP context */
     ret = mpp_create(&decoder->mpp_ctx, &decoder->mpi);
     if (ret != 0) {
-        fprintf(stderr, "Error: mpp_create failed\n");
+        LOG_ERROR("mpp_create failed");
         return -1;
     }
     
     /* Initialize decoder */
     ret = mpp_init(decoder->mpp_ctx, MPP_VIDEO_CodingMJPEG, 0);
     if (ret != 0) {
-        fprintf(stderr, "Error: mpp_init failed\n");
+        LOG_ERROR("mpp_init failed");
         mpp_destroy(decoder->mpp_ctx);
         return -1;
     }
@@ -274,14 +479,14 @@ int decoder_init_mpp(struct RkmppDecoder* decoder)
     /* Get buffer groups */
     ret = mpp_buffer_group_get_internal(&decoder->frame_group, 0);
     if (ret != 0) {
-        fprintf(stderr, "Error: failed to get frame buffer group\n");
+        LOG_ERROR("failed to get frame buffer group");
         mpp_destroy(decoder->mpp_ctx);
         return -1;
     }
     
     ret = mpp_buffer_group_get_internal(&decoder->packet_group, 1);
     if (ret != 0) {
-        fprintf(stderr, "Error: failed to get packet buffer group\n");
+        LOG_ERROR("failed to get packet buffer group");
         mpp_buffer_group_put(decoder->frame_group);
         mpp_destroy(decoder->mpp_ctx);
         return -1;
@@ -298,15 +503,54 @@ int decoder_configure(struct RkmppDecoder* decoder)
     
     /* In real implementation, configure:
      * - Input format: MJPEG
-     * - Output format: NV12
+     * - Output format: NV12 (YUV420SP), NV16 (YUV422SP), YUV400 or RGB
      * - Maximum resolution
      */
     
-    printf("Decoder configured: MJPEG -> NV12\n");
+    LOG_INFO("Decoder configured: MJPEG -> %s", format_name(decoder->output_format));
     
     return 0;
 }
 
+int decoder_resize_pool(struct RkmppDecoder* decoder, uint32_t width, uint32_t height)
+{
+    /* The software decoder's row buffers grow by themselves; MPP output
+     * frames come from the frame group, sized for the largest frame */
+    if (decoder->frame_group) {
+        MppBufferGroup* group = NULL;
+        
+        /* In a real implementation, this would also ack the info change
+         * (MPP_DEC_SET_INFO_CHANGE_READY) once the group holds buffers of
+         * the new size */
+        if (mpp_buffer_group_get_internal(&group, 0) != 0) {
+            return -1;
+        }
+        mpp_buffer_group_put(decoder->frame_group);
+        decoder->frame_group = group;
+    }
+    
+    decoder->pool_width = width;
+    decoder->pool_height = height;
+    
+    LOG_INFO("Decoder frame pool: %ux%u", width, height);
+    
+    return 0;
+}
+
+void decoder_release(struct RkmppDecoder* decoder)
+{
+    pthread_mutex_lock(&decoder->lock);
+    
+    if (decoder->initialized) {
+        decoder_cleanup_mpp(decoder);
+    }
+    
+    pthread_mutex_unlock(&decoder->lock);
+    pthread_mutex_destroy(&decoder->lock);
+    
+    free(decoder);
+}
+
 void decoder_cleanup_mpp(struct RkmppDecoder* decoder)
 {
     if (!decoder) {
@@ -328,6 +572,11 @@ void decoder_cleanup_mpp(struct RkmppDecoder* decoder)
         decoder->mpp_ctx = NULL;
     }
     
+    if (decoder->jpeg) {
+        jpeg_decoder_destroy(decoder->jpeg);
+        decoder->jpeg = NULL;
+    }
+    
     decoder->mpi = NULL;
 }
 
@@ -8,6 +8,11 @@
 #include <stdint.h>
 #include <pthread.h>
 
+#include "jpeg_decoder_internal.h"
+
+/* Largest frame the pool grows to */
+#define DECODER_MAX_DIMENSION 4096
+
 /* Forward declaration */
 typedef struct MppCtx MppCtx;
 typedef struct MppApi MppApi;
@@ -30,6 +35,17 @@ struct RkmppDecoder {
     uint32_t max_width;
     uint32_t max_height;
     uint32_t output_format;
+    uint32_t backend;                  /* RkmppBackend */
+    
+    /* Software decoder (CPU backend) */
+    JpegDecoder* jpeg;
+    
+    /* Resolution tracking: the pool holds frames up to pool_width x
+     * pool_height and only grows */
+    uint32_t pool_width;
+    uint32_t pool_height;
+    uint32_t frame_width;              /* Size of the last decoded frame (0 = none) */
+    uint32_t frame_height;
     
     /* Statistics */
     uint64_t frames_decoded;
@@ -53,9 +69,19 @@ int decoder_init_mpp(struct RkmppDecoder* decoder);
  */
 int decoder_configure(struct RkmppDecoder* decoder);
 
+/**
+ * Grow the frame pool to hold width x height frames
+ */
+int decoder_resize_pool(struct RkmppDecoder* decoder, uint32_t width, uint32_t height);
+
 /**
  * Cleanup decoder resources
  */
 void decoder_cleanup_mpp(struct RkmppDecoder* decoder);
 
+/**
+ * Tear a decoder down for good (the context cache's destructor)
+ */
+void decoder_release(struct RkmppDecoder* decoder);
+
 #endif /* DECODER_INTERNAL_H */
@@ -1,17 +1,23 @@
 /*
  * MJPEG Encoder Implementation
  * 
- * Implements NV12 to MJPEG hardware encoding using Rockchip MPP
+ * Implements NV12, NV16, YUYV, grayscale and RGB to MJPEG hardware encoding
+ * using Rockchip MPP, with a software baseline encoder as the CPU backend.
+ * Both backends share the rate controller, which picks the quality of every
+ * frame.
  */
 
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <math.h>
 
 #include "rkmpp_mjpeg.h"
 #include "encoder_internal.h"
+#include "log_internal.h"
+#include "jpeg_transform_internal.h"
+#include "context_cache_internal.h"
 
 /* Mock MPP API definitions for compilation without actual MPP library */
 /* In real implementation, these would be replaced with actual MPP headers */
@@ -64,19 +70,163 @@ static int mpp_frame_init(MppFrame* frame);
 static int mpp_frame_deinit(MppFrame* frame);
 static int mpp_packet_init(MppPacket* packet);
 static int mpp_packet_deinit(MppPacket* packet);
+static int mpp_enc_set_quality(MppCtx* ctx, uint32_t quality);
 
 /* ============================================================================
  * Helper Functions
  * ============================================================================ */
 
 /**
- * Calculate NV12 buffer size
- * NV12: Y plane (width * height) + UV plane (width * height / 2)
- * Total: width * height * 3 / 2
+ * Name of an input pixel format
  */
-static uint32_t calculate_nv12_size(uint32_t width, uint32_t height)
+static const char* format_name(uint32_t format)
 {
-    return (width * height * 3) / 2;
+    switch (format) {
+        case RKMPP_FORMAT_NV16:
+            return "NV16";
+        case RKMPP_FORMAT_YUYV:
+            return "YUYV";
+        case RKMPP_FORMAT_GRAY:
+            return "GRAY";
+        case RKMPP_FORMAT_RGB888:
+            return "RGB888";
+        case RKMPP_FORMAT_BGR888:
+            return "BGR888";
+        case RKMPP_FORMAT_RGBA8888:
+            return "RGBA8888";
+        case RKMPP_FORMAT_BGRA8888:
+            return "BGRA8888";
+        default:
+            return "NV12";
+    }
+}
+
+/**
+ * Whether an input orientation swaps width and height
+ */
+static int transform_swaps_axes(uint32_t transform)
+{
+    return transform == RKMPP_TRANSFORM_TRANSPOSE || transform == RKMPP_TRANSFORM_ROT90 ||
+           transform == RKMPP_TRANSFORM_ROT270;
+}
+
+/**
+ * Run the software encoder transform on an input frame
+ *
+ * YUV formats are read in place through plane views; packed RGB is
+ * converted to YCbCr as each MCU is extracted. With a dirty map only the
+ * flagged MCUs are read.
+ */
+static void encoder_transform(struct RkmppEncoder* encoder, const uint8_t* data,
+                              const uint8_t* dirty_map)
+{
+    JpegPlane planes[JPEG_MAX_COMPONENTS];
+    
+    if (encoder->input_format >= RKMPP_FORMAT_RGB888) {
+        int bgr = encoder->input_format == RKMPP_FORMAT_BGR888 ||
+                  encoder->input_format == RKMPP_FORMAT_BGRA8888;
+        JpegRgbFrame frame;
+        
+        frame.base = data;
+        frame.pixel_step = encoder->input_format >= RKMPP_FORMAT_RGBA8888 ? 4 : 3;
+        frame.row_step = (int32_t)encoder->width * frame.pixel_step;
+        frame.offset[0] = (uint8_t)(bgr ? 2 : 0);
+        frame.offset[1] = 1;
+        frame.offset[2] = (uint8_t)(bgr ? 0 : 2);
+        frame.width = encoder->width;
+        frame.height = encoder->height;
+        jpeg_transform_rgb_frame((JpegTransform)encoder->transform, &frame);
+        
+        jpeg_encoder_transform_rgb(encoder->jpeg, &frame, dirty_map);
+        return;
+    }
+    
+    switch (encoder->input_format) {
+        case RKMPP_FORMAT_NV16:
+            jpeg_planes_nv16(data, encoder->width, encoder->height, planes);
+            break;
+        case RKMPP_FORMAT_YUYV:
+            jpeg_planes_yuyv(data, encoder->width, encoder->height, planes);
+            break;
+        default:
+            /* GRAY only reads the Y plane view */
+            jpeg_planes_nv12(data, encoder->width, encoder->height, planes);
+            break;
+    }
+    
+    /* Orientation only changes how the views walk the input */
+    for (int c = 0; c < JPEG_MAX_COMPONENTS; c++) {
+        jpeg_transform_plane((JpegTransform)encoder->transform, &planes[c]);
+    }
+    
+    jpeg_encoder_transform(encoder->jpeg, planes, dirty_map);
+}
+
+/**
+ * Luma view of an input frame for static scene detection
+ *
+ * Packed RGB has no luma sample; green stands in for it.
+ */
+static void encoder_luma(const struct RkmppEncoder* encoder, const uint8_t* data,
+                         JpegPlane* luma)
+{
+    int32_t step = 1;
+    
+    if (encoder->input_format == RKMPP_FORMAT_YUYV) {
+        step = 2;
+    } else if (encoder->input_format >= RKMPP_FORMAT_RGB888) {
+        step = encoder->input_format >= RKMPP_FORMAT_RGBA8888 ? 4 : 3;
+        data += 1;
+    }
+    
+    luma->base = data;
+    luma->col_step = step;
+    luma->row_step = (int32_t)encoder->width * step;
+    luma->width = encoder->width;
+    luma->height = encoder->height;
+}
+
+/**
+ * Keep a copy of the JPEG just encoded for repeating static frames
+ */
+static int encoder_keep_jpeg(struct RkmppEncoder* encoder, const uint8_t* jpeg,
+                             uint32_t len, uint32_t quality)
+{
+    if (len > encoder->last_jpeg_size) {
+        uint8_t* copy = (uint8_t*)realloc(encoder->last_jpeg, len);
+        
+        if (!copy) {
+            return -1;
+        }
+        encoder->last_jpeg = copy;
+        encoder->last_jpeg_size = len;
+    }
+    
+    memcpy(encoder->last_jpeg, jpeg, len);
+    encoder->last_jpeg_len = len;
+    encoder->last_quality = quality;
+    
+    return 0;
+}
+
+/**
+ * Validate a frame size for an input format, at create and reconfigure
+ */
+static int validate_frame_size(uint32_t width, uint32_t height, uint32_t input_format)
+{
+    if (width < 16 || width > 4096 || height < 16 || height > 4096) {
+        LOG_ERROR("Invalid resolution: %ux%u", width, height);
+        return -1;
+    }
+    
+    /* 4:2:2 chroma pairs need an even width */
+    if ((input_format == RKMPP_FORMAT_NV16 || input_format == RKMPP_FORMAT_YUYV) &&
+        (width & 1)) {
+        LOG_ERROR("Invalid width for %s input: %u", format_name(input_format), width);
+        return -1;
+    }
+    
+    return 0;
 }
 
 /**
@@ -88,25 +238,112 @@ static int validate_encoder_config(const RkmppEncoderConfig* config)
         return -1;
     }
     
-    if (config->width < 16 || config->width > 4096 ||
-        config->height < 16 || config->height > 4096) {
-        fprintf(stderr, "Invalid resolution: %ux%u\n", config->width, config->height);
+    if (validate_frame_size(config->width, config->height, config->input_format) != 0) {
         return -1;
     }
     
     if (config->fps < 1 || config->fps > 120) {
-        fprintf(stderr, "Invalid FPS: %u\n", config->fps);
+        LOG_ERROR("Invalid FPS: %u", config->fps);
         return -1;
     }
     
     if (config->quality > 100) {
-        fprintf(stderr, "Invalid quality: %u (should be 0-100)\n", config->quality);
+        LOG_ERROR("Invalid quality: %u (should be 0-100)", config->quality);
+        return -1;
+    }
+    
+    if (config->rc_mode > RKMPP_RC_MODE_FIXQP) {
+        LOG_ERROR("Invalid RC mode: %u", config->rc_mode);
+        return -1;
+    }
+    
+    if (config->backend > RKMPP_BACKEND_CPU) {
+        LOG_ERROR("Invalid backend: %u", config->backend);
+        return -1;
+    }
+    
+    if (config->input_format > RKMPP_FORMAT_BGRA8888) {
+        LOG_ERROR("Invalid input format: %u", config->input_format);
+        return -1;
+    }
+    
+    if (config->transform > RKMPP_TRANSFORM_ROT270) {
+        LOG_ERROR("Invalid transform: %u", config->transform);
+        return -1;
+    }
+    
+    if (config->transform != RKMPP_TRANSFORM_NONE && config->backend != RKMPP_BACKEND_CPU) {
+        LOG_ERROR("Transform %u needs the CPU backend", config->transform);
+        return -1;
+    }
+    
+    /* Transposed 4:2:2 would need 4:4:0 sampling */
+    if ((config->input_format == RKMPP_FORMAT_NV16 ||
+         config->input_format == RKMPP_FORMAT_YUYV) &&
+        transform_swaps_axes(config->transform)) {
+        LOG_ERROR("Invalid transform for %s input: %u",
+                  format_name(config->input_format), config->transform);
+        return -1;
+    }
+    
+    if (config->static_threshold > 255) {
+        LOG_ERROR("Invalid static threshold: %u (should be 0-255)",
+                  config->static_threshold);
         return -1;
     }
     
     return 0;
 }
 
+/**
+ * Whether a parked encoder was built for a configuration
+ *
+ * Only what the backend and buffers depend on has to agree; rate control
+ * settings are applied to whichever context is taken.
+ */
+static int encoder_matches(const void* ctx, const void* key)
+{
+    const struct RkmppEncoder* encoder = (const struct RkmppEncoder*)ctx;
+    const RkmppEncoderConfig* config = (const RkmppEncoderConfig*)key;
+    
+    return encoder->width == config->width && encoder->height == config->height &&
+           encoder->backend == config->backend &&
+           encoder->input_format == config->input_format &&
+           encoder->transform == config->transform &&
+           encoder->scene.threshold == config->static_threshold &&
+           (!encoder->jpeg || encoder->jpeg->huff_refresh == config->huffman_refresh);
+}
+
+/**
+ * Start a new stream on a cached encoder
+ */
+static void encoder_restart(struct RkmppEncoder* encoder, const RkmppEncoderConfig* config)
+{
+    encoder->fps = config->fps;
+    encoder->bitrate = config->bitrate;
+    encoder->quality = config->quality ? config->quality : 80;
+    rc_init(&encoder->rc, config->rc_mode, config->bitrate, config->fps,
+            config->gop, encoder->quality);
+    
+    encoder->size_complexity = 0.0;
+    encoder->frames_encoded = 0;
+    encoder->bytes_encoded = 0;
+    encoder->eos_sent = 0;
+    
+    scene_reset(&encoder->scene);
+    encoder->last_jpeg_len = 0;
+    
+    /* Resizing to the same size only drops the previous stream's
+     * coefficients and Huffman statistics */
+    if (encoder->jpeg) {
+        jpeg_encoder_resize(encoder->jpeg, encoder->jpeg->width, encoder->jpeg->height);
+    }
+    if (encoder->mpp_ctx) {
+        mpp_enc_set_quality(encoder->mpp_ctx, encoder->rc.quality);
+        encoder->hw_quality = encoder->rc.quality;
+    }
+}
+
 /* ============================================================================
  * Public API Implementation
  * ============================================================================ */
@@ -117,19 +354,27 @@ RkmppEncoder* rkmpp_encoder_create(const RkmppEncoderConfig* config)
     int ret = 0;
     
     if (!config) {
-        fprintf(stderr, "Error: config is NULL\n");
+        LOG_ERROR("config is NULL");
         return NULL;
     }
     
     if (validate_encoder_config(config) != 0) {
-        fprintf(stderr, "Error: invalid encoder configuration\n");
+        LOG_ERROR("invalid encoder configuration");
         return NULL;
     }
     
+    /* A parked context skips backend setup altogether */
+    encoder = (RkmppEncoder*)context_cache_take(&context_cache_encoders,
+                                                encoder_matches, config);
+    if (encoder) {
+        encoder_restart(encoder, config);
+        return encoder;
+    }
+    
     /* Allocate encoder structure */
     encoder = (RkmppEncoder*)malloc(sizeof(RkmppEncoder));
     if (!encoder) {
-        fprintf(stderr, "Error: failed to allocate encoder structure\n");
+        LOG_ERROR("failed to allocate encoder structure");
         return NULL;
     }
     
@@ -144,11 +389,44 @@ RkmppEncoder* rkmpp_encoder_create(const RkmppEncoderConfig* config)
     encoder->fps = config->fps;
     encoder->bitrate = config->bitrate;
     encoder->quality = config->quality ? config->quality : 80;
+    encoder->backend = config->backend;
+    encoder->input_format = config->input_format;
+    encoder->transform = config->transform;
     
-    /* Initialize MPP */
-    ret = encoder_init_mpp(encoder);
+    rc_init(&encoder->rc, config->rc_mode, config->bitrate, config->fps,
+            config->gop, encoder->quality);
+    
+    /* Initialize the codec backend */
+    if (encoder->backend == RKMPP_BACKEND_CPU) {
+        JpegSampling sampling = JPEG_SAMPLING_420;
+        uint32_t jpeg_width = encoder->width;
+        uint32_t jpeg_height = encoder->height;
+        
+        if (encoder->input_format == RKMPP_FORMAT_GRAY) {
+            sampling = JPEG_SAMPLING_GRAY;
+        } else if (encoder->input_format == RKMPP_FORMAT_NV16 ||
+                   encoder->input_format == RKMPP_FORMAT_YUYV) {
+            sampling = JPEG_SAMPLING_422;
+        }
+        
+        /* The JPEG has the size of the oriented frame */
+        if (transform_swaps_axes(encoder->transform)) {
+            jpeg_width = encoder->height;
+            jpeg_height = encoder->width;
+        }
+        
+        encoder->jpeg = jpeg_encoder_create(jpeg_width, jpeg_height, sampling);
+        ret = encoder->jpeg ? 0 : -1;
+        if (ret == 0) {
+            ret = jpeg_encoder_set_huffman_refresh(encoder->jpeg, config->huffman_refresh);
+        }
+    } else {
+        ret = encoder_init_mpp(encoder);
+    }
     if (ret != 0) {
-        fprintf(stderr, "Error: failed to initialize MPP\n");
+        LOG_ERROR("failed to initialize %s backend",
+                  encoder->backend == RKMPP_BACKEND_CPU ? "CPU" : "MPP");
+        jpeg_encoder_destroy(encoder->jpeg);
         pthread_mutex_destroy(&encoder->lock);
         free(encoder);
         return NULL;
@@ -157,7 +435,17 @@ RkmppEncoder* rkmpp_encoder_create(const RkmppEncoderConfig* config)
     /* Configure encoder */
     ret = encoder_configure(encoder);
     if (ret != 0) {
-        fprintf(stderr, "Error: failed to configure encoder\n");
+        LOG_ERROR("failed to configure encoder");
+        encoder_cleanup_mpp(encoder);
+        pthread_mutex_destroy(&encoder->lock);
+        free(encoder);
+        return NULL;
+    }
+    
+    if (config->static_threshold > 0 &&
+        scene_init(&encoder->scene, encoder->width, encoder->height,
+                   config->static_threshold) != 0) {
+        LOG_ERROR("failed to allocate static scene detection");
         encoder_cleanup_mpp(encoder);
         pthread_mutex_destroy(&encoder->lock);
         free(encoder);
@@ -166,8 +454,8 @@ RkmppEncoder* rkmpp_encoder_create(const RkmppEncoderConfig* config)
     
     encoder->initialized = 1;
     
-    printf("MJPEG Encoder created: %ux%u@%ufps, quality=%u\n",
-           encoder->width, encoder->height, encoder->fps, encoder->quality);
+    LOG_INFO("MJPEG Encoder created: %ux%u@%ufps, quality=%u",
+             encoder->width, encoder->height, encoder->fps, encoder->quality);
     
     return encoder;
 }
@@ -178,16 +466,103 @@ RkmppStatus rkmpp_encoder_destroy(RkmppEncoder* encoder)
         return RKMPP_ERR_INVALID_PARAM;
     }
     
+    /* Wait out any call still holding the encoder before parking it */
     pthread_mutex_lock(&encoder->lock);
+    pthread_mutex_unlock(&encoder->lock);
     
-    if (encoder->initialized) {
-        encoder_cleanup_mpp(encoder);
+    if (!encoder->initialized ||
+        context_cache_put(&context_cache_encoders, encoder) != 0) {
+        encoder_release(encoder);
+    }
+    
+    return RKMPP_OK;
+}
+
+RkmppStatus rkmpp_encoder_reconfigure(
+    RkmppEncoder* encoder,
+    uint32_t width,
+    uint32_t height,
+    uint32_t quality)
+{
+    SceneDetector scene;
+    uint32_t rc_quality = 0;
+    int resized = 0;
+    int ret = 0;
+    
+    if (!encoder) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+    
+    if (validate_frame_size(width, height, encoder->input_format) != 0) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+    
+    if (quality > 100) {
+        LOG_ERROR("Invalid quality: %u (should be 0-100)", quality);
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+    
+    if (!encoder->initialized) {
+        return RKMPP_ERR_INIT;
     }
     
+    pthread_mutex_lock(&encoder->lock);
+    
+    /* Everything that can fail runs before the encoder changes */
+    memset(&scene, 0, sizeof(scene));
+    if (encoder->scene.threshold > 0 &&
+        scene_init(&scene, width, height, encoder->scene.threshold) != 0) {
+        LOG_ERROR("failed to allocate static scene detection");
+        pthread_mutex_unlock(&encoder->lock);
+        return RKMPP_ERR_MEMORY;
+    }
+    
+    if (encoder->backend == RKMPP_BACKEND_CPU) {
+        int swap = transform_swaps_axes(encoder->transform);
+        
+        ret = jpeg_encoder_resize(encoder->jpeg, swap ? height : width, swap ? width : height);
+        if (ret != 0) {
+            LOG_ERROR("failed to resize encoder buffers");
+            scene_release(&scene);
+            pthread_mutex_unlock(&encoder->lock);
+            return RKMPP_ERR_MEMORY;
+        }
+    }
+    
+    resized = width != encoder->width || height != encoder->height;
+    encoder->width = width;
+    encoder->height = height;
+    if (quality > 0) {
+        encoder->quality = quality;
+        rc_set_quality(&encoder->rc, quality);
+    }
+    
+    /* Size history of the old resolution says nothing about the new one.
+     * Rate control restarts its window, as on a new stream, but carries
+     * the quality it had reached. */
+    if (resized) {
+        rc_quality = encoder->rc.quality;
+        rc_init(&encoder->rc, encoder->rc.mode, encoder->rc.bitrate, encoder->rc.fps,
+                encoder->rc.window_len, encoder->quality);
+        encoder->rc.quality = rc_quality;
+    }
+    encoder->size_complexity = 0.0;
+    scene_release(&encoder->scene);
+    encoder->scene = scene;
+    encoder->last_jpeg_len = 0;
+    
+    /* The MPP context and buffer groups stay; only the frame setup changes */
+    ret = encoder_configure(encoder);
+    
     pthread_mutex_unlock(&encoder->lock);
-    pthread_mutex_destroy(&encoder->lock);
     
-    free(encoder);
+    if (ret != 0) {
+        LOG_ERROR("failed to configure encoder");
+        return RKMPP_ERR_INIT;
+    }
+    
+    LOG_INFO("MJPEG Encoder reconfigured: %ux%u, quality=%u",
+             encoder->width, encoder->height, encoder->quality);
     
     return RKMPP_OK;
 }
@@ -200,6 +575,25 @@ RkmppStatus rkmpp_encoder_encode(
     uint32_t jpeg_size,
     uint32_t* jpeg_len)
 {
+    return rkmpp_encoder_encode_ex(encoder, nv12_data, nv12_size,
+                                   jpeg_data, jpeg_size, jpeg_len, NULL, NULL);
+}
+
+RkmppStatus rkmpp_encoder_encode_ex(
+    RkmppEncoder* encoder,
+    const uint8_t* nv12_data,
+    uint32_t nv12_size,
+    uint8_t* jpeg_data,
+    uint32_t jpeg_size,
+    uint32_t* jpeg_len,
+    const RkmppEncodeParams* params,
+    RkmppEncodeResult* result)
+{
+    uint32_t max_size = params ? params->max_size : 0;
+    uint32_t quality = 0;
+    uint32_t passes = 1;
+    int ret = 0;
+    
     if (!encoder || !nv12_data || !jpeg_data || !jpeg_len) {
         return RKMPP_ERR_INVALID_PARAM;
     }
@@ -208,41 +602,159 @@ RkmppStatus rkmpp_encoder_encode(
         return RKMPP_ERR_INIT;
     }
     
-    uint32_t expected_size = calculate_nv12_size(encoder->width, encoder->height);
+    uint32_t expected_size = rkmpp_get_frame_size(encoder->input_format,
+                                                  encoder->width, encoder->height);
     if (nv12_size < expected_size) {
-        fprintf(stderr, "Error: NV12 buffer too small: %u < %u\n", nv12_size, expected_size);
+        LOG_ERROR("%s buffer too small: %u < %u",
+                  format_name(encoder->input_format), nv12_size, expected_size);
         return RKMPP_ERR_INVALID_PARAM;
     }
     
-    if (jpeg_size < expected_size) {
-        fprintf(stderr, "Error: JPEG output buffer too small: %u\n", jpeg_size);
+    /* The software encoder reports overflow itself */
+    if (encoder->backend == RKMPP_BACKEND_MPP && jpeg_size < expected_size) {
+        LOG_ERROR("JPEG output buffer too small: %u", jpeg_size);
         return RKMPP_ERR_INVALID_PARAM;
     }
     
     pthread_mutex_lock(&encoder->lock);
     
-    /* In a real implementation, this would:
-     * 1. Create MppFrame from NV12 data
-     * 2. Put frame to encoder via mpi->encode_put_frame
-     * 3. Get encoded packet via mpi->encode_get_packet
-     * 4. Copy packet data to jpeg_data
-     * 5. Update statistics
-     */
+    /* A static frame repeats the last JPEG if it fits where the frame would */
+    if (encoder->scene.threshold > 0) {
+        JpegPlane luma;
+        uint32_t limit = max_size > 0 && max_size < jpeg_size ? max_size : jpeg_size;
+        
+        encoder_luma(encoder, nv12_data, &luma);
+        if (scene_check(&encoder->scene, &luma) && encoder->last_jpeg_len <= limit) {
+            memcpy(jpeg_data, encoder->last_jpeg, encoder->last_jpeg_len);
+            *jpeg_len = encoder->last_jpeg_len;
+            
+            /* Changes under the threshold are in no caller's dirty map:
+             * the next frame is transformed whole */
+            if (encoder->jpeg && encoder->jpeg->keep_levels) {
+                encoder->jpeg->coefs_valid = 0;
+            }
+            
+            rc_update(&encoder->rc, encoder->last_quality, *jpeg_len);
+            encoder->frames_encoded++;
+            encoder->bytes_encoded += *jpeg_len;
+            
+            if (result) {
+                result->quality = encoder->last_quality;
+                result->passes = 0;
+                result->duplicate = 1;
+            }
+            
+            pthread_mutex_unlock(&encoder->lock);
+            return RKMPP_OK;
+        }
+    }
     
-    /* Mock implementation: simulate JPEG encoding */
-    /* Copy first part of NV12 as mock JPEG (in real code, actual encoding happens) */
-    uint32_t copy_size = (jpeg_size < nv12_size) ? jpeg_size : nv12_size;
-    memcpy(jpeg_data, nv12_data, copy_size);
-    *jpeg_len = copy_size;
+    /* Transform once; every quality pass reuses the coefficients */
+    if (encoder->backend == RKMPP_BACKEND_CPU) {
+        const uint8_t* dirty_map = params ? params->dirty_map : NULL;
+        
+        /* Partial updates need the levels of the frame being patched */
+        if (dirty_map && jpeg_encoder_keep_levels(encoder->jpeg) != 0) {
+            LOG_ERROR("failed to allocate partial update buffers");
+            pthread_mutex_unlock(&encoder->lock);
+            return RKMPP_ERR_MEMORY;
+        }
+        encoder_transform(encoder, nv12_data, dirty_map);
+    }
+    
+    if (max_size > 0) {
+        ret = encoder_encode_to_size(encoder, nv12_data, nv12_size, jpeg_data,
+                                     jpeg_size < max_size ? jpeg_size : max_size,
+                                     jpeg_len, &quality, &passes);
+        if (ret != 0) {
+            LOG_ERROR("no quality fits the %u byte budget", max_size);
+        }
+    } else {
+        quality = encoder->rc.quality;
+        ret = encoder_encode_pass(encoder, nv12_data, nv12_size, jpeg_data, jpeg_size,
+                                  quality, jpeg_len);
+        if (ret != 0) {
+            LOG_ERROR("JPEG output buffer too small: %u", jpeg_size);
+        }
+    }
+    
+    if (ret != 0) {
+        pthread_mutex_unlock(&encoder->lock);
+        return RKMPP_ERR_ENCODE;
+    }
+    
+    /* Without a copy to repeat, the next frame is compared afresh */
+    if (encoder->scene.threshold > 0) {
+        if (encoder_keep_jpeg(encoder, jpeg_data, *jpeg_len, quality) == 0) {
+            scene_commit(&encoder->scene);
+        } else {
+            scene_reset(&encoder->scene);
+        }
+    }
+    
+    rc_update(&encoder->rc, quality, *jpeg_len);
     
     encoder->frames_encoded++;
-    encoder->bytes_encoded += copy_size;
+    encoder->bytes_encoded += *jpeg_len;
+    
+    if (result) {
+        result->quality = quality;
+        result->passes = passes;
+        result->duplicate = 0;
+    }
+    
+    pthread_mutex_unlock(&encoder->lock);
+    
+    return RKMPP_OK;
+}
+
+RkmppStatus rkmpp_encoder_set_quality(RkmppEncoder* encoder, uint32_t quality)
+{
+    if (!encoder || quality < 1 || quality > 100) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+    
+    pthread_mutex_lock(&encoder->lock);
+    
+    encoder->quality = quality;
+    rc_set_quality(&encoder->rc, quality);
+    scene_reset(&encoder->scene);
     
     pthread_mutex_unlock(&encoder->lock);
     
     return RKMPP_OK;
 }
 
+RkmppStatus rkmpp_encoder_set_bitrate(RkmppEncoder* encoder, uint32_t bitrate)
+{
+    if (!encoder) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+    
+    pthread_mutex_lock(&encoder->lock);
+    
+    encoder->bitrate = bitrate;
+    rc_set_bitrate(&encoder->rc, bitrate);
+    scene_reset(&encoder->scene);
+    
+    pthread_mutex_unlock(&encoder->lock);
+    
+    return RKMPP_OK;
+}
+
+RkmppStatus rkmpp_encoder_get_quality(RkmppEncoder* encoder, uint32_t* quality)
+{
+    if (!encoder || !quality) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+    
+    pthread_mutex_lock(&encoder->lock);
+    *quality = encoder->rc.quality;
+    pthread_mutex_unlock(&encoder->lock);
+    
+    return RKMPP_OK;
+}
+
 RkmppStatus rkmpp_encoder_get_stats(
     RkmppEncoder* encoder,
     uint64_t* frames_encoded,
@@ -267,6 +779,34 @@ RkmppStatus rkmpp_encoder_get_stats(
     return RKMPP_OK;
 }
 
+RkmppStatus rkmpp_encoder_get_mcu_grid(
+    RkmppEncoder* encoder,
+    uint32_t* mcu_width,
+    uint32_t* mcu_height,
+    uint32_t* mcus_x,
+    uint32_t* mcus_y)
+{
+    if (!encoder || !mcus_x || !mcus_y) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+    
+    /* The hardware encoder has no coefficients to patch */
+    if (!encoder->initialized || !encoder->jpeg) {
+        return RKMPP_ERR_INIT;
+    }
+    
+    if (mcu_width) {
+        *mcu_width = encoder->jpeg->mcu_width;
+    }
+    if (mcu_height) {
+        *mcu_height = encoder->jpeg->mcu_height;
+    }
+    *mcus_x = encoder->jpeg->mcus_x;
+    *mcus_y = encoder->jpeg->mcus_y;
+    
+    return RKMPP_OK;
+}
+
 /* ============================================================================
  * Internal Implementation Functions
  * ============================================================================ */
@@ -282,14 +822,14 @@ int encoder_init_mpp(struct RkmppEncoder* encoder)
     /* Create MPP context */
     ret = mpp_create(&encoder->mpp_ctx, &encoder->mpi);
     if (ret != 0) {
-        fprintf(stderr, "Error: mpp_create failed\n");
+        LOG_ERROR("mpp_create failed");
         return -1;
     }
     
     /* Initialize encoder */
     ret = mpp_init(encoder->mpp_ctx, MPP_VIDEO_CodingMJPEG, 1);
     if (ret != 0) {
-        fprintf(stderr, "Error: mpp_init failed\n");
+        LOG_ERROR("mpp_init failed");
         mpp_destroy(encoder->mpp_ctx);
         return -1;
     }
@@ -297,14 +837,14 @@ int encoder_init_mpp(struct RkmppEncoder* encoder)
     /* Get buffer groups */
     ret = mpp_buffer_group_get_internal(&encoder->frame_group, 0);
     if (ret != 0) {
-        fprintf(stderr, "Error: failed to get frame buffer group\n");
+        LOG_ERROR("failed to get frame buffer group");
         mpp_destroy(encoder->mpp_ctx);
         return -1;
     }
     
     ret = mpp_buffer_group_get_internal(&encoder->packet_group, 1);
     if (ret != 0) {
-        fprintf(stderr, "Error: failed to get packet buffer group\n");
+        LOG_ERROR("failed to get packet buffer group");
         mpp_buffer_group_put(encoder->frame_group);
         mpp_destroy(encoder->mpp_ctx);
         return -1;
@@ -320,25 +860,205 @@ int encoder_configure(struct RkmppEncoder* encoder)
     }
     
     /* In real implementation, configure:
-     * - Input format: NV12
+     * - Input format: NV12 (YUV420SP), NV16 (YUV422SP), YUYV, YUV400 or RGB
      * - Output format: MJPEG
      * - Resolution
      * - FPS
-     * - Quality/Bitrate
-     * - RC mode
      */
     
-    printf("Encoder configured: NV12 -> MJPEG\n");
+    /* Quality is driven per frame by the shared rate controller */
+    if (encoder->mpp_ctx) {
+        mpp_enc_set_quality(encoder->mpp_ctx, encoder->rc.quality);
+        encoder->hw_quality = encoder->rc.quality;
+    }
+    
+    LOG_INFO("Encoder configured: %s -> MJPEG", format_name(encoder->input_format));
     
     return 0;
 }
 
+int encoder_encode_pass(
+    struct RkmppEncoder* encoder,
+    const uint8_t* nv12_data,
+    uint32_t nv12_size,
+    uint8_t* out,
+    uint32_t out_size,
+    uint32_t quality,
+    uint32_t* out_len)
+{
+    if (encoder->backend == RKMPP_BACKEND_CPU) {
+        if (jpeg_encoder_set_quality(encoder->jpeg, quality) != 0) {
+            return -1;
+        }
+        return jpeg_encoder_write(encoder->jpeg, out, out_size, out_len);
+    }
+    
+    /* Reprogram quantization only when it moved */
+    if (quality != encoder->hw_quality) {
+        mpp_enc_set_quality(encoder->mpp_ctx, quality);
+        encoder->hw_quality = quality;
+    }
+    
+    /* In a real implementation, this would:
+     * 1. Create MppFrame from NV12 data
+     * 2. Put frame to encoder via mpi->encode_put_frame
+     * 3. Get encoded packet via mpi->encode_get_packet
+     * 4. Copy packet data to jpeg_data
+     */
+    
+    /* Mock implementation: simulate JPEG encoding */
+    /* Copy first part of NV12 as mock JPEG (in real code, actual encoding happens) */
+    uint32_t copy_size = (out_size < nv12_size) ? out_size : nv12_size;
+    memcpy(out, nv12_data, copy_size);
+    *out_len = copy_size;
+    
+    return 0;
+}
+
+int encoder_encode_to_size(
+    struct RkmppEncoder* encoder,
+    const uint8_t* nv12_data,
+    uint32_t nv12_size,
+    uint8_t* out,
+    uint32_t budget,
+    uint32_t* out_len,
+    uint32_t* quality,
+    uint32_t* passes)
+{
+    uint32_t ceiling = encoder->rc.quality;
+    uint32_t q = ceiling;
+    uint32_t best_quality = 0;
+    uint32_t best_len = 0;
+    uint32_t prev_quality = 0;
+    uint32_t prev_len = 0;
+    double exponent = RC_MODEL_EXPONENT;
+    double margin = TARGET_SIZE_MARGIN;
+    double complexity = encoder->size_complexity;
+    uint32_t pass = 0;
+    
+    /* First guess from the size model of previous frames */
+    if (complexity > 0.0) {
+        q = rc_model_quality(complexity, budget * TARGET_SIZE_MARGIN, exponent);
+        if (q > ceiling) {
+            q = ceiling;
+        }
+    }
+    
+    for (pass = 1; pass <= TARGET_SIZE_MAX_PASSES; pass++) {
+        /* Never overwrite an image that already fits */
+        uint8_t* dst = out;
+        uint32_t len = 0;
+        uint32_t next = 0;
+        int ret = 0;
+        
+        if (best_len > 0) {
+            if (encoder->scratch_size < budget) {
+                uint8_t* scratch = (uint8_t*)realloc(encoder->scratch, budget);
+                if (!scratch) {
+                    break;
+                }
+                encoder->scratch = scratch;
+                encoder->scratch_size = budget;
+            }
+            dst = encoder->scratch;
+        }
+        
+        ret = encoder_encode_pass(encoder, nv12_data, nv12_size, dst, budget, q, &len);
+        
+        /* Two measurements pin down the exponent of this frame */
+        if (prev_len > 0 && prev_quality != q && prev_len != len) {
+            double fitted = log((double)prev_len / len) /
+                            log(rc_model_scale(q) / rc_model_scale(prev_quality));
+            if (fitted > 0.3 && fitted < 1.5) {
+                exponent = fitted;
+            }
+        }
+        complexity = rc_model_complexity(q, len, exponent);
+        encoder->size_complexity = rc_model_complexity(q, len, RC_MODEL_EXPONENT);
+        
+        if (ret == 0) {
+            if (dst != out) {
+                memcpy(out, dst, len);
+            }
+            best_quality = q;
+            best_len = len;
+            
+            /* Close enough to the budget, or nothing better to try */
+            if (q >= ceiling || len >= budget * TARGET_SIZE_SLACK) {
+                break;
+            }
+            next = rc_model_quality(complexity, budget * TARGET_SIZE_MARGIN, exponent);
+            if (next > ceiling) {
+                next = ceiling;
+            }
+            if (next <= q) {
+                break;
+            }
+        } else {
+            /* A better image already fits: keep it */
+            if (best_len > 0 || q <= 1) {
+                break;
+            }
+            
+            /* Each miss widens the margin: the model flattens out at low quality */
+            margin *= TARGET_SIZE_MARGIN;
+            next = rc_model_quality(complexity, budget * margin, exponent);
+            if (next >= q) {
+                next = q - 1;
+            }
+        }
+        
+        prev_quality = q;
+        prev_len = len;
+        q = next;
+    }
+    
+    if (best_len == 0) {
+        return -1;
+    }
+    
+    *out_len = best_len;
+    *quality = best_quality;
+    *passes = pass > TARGET_SIZE_MAX_PASSES ? TARGET_SIZE_MAX_PASSES : pass;
+    
+    return 0;
+}
+
+void encoder_release(struct RkmppEncoder* encoder)
+{
+    pthread_mutex_lock(&encoder->lock);
+    
+    if (encoder->initialized) {
+        encoder_cleanup_mpp(encoder);
+    }
+    
+    pthread_mutex_unlock(&encoder->lock);
+    pthread_mutex_destroy(&encoder->lock);
+    
+    free(encoder);
+}
+
 void encoder_cleanup_mpp(struct RkmppEncoder* encoder)
 {
     if (!encoder) {
         return;
     }
     
+    if (encoder->jpeg) {
+        jpeg_encoder_destroy(encoder->jpeg);
+        encoder->jpeg = NULL;
+    }
+    
+    free(encoder->scratch);
+    encoder->scratch = NULL;
+    encoder->scratch_size = 0;
+    
+    scene_release(&encoder->scene);
+    free(encoder->last_jpeg);
+    encoder->last_jpeg = NULL;
+    encoder->last_jpeg_len = 0;
+    encoder->last_jpeg_size = 0;
+    
     if (encoder->packet_group) {
         mpp_buffer_group_put(encoder->packet_group);
         encoder->packet_group = NULL;
@@ -419,3 +1139,9 @@ static int mpp_packet_deinit(MppPacket* packet)
     /* Mock implementation */
     return 0;
 }
+
+static int mpp_enc_set_quality(MppCtx* ctx, uint32_t quality)
+{
+    /* Mock implementation: real code sets jpeg:quant via MPP_ENC_SET_CFG */
+    return 0;
+}
@@ -8,6 +8,15 @@
 #include <stdint.h>
 #include <pthread.h>
 
+#include "jpeg_encoder_internal.h"
+#include "rate_control_internal.h"
+#include "scene_detect_internal.h"
+
+/* Target-size search */
+#define TARGET_SIZE_MAX_PASSES  3      /* First guess plus two re-quantizations */
+#define TARGET_SIZE_MARGIN      0.95   /* Aim below the budget */
+#define TARGET_SIZE_SLACK       0.85   /* Retry higher when a fit uses less */
+
 /* Forward declaration */
 typedef struct MppCtx MppCtx;
 typedef struct MppApi MppApi;
@@ -32,6 +41,28 @@ struct RkmppEncoder {
     uint32_t fps;
     uint32_t bitrate;
     uint32_t quality;
+    uint32_t backend;
+    uint32_t input_format;             /* RkmppFormat */
+    uint32_t transform;                /* RkmppTransform applied to the input */
+    
+    /* Software encoder (CPU backend) */
+    JpegEncoder* jpeg;
+    
+    /* Rate control */
+    RateControl rc;
+    uint32_t hw_quality;               /* Quality last programmed into MPP */
+    
+    /* Target-size encoding */
+    double size_complexity;            /* Size model from the last fitted frame */
+    uint8_t* scratch;                  /* Holds a retry while a fitting image is kept */
+    uint32_t scratch_size;
+    
+    /* Static scene detection (scene.threshold 0 = off) */
+    SceneDetector scene;
+    uint8_t* last_jpeg;                /* Last encoded JPEG, repeated for static frames */
+    uint32_t last_jpeg_len;
+    uint32_t last_jpeg_size;
+    uint32_t last_quality;
     
     /* Statistics */
     uint64_t frames_encoded;
@@ -55,9 +86,31 @@ int encoder_init_mpp(struct RkmppEncoder* encoder);
  */
 int encoder_configure(struct RkmppEncoder* encoder);
 
+/**
+ * Encode the current frame at one quality
+ *
+ * The CPU backend re-quantizes the coefficients cached by the last
+ * transform; the MPP backend resubmits the frame.
+ */
+int encoder_encode_pass(struct RkmppEncoder* encoder, const uint8_t* nv12_data,
+                        uint32_t nv12_size, uint8_t* out, uint32_t out_size,
+                        uint32_t quality, uint32_t* out_len);
+
+/**
+ * Encode at the highest quality (up to the current one) that fits budget
+ */
+int encoder_encode_to_size(struct RkmppEncoder* encoder, const uint8_t* nv12_data,
+                           uint32_t nv12_size, uint8_t* out, uint32_t budget,
+                           uint32_t* out_len, uint32_t* quality, uint32_t* passes);
+
 /**
  * Cleanup encoder resources
  */
 void encoder_cleanup_mpp(struct RkmppEncoder* encoder);
 
+/**
+ * Tear an encoder down for good (the context cache's destructor)
+ */
+void encoder_release(struct RkmppEncoder* encoder);
+
 #endif /* ENCODER_INTERNAL_H */
@@ -0,0 +1,896 @@
+/*
+ * Batched File Sink Implementation
+ *
+ * Writes encoded packets to individual files. File creation, the write and
+ * the close are chained in io_uring so a whole batch of snapshots costs a
+ * single system call; kernels without io_uring fall back to a pool of
+ * threads doing open/pwrite/close.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#ifdef RKMPP_HAVE_IO_URING
+#include <linux/io_uring.h>
+#endif
+
+#include "rkmpp_mjpeg.h"
+#include "file_sink_internal.h"
+#include "log_internal.h"
+
+#define SINK_DEFAULT_BUFFERS     16
+#define SINK_DEFAULT_BUFFER_SIZE (1024 * 1024)
+#define SINK_DEFAULT_BATCH       8
+#define SINK_DEFAULT_THREADS     4
+#define SINK_MAX_BUFFERS         1024
+#define SINK_MAX_THREADS         64
+#define SINK_PAGE_SIZE           4096
+
+#define SINK_FILE_MODE           0644
+#define SINK_OPEN_FLAGS          (O_WRONLY | O_CREAT | O_TRUNC)
+
+/* io_uring user_data layout: slot index << 2 | operation */
+#define SINK_OP_OPEN  0
+#define SINK_OP_WRITE 1
+#define SINK_OP_CLOSE 2
+#define SINK_OPS_PER_FILE 3
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+/**
+ * Monotonic clock in microseconds
+ */
+static uint64_t sink_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+/**
+ * Validate sink configuration
+ */
+static int validate_sink_config(const RkmppFileSinkConfig* config)
+{
+    if (config->engine > RKMPP_SINK_ENGINE_THREADS) {
+        LOG_ERROR("Invalid sink engine: %u", config->engine);
+        return -1;
+    }
+
+    if (config->num_buffers > SINK_MAX_BUFFERS) {
+        LOG_ERROR("Invalid sink buffer count: %u (max %u)",
+                  config->num_buffers, SINK_MAX_BUFFERS);
+        return -1;
+    }
+
+    if (config->num_threads > SINK_MAX_THREADS) {
+        LOG_ERROR("Invalid sink thread count: %u (max %u)",
+                  config->num_threads, SINK_MAX_THREADS);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Record the outcome of one file (lock held)
+ */
+static void sink_complete_slot(struct RkmppFileSink* sink, uint32_t index)
+{
+    SinkSlot* slot = &sink->slots[index];
+    uint64_t latency = sink_now_us() - slot->submit_us;
+
+    if (slot->failed) {
+        sink->write_errors++;
+        sink->errors_since_flush++;
+    } else {
+        int bucket = latency ? 64 - __builtin_clzll(latency) : 0;
+
+        sink->files_written++;
+        sink->bytes_written += slot->length;
+        sink->latency_sum_us += latency;
+        sink->latency_hist[bucket]++;
+
+        if (sink->files_written == 1 || latency < sink->latency_min_us) {
+            sink->latency_min_us = latency;
+        }
+        if (latency > sink->latency_max_us) {
+            sink->latency_max_us = latency;
+        }
+    }
+
+    free(slot->path);
+    slot->path = NULL;
+    slot->state = SINK_SLOT_FREE;
+    sink->free_list[sink->free_count++] = index;
+    sink->in_flight--;
+}
+
+/* ============================================================================
+ * io_uring Engine
+ * ============================================================================ */
+
+#ifdef RKMPP_HAVE_IO_URING
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params* p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                              unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                        flags, NULL, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, const void* arg,
+                                 unsigned nr_args)
+{
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/**
+ * Check the kernel supports direct-descriptor open/write/close chains
+ */
+static int sink_uring_probe(int fd, const struct io_uring_params* params)
+{
+    static const int required_ops[] = {
+        IORING_OP_OPENAT, IORING_OP_WRITE_FIXED, IORING_OP_CLOSE
+    };
+    size_t len = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe* probe = NULL;
+    int ret = 0;
+
+    /* Direct descriptors for openat/close arrived in 5.15; CQE_SKIP in 5.17 */
+    if (!(params->features & IORING_FEAT_CQE_SKIP) ||
+        !(params->features & IORING_FEAT_SINGLE_MMAP)) {
+        return -1;
+    }
+
+    probe = (struct io_uring_probe*)calloc(1, len);
+    if (!probe) {
+        return -1;
+    }
+
+    if (sys_io_uring_register(fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+        free(probe);
+        return -1;
+    }
+
+    for (size_t i = 0; i < sizeof(required_ops) / sizeof(required_ops[0]); i++) {
+        int op = required_ops[i];
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+            ret = -1;
+            break;
+        }
+    }
+
+    free(probe);
+    return ret;
+}
+
+int sink_uring_init(struct RkmppFileSink* sink)
+{
+    struct io_uring_params params;
+    SinkRing* ring = &sink->ring;
+    struct iovec* iovecs = NULL;
+    int* files = NULL;
+    unsigned entries = 1;
+
+    while (entries < sink->num_buffers * SINK_OPS_PER_FILE) {
+        entries <<= 1;
+    }
+
+    memset(&params, 0, sizeof(params));
+    ring->fd = sys_io_uring_setup(entries, &params);
+    if (ring->fd < 0) {
+        ring->fd = -1;
+        return -1;
+    }
+
+    if (sink_uring_probe(ring->fd, &params) != 0) {
+        goto fail;
+    }
+
+    /* Map submission and completion rings (single mmap) */
+    ring->sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    if (params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe) > ring->sq_len) {
+        ring->sq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    }
+
+    ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        ring->sq_ptr = NULL;
+        goto fail;
+    }
+    ring->cq_ptr = ring->sq_ptr;
+
+    ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqes_len,
+                                            PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_POPULATE,
+                                            ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        goto fail;
+    }
+
+    ring->sq_head = (unsigned*)((uint8_t*)ring->sq_ptr + params.sq_off.head);
+    ring->sq_tail = (unsigned*)((uint8_t*)ring->sq_ptr + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)((uint8_t*)ring->sq_ptr + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)((uint8_t*)ring->sq_ptr + params.sq_off.array);
+    ring->cq_head = (unsigned*)((uint8_t*)ring->cq_ptr + params.cq_off.head);
+    ring->cq_tail = (unsigned*)((uint8_t*)ring->cq_ptr + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)((uint8_t*)ring->cq_ptr + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)((uint8_t*)ring->cq_ptr + params.cq_off.cqes);
+
+    /* Register the packet pool: slot i writes from fixed buffer i */
+    iovecs = (struct iovec*)calloc(sink->num_buffers, sizeof(struct iovec));
+    files = (int*)malloc(sink->num_buffers * sizeof(int));
+    if (!iovecs || !files) {
+        goto fail;
+    }
+
+    for (uint32_t i = 0; i < sink->num_buffers; i++) {
+        iovecs[i].iov_base = sink->slots[i].data;
+        iovecs[i].iov_len = sink->buffer_size;
+        files[i] = -1;
+    }
+
+    if (sys_io_uring_register(ring->fd, IORING_REGISTER_BUFFERS,
+                              iovecs, sink->num_buffers) < 0) {
+        goto fail;
+    }
+
+    /* Sparse direct descriptor table: slot i opens into file index i */
+    if (sys_io_uring_register(ring->fd, IORING_REGISTER_FILES,
+                              files, sink->num_buffers) < 0) {
+        goto fail;
+    }
+
+    free(files);
+    free(iovecs);
+    return 0;
+
+fail:
+    free(files);
+    free(iovecs);
+    sink_uring_cleanup(sink);
+    return -1;
+}
+
+void sink_uring_cleanup(struct RkmppFileSink* sink)
+{
+    SinkRing* ring = &sink->ring;
+
+    if (ring->sqes) {
+        munmap(ring->sqes, ring->sqes_len);
+    }
+
+    if (ring->sq_ptr) {
+        munmap(ring->sq_ptr, ring->sq_len);
+    }
+
+    if (ring->fd >= 0) {
+        /* Closing the ring also closes any direct descriptors left behind */
+        close(ring->fd);
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+/**
+ * Reserve the next submission queue entry
+ */
+static struct io_uring_sqe* sink_uring_get_sqe(SinkRing* ring)
+{
+    unsigned tail = *ring->sq_tail + ring->to_submit;
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+
+    ring->sq_array[index] = index;
+    ring->to_submit++;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+/**
+ * Prepare the open -> write -> close chain for one slot (lock held)
+ */
+static void sink_uring_queue(struct RkmppFileSink* sink, uint32_t index)
+{
+    SinkSlot* slot = &sink->slots[index];
+    struct io_uring_sqe* sqe = NULL;
+
+    sqe = sink_uring_get_sqe(&sink->ring);
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->flags = IOSQE_IO_LINK;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (uint64_t)(uintptr_t)slot->path;
+    sqe->len = SINK_FILE_MODE;
+    sqe->open_flags = SINK_OPEN_FLAGS;     /* O_CLOEXEC is invalid for direct fds */
+    sqe->file_index = index + 1;
+    sqe->user_data = ((uint64_t)index << 2) | SINK_OP_OPEN;
+
+    sqe = sink_uring_get_sqe(&sink->ring);
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->flags = IOSQE_IO_LINK | IOSQE_FIXED_FILE;
+    sqe->fd = (int32_t)index;
+    sqe->addr = (uint64_t)(uintptr_t)slot->data;
+    sqe->len = slot->length;
+    sqe->off = 0;
+    sqe->buf_index = (uint16_t)index;
+    sqe->user_data = ((uint64_t)index << 2) | SINK_OP_WRITE;
+
+    sqe = sink_uring_get_sqe(&sink->ring);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = index + 1;
+    sqe->user_data = ((uint64_t)index << 2) | SINK_OP_CLOSE;
+
+    slot->pending_ops = SINK_OPS_PER_FILE;
+    slot->failed = 0;
+    sink->queued++;
+}
+
+/**
+ * Drain the completion queue (lock held)
+ */
+static void sink_uring_reap(struct RkmppFileSink* sink)
+{
+    SinkRing* ring = &sink->ring;
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+        uint32_t index = (uint32_t)(cqe->user_data >> 2);
+        uint32_t op = (uint32_t)(cqe->user_data & 3);
+        SinkSlot* slot = &sink->slots[index];
+
+        if (cqe->res < 0 ||
+            (op == SINK_OP_WRITE && (uint32_t)cqe->res != slot->length)) {
+            slot->failed = 1;
+        }
+
+        if (--slot->pending_ops == 0) {
+            sink_complete_slot(sink, index);
+        }
+
+        head++;
+    }
+
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/**
+ * Submit prepared chains and optionally wait for completions (lock held)
+ */
+static int sink_uring_enter(struct RkmppFileSink* sink, unsigned min_complete)
+{
+    SinkRing* ring = &sink->ring;
+    unsigned flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+    unsigned submit = 0;
+    int ret = 0;
+
+    if (ring->to_submit) {
+        __atomic_store_n(ring->sq_tail, *ring->sq_tail + ring->to_submit, __ATOMIC_RELEASE);
+        ring->to_submit = 0;
+        sink->in_flight += sink->queued;
+        sink->queued = 0;
+        sink->submissions++;
+    }
+
+    /* Entries the kernel has not consumed yet, including any left by a
+     * previous partial submission */
+    submit = *ring->sq_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+    if (!submit && !min_complete) {
+        return 0;
+    }
+
+    do {
+        ret = sys_io_uring_enter(ring->fd, submit, min_complete, flags);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret < 0) {
+        LOG_ERROR("io_uring_enter failed: %s", strerror(errno));
+        return -1;
+    }
+
+    sink_uring_reap(sink);
+    return 0;
+}
+
+#else /* !RKMPP_HAVE_IO_URING */
+
+int sink_uring_init(struct RkmppFileSink* sink)
+{
+    (void)sink;
+    return -1;
+}
+
+void sink_uring_cleanup(struct RkmppFileSink* sink)
+{
+    sink->ring.fd = -1;
+}
+
+static void sink_uring_queue(struct RkmppFileSink* sink, uint32_t index)
+{
+    (void)sink;
+    (void)index;
+}
+
+static void sink_uring_reap(struct RkmppFileSink* sink)
+{
+    (void)sink;
+}
+
+static int sink_uring_enter(struct RkmppFileSink* sink, unsigned min_complete)
+{
+    (void)sink;
+    (void)min_complete;
+    return -1;
+}
+
+#endif /* RKMPP_HAVE_IO_URING */
+
+/* ============================================================================
+ * Thread-Pool Engine
+ * ============================================================================ */
+
+/**
+ * Write one file with plain system calls
+ */
+static int sink_write_file(const SinkSlot* slot)
+{
+    uint32_t written = 0;
+    int fd = open(slot->path, SINK_OPEN_FLAGS | O_CLOEXEC, SINK_FILE_MODE);
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    while (written < slot->length) {
+        ssize_t ret = pwrite(fd, slot->data + written, slot->length - written, written);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            close(fd);
+            return -1;
+        }
+        written += (uint32_t)ret;
+    }
+
+    return close(fd);
+}
+
+static void* sink_worker(void* arg)
+{
+    struct RkmppFileSink* sink = (struct RkmppFileSink*)arg;
+
+    pthread_mutex_lock(&sink->lock);
+
+    for (;;) {
+        while (sink->job_count == 0 && !sink->stopping) {
+            pthread_cond_wait(&sink->job_cond, &sink->lock);
+        }
+
+        if (sink->job_count == 0) {
+            break;
+        }
+
+        uint32_t index = sink->jobs[sink->job_head];
+        sink->job_head = (sink->job_head + 1) % sink->num_buffers;
+        sink->job_count--;
+
+        pthread_mutex_unlock(&sink->lock);
+        int ret = sink_write_file(&sink->slots[index]);
+        pthread_mutex_lock(&sink->lock);
+
+        sink->slots[index].failed = (ret != 0);
+        sink_complete_slot(sink, index);
+        pthread_cond_broadcast(&sink->done_cond);
+    }
+
+    pthread_mutex_unlock(&sink->lock);
+    return NULL;
+}
+
+int sink_threads_init(struct RkmppFileSink* sink)
+{
+    sink->jobs = (uint32_t*)calloc(sink->num_buffers, sizeof(uint32_t));
+    sink->threads = (pthread_t*)calloc(sink->num_threads, sizeof(pthread_t));
+    if (!sink->jobs || !sink->threads) {
+        free(sink->jobs);
+        free(sink->threads);
+        sink->jobs = NULL;
+        sink->threads = NULL;
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < sink->num_threads; i++) {
+        if (pthread_create(&sink->threads[i], NULL, sink_worker, sink) != 0) {
+            LOG_ERROR("failed to start sink worker %u", i);
+            sink->num_threads = i;
+            sink_threads_cleanup(sink);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void sink_threads_cleanup(struct RkmppFileSink* sink)
+{
+    pthread_mutex_lock(&sink->lock);
+    sink->stopping = 1;
+    sink->job_count += sink->job_pending;
+    sink->job_pending = 0;
+    pthread_cond_broadcast(&sink->job_cond);
+    pthread_mutex_unlock(&sink->lock);
+
+    for (uint32_t i = 0; sink->threads && i < sink->num_threads; i++) {
+        pthread_join(sink->threads[i], NULL);
+    }
+
+    free(sink->threads);
+    free(sink->jobs);
+    sink->threads = NULL;
+    sink->jobs = NULL;
+}
+
+/**
+ * Make held-back jobs visible to the workers (lock held)
+ */
+static void sink_threads_release(struct RkmppFileSink* sink)
+{
+    if (sink->job_pending == 0) {
+        return;
+    }
+
+    sink->job_count += sink->job_pending;
+    sink->job_pending = 0;
+    sink->submissions++;
+    pthread_cond_broadcast(&sink->job_cond);
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+RkmppFileSink* rkmpp_file_sink_create(const RkmppFileSinkConfig* config)
+{
+    RkmppFileSinkConfig defaults;
+    RkmppFileSink* sink = NULL;
+
+    memset(&defaults, 0, sizeof(defaults));
+    if (!config) {
+        config = &defaults;
+    }
+
+    if (validate_sink_config(config) != 0) {
+        LOG_ERROR("invalid file sink configuration");
+        return NULL;
+    }
+
+    sink = (RkmppFileSink*)malloc(sizeof(RkmppFileSink));
+    if (!sink) {
+        LOG_ERROR("failed to allocate file sink structure");
+        return NULL;
+    }
+
+    memset(sink, 0, sizeof(RkmppFileSink));
+    sink->ring.fd = -1;
+
+    pthread_mutex_init(&sink->lock, NULL);
+    pthread_cond_init(&sink->job_cond, NULL);
+    pthread_cond_init(&sink->done_cond, NULL);
+
+    /* Store configuration */
+    sink->num_buffers = config->num_buffers ? config->num_buffers : SINK_DEFAULT_BUFFERS;
+    sink->buffer_size = config->buffer_size ? config->buffer_size : SINK_DEFAULT_BUFFER_SIZE;
+    sink->batch_size = config->batch_size ? config->batch_size : SINK_DEFAULT_BATCH;
+    sink->num_threads = config->num_threads ? config->num_threads : SINK_DEFAULT_THREADS;
+    if (sink->batch_size > sink->num_buffers) {
+        sink->batch_size = sink->num_buffers;
+    }
+
+    /* Allocate the packet pool as one page-aligned region */
+    sink->buffer_stride = ((size_t)sink->buffer_size + SINK_PAGE_SIZE - 1) &
+                          ~(size_t)(SINK_PAGE_SIZE - 1);
+    sink->slots = (SinkSlot*)calloc(sink->num_buffers, sizeof(SinkSlot));
+    sink->free_list = (uint32_t*)calloc(sink->num_buffers, sizeof(uint32_t));
+    if (!sink->slots || !sink->free_list ||
+        posix_memalign((void**)&sink->pool, SINK_PAGE_SIZE,
+                       sink->buffer_stride * sink->num_buffers) != 0) {
+        LOG_ERROR("failed to allocate sink packet pool");
+        sink->pool = NULL;
+        goto fail;
+    }
+
+    for (uint32_t i = 0; i < sink->num_buffers; i++) {
+        sink->slots[i].data = sink->pool + sink->buffer_stride * i;
+        sink->free_list[i] = sink->num_buffers - 1 - i;
+    }
+    sink->free_count = sink->num_buffers;
+
+    /* Pick the engine */
+    if (config->engine != RKMPP_SINK_ENGINE_THREADS && sink_uring_init(sink) == 0) {
+        sink->engine = RKMPP_SINK_ENGINE_IO_URING;
+    } else if (config->engine == RKMPP_SINK_ENGINE_IO_URING) {
+        LOG_ERROR("io_uring is not available");
+        goto fail;
+    } else if (sink_threads_init(sink) == 0) {
+        sink->engine = RKMPP_SINK_ENGINE_THREADS;
+    } else {
+        LOG_ERROR("failed to start sink threads");
+        goto fail;
+    }
+
+    return sink;
+
+fail:
+    free(sink->pool);
+    free(sink->free_list);
+    free(sink->slots);
+    pthread_cond_destroy(&sink->done_cond);
+    pthread_cond_destroy(&sink->job_cond);
+    pthread_mutex_destroy(&sink->lock);
+    free(sink);
+    return NULL;
+}
+
+RkmppStatus rkmpp_file_sink_destroy(RkmppFileSink* sink)
+{
+    RkmppStatus status = RKMPP_OK;
+
+    if (!sink) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    status = rkmpp_file_sink_flush(sink);
+
+    if (sink->engine == RKMPP_SINK_ENGINE_IO_URING) {
+        sink_uring_cleanup(sink);
+    } else {
+        sink_threads_cleanup(sink);
+    }
+
+    for (uint32_t i = 0; i < sink->num_buffers; i++) {
+        free(sink->slots[i].path);
+    }
+
+    free(sink->pool);
+    free(sink->free_list);
+    free(sink->slots);
+    pthread_cond_destroy(&sink->done_cond);
+    pthread_cond_destroy(&sink->job_cond);
+    pthread_mutex_destroy(&sink->lock);
+    free(sink);
+
+    return status;
+}
+
+RkmppStatus rkmpp_file_sink_get_buffer(
+    RkmppFileSink* sink,
+    uint8_t** buffer,
+    uint32_t* capacity)
+{
+    if (!sink || !buffer || !capacity) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&sink->lock);
+
+    while (sink->free_count == 0) {
+        if (sink->queued == 0 && sink->in_flight == 0) {
+            /* Every buffer is held by the caller; waiting would never end */
+            pthread_mutex_unlock(&sink->lock);
+            return RKMPP_ERR_NOT_READY;
+        }
+
+        if (sink->engine == RKMPP_SINK_ENGINE_IO_URING) {
+            /* Everything is queued or in flight: push it out and wait */
+            if (sink_uring_enter(sink, 1) != 0) {
+                pthread_mutex_unlock(&sink->lock);
+                return RKMPP_ERR_UNKNOWN;
+            }
+        } else {
+            sink_threads_release(sink);
+            pthread_cond_wait(&sink->done_cond, &sink->lock);
+        }
+    }
+
+    uint32_t index = sink->free_list[--sink->free_count];
+    sink->slots[index].state = SINK_SLOT_ACQUIRED;
+    *buffer = sink->slots[index].data;
+    *capacity = sink->buffer_size;
+
+    pthread_mutex_unlock(&sink->lock);
+
+    return RKMPP_OK;
+}
+
+RkmppStatus rkmpp_file_sink_submit(
+    RkmppFileSink* sink,
+    const char* path,
+    uint8_t* buffer,
+    uint32_t length)
+{
+    uint32_t index = 0;
+    SinkSlot* slot = NULL;
+
+    if (!sink || !path || !buffer || buffer < sink->pool) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    index = (uint32_t)((size_t)(buffer - sink->pool) / sink->buffer_stride);
+    if (index >= sink->num_buffers || sink->slots[index].data != buffer ||
+        length > sink->buffer_size) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&sink->lock);
+
+    slot = &sink->slots[index];
+    if (slot->state != SINK_SLOT_ACQUIRED) {
+        pthread_mutex_unlock(&sink->lock);
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    slot->path = strdup(path);
+    if (!slot->path) {
+        pthread_mutex_unlock(&sink->lock);
+        return RKMPP_ERR_MEMORY;
+    }
+
+    slot->length = length;
+    slot->state = SINK_SLOT_QUEUED;
+    slot->submit_us = sink_now_us();
+
+    if (sink->engine == RKMPP_SINK_ENGINE_IO_URING) {
+        sink_uring_queue(sink, index);
+        if (sink->queued >= sink->batch_size) {
+            sink_uring_enter(sink, 0);
+        }
+    } else {
+        uint32_t tail = (sink->job_head + sink->job_count + sink->job_pending) % sink->num_buffers;
+        sink->jobs[tail] = index;
+        sink->job_pending++;
+        sink->in_flight++;
+        if (sink->job_pending >= sink->batch_size) {
+            sink_threads_release(sink);
+        }
+    }
+
+    pthread_mutex_unlock(&sink->lock);
+
+    return RKMPP_OK;
+}
+
+RkmppStatus rkmpp_file_sink_write(
+    RkmppFileSink* sink,
+    const char* path,
+    const uint8_t* data,
+    uint32_t length)
+{
+    uint8_t* buffer = NULL;
+    uint32_t capacity = 0;
+    RkmppStatus status = RKMPP_OK;
+
+    if (!sink || !path || (!data && length)) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    if (length > sink->buffer_size) {
+        LOG_ERROR("packet larger than sink buffer: %u > %u",
+                  length, sink->buffer_size);
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    status = rkmpp_file_sink_get_buffer(sink, &buffer, &capacity);
+    if (status != RKMPP_OK) {
+        return status;
+    }
+
+    if (length) {
+        memcpy(buffer, data, length);
+    }
+
+    return rkmpp_file_sink_submit(sink, path, buffer, length);
+}
+
+RkmppStatus rkmpp_file_sink_flush(RkmppFileSink* sink)
+{
+    RkmppStatus status = RKMPP_OK;
+
+    if (!sink) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&sink->lock);
+
+    if (sink->engine == RKMPP_SINK_ENGINE_IO_URING) {
+        if (sink->queued && sink_uring_enter(sink, 0) != 0) {
+            status = RKMPP_ERR_UNKNOWN;
+        }
+        while (status == RKMPP_OK && sink->in_flight > 0) {
+            if (sink_uring_enter(sink, 1) != 0) {
+                status = RKMPP_ERR_UNKNOWN;
+            }
+        }
+    } else {
+        sink_threads_release(sink);
+        while (sink->in_flight > 0) {
+            pthread_cond_wait(&sink->done_cond, &sink->lock);
+        }
+    }
+
+    if (sink->errors_since_flush) {
+        sink->errors_since_flush = 0;
+        status = RKMPP_ERR_UNKNOWN;
+    }
+
+    pthread_mutex_unlock(&sink->lock);
+
+    return status;
+}
+
+RkmppStatus rkmpp_file_sink_get_stats(
+    RkmppFileSink* sink,
+    RkmppFileSinkStats* stats)
+{
+    if (!sink || !stats) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&sink->lock);
+
+    if (sink->engine == RKMPP_SINK_ENGINE_IO_URING) {
+        sink_uring_reap(sink);
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    stats->engine = sink->engine;
+    stats->files_written = sink->files_written;
+    stats->bytes_written = sink->bytes_written;
+    stats->write_errors = sink->write_errors;
+    stats->submissions = sink->submissions;
+    stats->latency_min_us = sink->latency_min_us;
+    stats->latency_max_us = sink->latency_max_us;
+
+    if (sink->files_written) {
+        uint64_t threshold = (sink->files_written * 99 + 99) / 100;
+        uint64_t seen = 0;
+
+        stats->latency_avg_us = sink->latency_sum_us / sink->files_written;
+
+        for (int i = 0; i < SINK_LATENCY_BUCKETS; i++) {
+            seen += sink->latency_hist[i];
+            if (seen >= threshold) {
+                stats->latency_p99_us = i ? (1ULL << i) - 1 : 0;
+                break;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&sink->lock);
+
+    return RKMPP_OK;
+}
@@ -0,0 +1,133 @@
+/*
+ * Batched File Sink Internal Implementation
+ */
+
+#ifndef FILE_SINK_INTERNAL_H
+#define FILE_SINK_INTERNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+/* Forward declaration (defined by <linux/io_uring.h>) */
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/* Number of power-of-two latency histogram buckets */
+#define SINK_LATENCY_BUCKETS 64
+
+/**
+ * Packet buffer slot states
+ */
+typedef enum {
+    SINK_SLOT_FREE = 0,                /* Available to rkmpp_file_sink_get_buffer */
+    SINK_SLOT_ACQUIRED = 1,            /* Handed out to the caller */
+    SINK_SLOT_QUEUED = 2               /* Submitted, waiting for completion */
+} SinkSlotState;
+
+/**
+ * Packet buffer slot
+ *
+ * With io_uring each slot owns registered buffer <index> and direct file
+ * descriptor <index>, so a whole open/write/close chain needs no lookup.
+ */
+typedef struct {
+    uint8_t* data;                     /* Packet buffer (page aligned) */
+    char* path;                        /* Destination path (owned copy) */
+    uint32_t length;                   /* Bytes to write */
+    uint32_t state;                    /* SinkSlotState */
+    uint64_t submit_us;                /* Submission timestamp */
+    int pending_ops;                   /* io_uring completions still expected */
+    int failed;                        /* Any operation in the chain failed */
+} SinkSlot;
+
+/**
+ * Mapped io_uring instance
+ */
+typedef struct {
+    int fd;                            /* Ring file descriptor (-1 if unused) */
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sq_ptr;                      /* SQ and CQ rings (single mmap) */
+    size_t sq_len;
+    void* cq_ptr;
+    size_t sqes_len;
+    unsigned to_submit;                /* SQEs written but not yet entered */
+} SinkRing;
+
+/**
+ * Internal file sink context structure
+ */
+struct RkmppFileSink {
+    /* Configuration */
+    uint32_t engine;
+    uint32_t num_buffers;
+    uint32_t buffer_size;
+    uint32_t batch_size;
+    uint32_t num_threads;
+
+    /* Packet buffer pool */
+    uint8_t* pool;                     /* num_buffers * buffer_stride bytes */
+    size_t buffer_stride;              /* buffer_size rounded up to a page */
+    SinkSlot* slots;
+    uint32_t* free_list;
+    uint32_t free_count;
+
+    /* io_uring engine */
+    SinkRing ring;
+    uint32_t queued;                   /* Files prepared but not submitted */
+    uint32_t in_flight;                /* Files submitted but not completed */
+
+    /* Thread-pool engine */
+    pthread_t* threads;
+    uint32_t* jobs;                    /* Ring of slot indices */
+    uint32_t job_head;
+    uint32_t job_count;                /* Jobs visible to the workers */
+    uint32_t job_pending;              /* Jobs held back until the batch fills */
+    int stopping;
+    pthread_cond_t job_cond;
+    pthread_cond_t done_cond;
+
+    /* Statistics */
+    uint64_t files_written;
+    uint64_t bytes_written;
+    uint64_t write_errors;
+    uint64_t submissions;
+    uint64_t latency_min_us;
+    uint64_t latency_max_us;
+    uint64_t latency_sum_us;
+    uint64_t latency_hist[SINK_LATENCY_BUCKETS];
+    uint64_t errors_since_flush;
+
+    /* Synchronization */
+    pthread_mutex_t lock;
+};
+
+/**
+ * Set up io_uring, register the buffer pool and a sparse file table
+ */
+int sink_uring_init(struct RkmppFileSink* sink);
+
+/**
+ * Tear down io_uring
+ */
+void sink_uring_cleanup(struct RkmppFileSink* sink);
+
+/**
+ * Start the pwrite worker threads
+ */
+int sink_threads_init(struct RkmppFileSink* sink);
+
+/**
+ * Stop and join the pwrite worker threads
+ */
+void sink_threads_cleanup(struct RkmppFileSink* sink);
+
+#endif /* FILE_SINK_INTERNAL_H */
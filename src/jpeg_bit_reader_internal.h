@@ -0,0 +1,135 @@
+/*
+ * JPEG Bit Reader Internal Implementation
+ *
+ * Entropy-coded segment reader with a 64-bit bit buffer, the counterpart of
+ * jpeg_bit_writer_internal.h. A refill loads eight bytes with one big-endian
+ * read when none of them is 0xFF; otherwise bytes are taken one at a time,
+ * dropping stuffed 0x00 bytes and stopping at the first marker, after which
+ * the buffer is padded with zero bits.
+ */
+
+#ifndef JPEG_BIT_READER_INTERNAL_H
+#define JPEG_BIT_READER_INTERNAL_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Bit reader over one entropy-coded segment
+ *
+ * Pending bits are left-aligned in buf. Bits below the valid ones may hold
+ * a copy of the following stream bytes, which later refills OR in again.
+ */
+typedef struct {
+    const uint8_t* data;
+    uint32_t pos;                      /* Next byte not yet in the buffer */
+    uint32_t size;
+    uint64_t buf;
+    int bits;                          /* Valid bits in buf */
+    int marker;                        /* Set once a marker ended the segment */
+} JpegBitReader;
+
+/* Bytes of v equal to 0xFF, each flagged by its top bit */
+#define JPEG_BR_FF_BYTES(v) \
+    ((~(v) - 0x0101010101010101ull) & (v) & 0x8080808080808080ull)
+
+static inline void jpeg_br_init(JpegBitReader* r, const uint8_t* data, uint32_t pos,
+                                uint32_t size)
+{
+    r->data = data;
+    r->pos = pos;
+    r->size = size;
+    r->buf = 0;
+    r->bits = 0;
+    r->marker = 0;
+}
+
+/**
+ * Top the buffer up to at least 56 valid bits
+ */
+static inline void jpeg_br_refill(JpegBitReader* r)
+{
+    if (r->pos + 8 <= r->size && !r->marker) {
+        uint64_t next;
+
+        memcpy(&next, r->data + r->pos, 8);
+        next = __builtin_bswap64(next);
+        if (!JPEG_BR_FF_BYTES(next)) {
+            r->buf |= next >> r->bits;
+            r->pos += (uint32_t)(63 - r->bits) >> 3;
+            r->bits |= 56;
+            return;
+        }
+    }
+
+    while (r->bits <= 56) {
+        uint8_t byte = 0;
+
+        if (!r->marker && r->pos < r->size) {
+            byte = r->data[r->pos];
+            if (byte != 0xFF) {
+                r->pos++;
+            } else if (r->pos + 1 < r->size && r->data[r->pos + 1] == 0x00) {
+                r->pos += 2;
+            } else {
+                /* Leave pos on the marker */
+                r->marker = 1;
+                byte = 0;
+            }
+        }
+
+        r->buf |= (uint64_t)byte << (56 - r->bits);
+        r->bits += 8;
+    }
+}
+
+/**
+ * Next n bits without consuming them (n 1-32)
+ */
+static inline uint32_t jpeg_br_peek(const JpegBitReader* r, int n)
+{
+    return (uint32_t)(r->buf >> (64 - n));
+}
+
+static inline void jpeg_br_skip(JpegBitReader* r, int n)
+{
+    r->buf <<= n;
+    r->bits -= n;
+}
+
+/**
+ * Consume n bits (n 0-16); the caller keeps the buffer filled
+ */
+static inline uint32_t jpeg_br_get(JpegBitReader* r, int n)
+{
+    uint32_t value = 0;
+
+    if (n) {
+        value = jpeg_br_peek(r, n);
+        jpeg_br_skip(r, n);
+    }
+
+    return value;
+}
+
+/**
+ * Drop buffered bits and step over the next RSTn marker
+ */
+static inline int jpeg_br_restart(JpegBitReader* r)
+{
+    uint32_t pos = r->pos;
+
+    while (pos + 1 < r->size &&
+           !(r->data[pos] == 0xFF && r->data[pos + 1] >= 0xD0 && r->data[pos + 1] <= 0xD7)) {
+        pos++;
+    }
+    if (pos + 1 >= r->size) {
+        return -1;
+    }
+
+    jpeg_br_init(r, r->data, pos + 2, r->size);
+
+    return 0;
+}
+
+#endif /* JPEG_BIT_READER_INTERNAL_H */
@@ -0,0 +1,132 @@
+/*
+ * JPEG Bit Writer Internal Implementation
+ *
+ * Entropy-coded segment writer with a 64-bit accumulator. Codes are shifted
+ * in without per-bit loops; once the accumulator fills, all eight bytes are
+ * stored with one big-endian write unless one of them is 0xFF, in which case
+ * the bytes go out one at a time with a 0x00 stuffed after each 0xFF.
+ */
+
+#ifndef JPEG_BIT_WRITER_INTERNAL_H
+#define JPEG_BIT_WRITER_INTERNAL_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Output writer for headers and entropy-coded data
+ *
+ * The accumulator holds 64 - free_bits pending bits in its low end; bits
+ * above them are stale and are shifted out before they are ever stored.
+ */
+typedef struct {
+    uint8_t* buf;
+    uint32_t pos;
+    uint32_t size;
+    uint64_t acc;
+    int free_bits;                     /* Room left in the accumulator (1-64) */
+    int overflow;                      /* Set once a byte did not fit */
+} JpegBitWriter;
+
+/* Bytes of v equal to 0xFF, each flagged by its top bit */
+#define JPEG_BW_FF_BYTES(v) \
+    ((~(v) - 0x0101010101010101ull) & (v) & 0x8080808080808080ull)
+
+static inline void jpeg_bw_init(JpegBitWriter* w, uint8_t* buf, uint32_t size)
+{
+    w->buf = buf;
+    w->pos = 0;
+    w->size = size;
+    w->acc = 0;
+    w->free_bits = 64;
+    w->overflow = 0;
+}
+
+/**
+ * Append a raw byte (headers and markers; the accumulator must be empty)
+ */
+static inline void jpeg_bw_put_byte(JpegBitWriter* w, uint8_t value)
+{
+    if (w->pos >= w->size) {
+        w->overflow = 1;
+        return;
+    }
+    w->buf[w->pos++] = value;
+}
+
+static inline void jpeg_bw_put_marker(JpegBitWriter* w, uint8_t marker)
+{
+    jpeg_bw_put_byte(w, 0xFF);
+    jpeg_bw_put_byte(w, marker);
+}
+
+/**
+ * Store a full accumulator, stuffing 0x00 after every 0xFF byte
+ */
+static inline void jpeg_bw_store(JpegBitWriter* w, uint64_t acc)
+{
+    if (!JPEG_BW_FF_BYTES(acc) && w->pos + 8 <= w->size) {
+        uint64_t be = __builtin_bswap64(acc);
+
+        memcpy(w->buf + w->pos, &be, 8);
+        w->pos += 8;
+        return;
+    }
+
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        uint8_t byte = (uint8_t)(acc >> shift);
+
+        jpeg_bw_put_byte(w, byte);
+        if (byte == 0xFF) {
+            jpeg_bw_put_byte(w, 0x00);
+        }
+    }
+}
+
+/**
+ * Append the low size bits of code (size 1-32)
+ */
+static inline void jpeg_bw_put_bits(JpegBitWriter* w, uint32_t code, int size)
+{
+    uint64_t bits = code & ((1ull << size) - 1);
+
+    if (size < w->free_bits) {
+        w->acc = (w->acc << size) | bits;
+        w->free_bits -= size;
+        return;
+    }
+
+    /* Top up the accumulator, store it and keep the remainder */
+    w->free_bits = size - w->free_bits;
+    jpeg_bw_store(w, (w->acc << (size - w->free_bits)) | (bits >> w->free_bits));
+    w->acc = bits;
+    w->free_bits = 64 - w->free_bits;
+}
+
+/**
+ * Pad the pending bits to a byte boundary with 1 bits and store them
+ */
+static inline void jpeg_bw_flush(JpegBitWriter* w)
+{
+    int pending = 64 - w->free_bits;
+    int pad = (8 - (pending & 7)) & 7;
+
+    if (pad) {
+        w->acc = (w->acc << pad) | ((1u << pad) - 1);
+        pending += pad;
+    }
+
+    for (int shift = pending - 8; shift >= 0; shift -= 8) {
+        uint8_t byte = (uint8_t)(w->acc >> shift);
+
+        jpeg_bw_put_byte(w, byte);
+        if (byte == 0xFF) {
+            jpeg_bw_put_byte(w, 0x00);
+        }
+    }
+
+    w->acc = 0;
+    w->free_bits = 64;
+}
+
+#endif /* JPEG_BIT_WRITER_INTERNAL_H */
@@ -0,0 +1,1093 @@
+/*
+ * Software JPEG Decoder Implementation
+ *
+ * Baseline sequential (SOF0/SOF1, 8-bit) Huffman JPEG decoder used by the
+ * CPU backend. Huffman symbols are resolved through a lookahead table whose
+ * entries also carry the magnitude bits, so most coefficients cost a single
+ * lookup; blocks are reconstructed with the integer LLM inverse DCT.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jpeg_decoder_internal.h"
+#include "jpeg_bit_reader_internal.h"
+
+/* JFIF YCbCr to RGB (full range, 16-bit fixed point) */
+#define RGB_FIX_BITS    16
+#define FIX_R_CR        ((int32_t)91881)   /* 1.40200 */
+#define FIX_G_CB        ((int32_t)22554)   /* 0.34414 */
+#define FIX_G_CR        ((int32_t)46802)   /* 0.71414 */
+#define FIX_B_CB        ((int32_t)116130)  /* 1.77200 */
+
+/* Integer LLM DCT constants (13-bit fixed point) */
+#define DCT_CONST_BITS  13
+#define DCT_PASS1_BITS  2
+
+#define FIX_0_298631336 ((int32_t)2446)
+#define FIX_0_390180644 ((int32_t)3196)
+#define FIX_0_541196100 ((int32_t)4433)
+#define FIX_0_765366865 ((int32_t)6270)
+#define FIX_0_899976223 ((int32_t)7373)
+#define FIX_1_175875602 ((int32_t)9633)
+#define FIX_1_501321110 ((int32_t)12299)
+#define FIX_1_847759065 ((int32_t)15137)
+#define FIX_1_961570560 ((int32_t)16069)
+#define FIX_2_053119869 ((int32_t)16819)
+#define FIX_2_562915447 ((int32_t)20995)
+#define FIX_3_072711026 ((int32_t)25172)
+
+#define DESCALE(x, n) (((x) + (1 << ((n) - 1))) >> (n))
+
+/* Bits one symbol may need: a 16-bit code plus up to 15 magnitude bits */
+#define HUFF_MAX_SYMBOL_BITS    32
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+static uint32_t read_u16(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 8) | p[1];
+}
+
+/**
+ * Sign-extend the magnitude bits of a coefficient (T.81 F.2.2.1)
+ */
+static int32_t extend(uint32_t bits, int size)
+{
+    if (size == 0) {
+        return 0;
+    }
+
+    return bits < (1u << (size - 1)) ? (int32_t)bits - (int32_t)(1u << size) + 1 : (int32_t)bits;
+}
+
+/**
+ * Keep dequantized coefficients of corrupt data to the 16-bit range that
+ * valid images never leave, so the inverse DCT cannot overflow
+ */
+static int32_t clamp_coef(int32_t value)
+{
+    return value < -32768 ? -32768 : value > 32767 ? 32767 : value;
+}
+
+static uint8_t clamp_sample(int64_t value)
+{
+    return (uint8_t)(value < 0 ? 0 : value > 255 ? 255 : value);
+}
+
+/**
+ * Fill the lookahead entries of one code
+ *
+ * When the magnitude bits fit in the lookahead too, one entry per
+ * magnitude value is stored with the extended coefficient, so decoding
+ * needs no further bit reads.
+ */
+static void fill_fast(JpegHuffDecoder* h, uint32_t code, int len, uint8_t symbol)
+{
+    int size = symbol & 15;
+    int shift = JPEG_HUFF_LOOKAHEAD - len;
+    uint32_t base = code << shift;
+
+    if (len + size <= JPEG_HUFF_LOOKAHEAD) {
+        int free_bits = shift - size;
+
+        for (uint32_t bits = 0; bits < (1u << size); bits++) {
+            int32_t value = extend(bits, size);
+            int32_t entry = (int32_t)(((uint32_t)value << JPEG_HUFF_VALUE_SHIFT) |
+                                      ((uint32_t)symbol << JPEG_HUFF_SYMBOL_SHIFT) |
+                                      JPEG_HUFF_FULL | (uint32_t)(len + size));
+            uint32_t first = base | (bits << free_bits);
+
+            for (uint32_t i = 0; i < (1u << free_bits); i++) {
+                h->fast[first + i] = entry;
+            }
+        }
+    } else {
+        int32_t entry = (int32_t)(((uint32_t)symbol << JPEG_HUFF_SYMBOL_SHIFT) | (uint32_t)len);
+
+        for (uint32_t i = 0; i < (1u << shift); i++) {
+            h->fast[base + i] = entry;
+        }
+    }
+}
+
+/**
+ * Build a decoding table from a DHT specification
+ */
+static int build_huff_decoder(const JpegHuffSpec* spec, JpegHuffDecoder* h)
+{
+    uint32_t code = 0;
+    uint32_t k = 0;
+
+    memset(h, 0, sizeof(JpegHuffDecoder));
+
+    for (int len = 1; len <= 16; len++) {
+        uint32_t count = spec->bits[len];
+
+        h->maxcode[len] = count ? (int32_t)(code + count - 1) : -1;
+        h->valoffset[len] = (int32_t)k - (int32_t)code;
+
+        for (uint32_t i = 0; i < count; i++) {
+            if (k >= 256) {
+                return -1;
+            }
+            h->vals[k] = spec->vals[k];
+            if (len <= JPEG_HUFF_LOOKAHEAD) {
+                fill_fast(h, code, len, spec->vals[k]);
+            }
+            code++;
+            k++;
+        }
+
+        if (code > (1u << len)) {
+            return -1;
+        }
+        code <<= 1;
+    }
+
+    h->maxcode[17] = INT32_MAX;
+    h->valid = 1;
+
+    return 0;
+}
+
+/**
+ * Canonical decode of a code longer than the lookahead
+ */
+static int huff_decode_slow(JpegBitReader* r, const JpegHuffDecoder* h)
+{
+    uint32_t code = jpeg_br_peek(r, 16);
+
+    for (int len = JPEG_HUFF_LOOKAHEAD + 1; len <= 16; len++) {
+        int32_t c = (int32_t)(code >> (16 - len));
+
+        if (c <= h->maxcode[len]) {
+            jpeg_br_skip(r, len);
+            return h->vals[h->valoffset[len] + c];
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Decode one symbol and its coefficient value
+ *
+ * @return Run/size symbol, or -1 for an invalid code
+ */
+static inline int huff_decode(JpegBitReader* r, const JpegHuffDecoder* h, int32_t* value)
+{
+    int32_t entry = 0;
+    int symbol = 0;
+
+    if (r->bits < HUFF_MAX_SYMBOL_BITS) {
+        jpeg_br_refill(r);
+    }
+
+    entry = h->fast[jpeg_br_peek(r, JPEG_HUFF_LOOKAHEAD)];
+
+    /* Code and magnitude in one lookup */
+    if (entry & JPEG_HUFF_FULL) {
+        jpeg_br_skip(r, entry & JPEG_HUFF_LEN_MASK);
+        *value = entry >> JPEG_HUFF_VALUE_SHIFT;
+        return (entry >> JPEG_HUFF_SYMBOL_SHIFT) & 0xFF;
+    }
+
+    if (entry & JPEG_HUFF_LEN_MASK) {
+        jpeg_br_skip(r, entry & JPEG_HUFF_LEN_MASK);
+        symbol = (entry >> JPEG_HUFF_SYMBOL_SHIFT) & 0xFF;
+    } else {
+        symbol = huff_decode_slow(r, h);
+        if (symbol < 0) {
+            return -1;
+        }
+    }
+
+    *value = extend(jpeg_br_get(r, symbol & 15), symbol & 15);
+
+    return symbol;
+}
+
+/**
+ * Decode and dequantize one block into natural order
+ */
+static int decode_block(JpegBitReader* r, const JpegHuffDecoder* dc, const JpegHuffDecoder* ac,
+                        const uint16_t* quant, int32_t* last_dc, int32_t* block)
+{
+    int32_t value = 0;
+    int symbol = huff_decode(r, dc, &value);
+
+    if (symbol < 0 || symbol > 11) {
+        return -1;
+    }
+
+    memset(block, 0, JPEG_BLOCK_SIZE * sizeof(int32_t));
+
+    *last_dc = clamp_coef(*last_dc + value);
+    block[0] = clamp_coef(*last_dc * quant[0]);
+
+    for (int k = 1; k < JPEG_BLOCK_SIZE; k++) {
+        symbol = huff_decode(r, ac, &value);
+        if (symbol < 0) {
+            return -1;
+        }
+
+        if ((symbol & 15) == 0) {
+            if (symbol != 0xF0) {
+                break;                 /* EOB */
+            }
+            k += 15;                   /* ZRL */
+            continue;
+        }
+
+        k += symbol >> 4;
+        if (k >= JPEG_BLOCK_SIZE) {
+            return -1;
+        }
+        block[jpeg_zigzag[k]] = clamp_coef(value * quant[jpeg_zigzag[k]]);
+    }
+
+    return 0;
+}
+
+/**
+ * Step over one block whose samples are not needed: no dequantization,
+ * coefficient stores or inverse DCT
+ */
+static int skip_block(JpegBitReader* r, const JpegHuffDecoder* dc, const JpegHuffDecoder* ac)
+{
+    int32_t value = 0;
+    int symbol = huff_decode(r, dc, &value);
+
+    if (symbol < 0 || symbol > 11) {
+        return -1;
+    }
+
+    for (int k = 1; k < JPEG_BLOCK_SIZE; k++) {
+        symbol = huff_decode(r, ac, &value);
+        if (symbol < 0) {
+            return -1;
+        }
+
+        if ((symbol & 15) == 0) {
+            if (symbol != 0xF0) {
+                break;                 /* EOB */
+            }
+            k += 15;                   /* ZRL */
+            continue;
+        }
+
+        k += symbol >> 4;
+        if (k >= JPEG_BLOCK_SIZE) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Inverse DCT of a dequantized block into 8x8 samples
+ */
+static void idct_islow(const int32_t* in, uint8_t* out, uint32_t stride)
+{
+    int32_t ws[JPEG_BLOCK_SIZE];
+    int64_t tmp0, tmp1, tmp2, tmp3;
+    int64_t tmp10, tmp11, tmp12, tmp13;
+    int64_t z1, z2, z3, z4, z5;
+
+    /* Pass 1: columns, results scaled up by 2^PASS1_BITS */
+    for (int i = 0; i < 8; i++) {
+        const int32_t* d = &in[i];
+        int32_t* w = &ws[i];
+
+        if (!(d[8] | d[16] | d[24] | d[32] | d[40] | d[48] | d[56])) {
+            int32_t dc = d[0] * (1 << DCT_PASS1_BITS);
+
+            for (int j = 0; j < 8; j++) {
+                w[j * 8] = dc;
+            }
+            continue;
+        }
+
+        z2 = d[16];
+        z3 = d[48];
+        z1 = (z2 + z3) * FIX_0_541196100;
+        tmp2 = z1 - z3 * FIX_1_847759065;
+        tmp3 = z1 + z2 * FIX_0_765366865;
+
+        tmp0 = (int64_t)(d[0] + d[32]) * (1 << DCT_CONST_BITS);
+        tmp1 = (int64_t)(d[0] - d[32]) * (1 << DCT_CONST_BITS);
+
+        tmp10 = tmp0 + tmp3;
+        tmp13 = tmp0 - tmp3;
+        tmp11 = tmp1 + tmp2;
+        tmp12 = tmp1 - tmp2;
+
+        tmp0 = d[56];
+        tmp1 = d[40];
+        tmp2 = d[24];
+        tmp3 = d[8];
+
+        z1 = tmp0 + tmp3;
+        z2 = tmp1 + tmp2;
+        z3 = tmp0 + tmp2;
+        z4 = tmp1 + tmp3;
+        z5 = (z3 + z4) * FIX_1_175875602;
+
+        tmp0 *= FIX_0_298631336;
+        tmp1 *= FIX_2_053119869;
+        tmp2 *= FIX_3_072711026;
+        tmp3 *= FIX_1_501321110;
+        z1 *= -FIX_0_899976223;
+        z2 *= -FIX_2_562915447;
+        z3 = z3 * -FIX_1_961570560 + z5;
+        z4 = z4 * -FIX_0_390180644 + z5;
+
+        tmp0 += z1 + z3;
+        tmp1 += z2 + z4;
+        tmp2 += z2 + z3;
+        tmp3 += z1 + z4;
+
+        w[0] = (int32_t)DESCALE(tmp10 + tmp3, DCT_CONST_BITS - DCT_PASS1_BITS);
+        w[56] = (int32_t)DESCALE(tmp10 - tmp3, DCT_CONST_BITS - DCT_PASS1_BITS);
+        w[8] = (int32_t)DESCALE(tmp11 + tmp2, DCT_CONST_BITS - DCT_PASS1_BITS);
+        w[48] = (int32_t)DESCALE(tmp11 - tmp2, DCT_CONST_BITS - DCT_PASS1_BITS);
+        w[16] = (int32_t)DESCALE(tmp12 + tmp1, DCT_CONST_BITS - DCT_PASS1_BITS);
+        w[40] = (int32_t)DESCALE(tmp12 - tmp1, DCT_CONST_BITS - DCT_PASS1_BITS);
+        w[24] = (int32_t)DESCALE(tmp13 + tmp0, DCT_CONST_BITS - DCT_PASS1_BITS);
+        w[32] = (int32_t)DESCALE(tmp13 - tmp0, DCT_CONST_BITS - DCT_PASS1_BITS);
+    }
+
+    /* Pass 2: rows, removing the pass 1 scaling and the factor of 8 */
+    for (int i = 0; i < 8; i++) {
+        const int32_t* w = &ws[i * 8];
+        uint8_t* o = out + i * stride;
+
+        z2 = w[2];
+        z3 = w[6];
+        z1 = (z2 + z3) * FIX_0_541196100;
+        tmp2 = z1 - z3 * FIX_1_847759065;
+        tmp3 = z1 + z2 * FIX_0_765366865;
+
+        tmp0 = (int64_t)(w[0] + w[4]) * (1 << DCT_CONST_BITS);
+        tmp1 = (int64_t)(w[0] - w[4]) * (1 << DCT_CONST_BITS);
+
+        tmp10 = tmp0 + tmp3;
+        tmp13 = tmp0 - tmp3;
+        tmp11 = tmp1 + tmp2;
+        tmp12 = tmp1 - tmp2;
+
+        tmp0 = w[7];
+        tmp1 = w[5];
+        tmp2 = w[3];
+        tmp3 = w[1];
+
+        z1 = tmp0 + tmp3;
+        z2 = tmp1 + tmp2;
+        z3 = tmp0 + tmp2;
+        z4 = tmp1 + tmp3;
+        z5 = (z3 + z4) * FIX_1_175875602;
+
+        tmp0 *= FIX_0_298631336;
+        tmp1 *= FIX_2_053119869;
+        tmp2 *= FIX_3_072711026;
+        tmp3 *= FIX_1_501321110;
+        z1 *= -FIX_0_899976223;
+        z2 *= -FIX_2_562915447;
+        z3 = z3 * -FIX_1_961570560 + z5;
+        z4 = z4 * -FIX_0_390180644 + z5;
+
+        tmp0 += z1 + z3;
+        tmp1 += z2 + z4;
+        tmp2 += z2 + z3;
+        tmp3 += z1 + z4;
+
+        o[0] = clamp_sample(DESCALE(tmp10 + tmp3, DCT_CONST_BITS + DCT_PASS1_BITS + 3) + 128);
+        o[7] = clamp_sample(DESCALE(tmp10 - tmp3, DCT_CONST_BITS + DCT_PASS1_BITS + 3) + 128);
+        o[1] = clamp_sample(DESCALE(tmp11 + tmp2, DCT_CONST_BITS + DCT_PASS1_BITS + 3) + 128);
+        o[6] = clamp_sample(DESCALE(tmp11 - tmp2, DCT_CONST_BITS + DCT_PASS1_BITS + 3) + 128);
+        o[2] = clamp_sample(DESCALE(tmp12 + tmp1, DCT_CONST_BITS + DCT_PASS1_BITS + 3) + 128);
+        o[5] = clamp_sample(DESCALE(tmp12 - tmp1, DCT_CONST_BITS + DCT_PASS1_BITS + 3) + 128);
+        o[3] = clamp_sample(DESCALE(tmp13 + tmp0, DCT_CONST_BITS + DCT_PASS1_BITS + 3) + 128);
+        o[4] = clamp_sample(DESCALE(tmp13 - tmp0, DCT_CONST_BITS + DCT_PASS1_BITS + 3) + 128);
+    }
+}
+
+/* ============================================================================
+ * Marker Parsing
+ * ============================================================================ */
+
+static int parse_dqt(JpegDecoder* dec, const uint8_t* p, uint32_t len)
+{
+    uint32_t pos = 0;
+
+    while (pos < len) {
+        uint32_t precision = p[pos] >> 4;
+        uint32_t table = p[pos] & 15;
+        uint32_t entry_size = precision ? 2 : 1;
+
+        if (precision > 1 || table >= JPEG_MAX_QUANT_TABLES ||
+            pos + 1 + JPEG_BLOCK_SIZE * entry_size > len) {
+            return -1;
+        }
+        pos++;
+
+        for (int k = 0; k < JPEG_BLOCK_SIZE; k++) {
+            dec->quant[table][jpeg_zigzag[k]] =
+                (uint16_t)(precision ? read_u16(p + pos) : p[pos]);
+            pos += entry_size;
+        }
+    }
+
+    return 0;
+}
+
+static int parse_dht(JpegDecoder* dec, const uint8_t* p, uint32_t len)
+{
+    uint32_t pos = 0;
+
+    while (pos < len) {
+        JpegHuffSpec spec;
+        uint32_t table_class = p[pos] >> 4;
+        uint32_t table = p[pos] & 15;
+        uint32_t count = 0;
+
+        if (table_class > 1 || table >= JPEG_MAX_HUFF_TABLES || pos + 17 > len) {
+            return -1;
+        }
+
+        memset(&spec, 0, sizeof(spec));
+        for (int i = 1; i <= 16; i++) {
+            spec.bits[i] = p[pos + i];
+            count += spec.bits[i];
+        }
+        pos += 17;
+
+        if (count > 256 || pos + count > len) {
+            return -1;
+        }
+        memcpy(spec.vals, p + pos, count);
+        pos += count;
+
+        if (build_huff_decoder(&spec, table_class ? &dec->ac[table] : &dec->dc[table]) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int parse_sof(JpegDecoder* dec, const uint8_t* p, uint32_t len)
+{
+    uint32_t mcu_width = 0;
+    uint32_t mcu_height = 0;
+
+    if (len < 6 || p[0] != 8) {
+        return -1;
+    }
+
+    dec->height = read_u16(p + 1);
+    dec->width = read_u16(p + 3);
+    dec->num_components = p[5];
+
+    if (dec->width == 0 || dec->height == 0 ||
+        (dec->num_components != 1 && dec->num_components != 3) ||
+        len < 6 + 3 * dec->num_components) {
+        return -1;
+    }
+
+    for (uint32_t c = 0; c < dec->num_components; c++) {
+        JpegDecComponent* comp = &dec->comp[c];
+
+        comp->id = p[6 + 3 * c];
+        comp->h_samp = p[7 + 3 * c] >> 4;
+        comp->v_samp = p[7 + 3 * c] & 15;
+        comp->quant_table = p[8 + 3 * c];
+
+        if (comp->quant_table >= JPEG_MAX_QUANT_TABLES) {
+            return -1;
+        }
+    }
+
+    /* Luma at up to 2x2, chroma at 1x1; a single component scan codes
+     * one block per MCU whatever its factors say */
+    if (dec->num_components == 1) {
+        dec->comp[0].h_samp = 1;
+        dec->comp[0].v_samp = 1;
+    }
+    if (dec->comp[0].h_samp < 1 || dec->comp[0].h_samp > 2 ||
+        dec->comp[0].v_samp < 1 || dec->comp[0].v_samp > 2) {
+        return -1;
+    }
+    for (uint32_t c = 1; c < dec->num_components; c++) {
+        if (dec->comp[c].h_samp != 1 || dec->comp[c].v_samp != 1) {
+            return -1;
+        }
+    }
+
+    dec->max_h = dec->comp[0].h_samp;
+    dec->max_v = dec->comp[0].v_samp;
+    mcu_width = 8 * dec->max_h;
+    mcu_height = 8 * dec->max_v;
+    dec->mcus_x = (dec->width + mcu_width - 1) / mcu_width;
+    dec->mcus_y = (dec->height + mcu_height - 1) / mcu_height;
+
+    return 0;
+}
+
+static int parse_sos(JpegDecoder* dec, const uint8_t* p, uint32_t len)
+{
+    uint32_t count = len > 0 ? p[0] : 0;
+
+    /* Baseline single scan: every component, full spectrum */
+    if (count != dec->num_components || len < 4 + 2 * count ||
+        p[1 + 2 * count] != 0 || p[2 + 2 * count] != 63) {
+        return -1;
+    }
+
+    for (uint32_t s = 0; s < count; s++) {
+        uint8_t id = p[1 + 2 * s];
+        uint32_t dc_table = p[2 + 2 * s] >> 4;
+        uint32_t ac_table = p[2 + 2 * s] & 15;
+        uint32_t c = 0;
+
+        while (c < dec->num_components && dec->comp[c].id != id) {
+            c++;
+        }
+        if (c == dec->num_components || dc_table >= JPEG_MAX_HUFF_TABLES ||
+            ac_table >= JPEG_MAX_HUFF_TABLES ||
+            !dec->dc[dc_table].valid || !dec->ac[ac_table].valid) {
+            return -1;
+        }
+
+        dec->comp[c].dc_table = (uint8_t)dc_table;
+        dec->comp[c].ac_table = (uint8_t)ac_table;
+        dec->scan_comp[s] = (uint8_t)c;
+    }
+
+    dec->scan_components = count;
+
+    return 0;
+}
+
+/* ============================================================================
+ * Output Conversion
+ * ============================================================================ */
+
+/**
+ * Make room for one MCU row of every component
+ */
+static int ensure_strips(JpegDecoder* dec)
+{
+    size_t total = 0;
+    uint8_t* base = NULL;
+
+    for (uint32_t c = 0; c < dec->num_components; c++) {
+        dec->strip_stride[c] = dec->mcus_x * 8 * dec->comp[c].h_samp;
+        total += (size_t)dec->strip_stride[c] * 8 * dec->comp[c].v_samp;
+    }
+    total += (size_t)dec->strip_stride[0] * 3;
+
+    if (total > dec->strip_capacity) {
+        base = (uint8_t*)realloc(dec->strip[0], total);
+        if (!base) {
+            return -1;
+        }
+        dec->strip[0] = base;
+        dec->strip_capacity = total;
+    }
+
+    for (uint32_t c = 1; c < dec->num_components; c++) {
+        dec->strip[c] = dec->strip[c - 1] +
+                        (size_t)dec->strip_stride[c - 1] * 8 * dec->comp[c - 1].v_samp;
+    }
+    dec->rgb_row = dec->strip[dec->num_components - 1] +
+                   (size_t)dec->strip_stride[dec->num_components - 1] * 8 *
+                   dec->comp[dec->num_components - 1].v_samp;
+
+    return 0;
+}
+
+static inline uint8_t clamp_u8(int32_t value)
+{
+    return (uint8_t)(value < 0 ? 0 : value > 255 ? 255 : value);
+}
+
+/**
+ * YCbCr to RGB for one row, chroma replicated 2x horizontally when hx is 1
+ *
+ * Each chroma sample is converted once and added to the luma of every
+ * pixel it covers. Both loops are branch-free over independent lanes, so
+ * the compiler vectorizes them.
+ */
+static void ycc_row_to_rgb(const uint8_t* luma, const uint8_t* cb, const uint8_t* cr,
+                           uint32_t hx, uint32_t width, uint8_t* r, uint8_t* g, uint8_t* b)
+{
+    uint32_t pairs = hx ? width / 2 : 0;
+
+    if (!hx) {
+        for (uint32_t x = 0; x < width; x++) {
+            int32_t u = (int32_t)cb[x] - 128;
+            int32_t v = (int32_t)cr[x] - 128;
+
+            r[x] = clamp_u8(luma[x] + DESCALE(FIX_R_CR * v, RGB_FIX_BITS));
+            g[x] = clamp_u8(luma[x] + DESCALE(-FIX_G_CB * u - FIX_G_CR * v, RGB_FIX_BITS));
+            b[x] = clamp_u8(luma[x] + DESCALE(FIX_B_CB * u, RGB_FIX_BITS));
+        }
+        return;
+    }
+
+    for (uint32_t cx = 0; cx < pairs; cx++) {
+        int32_t u = (int32_t)cb[cx] - 128;
+        int32_t v = (int32_t)cr[cx] - 128;
+        int32_t dr = DESCALE(FIX_R_CR * v, RGB_FIX_BITS);
+        int32_t dg = DESCALE(-FIX_G_CB * u - FIX_G_CR * v, RGB_FIX_BITS);
+        int32_t db = DESCALE(FIX_B_CB * u, RGB_FIX_BITS);
+
+        r[2 * cx] = clamp_u8(luma[2 * cx] + dr);
+        r[2 * cx + 1] = clamp_u8(luma[2 * cx + 1] + dr);
+        g[2 * cx] = clamp_u8(luma[2 * cx] + dg);
+        g[2 * cx + 1] = clamp_u8(luma[2 * cx + 1] + dg);
+        b[2 * cx] = clamp_u8(luma[2 * cx] + db);
+        b[2 * cx + 1] = clamp_u8(luma[2 * cx + 1] + db);
+    }
+
+    /* Odd width: the last pixel has a chroma sample of its own */
+    if (width & 1) {
+        int32_t u = (int32_t)cb[pairs] - 128;
+        int32_t v = (int32_t)cr[pairs] - 128;
+        uint32_t x = width - 1;
+
+        r[x] = clamp_u8(luma[x] + DESCALE(FIX_R_CR * v, RGB_FIX_BITS));
+        g[x] = clamp_u8(luma[x] + DESCALE(-FIX_G_CB * u - FIX_G_CR * v, RGB_FIX_BITS));
+        b[x] = clamp_u8(luma[x] + DESCALE(FIX_B_CB * u, RGB_FIX_BITS));
+    }
+}
+
+/**
+ * Convert one decoded MCU row to packed or planar float RGB
+ *
+ * Subsampled chroma is replicated; grayscale images give R = G = B = Y.
+ */
+static void strip_to_rgb(const JpegDecoder* dec, uint32_t mcu_row, JpegOutputFormat format,
+                         uint8_t* out)
+{
+    uint32_t mcu_height = 8 * dec->max_v;
+    uint32_t y0 = mcu_row * mcu_height;
+    uint32_t rows = dec->height - y0 < mcu_height ? dec->height - y0 : mcu_height;
+    uint32_t width = dec->width;
+    int bgr = format == JPEG_OUTPUT_BGR888 || format == JPEG_OUTPUT_BGRA8888;
+    size_t plane = (size_t)width * dec->height;
+    uint8_t* row_r = dec->rgb_row;
+    uint8_t* row_g = row_r + dec->strip_stride[0];
+    uint8_t* row_b = row_g + dec->strip_stride[0];
+
+    for (uint32_t y = 0; y < rows; y++) {
+        const uint8_t* luma = dec->strip[0] + (size_t)y * dec->strip_stride[0];
+        const uint8_t* r = luma;
+        const uint8_t* g = luma;
+        const uint8_t* b = luma;
+        size_t index = (size_t)(y0 + y) * width;
+
+        /* Chroma is sampled 1x1, luma 1 or 2 times as densely */
+        if (dec->num_components == 3) {
+            uint32_t ry = dec->max_v;
+            const uint8_t* cb = dec->strip[1] + (size_t)(y / ry) * dec->strip_stride[1];
+            const uint8_t* cr = dec->strip[2] + (size_t)(y / ry) * dec->strip_stride[2];
+
+            ycc_row_to_rgb(luma, cb, cr, dec->max_h - 1, width, row_r, row_g, row_b);
+            r = row_r;
+            g = row_g;
+            b = row_b;
+        }
+
+        if (bgr) {
+            const uint8_t* t = r;
+            r = b;
+            b = t;
+        }
+
+        switch (format) {
+        case JPEG_OUTPUT_RGB_F32: {
+            float* dst = (float*)out + index;
+
+            for (uint32_t x = 0; x < width; x++) {
+                dst[x] = r[x] * (1.0f / 255.0f);
+                dst[x + plane] = g[x] * (1.0f / 255.0f);
+                dst[x + 2 * plane] = b[x] * (1.0f / 255.0f);
+            }
+            break;
+        }
+        case JPEG_OUTPUT_RGBA8888:
+        case JPEG_OUTPUT_BGRA8888: {
+            uint8_t* dst = out + index * 4;
+
+            for (uint32_t x = 0; x < width; x++) {
+                dst[4 * x] = r[x];
+                dst[4 * x + 1] = g[x];
+                dst[4 * x + 2] = b[x];
+                dst[4 * x + 3] = 255;
+            }
+            break;
+        }
+        default: {
+            uint8_t* dst = out + index * 3;
+
+            for (uint32_t x = 0; x < width; x++) {
+                dst[3 * x] = r[x];
+                dst[3 * x + 1] = g[x];
+                dst[3 * x + 2] = b[x];
+            }
+            break;
+        }
+        }
+    }
+}
+
+/**
+ * Copy one decoded MCU row into the output frame, averaging chroma that is
+ * sampled more densely than the output and replicating sparser chroma
+ */
+static void strip_to_output(const JpegDecoder* dec, uint32_t mcu_row, JpegOutputFormat format,
+                            uint8_t* out)
+{
+    uint32_t mcu_height = 8 * dec->max_v;
+    uint32_t y0 = mcu_row * mcu_height;
+    uint32_t rows = dec->height - y0 < mcu_height ? dec->height - y0 : mcu_height;
+    uint32_t out_v = format == JPEG_OUTPUT_NV12 ? 2 : 1;   /* Luma rows per CbCr row */
+    uint32_t chroma_height = dec->height / out_v;
+    uint32_t cy_end = (y0 + rows) / out_v < chroma_height ? (y0 + rows) / out_v : chroma_height;
+    uint8_t* uv = out + (size_t)dec->width * dec->height;
+
+    for (uint32_t y = 0; y < rows; y++) {
+        memcpy(out + (size_t)(y0 + y) * dec->width,
+               dec->strip[0] + (size_t)y * dec->strip_stride[0], dec->width);
+    }
+
+    if (format == JPEG_OUTPUT_GRAY) {
+        return;
+    }
+
+    for (uint32_t cy = y0 / out_v; cy < cy_end; cy++) {
+        uint8_t* row = uv + (size_t)cy * dec->width;
+        uint32_t ly = cy * out_v - y0;
+
+        if (dec->num_components == 1) {
+            memset(row, 128, (dec->width / 2) * 2);
+            continue;
+        }
+
+        for (uint32_t c = 1; c < dec->num_components; c++) {
+            uint32_t rx = dec->max_h / dec->comp[c].h_samp;
+            uint32_t ry = dec->max_v / dec->comp[c].v_samp;
+            uint32_t nx = rx == 1 ? 2 : 1;
+            uint32_t ny = out_v > ry ? out_v / ry : 1;
+            const uint8_t* src = dec->strip[c] + (size_t)(ly / ry) * dec->strip_stride[c];
+            uint8_t* dst = row + (c - 1);
+
+            if (nx == 1 && ny == 1) {
+                for (uint32_t cx = 0; cx < dec->width / 2; cx++) {
+                    dst[2 * cx] = src[cx];
+                }
+                continue;
+            }
+
+            for (uint32_t cx = 0; cx < dec->width / 2; cx++) {
+                const uint8_t* s = src + (2 * cx) / rx;
+                uint32_t sum = 0;
+
+                for (uint32_t j = 0; j < ny; j++) {
+                    for (uint32_t i = 0; i < nx; i++) {
+                        sum += s[j * dec->strip_stride[c] + i];
+                    }
+                }
+                dst[2 * cx] = (uint8_t)((sum + nx * ny / 2) / (nx * ny));
+            }
+        }
+    }
+}
+
+/**
+ * Step over the restart marker due before the next MCU, if any
+ */
+static int next_restart(const JpegDecoder* dec, JpegBitReader* r, int32_t* last_dc,
+                        uint32_t* restarts_left)
+{
+    if (!dec->restart_interval) {
+        return 0;
+    }
+
+    if (*restarts_left == 0) {
+        if (jpeg_br_restart(r) != 0) {
+            return -1;
+        }
+        memset(last_dc, 0, JPEG_MAX_COMPONENTS * sizeof(int32_t));
+        *restarts_left = dec->restart_interval;
+    }
+    (*restarts_left)--;
+
+    return 0;
+}
+
+/**
+ * Output frame written by jpeg_decoder_decode()
+ */
+typedef struct {
+    JpegOutputFormat format;
+    uint8_t* out;
+} FrameSink;
+
+static void frame_sink_row(void* opaque, const JpegDecoder* dec, uint32_t mcu_row)
+{
+    const FrameSink* frame = (const FrameSink*)opaque;
+
+    if (frame->format >= JPEG_OUTPUT_RGB888) {
+        strip_to_rgb(dec, mcu_row, frame->format, frame->out);
+    } else {
+        strip_to_output(dec, mcu_row, frame->format, frame->out);
+    }
+}
+
+/* ============================================================================
+ * Internal Implementation Functions
+ * ============================================================================ */
+
+JpegDecoder* jpeg_decoder_create(void)
+{
+    JpegDecoder* dec = (JpegDecoder*)calloc(1, sizeof(JpegDecoder));
+    if (!dec) {
+        return NULL;
+    }
+
+    if (jpeg_decoder_reset(dec) != 0) {
+        free(dec);
+        return NULL;
+    }
+
+    return dec;
+}
+
+int jpeg_decoder_reset(JpegDecoder* dec)
+{
+    memset(dec->quant, 0, sizeof(dec->quant));
+    for (uint32_t t = 0; t < JPEG_MAX_HUFF_TABLES; t++) {
+        dec->dc[t].valid = 0;
+        dec->ac[t].valid = 0;
+    }
+
+    /* MJPEG streams commonly omit DHT and rely on the Annex K tables */
+    if (build_huff_decoder(&jpeg_std_dc_luma, &dec->dc[0]) != 0 ||
+        build_huff_decoder(&jpeg_std_ac_luma, &dec->ac[0]) != 0 ||
+        build_huff_decoder(&jpeg_std_dc_chroma, &dec->dc[1]) != 0 ||
+        build_huff_decoder(&jpeg_std_ac_chroma, &dec->ac[1]) != 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+void jpeg_decoder_destroy(JpegDecoder* dec)
+{
+    if (!dec) {
+        return;
+    }
+
+    free(dec->strip[0]);
+    free(dec);
+}
+
+int jpeg_decoder_read_header(JpegDecoder* dec, const uint8_t* data, uint32_t size)
+{
+    uint32_t pos = 2;
+    int have_frame = 0;
+
+    if (size < 4 || data[0] != 0xFF || data[1] != JPEG_MARKER_SOI) {
+        return -1;
+    }
+
+    dec->restart_interval = 0;
+
+    while (pos < size) {
+        uint8_t marker = 0;
+        uint32_t len = 0;
+        const uint8_t* segment = NULL;
+        int ret = 0;
+
+        /* Markers may be preceded by fill bytes */
+        if (data[pos] != 0xFF) {
+            return -1;
+        }
+        while (pos < size && data[pos] == 0xFF) {
+            pos++;
+        }
+        if (pos >= size) {
+            return -1;
+        }
+        marker = data[pos++];
+
+        if (marker == JPEG_MARKER_SOI || (marker >= JPEG_MARKER_RST0 && marker <= 0xD7)) {
+            continue;
+        }
+        if (marker == JPEG_MARKER_EOI || pos + 2 > size) {
+            return -1;
+        }
+
+        len = read_u16(data + pos);
+        if (len < 2 || pos + len > size) {
+            return -1;
+        }
+        segment = data + pos + 2;
+
+        switch (marker) {
+        case JPEG_MARKER_SOF0:
+        case JPEG_MARKER_SOF1:
+            ret = parse_sof(dec, segment, len - 2);
+            have_frame = ret == 0;
+            break;
+        case JPEG_MARKER_DHT:
+            ret = parse_dht(dec, segment, len - 2);
+            break;
+        case JPEG_MARKER_DQT:
+            ret = parse_dqt(dec, segment, len - 2);
+            break;
+        case JPEG_MARKER_DRI:
+            ret = len >= 4 ? 0 : -1;
+            dec->restart_interval = len >= 4 ? read_u16(segment) : 0;
+            break;
+        case JPEG_MARKER_SOS:
+            if (!have_frame || parse_sos(dec, segment, len - 2) != 0) {
+                return -1;
+            }
+            dec->scan_offset = pos + len;
+            return 0;
+        default:
+            /* Progressive, lossless and arithmetic-coded frames */
+            if (marker >= 0xC2 && marker <= 0xCF && marker != JPEG_MARKER_DHT &&
+                marker != 0xC8 && marker != 0xCC) {
+                return -1;
+            }
+            break;
+        }
+
+        if (ret != 0) {
+            return -1;
+        }
+        pos += len;
+    }
+
+    return -1;
+}
+
+int jpeg_decoder_decode_rows(JpegDecoder* dec, const uint8_t* data, uint32_t size,
+                             int luma_only, JpegRowSink sink, void* opaque)
+{
+    JpegBitReader r;
+    int32_t block[JPEG_BLOCK_SIZE];
+    int32_t last_dc[JPEG_MAX_COMPONENTS] = { 0 };
+    uint32_t restarts_left = dec->restart_interval;
+
+    if (ensure_strips(dec) != 0) {
+        return -1;
+    }
+
+    jpeg_br_init(&r, data, dec->scan_offset, size);
+
+    for (uint32_t my = 0; my < dec->mcus_y; my++) {
+        for (uint32_t mx = 0; mx < dec->mcus_x; mx++) {
+            if (next_restart(dec, &r, last_dc, &restarts_left) != 0) {
+                return -1;
+            }
+
+            for (uint32_t s = 0; s < dec->scan_components; s++) {
+                uint32_t c = dec->scan_comp[s];
+                const JpegDecComponent* comp = &dec->comp[c];
+                uint32_t stride = dec->strip_stride[c];
+
+                /* Chroma blocks only need their bits consumed */
+                if (luma_only && c != 0) {
+                    for (uint32_t b = 0; b < (uint32_t)comp->h_samp * comp->v_samp; b++) {
+                        if (skip_block(&r, &dec->dc[comp->dc_table],
+                                       &dec->ac[comp->ac_table]) != 0) {
+                            return -1;
+                        }
+                    }
+                    continue;
+                }
+
+                for (uint32_t by = 0; by < comp->v_samp; by++) {
+                    for (uint32_t bx = 0; bx < comp->h_samp; bx++) {
+                        uint8_t* out = dec->strip[c] + (size_t)by * 8 * stride +
+                                       (mx * comp->h_samp + bx) * 8;
+
+                        if (decode_block(&r, &dec->dc[comp->dc_table], &dec->ac[comp->ac_table],
+                                         dec->quant[comp->quant_table], &last_dc[c], block) != 0) {
+                            return -1;
+                        }
+                        idct_islow(block, out, stride);
+                    }
+                }
+            }
+        }
+
+        sink(opaque, dec, my);
+    }
+
+    return 0;
+}
+
+int jpeg_decoder_decode(JpegDecoder* dec, const uint8_t* data, uint32_t size,
+                        JpegOutputFormat format, uint8_t* out)
+{
+    FrameSink frame = { format, out };
+
+    return jpeg_decoder_decode_rows(dec, data, size, format == JPEG_OUTPUT_GRAY,
+                                    frame_sink_row, &frame);
+}
+
+int jpeg_decoder_decode_coefs(JpegDecoder* dec, const uint8_t* data, uint32_t size,
+                              int16_t* coefs)
+{
+    JpegBitReader r;
+    int32_t block[JPEG_BLOCK_SIZE];
+    int32_t last_dc[JPEG_MAX_COMPONENTS] = { 0 };
+    uint32_t restarts_left = dec->restart_interval;
+
+    jpeg_br_init(&r, data, dec->scan_offset, size);
+
+    for (uint32_t m = 0; m < dec->mcus_x * dec->mcus_y; m++) {
+        if (next_restart(dec, &r, last_dc, &restarts_left) != 0) {
+            return -1;
+        }
+
+        for (uint32_t s = 0; s < dec->scan_components; s++) {
+            uint32_t c = dec->scan_comp[s];
+            const JpegDecComponent* comp = &dec->comp[c];
+
+            for (uint32_t b = 0; b < (uint32_t)comp->h_samp * comp->v_samp; b++) {
+                if (decode_block(&r, &dec->dc[comp->dc_table], &dec->ac[comp->ac_table],
+                                 dec->quant[comp->quant_table], &last_dc[c], block) != 0) {
+                    return -1;
+                }
+
+                /* Forward DCT scaling, saturated like corrupt coefficients */
+                for (int k = 0; k < JPEG_BLOCK_SIZE; k++) {
+                    coefs[k] = (int16_t)clamp_coef(block[k] * 8);
+                }
+                coefs += JPEG_BLOCK_SIZE;
+            }
+        }
+    }
+
+    return 0;
+}
+
+void jpeg_decoder_component_size(const JpegDecoder* dec, uint32_t c, uint32_t* width,
+                                 uint32_t* height)
+{
+    *width = (dec->width * dec->comp[c].h_samp + dec->max_h - 1) / dec->max_h;
+    *height = (dec->height * dec->comp[c].v_samp + dec->max_v - 1) / dec->max_v;
+}
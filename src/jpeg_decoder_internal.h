@@ -0,0 +1,178 @@
+/*
+ * Software JPEG Decoder Internal Implementation
+ */
+
+#ifndef JPEG_DECODER_INTERNAL_H
+#define JPEG_DECODER_INTERNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "jpeg_internal.h"
+
+/* Huffman lookahead: codes (plus magnitude bits) up to this long decode
+ * with one table lookup */
+#define JPEG_HUFF_LOOKAHEAD     10
+
+/* Lookahead entry layout */
+#define JPEG_HUFF_LEN_MASK      0x1F   /* Bits consumed, 0 = longer code */
+#define JPEG_HUFF_FULL          0x20   /* Length and value include the magnitude bits */
+#define JPEG_HUFF_SYMBOL_SHIFT  8      /* Run/size symbol */
+#define JPEG_HUFF_VALUE_SHIFT   16     /* Signed coefficient value (FULL entries) */
+
+#define JPEG_MAX_HUFF_TABLES    4
+#define JPEG_MAX_QUANT_TABLES   4
+
+/**
+ * Output layout
+ */
+typedef enum {
+    JPEG_OUTPUT_NV12 = 0,              /* One CbCr row per two luma rows */
+    JPEG_OUTPUT_NV16 = 1,              /* One CbCr row per luma row */
+    JPEG_OUTPUT_GRAY = 2,              /* Luma only */
+    JPEG_OUTPUT_RGB888 = 3,            /* Packed R G B */
+    JPEG_OUTPUT_BGR888 = 4,            /* Packed B G R */
+    JPEG_OUTPUT_RGBA8888 = 5,          /* Packed R G B 255 */
+    JPEG_OUTPUT_BGRA8888 = 6,          /* Packed B G R 255 */
+    JPEG_OUTPUT_RGB_F32 = 7            /* Float R, G and B planes in [0, 1] */
+} JpegOutputFormat;
+
+/**
+ * Huffman decoding table
+ */
+typedef struct {
+    int32_t fast[1 << JPEG_HUFF_LOOKAHEAD];  /* Lookahead entries */
+    int32_t maxcode[18];               /* Largest code of each length, -1 if none */
+    int32_t valoffset[17];             /* vals index of a length's first code, minus that code */
+    uint8_t vals[256];
+    int valid;
+} JpegHuffDecoder;
+
+/**
+ * Frame component
+ */
+typedef struct {
+    uint8_t id;
+    uint8_t h_samp;
+    uint8_t v_samp;
+    uint8_t quant_table;
+    uint8_t dc_table;
+    uint8_t ac_table;
+} JpegDecComponent;
+
+/**
+ * Baseline sequential JPEG decoder
+ *
+ * Tables persist across images, so streams that only send DQT/DHT once (or
+ * never, using the Annex K Huffman tables as MJPEG does) decode. Samples are
+ * produced one MCU row at a time into a strip and converted to the output
+ * layout from there, resampling chroma on the way.
+ */
+typedef struct {
+    /* Frame header */
+    uint32_t width;
+    uint32_t height;
+    uint32_t num_components;
+    JpegDecComponent comp[JPEG_MAX_COMPONENTS];
+    uint32_t max_h;
+    uint32_t max_v;
+    uint32_t mcus_x;
+    uint32_t mcus_y;
+    uint32_t restart_interval;
+
+    /* Tables */
+    uint16_t quant[JPEG_MAX_QUANT_TABLES][JPEG_BLOCK_SIZE];   /* Natural order */
+    JpegHuffDecoder dc[JPEG_MAX_HUFF_TABLES];
+    JpegHuffDecoder ac[JPEG_MAX_HUFF_TABLES];
+
+    /* Scan: components in MCU order and the entropy-coded data offset */
+    uint32_t scan_components;
+    uint8_t scan_comp[JPEG_MAX_COMPONENTS];
+    uint32_t scan_offset;
+
+    /* One MCU row of samples per component */
+    uint8_t* strip[JPEG_MAX_COMPONENTS];
+    uint32_t strip_stride[JPEG_MAX_COMPONENTS];
+    size_t strip_capacity;
+    uint8_t* rgb_row;                  /* R, G and B rows for RGB output (same allocation) */
+} JpegDecoder;
+
+/**
+ * Create a decoder with the Annex K Huffman tables preloaded
+ */
+JpegDecoder* jpeg_decoder_create(void);
+
+/**
+ * Destroy a decoder
+ */
+void jpeg_decoder_destroy(JpegDecoder* dec);
+
+/**
+ * Forget the tables of a previous stream: quantization tables are cleared
+ * and the Annex K Huffman tables reloaded, while row buffers stay
+ *
+ * @return 0 on success, -1 if the default tables cannot be built
+ */
+int jpeg_decoder_reset(JpegDecoder* dec);
+
+/**
+ * Parse markers up to the first scan
+ *
+ * @return 0 on success, -1 for malformed or unsupported (non-baseline) data
+ */
+int jpeg_decoder_read_header(JpegDecoder* dec, const uint8_t* data, uint32_t size);
+
+/**
+ * Decode the scan found by jpeg_decoder_read_header()
+ *
+ * The output holds width * height luma bytes followed by height / 2 (NV12)
+ * or height (NV16) rows of width / 2 interleaved CbCr pairs (row stride
+ * width). Chroma is box-averaged down or replicated up to that density.
+ * GRAY output is the luma plane alone; chroma blocks are entropy-decoded
+ * only as far as needed to step over them. RGB layouts are converted from
+ * each decoded MCU row, replicating subsampled chroma.
+ *
+ * @return 0 on success, -1 on corrupt entropy-coded data
+ */
+int jpeg_decoder_decode(JpegDecoder* dec, const uint8_t* data, uint32_t size,
+                        JpegOutputFormat format, uint8_t* out);
+
+/**
+ * Consumer of decoded MCU rows
+ *
+ * Called once per MCU row, top to bottom, while strip[c] holds the row's
+ * samples of component c (strip_stride[c] bytes apart, padded to whole
+ * blocks; rows past the component height are padding).
+ */
+typedef void (*JpegRowSink)(void* opaque, const JpegDecoder* dec, uint32_t mcu_row);
+
+/**
+ * Decode the scan found by jpeg_decoder_read_header() into a row sink
+ *
+ * No frame-sized buffer is involved; only one MCU row exists at a time.
+ * With luma_only set, chroma strips are left untouched.
+ *
+ * @return 0 on success, -1 on corrupt entropy-coded data
+ */
+int jpeg_decoder_decode_rows(JpegDecoder* dec, const uint8_t* data, uint32_t size,
+                             int luma_only, JpegRowSink sink, void* opaque);
+
+/**
+ * Entropy-decode the scan into dequantized coefficient blocks
+ *
+ * Blocks are stored MCU by MCU, in scan order within an MCU and raster
+ * order within a component, each in natural order and multiplied by 8 as
+ * the encoder's forward DCT leaves them. No inverse DCT runs.
+ *
+ * @return 0 on success, -1 on corrupt entropy-coded data
+ */
+int jpeg_decoder_decode_coefs(JpegDecoder* dec, const uint8_t* data, uint32_t size,
+                              int16_t* coefs);
+
+/**
+ * Sample dimensions of component c (subsampled sizes round up)
+ */
+void jpeg_decoder_component_size(const JpegDecoder* dec, uint32_t c, uint32_t* width,
+                                 uint32_t* height);
+
+#endif /* JPEG_DECODER_INTERNAL_H */
@@ -0,0 +1,1105 @@
+/*
+ * Software JPEG Encoder Implementation
+ *
+ * Baseline sequential (SOF0) Huffman JPEG encoder used by the CPU backend.
+ * Samples are read through strided plane views (or converted from packed
+ * RGB one MCU at a time), transformed with the integer LLM forward DCT and
+ * entropy coded with the Annex K tables, or optionally with optimal tables
+ * built from a statistics pass.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jpeg_encoder_internal.h"
+#include "jpeg_bit_writer_internal.h"
+
+/* Integer LLM DCT constants (13-bit fixed point) */
+#define DCT_CONST_BITS  13
+#define DCT_PASS1_BITS  2
+
+#define FIX_0_298631336 ((int32_t)2446)
+#define FIX_0_390180644 ((int32_t)3196)
+#define FIX_0_541196100 ((int32_t)4433)
+#define FIX_0_765366865 ((int32_t)6270)
+#define FIX_0_899976223 ((int32_t)7373)
+#define FIX_1_175875602 ((int32_t)9633)
+#define FIX_1_501321110 ((int32_t)12299)
+#define FIX_1_847759065 ((int32_t)15137)
+#define FIX_1_961570560 ((int32_t)16069)
+#define FIX_2_053119869 ((int32_t)16819)
+#define FIX_2_562915447 ((int32_t)20995)
+#define FIX_3_072711026 ((int32_t)25172)
+
+#define DESCALE(x, n) (((x) + (1 << ((n) - 1))) >> (n))
+
+/* JFIF RGB to YCbCr (full range, 16-bit fixed point) */
+#define RGB_FIX_BITS    16
+#define FIX_Y_R         ((int32_t)19595)   /* 0.29900 */
+#define FIX_Y_G         ((int32_t)38470)   /* 0.58700 */
+#define FIX_Y_B         ((int32_t)7471)    /* 0.11400 */
+#define FIX_CB_R        ((int32_t)11059)   /* 0.16874 */
+#define FIX_CB_G        ((int32_t)21709)   /* 0.33126 */
+#define FIX_CR_G        ((int32_t)27439)   /* 0.41869 */
+#define FIX_CR_B        ((int32_t)5329)    /* 0.08131 */
+#define FIX_HALF        ((int32_t)32768)   /* 0.50000 */
+
+/* Largest MCU edge in pixels (4:2:0) */
+#define MAX_MCU_PIXELS  16
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+/**
+ * Number of bits needed for a coefficient magnitude
+ */
+static int coef_bits(int32_t value)
+{
+    uint32_t mag = (uint32_t)(value < 0 ? -value : value);
+
+    return mag ? 32 - __builtin_clz(mag) : 0;
+}
+
+/**
+ * Load one 8x8 block, replicating edge samples past the plane border
+ */
+static void fetch_block(const JpegPlane* plane, uint32_t x0, uint32_t y0, int32_t* block)
+{
+    if (x0 + 8 <= plane->width && y0 + 8 <= plane->height) {
+        const uint8_t* row = plane->base + (int64_t)y0 * plane->row_step +
+                             (int64_t)x0 * plane->col_step;
+
+        for (int y = 0; y < 8; y++) {
+            const uint8_t* p = row;
+            for (int x = 0; x < 8; x++) {
+                block[y * 8 + x] = (int32_t)*p - 128;
+                p += plane->col_step;
+            }
+            row += plane->row_step;
+        }
+        return;
+    }
+
+    for (int y = 0; y < 8; y++) {
+        uint32_t sy = y0 + y < plane->height ? y0 + y : plane->height - 1;
+        for (int x = 0; x < 8; x++) {
+            uint32_t sx = x0 + x < plane->width ? x0 + x : plane->width - 1;
+            block[y * 8 + x] = (int32_t)plane->base[(int64_t)sy * plane->row_step +
+                                                   (int64_t)sx * plane->col_step] - 128;
+        }
+    }
+}
+
+/**
+ * Load one MCU of packed RGB into separate channels, replicating edge
+ * pixels past the frame border
+ */
+static void fetch_mcu_rgb(const JpegRgbFrame* frame, uint32_t x0, uint32_t y0,
+                          uint32_t mcu_width, uint32_t mcu_height,
+                          int32_t* r, int32_t* g, int32_t* b)
+{
+    const uint32_t ro = frame->offset[0];
+    const uint32_t go = frame->offset[1];
+    const uint32_t bo = frame->offset[2];
+
+    for (uint32_t y = 0; y < mcu_height; y++) {
+        uint32_t sy = y0 + y < frame->height ? y0 + y : frame->height - 1;
+        const uint8_t* row = frame->base + (int64_t)sy * frame->row_step;
+        uint32_t i = y * MAX_MCU_PIXELS;
+
+        if (x0 + mcu_width <= frame->width) {
+            const uint8_t* p = row + (int64_t)x0 * frame->pixel_step;
+
+            for (uint32_t x = 0; x < mcu_width; x++) {
+                r[i + x] = p[ro];
+                g[i + x] = p[go];
+                b[i + x] = p[bo];
+                p += frame->pixel_step;
+            }
+            continue;
+        }
+
+        for (uint32_t x = 0; x < mcu_width; x++) {
+            uint32_t sx = x0 + x < frame->width ? x0 + x : frame->width - 1;
+            const uint8_t* p = row + (int64_t)sx * frame->pixel_step;
+
+            r[i + x] = p[ro];
+            g[i + x] = p[go];
+            b[i + x] = p[bo];
+        }
+    }
+}
+
+/**
+ * Level-shifted luma of the 8x8 block at (bx, by) of an RGB MCU
+ */
+static void rgb_luma_block(const int32_t* r, const int32_t* g, const int32_t* b,
+                           uint32_t bx, uint32_t by, int32_t* block)
+{
+    for (int y = 0; y < 8; y++) {
+        uint32_t i = (by * 8 + y) * MAX_MCU_PIXELS + bx * 8;
+
+        /* Fixed-length rows of independent lanes: vectorized by the compiler */
+        for (int x = 0; x < 8; x++) {
+            block[y * 8 + x] = DESCALE(FIX_Y_R * r[i + x] + FIX_Y_G * g[i + x] +
+                                       FIX_Y_B * b[i + x], RGB_FIX_BITS) - 128;
+        }
+    }
+}
+
+/**
+ * Level-shifted Cb and Cr blocks of an RGB MCU
+ *
+ * RGB is averaged over each rx x ry group of pixels before the (linear)
+ * conversion, which costs one conversion per chroma sample.
+ */
+static void rgb_chroma_blocks(const int32_t* r, const int32_t* g, const int32_t* b,
+                              uint32_t rx, uint32_t ry, int32_t* cb, int32_t* cr)
+{
+    int shift = RGB_FIX_BITS + (int)(rx >> 1) + (int)(ry >> 1);
+
+    for (uint32_t y = 0; y < 8; y++) {
+        for (uint32_t x = 0; x < 8; x++) {
+            int32_t rs = 0;
+            int32_t gs = 0;
+            int32_t bs = 0;
+
+            for (uint32_t j = 0; j < ry; j++) {
+                uint32_t i = (y * ry + j) * MAX_MCU_PIXELS + x * rx;
+
+                for (uint32_t k = 0; k < rx; k++) {
+                    rs += r[i + k];
+                    gs += g[i + k];
+                    bs += b[i + k];
+                }
+            }
+
+            cb[y * 8 + x] = DESCALE(FIX_HALF * bs - FIX_CB_R * rs - FIX_CB_G * gs, shift);
+            cr[y * 8 + x] = DESCALE(FIX_HALF * rs - FIX_CR_G * gs - FIX_CR_B * bs, shift);
+        }
+    }
+}
+
+/**
+ * Forward DCT of a level-shifted block; output is scaled up by 8
+ */
+static void fdct_islow(int32_t* data, int16_t* out)
+{
+    int32_t tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+    int32_t tmp10, tmp11, tmp12, tmp13;
+    int32_t z1, z2, z3, z4, z5;
+
+    /* Pass 1: rows, results scaled up by 2^PASS1_BITS */
+    for (int i = 0; i < 8; i++) {
+        int32_t* d = &data[i * 8];
+
+        tmp0 = d[0] + d[7];
+        tmp7 = d[0] - d[7];
+        tmp1 = d[1] + d[6];
+        tmp6 = d[1] - d[6];
+        tmp2 = d[2] + d[5];
+        tmp5 = d[2] - d[5];
+        tmp3 = d[3] + d[4];
+        tmp4 = d[3] - d[4];
+
+        tmp10 = tmp0 + tmp3;
+        tmp13 = tmp0 - tmp3;
+        tmp11 = tmp1 + tmp2;
+        tmp12 = tmp1 - tmp2;
+
+        d[0] = (tmp10 + tmp11) * (1 << DCT_PASS1_BITS);
+        d[4] = (tmp10 - tmp11) * (1 << DCT_PASS1_BITS);
+
+        z1 = (tmp12 + tmp13) * FIX_0_541196100;
+        d[2] = DESCALE(z1 + tmp13 * FIX_0_765366865, DCT_CONST_BITS - DCT_PASS1_BITS);
+        d[6] = DESCALE(z1 - tmp12 * FIX_1_847759065, DCT_CONST_BITS - DCT_PASS1_BITS);
+
+        z1 = tmp4 + tmp7;
+        z2 = tmp5 + tmp6;
+        z3 = tmp4 + tmp6;
+        z4 = tmp5 + tmp7;
+        z5 = (z3 + z4) * FIX_1_175875602;
+
+        tmp4 *= FIX_0_298631336;
+        tmp5 *= FIX_2_053119869;
+        tmp6 *= FIX_3_072711026;
+        tmp7 *= FIX_1_501321110;
+        z1 *= -FIX_0_899976223;
+        z2 *= -FIX_2_562915447;
+        z3 = z3 * -FIX_1_961570560 + z5;
+        z4 = z4 * -FIX_0_390180644 + z5;
+
+        d[7] = DESCALE(tmp4 + z1 + z3, DCT_CONST_BITS - DCT_PASS1_BITS);
+        d[5] = DESCALE(tmp5 + z2 + z4, DCT_CONST_BITS - DCT_PASS1_BITS);
+        d[3] = DESCALE(tmp6 + z2 + z3, DCT_CONST_BITS - DCT_PASS1_BITS);
+        d[1] = DESCALE(tmp7 + z1 + z4, DCT_CONST_BITS - DCT_PASS1_BITS);
+    }
+
+    /* Pass 2: columns, removing the pass 1 scaling */
+    for (int i = 0; i < 8; i++) {
+        int32_t* d = &data[i];
+
+        tmp0 = d[0] + d[56];
+        tmp7 = d[0] - d[56];
+        tmp1 = d[8] + d[48];
+        tmp6 = d[8] - d[48];
+        tmp2 = d[16] + d[40];
+        tmp5 = d[16] - d[40];
+        tmp3 = d[24] + d[32];
+        tmp4 = d[24] - d[32];
+
+        tmp10 = tmp0 + tmp3;
+        tmp13 = tmp0 - tmp3;
+        tmp11 = tmp1 + tmp2;
+        tmp12 = tmp1 - tmp2;
+
+        out[i] = (int16_t)DESCALE(tmp10 + tmp11, DCT_PASS1_BITS);
+        out[i + 32] = (int16_t)DESCALE(tmp10 - tmp11, DCT_PASS1_BITS);
+
+        z1 = (tmp12 + tmp13) * FIX_0_541196100;
+        out[i + 16] = (int16_t)DESCALE(z1 + tmp13 * FIX_0_765366865,
+                                       DCT_CONST_BITS + DCT_PASS1_BITS);
+        out[i + 48] = (int16_t)DESCALE(z1 - tmp12 * FIX_1_847759065,
+                                       DCT_CONST_BITS + DCT_PASS1_BITS);
+
+        z1 = tmp4 + tmp7;
+        z2 = tmp5 + tmp6;
+        z3 = tmp4 + tmp6;
+        z4 = tmp5 + tmp7;
+        z5 = (z3 + z4) * FIX_1_175875602;
+
+        tmp4 *= FIX_0_298631336;
+        tmp5 *= FIX_2_053119869;
+        tmp6 *= FIX_3_072711026;
+        tmp7 *= FIX_1_501321110;
+        z1 *= -FIX_0_899976223;
+        z2 *= -FIX_2_562915447;
+        z3 = z3 * -FIX_1_961570560 + z5;
+        z4 = z4 * -FIX_0_390180644 + z5;
+
+        out[i + 56] = (int16_t)DESCALE(tmp4 + z1 + z3, DCT_CONST_BITS + DCT_PASS1_BITS);
+        out[i + 40] = (int16_t)DESCALE(tmp5 + z2 + z4, DCT_CONST_BITS + DCT_PASS1_BITS);
+        out[i + 24] = (int16_t)DESCALE(tmp6 + z2 + z3, DCT_CONST_BITS + DCT_PASS1_BITS);
+        out[i + 8] = (int16_t)DESCALE(tmp7 + z1 + z4, DCT_CONST_BITS + DCT_PASS1_BITS);
+    }
+}
+
+/**
+ * Quantize a block into zigzag order
+ *
+ * Rounding division by 8 * quant is a multiply by the cached reciprocal,
+ * done in natural order over contiguous arrays so the compiler vectorizes
+ * it. The zigzag permutation also records which coefficients are non-zero.
+ *
+ * @return Bitmap of non-zero coefficients, bit k for zigzag position k
+ */
+static uint64_t quantize_block(const int16_t* coefs, const JpegQuantTables* tables, uint32_t t,
+                               int16_t* zz)
+{
+    const uint16_t* quant = tables->quant[t];
+    const uint32_t* recip = tables->recip[t];
+    int16_t q[JPEG_BLOCK_SIZE];
+    uint64_t mask = 0;
+
+    for (int n = 0; n < JPEG_BLOCK_SIZE; n++) {
+        int32_t value = coefs[n];
+        int32_t sign = value >> 31;
+        uint32_t mag = (uint32_t)((value ^ sign) - sign) + (uint32_t)quant[n] * 4;
+        int32_t level = (int32_t)(((uint64_t)mag * recip[n]) >> 32);
+
+        q[n] = (int16_t)((level ^ sign) - sign);
+    }
+
+    for (int k = 0; k < JPEG_BLOCK_SIZE; k++) {
+        zz[k] = q[jpeg_zigzag[k]];
+        mask |= (uint64_t)(zz[k] != 0) << k;
+    }
+
+    return mask;
+}
+
+/**
+ * Huffman code one quantized block, visiting only non-zero coefficients
+ */
+static void encode_block(JpegBitWriter* w, const int16_t* zz, uint64_t mask, int32_t* last_dc,
+                         const JpegHuffCodes* dc, const JpegHuffCodes* ac)
+{
+    int32_t diff = zz[0] - *last_dc;
+    int nbits = coef_bits(diff);
+    uint64_t ac_mask = mask & ~1ull;
+    int prev = 0;
+
+    *last_dc = zz[0];
+
+    /* Each code goes out together with its magnitude bits */
+    jpeg_bw_put_bits(w, ((uint32_t)dc->code[nbits] << nbits) |
+                        ((uint32_t)(diff < 0 ? diff - 1 : diff) & ((1u << nbits) - 1)),
+                     dc->size[nbits] + nbits);
+
+    while (ac_mask) {
+        int k = __builtin_ctzll(ac_mask);
+        int run = k - prev - 1;
+        int32_t value = zz[k];
+        int symbol = 0;
+
+        while (run > 15) {
+            jpeg_bw_put_bits(w, ac->code[0xF0], ac->size[0xF0]);
+            run -= 16;
+        }
+
+        nbits = coef_bits(value);
+        symbol = (run << 4) | nbits;
+        jpeg_bw_put_bits(w, ((uint32_t)ac->code[symbol] << nbits) |
+                            ((uint32_t)(value < 0 ? value - 1 : value) & ((1u << nbits) - 1)),
+                         ac->size[symbol] + nbits);
+
+        prev = k;
+        ac_mask &= ac_mask - 1;
+    }
+
+    if (prev != JPEG_BLOCK_SIZE - 1) {
+        jpeg_bw_put_bits(w, ac->code[0x00], ac->size[0x00]);
+    }
+}
+
+/**
+ * Count the Huffman symbols encode_block() would emit for a block
+ */
+static void count_block(const int16_t* zz, uint64_t mask, int32_t* last_dc,
+                        uint32_t* dc_freq, uint32_t* ac_freq)
+{
+    uint64_t ac_mask = mask & ~1ull;
+    int prev = 0;
+
+    dc_freq[coef_bits(zz[0] - *last_dc)]++;
+    *last_dc = zz[0];
+
+    while (ac_mask) {
+        int k = __builtin_ctzll(ac_mask);
+        int run = k - prev - 1;
+
+        ac_freq[0xF0] += (uint32_t)(run >> 4);
+        ac_freq[((run & 15) << 4) | coef_bits(zz[k])]++;
+
+        prev = k;
+        ac_mask &= ac_mask - 1;
+    }
+
+    if (prev != JPEG_BLOCK_SIZE - 1) {
+        ac_freq[0x00]++;
+    }
+}
+
+/**
+ * Emit a DHT segment
+ */
+static void put_dht(JpegBitWriter* w, uint8_t table_class_id, const JpegHuffSpec* spec)
+{
+    uint32_t count = jpeg_huff_spec_count(spec);
+
+    jpeg_bw_put_marker(w, JPEG_MARKER_DHT);
+    jpeg_bw_put_byte(w, (uint8_t)((2 + 1 + 16 + count) >> 8));
+    jpeg_bw_put_byte(w, (uint8_t)(2 + 1 + 16 + count));
+    jpeg_bw_put_byte(w, table_class_id);
+    for (int len = 1; len <= 16; len++) {
+        jpeg_bw_put_byte(w, spec->bits[len]);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        jpeg_bw_put_byte(w, spec->vals[i]);
+    }
+}
+
+/**
+ * Non-zero when the optimized tables are due for a rebuild; statistics
+ * gathered at another quality no longer describe the symbols
+ */
+static int huffman_rebuild_due(const JpegEncoder* enc)
+{
+    return enc->huff_refresh == 1 || !enc->huff_valid ||
+           enc->huff_quality != enc->quality ||
+           enc->frame_index - enc->huff_frame >= enc->huff_refresh;
+}
+
+/**
+ * Whether any of n flags is set
+ */
+static int any_set(const uint8_t* flags, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        if (flags[i]) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Level shift and forward DCT the blocks of MCU mx in an MCU row's views
+ */
+static void transform_mcu(JpegEncoder* enc, const JpegPlane* planes, uint32_t mcu_row,
+                          uint32_t mx)
+{
+    int32_t block[JPEG_BLOCK_SIZE];
+    int16_t* out = enc->coefs + ((size_t)mcu_row * enc->mcus_x + mx) * enc->blocks_in_mcu *
+                                JPEG_BLOCK_SIZE;
+
+    for (uint32_t b = 0; b < enc->blocks_in_mcu; b++) {
+        const JpegComponent* comp = &enc->comp[enc->block_comp[b]];
+        uint32_t x0 = (mx * comp->h_samp + enc->block_x[b]) * 8;
+
+        fetch_block(&planes[enc->block_comp[b]], x0, enc->block_y[b] * 8u, block);
+        fdct_islow(block, out);
+        out += JPEG_BLOCK_SIZE;
+    }
+}
+
+/**
+ * Convert and forward DCT MCU (mx, my) of a packed RGB frame
+ */
+static void transform_mcu_rgb(JpegEncoder* enc, const JpegRgbFrame* frame, uint32_t mx,
+                              uint32_t my)
+{
+    int32_t r[MAX_MCU_PIXELS * MAX_MCU_PIXELS];
+    int32_t g[MAX_MCU_PIXELS * MAX_MCU_PIXELS];
+    int32_t b[MAX_MCU_PIXELS * MAX_MCU_PIXELS];
+    int32_t chroma[2][JPEG_BLOCK_SIZE];
+    int32_t block[JPEG_BLOCK_SIZE];
+    int16_t* out = enc->coefs + ((size_t)my * enc->mcus_x + mx) * enc->blocks_in_mcu *
+                                JPEG_BLOCK_SIZE;
+
+    fetch_mcu_rgb(frame, mx * enc->mcu_width, my * enc->mcu_height,
+                  enc->mcu_width, enc->mcu_height, r, g, b);
+
+    /* Chroma is sampled 1x1, so each MCU holds one block of each */
+    if (enc->num_components > 1) {
+        rgb_chroma_blocks(r, g, b, enc->comp[0].h_samp, enc->comp[0].v_samp,
+                          chroma[0], chroma[1]);
+    }
+
+    for (uint32_t i = 0; i < enc->blocks_in_mcu; i++) {
+        uint32_t c = enc->block_comp[i];
+
+        if (c == 0) {
+            rgb_luma_block(r, g, b, enc->block_x[i], enc->block_y[i], block);
+            fdct_islow(block, out);
+        } else {
+            fdct_islow(chroma[c - 1], out);
+        }
+        out += JPEG_BLOCK_SIZE;
+    }
+}
+
+/**
+ * Whether block i must be quantized again: always, unless levels are kept
+ * and neither its MCU nor the tables changed since they were computed
+ */
+static int levels_stale(const JpegEncoder* enc, size_t i)
+{
+    return !enc->keep_levels || enc->levels_quant != enc->quant ||
+           enc->mcu_dirty[i / enc->blocks_in_mcu];
+}
+
+/**
+ * Record that every block's kept levels match the current tables
+ */
+static void levels_settled(JpegEncoder* enc)
+{
+    if (enc->keep_levels) {
+        enc->levels_quant = enc->quant;
+        memset(enc->mcu_dirty, 0, (size_t)enc->mcus_x * enc->mcus_y);
+    }
+}
+
+/**
+ * Flag the MCUs a transform rewrote
+ */
+static void mark_dirty(JpegEncoder* enc, size_t first_mcu, size_t count)
+{
+    if (enc->mcu_dirty) {
+        memset(enc->mcu_dirty + first_mcu, 1, count);
+    }
+}
+
+/**
+ * Statistics pass: quantize the whole frame and build optimal tables
+ *
+ * Tables kept across several frames start every symbol at a count of one,
+ * so later frames can always code symbols this frame did not use.
+ */
+static int build_optimal_tables(JpegEncoder* enc)
+{
+    uint32_t dc_freq[JPEG_NUM_TABLES][256];
+    uint32_t ac_freq[JPEG_NUM_TABLES][256];
+    int32_t last_dc[JPEG_MAX_COMPONENTS] = { 0 };
+    uint32_t num_tables = enc->num_components > 1 ? 2 : 1;
+
+    memset(dc_freq, 0, sizeof(dc_freq));
+    memset(ac_freq, 0, sizeof(ac_freq));
+
+    if (enc->huff_refresh > 1) {
+        for (uint32_t t = 0; t < num_tables; t++) {
+            for (int size = 0; size <= 11; size++) {
+                dc_freq[t][size] = 1;
+            }
+            ac_freq[t][0x00] = 1;
+            ac_freq[t][0xF0] = 1;
+            for (int run = 0; run < 16; run++) {
+                for (int size = 1; size <= 10; size++) {
+                    ac_freq[t][(run << 4) | size] = 1;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < enc->num_blocks; i++) {
+        uint32_t c = enc->block_comp[i % enc->blocks_in_mcu];
+        uint32_t t = enc->comp[c].table;
+        int16_t* zz = enc->qcoefs + i * JPEG_BLOCK_SIZE;
+
+        if (levels_stale(enc, i)) {
+            enc->masks[i] = quantize_block(enc->coefs + i * JPEG_BLOCK_SIZE, enc->quant, t, zz);
+        }
+        count_block(zz, enc->masks[i], &last_dc[c], dc_freq[t], ac_freq[t]);
+    }
+    levels_settled(enc);
+
+    for (uint32_t t = 0; t < num_tables; t++) {
+        if (jpeg_build_optimal_spec(dc_freq[t], &enc->opt_dc_spec[t]) != 0 ||
+            jpeg_build_optimal_spec(ac_freq[t], &enc->opt_ac_spec[t]) != 0 ||
+            jpeg_build_huff_codes(&enc->opt_dc_spec[t], &enc->opt_dc_codes[t]) != 0 ||
+            jpeg_build_huff_codes(&enc->opt_ac_spec[t], &enc->opt_ac_codes[t]) != 0) {
+            enc->huff_valid = 0;
+            return -1;
+        }
+    }
+
+    enc->huff_valid = 1;
+    enc->huff_frame = enc->frame_index;
+    enc->huff_quality = enc->quality;
+
+    return 0;
+}
+
+/* ============================================================================
+ * Internal Implementation Functions
+ * ============================================================================ */
+
+JpegEncoder* jpeg_encoder_create(uint32_t width, uint32_t height, JpegSampling sampling)
+{
+    JpegEncoder* enc = NULL;
+    uint32_t num_components = sampling == JPEG_SAMPLING_GRAY ? 1 : 3;
+    uint32_t h_samp = sampling == JPEG_SAMPLING_420 || sampling == JPEG_SAMPLING_422 ? 2 : 1;
+    uint32_t v_samp = sampling == JPEG_SAMPLING_420 ? 2 : 1;
+    uint32_t n = 0;
+
+    if (width == 0 || height == 0 || width > 65535 || height > 65535 ||
+        (uint32_t)sampling >= JPEG_SAMPLING_COUNT) {
+        return NULL;
+    }
+
+    enc = (JpegEncoder*)calloc(1, sizeof(JpegEncoder));
+    if (!enc) {
+        return NULL;
+    }
+
+    enc->width = width;
+    enc->height = height;
+    enc->num_components = num_components;
+    enc->sampling = sampling;
+
+    for (uint32_t c = 0; c < num_components; c++) {
+        enc->comp[c].id = (uint8_t)(c + 1);
+        enc->comp[c].h_samp = (uint8_t)(c == 0 ? h_samp : 1);
+        enc->comp[c].v_samp = (uint8_t)(c == 0 ? v_samp : 1);
+        enc->comp[c].table = (uint8_t)(c == 0 ? 0 : 1);
+
+        for (uint32_t y = 0; y < enc->comp[c].v_samp; y++) {
+            for (uint32_t x = 0; x < enc->comp[c].h_samp; x++) {
+                enc->block_comp[n] = (uint8_t)c;
+                enc->block_x[n] = (uint8_t)x;
+                enc->block_y[n] = (uint8_t)y;
+                n++;
+            }
+        }
+    }
+
+    enc->blocks_in_mcu = n;
+    enc->mcu_width = 8 * h_samp;
+    enc->mcu_height = 8 * v_samp;
+    enc->mcus_x = (width + enc->mcu_width - 1) / enc->mcu_width;
+    enc->mcus_y = (height + enc->mcu_height - 1) / enc->mcu_height;
+    enc->num_blocks = (size_t)enc->mcus_x * enc->mcus_y * enc->blocks_in_mcu;
+    enc->block_capacity = enc->num_blocks;
+
+    enc->coefs = (int16_t*)malloc(enc->num_blocks * JPEG_BLOCK_SIZE * sizeof(int16_t));
+    if (!enc->coefs) {
+        free(enc);
+        return NULL;
+    }
+
+    for (uint32_t t = 0; t < JPEG_NUM_TABLES; t++) {
+        enc->dc_codes[t] = jpeg_cache_dc_codes(t);
+        enc->ac_codes[t] = jpeg_cache_ac_codes(t);
+        if (!enc->dc_codes[t] || !enc->ac_codes[t]) {
+            jpeg_encoder_destroy(enc);
+            return NULL;
+        }
+    }
+
+    if (jpeg_encoder_set_quality(enc, 80) != 0) {
+        jpeg_encoder_destroy(enc);
+        return NULL;
+    }
+
+    return enc;
+}
+
+void jpeg_encoder_destroy(JpegEncoder* enc)
+{
+    if (!enc) {
+        return;
+    }
+
+    free(enc->coefs);
+    free(enc->qcoefs);
+    free(enc->masks);
+    free(enc->mcu_dirty);
+    free(enc);
+}
+
+int jpeg_encoder_resize(JpegEncoder* enc, uint32_t width, uint32_t height)
+{
+    uint32_t mcus_x = (width + enc->mcu_width - 1) / enc->mcu_width;
+    uint32_t mcus_y = (height + enc->mcu_height - 1) / enc->mcu_height;
+    size_t num_blocks = (size_t)mcus_x * mcus_y * enc->blocks_in_mcu;
+
+    if (width == 0 || height == 0 || width > 65535 || height > 65535) {
+        return -1;
+    }
+
+    /* Grow only; a buffer that grew stays valid if a later one fails */
+    if (num_blocks > enc->block_capacity) {
+        int16_t* coefs = (int16_t*)realloc(enc->coefs,
+                                           num_blocks * JPEG_BLOCK_SIZE * sizeof(int16_t));
+        if (!coefs) {
+            return -1;
+        }
+        enc->coefs = coefs;
+
+        if (enc->qcoefs) {
+            int16_t* qcoefs = (int16_t*)realloc(enc->qcoefs,
+                                                num_blocks * JPEG_BLOCK_SIZE * sizeof(int16_t));
+            uint64_t* masks = NULL;
+
+            if (!qcoefs) {
+                return -1;
+            }
+            enc->qcoefs = qcoefs;
+            masks = (uint64_t*)realloc(enc->masks, num_blocks * sizeof(uint64_t));
+            if (!masks) {
+                return -1;
+            }
+            enc->masks = masks;
+        }
+
+        if (enc->mcu_dirty) {
+            uint8_t* mcu_dirty = (uint8_t*)realloc(enc->mcu_dirty, (size_t)mcus_x * mcus_y);
+            if (!mcu_dirty) {
+                return -1;
+            }
+            enc->mcu_dirty = mcu_dirty;
+        }
+
+        enc->block_capacity = num_blocks;
+    }
+
+    enc->width = width;
+    enc->height = height;
+    enc->mcus_x = mcus_x;
+    enc->mcus_y = mcus_y;
+    enc->num_blocks = num_blocks;
+
+    /* Nothing stored describes a frame of this size */
+    enc->coefs_valid = 0;
+    enc->huff_valid = 0;
+    enc->levels_quant = NULL;
+    mark_dirty(enc, 0, (size_t)mcus_x * mcus_y);
+
+    return 0;
+}
+
+int jpeg_encoder_set_quality(JpegEncoder* enc, uint32_t quality)
+{
+    const JpegHeaderTemplate* header = jpeg_cache_header(quality, enc->sampling);
+    if (!header) {
+        return -1;
+    }
+
+    enc->quality = quality;
+    enc->header = header;
+    enc->quant = header->quant;
+
+    return 0;
+}
+
+int jpeg_encoder_set_quant_tables(JpegEncoder* enc, const uint16_t* luma,
+                                  const uint16_t* chroma)
+{
+    for (int n = 0; n < JPEG_BLOCK_SIZE; n++) {
+        if (luma[n] == 0 || luma[n] > 255 || chroma[n] == 0 || chroma[n] > 255) {
+            return -1;
+        }
+    }
+
+    jpeg_init_quant_tables(&enc->custom_quant, luma, chroma);
+    jpeg_init_header(&enc->custom_header, &enc->custom_quant, enc->sampling);
+
+    /* No quality level describes these tables; statistics gathered under
+     * other tables are not reused */
+    enc->quality = 0;
+    enc->header = &enc->custom_header;
+    enc->quant = &enc->custom_quant;
+    enc->huff_valid = 0;
+    enc->levels_quant = NULL;
+
+    return 0;
+}
+
+int jpeg_encoder_set_huffman_refresh(JpegEncoder* enc, uint32_t refresh)
+{
+    if (refresh > 0 && !enc->qcoefs) {
+        enc->qcoefs = (int16_t*)malloc(enc->block_capacity * JPEG_BLOCK_SIZE * sizeof(int16_t));
+        enc->masks = (uint64_t*)malloc(enc->block_capacity * sizeof(uint64_t));
+        if (!enc->qcoefs || !enc->masks) {
+            free(enc->qcoefs);
+            free(enc->masks);
+            enc->qcoefs = NULL;
+            enc->masks = NULL;
+            return -1;
+        }
+    }
+
+    enc->huff_refresh = refresh;
+    enc->huff_valid = 0;
+
+    return 0;
+}
+
+int jpeg_encoder_keep_levels(JpegEncoder* enc)
+{
+    int16_t* qcoefs = enc->qcoefs;
+    uint64_t* masks = enc->masks;
+    uint8_t* mcu_dirty = NULL;
+
+    if (enc->keep_levels) {
+        return 0;
+    }
+
+    /* Level buffers may already belong to Huffman refresh: free only what
+     * this call allocated */
+    if (!qcoefs) {
+        qcoefs = (int16_t*)malloc(enc->block_capacity * JPEG_BLOCK_SIZE * sizeof(int16_t));
+        masks = (uint64_t*)malloc(enc->block_capacity * sizeof(uint64_t));
+    }
+    mcu_dirty = (uint8_t*)malloc(enc->block_capacity / enc->blocks_in_mcu);
+    if (!qcoefs || !masks || !mcu_dirty) {
+        if (qcoefs != enc->qcoefs) {
+            free(qcoefs);
+            free(masks);
+        }
+        free(mcu_dirty);
+        return -1;
+    }
+
+    enc->qcoefs = qcoefs;
+    enc->masks = masks;
+    enc->mcu_dirty = mcu_dirty;
+
+    /* Nothing is kept yet */
+    memset(enc->mcu_dirty, 1, (size_t)enc->mcus_x * enc->mcus_y);
+    enc->levels_quant = NULL;
+    enc->keep_levels = 1;
+
+    return 0;
+}
+
+void jpeg_planes_nv12(const uint8_t* nv12, uint32_t width, uint32_t height, JpegPlane* planes)
+{
+    const uint8_t* uv = nv12 + (size_t)width * height;
+    uint32_t chroma_width = width / 2;
+    uint32_t chroma_height = height / 2;
+
+    planes[0].base = nv12;
+    planes[0].col_step = 1;
+    planes[0].row_step = (int32_t)width;
+    planes[0].width = width;
+    planes[0].height = height;
+
+    /* Interleaved CbCr rows share the luma stride; an odd last row or
+     * column has no chroma of its own and is covered by edge replication */
+    for (int c = 1; c <= 2; c++) {
+        planes[c].base = uv + (c - 1);
+        planes[c].col_step = 2;
+        planes[c].row_step = (int32_t)width;
+        planes[c].width = chroma_width;
+        planes[c].height = chroma_height;
+    }
+}
+
+void jpeg_planes_nv16(const uint8_t* nv16, uint32_t width, uint32_t height, JpegPlane* planes)
+{
+    jpeg_planes_nv12(nv16, width, height, planes);
+
+    /* Same layout with a CbCr row for every luma row */
+    planes[1].height = height;
+    planes[2].height = height;
+}
+
+void jpeg_planes_yuyv(const uint8_t* yuyv, uint32_t width, uint32_t height, JpegPlane* planes)
+{
+    static const uint32_t offset[JPEG_MAX_COMPONENTS] = { 0, 1, 3 };
+
+    /* Every component is read in place from the packed Y0 Cb Y1 Cr words */
+    for (int c = 0; c < JPEG_MAX_COMPONENTS; c++) {
+        planes[c].base = yuyv + offset[c];
+        planes[c].col_step = c == 0 ? 2 : 4;
+        planes[c].row_step = (int32_t)width * 2;
+        planes[c].width = c == 0 ? width : width / 2;
+        planes[c].height = height;
+    }
+}
+
+void jpeg_plane_strip(const JpegPlane* plane, uint32_t first_row, JpegPlane* strip)
+{
+    /* Rows past the bottom replicate the last one */
+    uint32_t start = first_row < plane->height ? first_row : plane->height - 1;
+
+    *strip = *plane;
+    strip->base += (int64_t)start * plane->row_step;
+    strip->height = plane->height - start;
+}
+
+void jpeg_encoder_transform_strip(JpegEncoder* enc, const JpegPlane* planes, uint32_t mcu_row)
+{
+    for (uint32_t mx = 0; mx < enc->mcus_x; mx++) {
+        transform_mcu(enc, planes, mcu_row, mx);
+    }
+    mark_dirty(enc, (size_t)mcu_row * enc->mcus_x, enc->mcus_x);
+}
+
+void jpeg_encoder_transform(JpegEncoder* enc, const JpegPlane* planes, const uint8_t* dirty)
+{
+    JpegPlane strips[JPEG_MAX_COMPONENTS];
+
+    /* A partial update needs a complete frame to patch */
+    if (!enc->coefs_valid) {
+        dirty = NULL;
+    }
+
+    for (uint32_t my = 0; my < enc->mcus_y; my++) {
+        const uint8_t* row = dirty ? dirty + (size_t)my * enc->mcus_x : NULL;
+
+        if (row && !any_set(row, enc->mcus_x)) {
+            continue;
+        }
+
+        for (uint32_t c = 0; c < enc->num_components; c++) {
+            jpeg_plane_strip(&planes[c], my * 8 * enc->comp[c].v_samp, &strips[c]);
+        }
+
+        if (!row) {
+            jpeg_encoder_transform_strip(enc, strips, my);
+            continue;
+        }
+        for (uint32_t mx = 0; mx < enc->mcus_x; mx++) {
+            if (row[mx]) {
+                transform_mcu(enc, strips, my, mx);
+                mark_dirty(enc, (size_t)my * enc->mcus_x + mx, 1);
+            }
+        }
+    }
+
+    enc->coefs_valid = 1;
+    enc->frame_index++;
+}
+
+void jpeg_encoder_transform_rgb(JpegEncoder* enc, const JpegRgbFrame* frame,
+                                const uint8_t* dirty)
+{
+    if (!enc->coefs_valid) {
+        dirty = NULL;
+    }
+
+    for (uint32_t my = 0; my < enc->mcus_y; my++) {
+        for (uint32_t mx = 0; mx < enc->mcus_x; mx++) {
+            size_t mcu = (size_t)my * enc->mcus_x + mx;
+
+            if (!dirty || dirty[mcu]) {
+                transform_mcu_rgb(enc, frame, mx, my);
+                mark_dirty(enc, mcu, 1);
+            }
+        }
+    }
+
+    enc->coefs_valid = 1;
+    enc->frame_index++;
+}
+
+int16_t* jpeg_encoder_begin_coefs(JpegEncoder* enc)
+{
+    /* The caller rewrites every block */
+    mark_dirty(enc, 0, (size_t)enc->mcus_x * enc->mcus_y);
+    enc->coefs_valid = 1;
+    enc->frame_index++;
+
+    return enc->coefs;
+}
+
+int jpeg_encoder_write(JpegEncoder* enc, uint8_t* out, uint32_t out_size, uint32_t* out_len)
+{
+    JpegBitWriter w;
+    int32_t last_dc[JPEG_MAX_COMPONENTS] = { 0 };
+    int16_t zz[JPEG_BLOCK_SIZE];
+    const JpegHeaderTemplate* header = enc->header;
+    const JpegHuffCodes* dc_codes[JPEG_NUM_TABLES];
+    const JpegHuffCodes* ac_codes[JPEG_NUM_TABLES];
+    const int16_t* coefs = enc->coefs;
+    const int16_t* qcoefs = NULL;
+    uint32_t header_len = 0;
+    size_t i = 0;
+
+    jpeg_bw_init(&w, out, out_size);
+
+    /* Optimized mode codes from the statistics pass when it rebuilt the
+     * tables, and otherwise reuses the tables of an earlier frame */
+    if (enc->huff_refresh > 0) {
+        if (huffman_rebuild_due(enc)) {
+            if (build_optimal_tables(enc) != 0) {
+                *out_len = 0;
+                return -1;
+            }
+            qcoefs = enc->qcoefs;
+        }
+        header_len = header->dht_offset;
+    } else {
+        header_len = header->len;
+    }
+
+    for (uint32_t t = 0; t < JPEG_NUM_TABLES; t++) {
+        dc_codes[t] = enc->huff_refresh > 0 ? &enc->opt_dc_codes[t] : enc->dc_codes[t];
+        ac_codes[t] = enc->huff_refresh > 0 ? &enc->opt_ac_codes[t] : enc->ac_codes[t];
+    }
+
+    /* Cached header plus the frame size */
+    if (out_size < header_len) {
+        *out_len = out_size + 1;
+        return -1;
+    }
+    memcpy(out, header->data, header_len);
+    out[header->dims_offset] = (uint8_t)(enc->height >> 8);
+    out[header->dims_offset + 1] = (uint8_t)enc->height;
+    out[header->dims_offset + 2] = (uint8_t)(enc->width >> 8);
+    out[header->dims_offset + 3] = (uint8_t)enc->width;
+    w.pos = header_len;
+
+    if (enc->huff_refresh > 0) {
+        put_dht(&w, 0x00, &enc->opt_dc_spec[0]);
+        put_dht(&w, 0x10, &enc->opt_ac_spec[0]);
+        if (enc->num_components > 1) {
+            put_dht(&w, 0x01, &enc->opt_dc_spec[1]);
+            put_dht(&w, 0x11, &enc->opt_ac_spec[1]);
+        }
+        for (uint32_t k = header->sos_offset; k < header->len; k++) {
+            jpeg_bw_put_byte(&w, header->data[k]);
+        }
+        if (w.overflow) {
+            *out_len = out_size + 1;
+            return -1;
+        }
+        header_len = w.pos;
+    }
+
+    for (i = 0; i < enc->num_blocks && !w.overflow; i++) {
+        uint32_t c = enc->block_comp[i % enc->blocks_in_mcu];
+        uint32_t t = enc->comp[c].table;
+
+        if (qcoefs) {
+            encode_block(&w, qcoefs + i * JPEG_BLOCK_SIZE, enc->masks[i], &last_dc[c],
+                         dc_codes[t], ac_codes[t]);
+        } else if (enc->keep_levels) {
+            int16_t* kept = enc->qcoefs + i * JPEG_BLOCK_SIZE;
+
+            if (levels_stale(enc, i)) {
+                enc->masks[i] = quantize_block(coefs + i * JPEG_BLOCK_SIZE, enc->quant, t, kept);
+            }
+            encode_block(&w, kept, enc->masks[i], &last_dc[c], dc_codes[t], ac_codes[t]);
+        } else {
+            uint64_t mask = quantize_block(coefs + i * JPEG_BLOCK_SIZE, enc->quant, t, zz);
+            encode_block(&w, zz, mask, &last_dc[c], dc_codes[t], ac_codes[t]);
+        }
+    }
+
+    /* Levels of a frame cut short stay stale and are redone next time */
+    if (i == enc->num_blocks) {
+        levels_settled(enc);
+    }
+
+    jpeg_bw_flush(&w);
+    jpeg_bw_put_marker(&w, JPEG_MARKER_EOI);
+
+    if (w.overflow) {
+        /* Extrapolate from the blocks coded before running out of room */
+        if (i > 0 && w.pos > header_len) {
+            *out_len = header_len + (uint32_t)((double)(w.pos - header_len) *
+                                               (double)enc->num_blocks / (double)i);
+        } else {
+            *out_len = out_size + 1;
+        }
+        return -1;
+    }
+
+    *out_len = w.pos;
+
+    return 0;
+}
+
+int jpeg_encoder_write_intervals(JpegEncoder* enc, uint32_t interval, uint8_t* out,
+                                 uint32_t out_size, uint32_t* ends, uint32_t* out_len)
+{
+    JpegBitWriter w;
+    int32_t last_dc[JPEG_MAX_COMPONENTS] = { 0 };
+    int16_t zz[JPEG_BLOCK_SIZE];
+    size_t interval_blocks = (size_t)interval * enc->blocks_in_mcu;
+    uint32_t n = 0;
+    size_t i = 0;
+
+    jpeg_bw_init(&w, out, out_size);
+
+    for (i = 0; i < enc->num_blocks && !w.overflow; i++) {
+        uint32_t c = enc->block_comp[i % enc->blocks_in_mcu];
+        uint32_t t = enc->comp[c].table;
+        uint64_t mask = quantize_block(enc->coefs + i * JPEG_BLOCK_SIZE, enc->quant, t, zz);
+
+        encode_block(&w, zz, mask, &last_dc[c], enc->dc_codes[t], enc->ac_codes[t]);
+
+        /* A restart interval ends byte-aligned and resets DC prediction */
+        if ((i + 1) % interval_blocks == 0) {
+            jpeg_bw_flush(&w);
+            ends[n++] = w.pos;
+            memset(last_dc, 0, sizeof(last_dc));
+        }
+    }
+
+    if (w.overflow) {
+        *out_len = i > 0 ? (uint32_t)((double)w.pos * (double)enc->num_blocks / (double)i)
+                         : out_size + 1;
+        return -1;
+    }
+
+    *out_len = w.pos;
+
+    return 0;
+}
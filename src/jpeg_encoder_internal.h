@@ -0,0 +1,236 @@
+/*
+ * Software JPEG Encoder Internal Implementation
+ */
+
+#ifndef JPEG_ENCODER_INTERNAL_H
+#define JPEG_ENCODER_INTERNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "jpeg_internal.h"
+
+/**
+ * Component layout inside an interleaved MCU
+ */
+typedef struct {
+    uint8_t id;                        /* Component identifier in SOF/SOS */
+    uint8_t h_samp;                    /* Horizontal sampling factor */
+    uint8_t v_samp;                    /* Vertical sampling factor */
+    uint8_t table;                     /* Quantization/Huffman table index */
+} JpegComponent;
+
+/**
+ * Packed RGB frame, 3 or 4 bytes per pixel in any channel order
+ *
+ * Steps are signed like those of JpegPlane, so a view can walk the frame
+ * in any orientation.
+ */
+typedef struct {
+    const uint8_t* base;
+    int32_t pixel_step;                /* Bytes per pixel */
+    int32_t row_step;                  /* Bytes per row */
+    uint8_t offset[3];                 /* Byte offsets of R, G and B in a pixel */
+    uint32_t width;
+    uint32_t height;
+} JpegRgbFrame;
+
+/**
+ * Baseline sequential JPEG encoder
+ *
+ * Encoding is split in two stages so quantization can change without
+ * repeating the transform: jpeg_encoder_transform() stores the unquantized
+ * DCT coefficients of the whole frame, jpeg_encoder_write() quantizes them
+ * with the current tables and emits the bitstream.
+ */
+typedef struct {
+    /* Geometry */
+    uint32_t width;
+    uint32_t height;
+    uint32_t num_components;
+    JpegComponent comp[JPEG_MAX_COMPONENTS];
+    uint32_t mcu_width;                /* MCU size in pixels */
+    uint32_t mcu_height;
+    uint32_t mcus_x;
+    uint32_t mcus_y;
+
+    /* Blocks of one MCU, in bitstream order */
+    uint32_t blocks_in_mcu;
+    uint8_t block_comp[JPEG_MAX_BLOCKS_IN_MCU];
+    uint8_t block_x[JPEG_MAX_BLOCKS_IN_MCU];
+    uint8_t block_y[JPEG_MAX_BLOCKS_IN_MCU];
+
+    /* DCT output (scaled by 8), blocks_in_mcu blocks per MCU in raster order */
+    int16_t* coefs;
+    size_t num_blocks;
+    size_t block_capacity;             /* Blocks the per-block buffers hold */
+
+    /* Tables, shared from the process-wide cache */
+    JpegSampling sampling;
+    uint32_t quality;
+    const JpegHeaderTemplate* header;
+    const JpegQuantTables* quant;
+    const JpegHuffCodes* dc_codes[JPEG_NUM_TABLES];
+    const JpegHuffCodes* ac_codes[JPEG_NUM_TABLES];
+
+    /* Caller-supplied quantization tables, used instead of the cache's */
+    JpegQuantTables custom_quant;
+    JpegHeaderTemplate custom_header;
+
+    /* Optimized Huffman tables, rebuilt every huff_refresh frames (0 = off) */
+    uint32_t huff_refresh;
+    uint32_t frame_index;              /* Frames transformed so far */
+    uint32_t huff_frame;               /* Frame the current tables were built on */
+    uint32_t huff_quality;             /* Quality the current tables were built at */
+    int huff_valid;
+    int16_t* qcoefs;                   /* Quantized blocks (zigzag) of the statistics pass */
+    uint64_t* masks;                   /* Non-zero coefficient bitmap per block */
+    JpegHuffSpec opt_dc_spec[JPEG_NUM_TABLES];
+    JpegHuffSpec opt_ac_spec[JPEG_NUM_TABLES];
+    JpegHuffCodes opt_dc_codes[JPEG_NUM_TABLES];
+    JpegHuffCodes opt_ac_codes[JPEG_NUM_TABLES];
+
+    /* Partial updates: quantized levels survive in qcoefs/masks across
+     * frames and only MCUs a transform rewrote are quantized again */
+    int coefs_valid;                   /* coefs hold a complete frame */
+    int keep_levels;
+    const JpegQuantTables* levels_quant; /* Tables the kept levels use (NULL = none) */
+    uint8_t* mcu_dirty;                /* Per MCU: transformed since last quantized */
+} JpegEncoder;
+
+/**
+ * Create an encoder for a frame geometry
+ */
+JpegEncoder* jpeg_encoder_create(uint32_t width, uint32_t height, JpegSampling sampling);
+
+/**
+ * Destroy an encoder
+ */
+void jpeg_encoder_destroy(JpegEncoder* enc);
+
+/**
+ * Change the frame size, keeping sampling and tables
+ *
+ * Buffers are reallocated only when the new frame has more blocks than
+ * any size before. Stored coefficients and statistics are discarded.
+ *
+ * @return 0 on success, -1 on an invalid size or allocation failure (the
+ *         previous size stays in effect)
+ */
+int jpeg_encoder_resize(JpegEncoder* enc, uint32_t width, uint32_t height);
+
+/**
+ * Switch to the cached tables of a quality (1-100)
+ */
+int jpeg_encoder_set_quality(JpegEncoder* enc, uint32_t quality);
+
+/**
+ * Switch to caller-supplied quantization tables (natural order, 1-255)
+ *
+ * Used to re-code coefficients with the tables they were decoded with,
+ * so that quantization reproduces the source levels exactly.
+ *
+ * @return 0 on success, -1 if an entry does not fit a baseline table
+ */
+int jpeg_encoder_set_quant_tables(JpegEncoder* enc, const uint16_t* luma,
+                                  const uint16_t* chroma);
+
+/**
+ * Use optimal Huffman tables, rebuilt from symbol statistics every
+ * refresh frames (1 = per image, 0 = Annex K tables)
+ */
+int jpeg_encoder_set_huffman_refresh(JpegEncoder* enc, uint32_t refresh);
+
+/**
+ * Keep quantized levels across frames for partial updates
+ *
+ * Once enabled, a transform given a dirty map only rewrites the flagged
+ * MCUs and jpeg_encoder_write() quantizes only what was rewritten; every
+ * block is still entropy coded. Switching tables requantizes everything.
+ */
+int jpeg_encoder_keep_levels(JpegEncoder* enc);
+
+/**
+ * Plane views of an NV12 frame (Y, Cb, Cr)
+ */
+void jpeg_planes_nv12(const uint8_t* nv12, uint32_t width, uint32_t height, JpegPlane* planes);
+
+/**
+ * Plane views of an NV16 frame (Y, Cb, Cr)
+ */
+void jpeg_planes_nv16(const uint8_t* nv16, uint32_t width, uint32_t height, JpegPlane* planes);
+
+/**
+ * Plane views of a packed YUYV frame (Y, Cb, Cr)
+ */
+void jpeg_planes_yuyv(const uint8_t* yuyv, uint32_t width, uint32_t height, JpegPlane* planes);
+
+/**
+ * Level shift and forward DCT every block of the frame
+ *
+ * With a dirty map (one byte per MCU, row-major, non-zero = changed) only
+ * the flagged MCUs are transformed and the rest keep the previous frame's
+ * coefficients; the map is ignored until a complete frame is stored.
+ */
+void jpeg_encoder_transform(JpegEncoder* enc, const JpegPlane* planes, const uint8_t* dirty);
+
+/**
+ * View of a plane starting at first_row (clamped to the last row)
+ */
+void jpeg_plane_strip(const JpegPlane* plane, uint32_t first_row, JpegPlane* strip);
+
+/**
+ * Level shift and forward DCT one MCU row
+ *
+ * Row 0 of each plane view is the top of the MCU row, and rows past a
+ * view's height replicate its last row, so the views can be a strip of a
+ * frame (jpeg_plane_strip()) or a buffer holding just this MCU row. Start
+ * the frame with jpeg_encoder_begin_coefs().
+ */
+void jpeg_encoder_transform_strip(JpegEncoder* enc, const JpegPlane* planes, uint32_t mcu_row);
+
+/**
+ * Convert packed RGB to YCbCr and forward DCT every block of the frame
+ *
+ * Conversion runs one MCU at a time as blocks are extracted, so the
+ * frame is read once and no YCbCr copy of it is ever stored. The dirty
+ * map works as for jpeg_encoder_transform().
+ */
+void jpeg_encoder_transform_rgb(JpegEncoder* enc, const JpegRgbFrame* frame,
+                                const uint8_t* dirty);
+
+/**
+ * Start a frame whose coefficients the caller supplies (DCT-domain
+ * transcoding)
+ *
+ * @return The coefficient array to fill in the layout jpeg_encoder_transform()
+ *         produces, ready for jpeg_encoder_write()
+ */
+int16_t* jpeg_encoder_begin_coefs(JpegEncoder* enc);
+
+/**
+ * Quantize the stored coefficients and write a complete JFIF image
+ *
+ * Coding stops as soon as the buffer is full, in which case out_len
+ * receives an estimate of the size the complete image would need.
+ *
+ * @return 0 on success, -1 if the output buffer is too small
+ */
+int jpeg_encoder_write(JpegEncoder* enc, uint8_t* out, uint32_t out_size, uint32_t* out_len);
+
+/**
+ * Quantize and code the stored coefficients as bare restart intervals
+ *
+ * Every interval MCUs (which must divide the MCU count) the coder pads to
+ * a byte boundary and resets DC prediction, and ends[] receives the
+ * offset where that interval ends; ends needs one entry per interval.
+ * No headers, RST markers or EOI are written, so the intervals of several
+ * encoders can be interleaved into one scan. Uses the Annex K tables.
+ *
+ * @return 0 on success, -1 if the output buffer is too small (out_len then
+ *         estimates the size needed)
+ */
+int jpeg_encoder_write_intervals(JpegEncoder* enc, uint32_t interval, uint8_t* out,
+                                 uint32_t out_size, uint32_t* ends, uint32_t* out_len);
+
+#endif /* JPEG_ENCODER_INTERNAL_H */
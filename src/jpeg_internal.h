@@ -0,0 +1,162 @@
+/*
+ * Baseline JPEG Shared Definitions
+ *
+ * Tables and helpers shared by the software (CPU backend) JPEG paths.
+ */
+
+#ifndef JPEG_INTERNAL_H
+#define JPEG_INTERNAL_H
+
+#include <stdint.h>
+
+/* Limits */
+#define JPEG_BLOCK_SIZE         64
+#define JPEG_MAX_COMPONENTS     3
+#define JPEG_MAX_BLOCKS_IN_MCU  10
+#define JPEG_NUM_TABLES         2      /* Luma and chroma */
+
+/* Markers */
+#define JPEG_MARKER_SOF0 0xC0
+#define JPEG_MARKER_SOF1 0xC1
+#define JPEG_MARKER_DHT  0xC4
+#define JPEG_MARKER_RST0 0xD0
+#define JPEG_MARKER_SOI  0xD8
+#define JPEG_MARKER_EOI  0xD9
+#define JPEG_MARKER_SOS  0xDA
+#define JPEG_MARKER_DQT  0xDB
+#define JPEG_MARKER_DRI  0xDD
+#define JPEG_MARKER_APP0 0xE0
+
+/**
+ * Huffman table specification as carried in DHT
+ */
+typedef struct {
+    uint8_t bits[17];                  /* bits[n]: number of codes of length n */
+    uint8_t vals[256];                 /* Symbols in code order */
+} JpegHuffSpec;
+
+/**
+ * Huffman encoding table: code and length per symbol
+ */
+typedef struct {
+    uint16_t code[256];
+    uint8_t size[256];
+} JpegHuffCodes;
+
+/**
+ * Strided view of one sample plane
+ *
+ * Sample (x, y) lives at base + x * col_step + y * row_step, which covers
+ * planar, semi-planar and packed layouts with the same fetch code.
+ */
+typedef struct {
+    const uint8_t* base;
+    int32_t col_step;
+    int32_t row_step;
+    uint32_t width;
+    uint32_t height;
+} JpegPlane;
+
+/* Chroma subsampling of a frame */
+typedef enum {
+    JPEG_SAMPLING_420 = 0,             /* Luma 2x2, chroma 1x1 */
+    JPEG_SAMPLING_422 = 1,             /* Luma 2x1, chroma 1x1 */
+    JPEG_SAMPLING_444 = 2,             /* All components 1x1 */
+    JPEG_SAMPLING_GRAY = 3,            /* Luma only */
+    JPEG_SAMPLING_COUNT
+} JpegSampling;
+
+/* Largest SOI..SOS header the cache emits */
+#define JPEG_MAX_HEADER 640
+
+/**
+ * Quantization tables for one quality level
+ */
+typedef struct {
+    uint16_t quant[JPEG_NUM_TABLES][JPEG_BLOCK_SIZE];   /* Natural order */
+    uint32_t recip[JPEG_NUM_TABLES][JPEG_BLOCK_SIZE];   /* Natural order, 2^32 / (8 * quant) */
+} JpegQuantTables;
+
+/**
+ * Prebuilt SOI..SOS header for one quality level and subsampling
+ *
+ * Everything but the frame size is fixed, so an image starts with one
+ * memcpy of data followed by a 4-byte patch at dims_offset.
+ */
+typedef struct {
+    const JpegQuantTables* quant;
+    uint8_t data[JPEG_MAX_HEADER];
+    uint32_t len;
+    uint32_t dims_offset;              /* SOF height, then width (big endian) */
+    uint32_t dht_offset;               /* First DHT marker */
+    uint32_t sos_offset;               /* SOS marker, right after the last DHT */
+} JpegHeaderTemplate;
+
+/* Zigzag position -> natural (row-major) coefficient index */
+extern const uint8_t jpeg_zigzag[JPEG_BLOCK_SIZE];
+
+/* ITU-T T.81 Annex K tables (natural order) */
+extern const uint8_t jpeg_std_luma_quant[JPEG_BLOCK_SIZE];
+extern const uint8_t jpeg_std_chroma_quant[JPEG_BLOCK_SIZE];
+extern const JpegHuffSpec jpeg_std_dc_luma;
+extern const JpegHuffSpec jpeg_std_dc_chroma;
+extern const JpegHuffSpec jpeg_std_ac_luma;
+extern const JpegHuffSpec jpeg_std_ac_chroma;
+
+/**
+ * Scale a base quantization table for an IJG quality (1-100)
+ */
+void jpeg_scale_quant_table(const uint8_t* base, uint32_t quality, uint16_t* table);
+
+/**
+ * Quality to IJG percentage scale factor and back
+ */
+uint32_t jpeg_quality_to_scale(uint32_t quality);
+uint32_t jpeg_scale_to_quality(uint32_t scale);
+
+/**
+ * Derive per-symbol codes from a DHT specification
+ */
+int jpeg_build_huff_codes(const JpegHuffSpec* spec, JpegHuffCodes* codes);
+
+/**
+ * Number of symbols in a DHT specification
+ */
+uint32_t jpeg_huff_spec_count(const JpegHuffSpec* spec);
+
+/**
+ * Build an optimal length-limited (16 bit) code for symbol frequencies
+ *
+ * @param freq 256 symbol counts; symbols with a zero count get no code
+ */
+int jpeg_build_optimal_spec(const uint32_t* freq, JpegHuffSpec* spec);
+
+/**
+ * Fill quantization tables and their reciprocals (natural order)
+ */
+void jpeg_init_quant_tables(JpegQuantTables* tables, const uint16_t* luma,
+                            const uint16_t* chroma);
+
+/**
+ * Build the SOI..SOS header for a set of quantization tables
+ */
+void jpeg_init_header(JpegHeaderTemplate* header, const JpegQuantTables* quant,
+                      JpegSampling sampling);
+
+/**
+ * Process-wide table cache
+ *
+ * Entries are built on first use and never change afterwards, so the
+ * returned pointers stay valid for the life of the process and can be
+ * shared by any number of encoders without locking.
+ */
+const JpegQuantTables* jpeg_cache_quant(uint32_t quality);
+const JpegHeaderTemplate* jpeg_cache_header(uint32_t quality, JpegSampling sampling);
+
+/**
+ * Annex K Huffman codes: table 0 luma, table 1 chroma
+ */
+const JpegHuffCodes* jpeg_cache_dc_codes(uint32_t table);
+const JpegHuffCodes* jpeg_cache_ac_codes(uint32_t table);
+
+#endif /* JPEG_INTERNAL_H */
@@ -0,0 +1,301 @@
+/*
+ * JPEG Table Cache
+ *
+ * Process-wide cache of everything derived from a quality level: scaled
+ * quantization tables, their reciprocals for multiply-shift quantization,
+ * and the complete SOI..SOS header per subsampling. Entries are built
+ * lazily under a global lock and published with release stores, so lookups
+ * after the first are a single acquire load.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "jpeg_internal.h"
+
+#define JPEG_NUM_QUALITIES 101
+
+/**
+ * Annex K Huffman codes, built once
+ */
+typedef struct {
+    JpegHuffCodes dc[JPEG_NUM_TABLES];
+    JpegHuffCodes ac[JPEG_NUM_TABLES];
+} JpegStdCodes;
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static JpegQuantTables* quant_cache[JPEG_NUM_QUALITIES];
+static JpegHeaderTemplate* header_cache[JPEG_SAMPLING_COUNT][JPEG_NUM_QUALITIES];
+static JpegStdCodes* std_codes;
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+/**
+ * Header byte writer
+ */
+typedef struct {
+    uint8_t* buf;
+    uint32_t pos;
+} HeaderWriter;
+
+static void hdr_byte(HeaderWriter* w, uint8_t value)
+{
+    w->buf[w->pos++] = value;
+}
+
+static void hdr_u16(HeaderWriter* w, uint16_t value)
+{
+    hdr_byte(w, (uint8_t)(value >> 8));
+    hdr_byte(w, (uint8_t)value);
+}
+
+static void hdr_marker(HeaderWriter* w, uint8_t marker)
+{
+    hdr_byte(w, 0xFF);
+    hdr_byte(w, marker);
+}
+
+static void hdr_dht(HeaderWriter* w, uint8_t table_class_id, const JpegHuffSpec* spec)
+{
+    uint32_t count = jpeg_huff_spec_count(spec);
+
+    hdr_marker(w, JPEG_MARKER_DHT);
+    hdr_u16(w, (uint16_t)(2 + 1 + 16 + count));
+    hdr_byte(w, table_class_id);
+    for (int len = 1; len <= 16; len++) {
+        hdr_byte(w, spec->bits[len]);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        hdr_byte(w, spec->vals[i]);
+    }
+}
+
+static JpegQuantTables* build_quant(uint32_t quality)
+{
+    uint16_t luma[JPEG_BLOCK_SIZE];
+    uint16_t chroma[JPEG_BLOCK_SIZE];
+
+    JpegQuantTables* tables = (JpegQuantTables*)malloc(sizeof(JpegQuantTables));
+    if (!tables) {
+        return NULL;
+    }
+
+    jpeg_scale_quant_table(jpeg_std_luma_quant, quality, luma);
+    jpeg_scale_quant_table(jpeg_std_chroma_quant, quality, chroma);
+    jpeg_init_quant_tables(tables, luma, chroma);
+
+    return tables;
+}
+
+static JpegHeaderTemplate* build_header(const JpegQuantTables* quant, JpegSampling sampling)
+{
+    JpegHeaderTemplate* header = (JpegHeaderTemplate*)malloc(sizeof(JpegHeaderTemplate));
+    if (!header) {
+        return NULL;
+    }
+
+    jpeg_init_header(header, quant, sampling);
+
+    return header;
+}
+
+static JpegStdCodes* build_std_codes(void)
+{
+    JpegStdCodes* codes = (JpegStdCodes*)malloc(sizeof(JpegStdCodes));
+    if (!codes) {
+        return NULL;
+    }
+
+    if (jpeg_build_huff_codes(&jpeg_std_dc_luma, &codes->dc[0]) != 0 ||
+        jpeg_build_huff_codes(&jpeg_std_ac_luma, &codes->ac[0]) != 0 ||
+        jpeg_build_huff_codes(&jpeg_std_dc_chroma, &codes->dc[1]) != 0 ||
+        jpeg_build_huff_codes(&jpeg_std_ac_chroma, &codes->ac[1]) != 0) {
+        free(codes);
+        return NULL;
+    }
+
+    return codes;
+}
+
+static const JpegStdCodes* cache_std_codes(void)
+{
+    JpegStdCodes* codes = __atomic_load_n(&std_codes, __ATOMIC_ACQUIRE);
+    if (codes) {
+        return codes;
+    }
+
+    pthread_mutex_lock(&cache_lock);
+    codes = std_codes;
+    if (!codes) {
+        codes = build_std_codes();
+        __atomic_store_n(&std_codes, codes, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&cache_lock);
+
+    return codes;
+}
+
+static uint32_t clamp_quality(uint32_t quality)
+{
+    return quality > 100 ? 100 : quality;
+}
+
+/* ============================================================================
+ * Internal Implementation Functions
+ * ============================================================================ */
+
+void jpeg_init_quant_tables(JpegQuantTables* tables, const uint16_t* luma,
+                            const uint16_t* chroma)
+{
+    memcpy(tables->quant[0], luma, sizeof(tables->quant[0]));
+    memcpy(tables->quant[1], chroma, sizeof(tables->quant[1]));
+
+    /* ceil(2^32 / d) gives exact rounding division for |coef| <= 2^15 */
+    for (int t = 0; t < JPEG_NUM_TABLES; t++) {
+        for (int n = 0; n < JPEG_BLOCK_SIZE; n++) {
+            uint64_t divisor = (uint64_t)tables->quant[t][n] * 8;
+            tables->recip[t][n] = (uint32_t)(((1ull << 32) + divisor - 1) / divisor);
+        }
+    }
+}
+
+void jpeg_init_header(JpegHeaderTemplate* header, const JpegQuantTables* quant,
+                      JpegSampling sampling)
+{
+    static const uint8_t jfif[] = {
+        'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0
+    };
+    uint32_t num_components = sampling == JPEG_SAMPLING_GRAY ? 1 : 3;
+    uint32_t num_tables = num_components > 1 ? 2 : 1;
+    uint8_t luma_samp = sampling == JPEG_SAMPLING_420 ? 0x22 :
+                        sampling == JPEG_SAMPLING_422 ? 0x21 : 0x11;
+    HeaderWriter w;
+
+    header->quant = quant;
+    w.buf = header->data;
+    w.pos = 0;
+
+    hdr_marker(&w, JPEG_MARKER_SOI);
+
+    hdr_marker(&w, JPEG_MARKER_APP0);
+    hdr_u16(&w, (uint16_t)(2 + sizeof(jfif)));
+    for (size_t i = 0; i < sizeof(jfif); i++) {
+        hdr_byte(&w, jfif[i]);
+    }
+
+    hdr_marker(&w, JPEG_MARKER_DQT);
+    hdr_u16(&w, (uint16_t)(2 + num_tables * 65));
+    for (uint32_t t = 0; t < num_tables; t++) {
+        hdr_byte(&w, (uint8_t)t);
+        for (int k = 0; k < JPEG_BLOCK_SIZE; k++) {
+            hdr_byte(&w, (uint8_t)quant->quant[t][jpeg_zigzag[k]]);
+        }
+    }
+
+    hdr_marker(&w, JPEG_MARKER_SOF0);
+    hdr_u16(&w, (uint16_t)(8 + 3 * num_components));
+    hdr_byte(&w, 8);
+    header->dims_offset = w.pos;
+    hdr_u16(&w, 0);
+    hdr_u16(&w, 0);
+    hdr_byte(&w, (uint8_t)num_components);
+    for (uint32_t c = 0; c < num_components; c++) {
+        hdr_byte(&w, (uint8_t)(c + 1));
+        hdr_byte(&w, c == 0 ? luma_samp : 0x11);
+        hdr_byte(&w, (uint8_t)(c == 0 ? 0 : 1));
+    }
+
+    header->dht_offset = w.pos;
+    hdr_dht(&w, 0x00, &jpeg_std_dc_luma);
+    hdr_dht(&w, 0x10, &jpeg_std_ac_luma);
+    if (num_tables > 1) {
+        hdr_dht(&w, 0x01, &jpeg_std_dc_chroma);
+        hdr_dht(&w, 0x11, &jpeg_std_ac_chroma);
+    }
+
+    header->sos_offset = w.pos;
+    hdr_marker(&w, JPEG_MARKER_SOS);
+    hdr_u16(&w, (uint16_t)(6 + 2 * num_components));
+    hdr_byte(&w, (uint8_t)num_components);
+    for (uint32_t c = 0; c < num_components; c++) {
+        hdr_byte(&w, (uint8_t)(c + 1));
+        hdr_byte(&w, (uint8_t)(c == 0 ? 0x00 : 0x11));
+    }
+    hdr_byte(&w, 0);
+    hdr_byte(&w, 63);
+    hdr_byte(&w, 0);
+
+    header->len = w.pos;
+}
+
+const JpegQuantTables* jpeg_cache_quant(uint32_t quality)
+{
+    JpegQuantTables* tables = NULL;
+
+    quality = clamp_quality(quality);
+
+    tables = __atomic_load_n(&quant_cache[quality], __ATOMIC_ACQUIRE);
+    if (tables) {
+        return tables;
+    }
+
+    pthread_mutex_lock(&cache_lock);
+    tables = quant_cache[quality];
+    if (!tables) {
+        tables = build_quant(quality);
+        __atomic_store_n(&quant_cache[quality], tables, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&cache_lock);
+
+    return tables;
+}
+
+const JpegHeaderTemplate* jpeg_cache_header(uint32_t quality, JpegSampling sampling)
+{
+    const JpegQuantTables* quant = NULL;
+    JpegHeaderTemplate* header = NULL;
+
+    if ((uint32_t)sampling >= JPEG_SAMPLING_COUNT) {
+        return NULL;
+    }
+
+    quality = clamp_quality(quality);
+
+    header = __atomic_load_n(&header_cache[sampling][quality], __ATOMIC_ACQUIRE);
+    if (header) {
+        return header;
+    }
+
+    quant = jpeg_cache_quant(quality);
+    if (!quant) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&cache_lock);
+    header = header_cache[sampling][quality];
+    if (!header) {
+        header = build_header(quant, sampling);
+        __atomic_store_n(&header_cache[sampling][quality], header, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&cache_lock);
+
+    return header;
+}
+
+const JpegHuffCodes* jpeg_cache_dc_codes(uint32_t table)
+{
+    const JpegStdCodes* codes = cache_std_codes();
+
+    return codes && table < JPEG_NUM_TABLES ? &codes->dc[table] : NULL;
+}
+
+const JpegHuffCodes* jpeg_cache_ac_codes(uint32_t table)
+{
+    const JpegStdCodes* codes = cache_std_codes();
+
+    return codes && table < JPEG_NUM_TABLES ? &codes->ac[table] : NULL;
+}
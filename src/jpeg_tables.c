@@ -0,0 +1,313 @@
+/*
+ * Baseline JPEG Tables
+ *
+ * Standard quantization and Huffman tables from ITU-T T.81 Annex K and the
+ * IJG quality scaling used to derive per-quality quantization tables.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "jpeg_internal.h"
+
+/* ============================================================================
+ * Standard Tables
+ * ============================================================================ */
+
+const uint8_t jpeg_zigzag[JPEG_BLOCK_SIZE] = {
+     0,  1,  8, 16,  9,  2,  3, 10,
+    17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63
+};
+
+const uint8_t jpeg_std_luma_quant[JPEG_BLOCK_SIZE] = {
+    16, 11, 10, 16,  24,  40,  51,  61,
+    12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,
+    14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,
+    24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103,  99
+};
+
+const uint8_t jpeg_std_chroma_quant[JPEG_BLOCK_SIZE] = {
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99
+};
+
+const JpegHuffSpec jpeg_std_dc_luma = {
+    { 0, 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 },
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 }
+};
+
+const JpegHuffSpec jpeg_std_dc_chroma = {
+    { 0, 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 },
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 }
+};
+
+const JpegHuffSpec jpeg_std_ac_luma = {
+    { 0, 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d },
+    {
+        0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12,
+        0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+        0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08,
+        0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+        0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16,
+        0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+        0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+        0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+        0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+        0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+        0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79,
+        0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+        0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98,
+        0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+        0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6,
+        0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+        0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4,
+        0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+        0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea,
+        0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+        0xf9, 0xfa
+    }
+};
+
+const JpegHuffSpec jpeg_std_ac_chroma = {
+    { 0, 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 },
+    {
+        0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21,
+        0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+        0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+        0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+        0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34,
+        0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+        0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38,
+        0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+        0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+        0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+        0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78,
+        0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+        0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96,
+        0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+        0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+        0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+        0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2,
+        0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+        0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9,
+        0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+        0xf9, 0xfa
+    }
+};
+
+/* ============================================================================
+ * Table Derivation
+ * ============================================================================ */
+
+uint32_t jpeg_quality_to_scale(uint32_t quality)
+{
+    if (quality < 1) {
+        quality = 1;
+    }
+    if (quality > 100) {
+        quality = 100;
+    }
+
+    return quality < 50 ? 5000 / quality : 200 - quality * 2;
+}
+
+uint32_t jpeg_scale_to_quality(uint32_t scale)
+{
+    uint32_t quality = 0;
+
+    if (scale > 100) {
+        quality = (5000 + scale / 2) / scale;
+    } else {
+        quality = (200 - scale + 1) / 2;
+    }
+
+    if (quality < 1) {
+        quality = 1;
+    }
+    if (quality > 100) {
+        quality = 100;
+    }
+
+    return quality;
+}
+
+void jpeg_scale_quant_table(const uint8_t* base, uint32_t quality, uint16_t* table)
+{
+    uint32_t scale = jpeg_quality_to_scale(quality);
+
+    for (int i = 0; i < JPEG_BLOCK_SIZE; i++) {
+        uint32_t q = (base[i] * scale + 50) / 100;
+
+        /* Baseline DQT carries 8-bit entries */
+        if (q < 1) {
+            q = 1;
+        }
+        if (q > 255) {
+            q = 255;
+        }
+        table[i] = (uint16_t)q;
+    }
+}
+
+uint32_t jpeg_huff_spec_count(const JpegHuffSpec* spec)
+{
+    uint32_t count = 0;
+
+    for (int len = 1; len <= 16; len++) {
+        count += spec->bits[len];
+    }
+
+    return count;
+}
+
+int jpeg_build_huff_codes(const JpegHuffSpec* spec, JpegHuffCodes* codes)
+{
+    uint32_t code = 0;
+    uint32_t k = 0;
+
+    memset(codes, 0, sizeof(JpegHuffCodes));
+
+    /* Canonical code assignment (T.81 Annex C) */
+    for (int len = 1; len <= 16; len++) {
+        for (int i = 0; i < spec->bits[len]; i++) {
+            if (k >= 256) {
+                return -1;
+            }
+            codes->code[spec->vals[k]] = (uint16_t)code;
+            codes->size[spec->vals[k]] = (uint8_t)len;
+            code++;
+            k++;
+        }
+        if (code > (1u << len)) {
+            return -1;
+        }
+        code <<= 1;
+    }
+
+    return 0;
+}
+
+int jpeg_build_optimal_spec(const uint32_t* freq, JpegHuffSpec* spec)
+{
+    uint32_t count[257];
+    int code_size[257];
+    int others[257];
+    int bits[33];
+    int p = 0;
+
+    memset(code_size, 0, sizeof(code_size));
+    memset(bits, 0, sizeof(bits));
+    memset(spec, 0, sizeof(JpegHuffSpec));
+
+    for (int i = 0; i < 256; i++) {
+        count[i] = freq[i];
+        others[i] = -1;
+    }
+
+    /* Reserved symbol keeps the all-ones code out of the table (T.81 K.2) */
+    count[256] = 1;
+    others[256] = -1;
+
+    for (;;) {
+        int c1 = -1;
+        int c2 = -1;
+        uint32_t v1 = UINT32_MAX;
+        uint32_t v2 = UINT32_MAX;
+
+        /* Two least frequent trees; ties go to the larger symbol */
+        for (int i = 0; i <= 256; i++) {
+            if (count[i] && count[i] <= v1) {
+                v2 = v1;
+                c2 = c1;
+                v1 = count[i];
+                c1 = i;
+            } else if (count[i] && count[i] <= v2) {
+                v2 = count[i];
+                c2 = i;
+            }
+        }
+
+        if (c2 < 0) {
+            break;
+        }
+
+        /* Merge c2 into c1, lengthening every code in both trees */
+        count[c1] += count[c2];
+        count[c2] = 0;
+
+        code_size[c1]++;
+        while (others[c1] >= 0) {
+            c1 = others[c1];
+            code_size[c1]++;
+        }
+        others[c1] = c2;
+
+        code_size[c2]++;
+        while (others[c2] >= 0) {
+            c2 = others[c2];
+            code_size[c2]++;
+        }
+    }
+
+    for (int i = 0; i <= 256; i++) {
+        if (code_size[i]) {
+            if (code_size[i] > 32) {
+                return -1;
+            }
+            bits[code_size[i]]++;
+        }
+    }
+
+    /* Limit code lengths to 16 bits (T.81 Figure K.3) */
+    for (int i = 32; i > 16; i--) {
+        while (bits[i] > 0) {
+            int j = i - 2;
+            while (bits[j] == 0) {
+                j--;
+            }
+            bits[i] -= 2;
+            bits[i - 1]++;
+            bits[j + 1] += 2;
+            bits[j]--;
+        }
+    }
+
+    /* Drop the reserved symbol's code from the longest length */
+    for (int i = 16; i > 0; i--) {
+        if (bits[i]) {
+            bits[i]--;
+            break;
+        }
+    }
+
+    for (int i = 1; i <= 16; i++) {
+        spec->bits[i] = (uint8_t)bits[i];
+    }
+
+    /* Symbols sorted by their unlimited code length */
+    for (int len = 1; len <= 32; len++) {
+        for (int i = 0; i < 256; i++) {
+            if (code_size[i] == len) {
+                spec->vals[p++] = (uint8_t)i;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * JPEG Geometric Transform Implementation
+ *
+ * Flips, rotations and transposition of a frame carried out on its DCT
+ * coefficients. Mirroring a block negates its odd-frequency coefficients
+ * along that axis and transposing it swaps rows and columns of the
+ * coefficient matrix, so the quantized levels come out unchanged and
+ * re-coding them with the source tables loses nothing.
+ *
+ * Raw input is oriented before the DCT instead, by rewriting the strided
+ * views the encoder fetches its blocks through.
+ */
+
+#include <stdint.h>
+
+#include "jpeg_transform_internal.h"
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+/**
+ * Whether a transform swaps the axes
+ */
+static int transposes(JpegTransform op)
+{
+    return op == JPEG_TRANSFORM_TRANSPOSE || op == JPEG_TRANSFORM_ROT90 ||
+           op == JPEG_TRANSFORM_ROT270;
+}
+
+/**
+ * Whether a transform reverses the source's columns
+ */
+static int reverses_x(JpegTransform op)
+{
+    return op == JPEG_TRANSFORM_HFLIP || op == JPEG_TRANSFORM_ROT180 ||
+           op == JPEG_TRANSFORM_ROT270;
+}
+
+/**
+ * Whether a transform reverses the source's rows
+ */
+static int reverses_y(JpegTransform op)
+{
+    return op == JPEG_TRANSFORM_VFLIP || op == JPEG_TRANSFORM_ROT180 ||
+           op == JPEG_TRANSFORM_ROT90;
+}
+
+/**
+ * Per output coefficient: source coefficient and sign
+ *
+ * Reversal is applied after transposition, on the output's axes.
+ */
+static void build_block_map(JpegTransform op, uint8_t* index, int16_t* sign)
+{
+    int flip_u = op == JPEG_TRANSFORM_HFLIP || op == JPEG_TRANSFORM_ROT180 ||
+                 op == JPEG_TRANSFORM_ROT90;
+    int flip_v = op == JPEG_TRANSFORM_VFLIP || op == JPEG_TRANSFORM_ROT180 ||
+                 op == JPEG_TRANSFORM_ROT270;
+
+    for (int v = 0; v < 8; v++) {
+        for (int u = 0; u < 8; u++) {
+            int negate = ((flip_u && (u & 1)) != 0) ^ ((flip_v && (v & 1)) != 0);
+
+            index[v * 8 + u] = (uint8_t)(transposes(op) ? u * 8 + v : v * 8 + u);
+            sign[v * 8 + u] = (int16_t)(negate ? -1 : 1);
+        }
+    }
+}
+
+/**
+ * Reorient a strided view: sample (x, y) of the result is the transformed
+ * sample of the original view
+ */
+static void orient_view(JpegTransform op, const uint8_t** base, int32_t* col_step,
+                        int32_t* row_step, uint32_t* width, uint32_t* height)
+{
+    /* Reverse on the source axes first, then swap them */
+    if (reverses_x(op)) {
+        *base += (int64_t)(*width - 1) * *col_step;
+        *col_step = -*col_step;
+    }
+    if (reverses_y(op)) {
+        *base += (int64_t)(*height - 1) * *row_step;
+        *row_step = -*row_step;
+    }
+
+    if (transposes(op)) {
+        int32_t step = *col_step;
+        uint32_t size = *width;
+
+        *col_step = *row_step;
+        *row_step = step;
+        *width = *height;
+        *height = size;
+    }
+}
+
+/* ============================================================================
+ * Internal Implementation Functions
+ * ============================================================================ */
+
+int jpeg_transform_size(JpegTransform op, JpegSampling sampling, uint32_t width,
+                        uint32_t height, uint32_t* out_width, uint32_t* out_height)
+{
+    uint32_t mcu_width = sampling == JPEG_SAMPLING_420 || sampling == JPEG_SAMPLING_422 ? 16 : 8;
+    uint32_t mcu_height = sampling == JPEG_SAMPLING_420 ? 16 : 8;
+
+    if ((uint32_t)op >= JPEG_TRANSFORM_COUNT ||
+        (transposes(op) && sampling == JPEG_SAMPLING_422)) {
+        return -1;
+    }
+
+    if (reverses_x(op)) {
+        width -= width % mcu_width;
+    }
+    if (reverses_y(op)) {
+        height -= height % mcu_height;
+    }
+    if (width == 0 || height == 0) {
+        return -1;
+    }
+
+    *out_width = transposes(op) ? height : width;
+    *out_height = transposes(op) ? width : height;
+
+    return 0;
+}
+
+void jpeg_transform_plane(JpegTransform op, JpegPlane* plane)
+{
+    orient_view(op, &plane->base, &plane->col_step, &plane->row_step,
+                &plane->width, &plane->height);
+}
+
+void jpeg_transform_rgb_frame(JpegTransform op, JpegRgbFrame* frame)
+{
+    orient_view(op, &frame->base, &frame->pixel_step, &frame->row_step,
+                &frame->width, &frame->height);
+}
+
+void jpeg_transform_coefs(JpegTransform op, const JpegEncoder* src, JpegEncoder* dst)
+{
+    uint8_t index[JPEG_BLOCK_SIZE];
+    int16_t sign[JPEG_BLOCK_SIZE];
+    uint32_t first_block[JPEG_MAX_COMPONENTS] = { 0 };
+    int16_t* out = jpeg_encoder_begin_coefs(dst);
+    int swap = transposes(op);
+
+    /* MCUs of the source that survive trimming */
+    uint32_t src_mcus_x = swap ? dst->mcus_y : dst->mcus_x;
+    uint32_t src_mcus_y = swap ? dst->mcus_x : dst->mcus_y;
+
+    build_block_map(op, index, sign);
+
+    /* Components follow each other inside an MCU */
+    for (uint32_t b = src->blocks_in_mcu; b-- > 0;) {
+        first_block[src->block_comp[b]] = b;
+    }
+
+    for (uint32_t my = 0; my < dst->mcus_y; my++) {
+        for (uint32_t mx = 0; mx < dst->mcus_x; mx++) {
+            for (uint32_t b = 0; b < dst->blocks_in_mcu; b++) {
+                uint32_t c = dst->block_comp[b];
+                uint32_t h = src->comp[c].h_samp;
+                uint32_t v = src->comp[c].v_samp;
+                uint32_t dbx = mx * dst->comp[c].h_samp + dst->block_x[b];
+                uint32_t dby = my * dst->comp[c].v_samp + dst->block_y[b];
+
+                /* Component block coordinates in the source */
+                uint32_t sbx = swap ? dby : dbx;
+                uint32_t sby = swap ? dbx : dby;
+                const int16_t* in = NULL;
+
+                if (reverses_x(op)) {
+                    sbx = src_mcus_x * h - 1 - sbx;
+                }
+                if (reverses_y(op)) {
+                    sby = src_mcus_y * v - 1 - sby;
+                }
+
+                in = src->coefs + (((size_t)(sby / v) * src->mcus_x + sbx / h) *
+                                   src->blocks_in_mcu +
+                                   first_block[c] + (sby % v) * h + sbx % h) * JPEG_BLOCK_SIZE;
+
+                for (int k = 0; k < JPEG_BLOCK_SIZE; k++) {
+                    out[k] = (int16_t)(in[index[k]] * sign[k]);
+                }
+                out += JPEG_BLOCK_SIZE;
+            }
+        }
+    }
+}
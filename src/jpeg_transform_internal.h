@@ -0,0 +1,60 @@
+/*
+ * JPEG Geometric Transform Internal Implementation
+ */
+
+#ifndef JPEG_TRANSFORM_INTERNAL_H
+#define JPEG_TRANSFORM_INTERNAL_H
+
+#include <stdint.h>
+
+#include "jpeg_internal.h"
+#include "jpeg_encoder_internal.h"
+
+/* Geometric transforms, in RkmppTransform order */
+typedef enum {
+    JPEG_TRANSFORM_NONE = 0,
+    JPEG_TRANSFORM_HFLIP = 1,          /* Mirror left-right */
+    JPEG_TRANSFORM_VFLIP = 2,          /* Mirror top-bottom */
+    JPEG_TRANSFORM_TRANSPOSE = 3,      /* Mirror across the main diagonal */
+    JPEG_TRANSFORM_ROT90 = 4,          /* Rotate clockwise */
+    JPEG_TRANSFORM_ROT180 = 5,
+    JPEG_TRANSFORM_ROT270 = 6,
+    JPEG_TRANSFORM_COUNT
+} JpegTransform;
+
+/**
+ * Output size of a transformed frame
+ *
+ * An edge that the transform moves away from the right or bottom is
+ * trimmed to whole MCUs, since its padding blocks cannot be carried along.
+ * Transposing transforms keep the sampling, which 4:2:2 cannot.
+ *
+ * @return 0 on success, -1 if the frame cannot be transformed
+ */
+int jpeg_transform_size(JpegTransform op, JpegSampling sampling, uint32_t width,
+                        uint32_t height, uint32_t* out_width, uint32_t* out_height);
+
+/**
+ * Rearrange the coefficients of src into dst
+ *
+ * Both encoders serve as coefficient containers: dst must have the
+ * sampling of src and the size jpeg_transform_size() reports. Blocks are
+ * moved to their new MCU positions and their coefficients transposed or
+ * negated in place of the pixel operation, so no value changes magnitude.
+ */
+void jpeg_transform_coefs(JpegTransform op, const JpegEncoder* src, JpegEncoder* dst);
+
+/**
+ * Turn a plane view into a view of the transformed plane
+ *
+ * Only base, steps and size change, so the encoder fetches blocks from the
+ * original samples in the new orientation and no rotated copy exists.
+ */
+void jpeg_transform_plane(JpegTransform op, JpegPlane* plane);
+
+/**
+ * Turn a packed RGB view into a view of the transformed frame
+ */
+void jpeg_transform_rgb_frame(JpegTransform op, JpegRgbFrame* frame);
+
+#endif /* JPEG_TRANSFORM_INTERNAL_H */
@@ -0,0 +1,112 @@
+/*
+ * Library Logging Implementation
+ *
+ * Every diagnostic of the library goes through one process-wide callback.
+ * The level filter runs at the call site, so a disabled message is never
+ * formatted and creating many codecs in parallel does not serialize on
+ * the stdio locks.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <pthread.h>
+
+#include "log_internal.h"
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+/**
+ * Default sink: errors and warnings to stderr, the rest to stdout
+ */
+static void log_stdio(RkmppLogLevel level, const char* message, void* opaque)
+{
+    (void)opaque;
+
+    switch (level) {
+        case RKMPP_LOG_ERROR:
+            fprintf(stderr, "Error: %s\n", message);
+            break;
+        case RKMPP_LOG_WARN:
+            fprintf(stderr, "Warning: %s\n", message);
+            break;
+        default:
+            printf("%s\n", message);
+            break;
+    }
+}
+
+/* Callback and its argument change together */
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+static RkmppLogCallback log_callback = log_stdio;
+static void* log_opaque = NULL;
+
+/* Messages delivered, per level */
+static uint64_t log_emitted[RKMPP_LOG_DEBUG + 1];
+
+/* ============================================================================
+ * Internal Implementation Functions
+ * ============================================================================ */
+
+volatile uint32_t log_level = RKMPP_LOG_WARN;
+uint64_t log_suppressed[RKMPP_LOG_DEBUG + 1];
+
+void log_write(uint32_t level, const char* format, ...)
+{
+    char message[LOG_MESSAGE_MAX];
+    RkmppLogCallback callback = NULL;
+    void* opaque = NULL;
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    pthread_mutex_lock(&log_lock);
+    callback = log_callback;
+    opaque = log_opaque;
+    pthread_mutex_unlock(&log_lock);
+
+    __atomic_fetch_add(&log_emitted[level], 1, __ATOMIC_RELAXED);
+    callback((RkmppLogLevel)level, message, opaque);
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+void rkmpp_set_log_callback(RkmppLogCallback callback, void* opaque)
+{
+    pthread_mutex_lock(&log_lock);
+    log_callback = callback ? callback : log_stdio;
+    log_opaque = callback ? opaque : NULL;
+    pthread_mutex_unlock(&log_lock);
+}
+
+RkmppStatus rkmpp_set_log_level(RkmppLogLevel level)
+{
+    if ((uint32_t)level > RKMPP_LOG_DEBUG) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    log_level = (uint32_t)level;
+
+    return RKMPP_OK;
+}
+
+RkmppStatus rkmpp_get_log_stats(RkmppLogLevel level, uint64_t* emitted, uint64_t* suppressed)
+{
+    if (level == RKMPP_LOG_NONE || (uint32_t)level > RKMPP_LOG_DEBUG) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    if (emitted) {
+        *emitted = __atomic_load_n(&log_emitted[level], __ATOMIC_RELAXED);
+    }
+    if (suppressed) {
+        *suppressed = __atomic_load_n(&log_suppressed[level], __ATOMIC_RELAXED);
+    }
+
+    return RKMPP_OK;
+}
@@ -0,0 +1,46 @@
+/*
+ * Library Logging Internal Implementation
+ */
+
+#ifndef LOG_INTERNAL_H
+#define LOG_INTERNAL_H
+
+#include <stdint.h>
+
+#include "rkmpp_mjpeg.h"
+
+#define LOG_MESSAGE_MAX 256            /* Longer messages are truncated */
+
+/* Most verbose level delivered; read without locking on every call site */
+extern volatile uint32_t log_level;
+
+/* Messages dropped by the level filter, per level */
+extern uint64_t log_suppressed[RKMPP_LOG_DEBUG + 1];
+
+/**
+ * Format a message and hand it to the log callback
+ */
+void log_write(uint32_t level, const char* format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * Log at a level
+ *
+ * A message the level filter drops costs one comparison and a counter
+ * increment: its arguments are neither formatted nor evaluated.
+ */
+#define LOG_AT(level, ...)                                                    \
+    do {                                                                      \
+        if ((uint32_t)(level) <= log_level) {                                 \
+            log_write((level), __VA_ARGS__);                                  \
+        } else {                                                              \
+            __atomic_fetch_add(&log_suppressed[(level)], 1, __ATOMIC_RELAXED); \
+        }                                                                     \
+    } while (0)
+
+#define LOG_ERROR(...) LOG_AT(RKMPP_LOG_ERROR, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT(RKMPP_LOG_WARN, __VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT(RKMPP_LOG_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(RKMPP_LOG_DEBUG, __VA_ARGS__)
+
+#endif /* LOG_INTERNAL_H */
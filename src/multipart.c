@@ -0,0 +1,244 @@
+/*
+ * Multipart (x-mixed-replace) Writer Implementation
+ *
+ * Wraps encoded frames in multipart boundaries for HTTP MJPEG streaming.
+ * Each part is a scatter list referencing the encoder output, so pushing a
+ * frame to N viewers costs N writev/sendmsg calls and no copies.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "rkmpp_mjpeg.h"
+#include "multipart_internal.h"
+#include "log_internal.h"
+
+#define MULTIPART_DEFAULT_BOUNDARY     "rkmppframe"
+#define MULTIPART_DEFAULT_CONTENT_TYPE "image/jpeg"
+
+/* Boundary characters that are not RFC 2045 token characters */
+#define MULTIPART_TSPECIALS "(),/:=? "
+
+static const char multipart_crlf[] = "\r\n";
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+/**
+ * Validate an RFC 2046 boundary token
+ */
+static int validate_boundary(const char* boundary)
+{
+    size_t len = strlen(boundary);
+
+    if (len == 0 || len > MULTIPART_MAX_BOUNDARY || boundary[len - 1] == ' ') {
+        return -1;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        char c = boundary[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+              strchr("'()+_,-./:=? ", c))) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Validate multipart writer configuration
+ */
+static int validate_multipart_config(const char* boundary, const char* content_type)
+{
+    if (validate_boundary(boundary) != 0) {
+        LOG_ERROR("Invalid multipart boundary: \"%s\"", boundary);
+        return -1;
+    }
+
+    if (strlen(content_type) == 0 || strlen(content_type) > MULTIPART_MAX_CONTENT_TYPE ||
+        strpbrk(content_type, "\r\n")) {
+        LOG_ERROR("Invalid multipart content type");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Append a decimal number, returning the number of characters written
+ */
+static uint32_t format_u32(char* out, uint32_t value)
+{
+    char digits[10];
+    uint32_t n = 0;
+
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = digits[n - 1 - i];
+    }
+
+    return n;
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+RkmppMultipartWriter* rkmpp_multipart_create(const RkmppMultipartConfig* config)
+{
+    const char* boundary = MULTIPART_DEFAULT_BOUNDARY;
+    const char* content_type = MULTIPART_DEFAULT_CONTENT_TYPE;
+    RkmppMultipartWriter* writer = NULL;
+    const char* quote = NULL;
+    int len = 0;
+
+    if (config && config->boundary) {
+        boundary = config->boundary;
+    }
+    if (config && config->content_type) {
+        content_type = config->content_type;
+    }
+
+    if (validate_multipart_config(boundary, content_type) != 0) {
+        LOG_ERROR("invalid multipart configuration");
+        return NULL;
+    }
+
+    writer = (RkmppMultipartWriter*)malloc(sizeof(RkmppMultipartWriter));
+    if (!writer) {
+        LOG_ERROR("failed to allocate multipart writer structure");
+        return NULL;
+    }
+
+    memset(writer, 0, sizeof(RkmppMultipartWriter));
+
+    /* Everything up to the length is identical for every frame */
+    len = snprintf(writer->prefix, sizeof(writer->prefix),
+                   "--%s\r\nContent-Type: %s\r\nContent-Length: ",
+                   boundary, content_type);
+    writer->prefix_len = (uint32_t)len;
+
+    /* Boundaries with RFC 2045 tspecials or spaces are not tokens and
+     * have to be quoted in the header parameter */
+    quote = strpbrk(boundary, MULTIPART_TSPECIALS) ? "\"" : "";
+    snprintf(writer->content_type, sizeof(writer->content_type),
+             "multipart/x-mixed-replace; boundary=%s%s%s", quote, boundary, quote);
+
+    return writer;
+}
+
+RkmppStatus rkmpp_multipart_destroy(RkmppMultipartWriter* writer)
+{
+    if (!writer) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    free(writer);
+
+    return RKMPP_OK;
+}
+
+const char* rkmpp_multipart_get_content_type(RkmppMultipartWriter* writer)
+{
+    if (!writer) {
+        return NULL;
+    }
+
+    return writer->content_type;
+}
+
+RkmppStatus rkmpp_multipart_build_frame(
+    RkmppMultipartWriter* writer,
+    const uint8_t* jpeg_data,
+    uint32_t jpeg_len,
+    RkmppMultipartFrame* frame)
+{
+    uint32_t n = 0;
+
+    if (!writer || !jpeg_data || !frame || jpeg_len == 0) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    memcpy(frame->header, writer->prefix, writer->prefix_len);
+    n = writer->prefix_len;
+    n += format_u32(&frame->header[n], jpeg_len);
+    memcpy(&frame->header[n], "\r\n\r\n", 4);
+    n += 4;
+
+    frame->iov[0].iov_base = frame->header;
+    frame->iov[0].iov_len = n;
+    frame->iov[1].iov_base = (void*)jpeg_data;
+    frame->iov[1].iov_len = jpeg_len;
+    frame->iov[2].iov_base = (void*)multipart_crlf;
+    frame->iov[2].iov_len = 2;
+    frame->iovcnt = 3;
+    frame->size = n + jpeg_len + 2;
+
+    return RKMPP_OK;
+}
+
+RkmppStatus rkmpp_multipart_send(
+    const RkmppMultipartFrame* frame,
+    int fd,
+    uint32_t* offset)
+{
+    if (!frame || !offset || fd < 0 || frame->iovcnt > 3 || *offset > frame->size) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    while (*offset < frame->size) {
+        struct iovec iov[3];
+        struct msghdr msg;
+        uint32_t skip = *offset;
+        int count = 0;
+        ssize_t ret = 0;
+
+        /* Resume inside the scatter list without copying */
+        for (uint32_t i = 0; i < frame->iovcnt; i++) {
+            if (skip >= frame->iov[i].iov_len) {
+                skip -= (uint32_t)frame->iov[i].iov_len;
+                continue;
+            }
+            iov[count].iov_base = (uint8_t*)frame->iov[i].iov_base + skip;
+            iov[count].iov_len = frame->iov[i].iov_len - skip;
+            skip = 0;
+            count++;
+        }
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = (size_t)count;
+
+        /* sendmsg avoids SIGPIPE on dropped viewers; writev covers pipes */
+        ret = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (ret < 0 && errno == ENOTSOCK) {
+            ret = writev(fd, iov, count);
+        }
+
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return RKMPP_ERR_NOT_READY;
+            }
+            return RKMPP_ERR_UNKNOWN;
+        }
+
+        *offset += (uint32_t)ret;
+    }
+
+    return RKMPP_OK;
+}
@@ -0,0 +1,26 @@
+/*
+ * Multipart Writer Internal Implementation
+ */
+
+#ifndef MULTIPART_INTERNAL_H
+#define MULTIPART_INTERNAL_H
+
+#include <stdint.h>
+
+/* RFC 2046 boundary limit */
+#define MULTIPART_MAX_BOUNDARY     70
+#define MULTIPART_MAX_CONTENT_TYPE 100
+
+/**
+ * Internal multipart writer context structure
+ */
+struct RkmppMultipartWriter {
+    /* "--boundary\r\nContent-Type: ...\r\nContent-Length: " */
+    char prefix[RKMPP_MULTIPART_MAX_HEADER];
+    uint32_t prefix_len;
+
+    /* "multipart/x-mixed-replace; boundary=..." */
+    char content_type[MULTIPART_MAX_BOUNDARY + 64];
+};
+
+#endif /* MULTIPART_INTERNAL_H */
@@ -0,0 +1,176 @@
+/*
+ * JPEG Rate Control Implementation
+ *
+ * Picks a per-frame JPEG quality so the bytes produced over a sliding window
+ * of frames track the configured bitrate. CBR keeps each frame close to the
+ * per-frame budget; VBR only holds the window average and lets single frames
+ * swing with scene complexity, never exceeding the configured quality.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "rkmpp_mjpeg.h"
+#include "rate_control_internal.h"
+#include "jpeg_internal.h"
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+/**
+ * Clamp a quality to the controller's range
+ */
+static uint32_t rc_clamp_quality(const RateControl* rc, uint32_t quality)
+{
+    uint32_t min_quality = rc->max_quality < RC_MIN_QUALITY ? rc->max_quality : RC_MIN_QUALITY;
+
+    if (quality < min_quality) {
+        return min_quality;
+    }
+    if (quality > rc->max_quality) {
+        return rc->max_quality;
+    }
+
+    return quality;
+}
+
+/* ============================================================================
+ * Internal Implementation Functions
+ * ============================================================================ */
+
+void rc_init(RateControl* rc, uint32_t mode, uint32_t bitrate, uint32_t fps,
+             uint32_t window, uint32_t quality)
+{
+    memset(rc, 0, sizeof(RateControl));
+
+    rc->mode = mode;
+    rc->bitrate = bitrate;
+    rc->fps = fps ? fps : 1;
+    rc->max_quality = quality;
+    rc->quality = quality;
+
+    /* One second of frames unless the caller asks otherwise */
+    rc->window_len = window ? window : rc->fps;
+    if (rc->window_len > RC_MAX_WINDOW) {
+        rc->window_len = RC_MAX_WINDOW;
+    }
+}
+
+void rc_set_bitrate(RateControl* rc, uint32_t bitrate)
+{
+    rc->bitrate = bitrate;
+
+    /* Start the new budget from a clean window */
+    rc->window_pos = 0;
+    rc->window_count = 0;
+    rc->window_bytes = 0;
+
+    if (!rc_enabled(rc)) {
+        rc->quality = rc->max_quality;
+    }
+}
+
+void rc_set_quality(RateControl* rc, uint32_t quality)
+{
+    rc->max_quality = quality;
+
+    if (!rc_enabled(rc) || rc->quality > quality) {
+        rc->quality = quality;
+    }
+}
+
+int rc_enabled(const RateControl* rc)
+{
+    return rc->bitrate > 0 && rc->mode != RKMPP_RC_MODE_FIXQP;
+}
+
+double rc_model_scale(uint32_t quality)
+{
+    uint32_t scale = jpeg_quality_to_scale(quality);
+
+    return scale ? (double)scale : 1.0;
+}
+
+double rc_model_complexity(uint32_t quality, uint32_t bytes, double exponent)
+{
+    return (double)bytes * pow(rc_model_scale(quality), exponent);
+}
+
+uint32_t rc_model_quality(double complexity, double bytes, double exponent)
+{
+    double scale = pow(complexity / bytes, 1.0 / exponent);
+
+    scale = fmax(1.0, fmin(scale, 5000.0));
+
+    return jpeg_scale_to_quality((uint32_t)(scale + 0.5));
+}
+
+void rc_update(RateControl* rc, uint32_t quality, uint32_t frame_bytes)
+{
+    uint32_t used = quality;
+    uint64_t recent = 0;
+    uint32_t frames = 0;
+    uint32_t horizon = 0;
+    double target = 0.0;
+    double surplus = 0.0;
+    double budget = 0.0;
+    double observed = 0.0;
+    int32_t next = 0;
+
+    /* Slide the window */
+    if (rc->window_count == rc->window_len) {
+        rc->window_bytes -= rc->window[rc->window_pos];
+    } else {
+        rc->window_count++;
+    }
+    rc->window[rc->window_pos] = frame_bytes;
+    rc->window_bytes += frame_bytes;
+    rc->window_pos = (rc->window_pos + 1) % rc->window_len;
+
+    if (!rc_enabled(rc)) {
+        return;
+    }
+
+    /* Re-estimate complexity from what the last frame actually cost */
+    observed = rc_model_complexity(used, frame_bytes, RC_MODEL_EXPONENT);
+    if (rc->complexity_valid) {
+        rc->complexity = 0.5 * rc->complexity + 0.5 * observed;
+    } else {
+        rc->complexity = observed;
+        rc->complexity_valid = 1;
+    }
+
+    /* Window surplus (or debt) once the oldest frame drops out. CBR pays it
+     * back within a quarter window and keeps frames near the target; VBR
+     * spreads it over the whole window and lets frames swing further. */
+    target = (double)rc->bitrate / 8.0 / (double)rc->fps;
+    recent = rc->window_bytes;
+    frames = rc->window_count;
+    if (rc->window_count == rc->window_len) {
+        recent -= rc->window[rc->window_pos];
+        frames = rc->window_len - 1;
+    }
+    surplus = (double)frames * target - (double)recent;
+
+    if (rc->mode == RKMPP_RC_MODE_CBR) {
+        horizon = rc->window_len / 4 ? rc->window_len / 4 : 1;
+        budget = fmax(0.75 * target, fmin(target + surplus / horizon, 1.25 * target));
+    } else {
+        horizon = rc->window_len;
+        budget = fmax(0.25 * target, fmin(target + surplus / horizon, 4.0 * target));
+    }
+
+    /* Solve the model for the quality that lands on the budget */
+    next = (int32_t)rc_model_quality(rc->complexity, budget, RC_MODEL_EXPONENT);
+
+    /* Limit swings caused by a single outlier frame */
+    if (next > (int32_t)used + RC_MAX_STEP) {
+        next = (int32_t)used + RC_MAX_STEP;
+    }
+    if (next < (int32_t)used - RC_MAX_STEP) {
+        next = (int32_t)used - RC_MAX_STEP;
+    }
+
+    rc->quality = rc_clamp_quality(rc, next < 1 ? 1 : (uint32_t)next);
+}
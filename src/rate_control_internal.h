@@ -0,0 +1,84 @@
+/*
+ * JPEG Rate Control Internal Implementation
+ */
+
+#ifndef RATE_CONTROL_INTERNAL_H
+#define RATE_CONTROL_INTERNAL_H
+
+#include <stdint.h>
+
+/* Bytes ~ complexity * scale^-RC_MODEL_EXPONENT */
+#define RC_MODEL_EXPONENT   0.7
+
+/* Limits */
+#define RC_MAX_WINDOW       240        /* Frames in the sliding window */
+#define RC_MIN_QUALITY      5          /* Lowest quality the controller picks */
+#define RC_MAX_STEP         20         /* Largest quality change per frame */
+
+/**
+ * Sliding-window rate controller
+ *
+ * Frame size is modelled as bytes = complexity * scale^-RC_MODEL_EXPONENT,
+ * where scale is the IJG quantization scale of the frame's quality. The
+ * complexity is re-estimated from every encoded frame, and the next frame's
+ * quality is solved from the bytes left in the window budget.
+ */
+typedef struct {
+    uint32_t mode;                     /* RkmppRcMode */
+    uint32_t bitrate;                  /* Target bits per second, 0 = off */
+    uint32_t fps;
+    uint32_t max_quality;              /* Quality ceiling (configured quality) */
+    uint32_t quality;                  /* Quality for the next frame */
+
+    double complexity;                 /* Model coefficient */
+    int complexity_valid;
+
+    uint32_t window[RC_MAX_WINDOW];    /* Recent frame sizes (ring) */
+    uint32_t window_len;               /* Window length in frames */
+    uint32_t window_pos;
+    uint32_t window_count;
+    uint64_t window_bytes;
+} RateControl;
+
+/**
+ * Initialize the controller
+ */
+void rc_init(RateControl* rc, uint32_t mode, uint32_t bitrate, uint32_t fps,
+             uint32_t window, uint32_t quality);
+
+/**
+ * Change the target bitrate (0 switches to fixed quality)
+ */
+void rc_set_bitrate(RateControl* rc, uint32_t bitrate);
+
+/**
+ * Change the quality ceiling (or the fixed quality when rate control is off)
+ */
+void rc_set_quality(RateControl* rc, uint32_t quality);
+
+/**
+ * Non-zero when the controller adjusts quality per frame
+ */
+int rc_enabled(const RateControl* rc);
+
+/**
+ * Account an encoded frame and pick the next frame's quality
+ */
+void rc_update(RateControl* rc, uint32_t quality, uint32_t frame_bytes);
+
+/**
+ * Size model: quantization scale of a quality (never zero)
+ */
+double rc_model_scale(uint32_t quality);
+
+/**
+ * Size model: complexity of a frame that took bytes at quality
+ */
+double rc_model_complexity(uint32_t quality, uint32_t bytes, double exponent);
+
+/**
+ * Size model: quality expected to produce bytes for a complexity
+ */
+uint32_t rc_model_quality(double complexity, double bytes, double exponent);
+
+#endif /* RATE_CONTROL_INTERNAL_H */
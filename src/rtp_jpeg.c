@@ -0,0 +1,456 @@
+/*
+ * RTP/JPEG Packetizer Implementation
+ *
+ * Fragments encoded JPEG frames into RTP packets as described in RFC 2435.
+ * Only the marker segments in front of the scan are parsed; the payload of
+ * every packet is an iovec into the caller's JPEG buffer.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rkmpp_mjpeg.h"
+#include "rtp_jpeg_internal.h"
+#include "jpeg_internal.h"
+#include "log_internal.h"
+
+#define RTP_DEFAULT_MTU          1400
+#define RTP_DEFAULT_PAYLOAD_TYPE 26
+#define RTP_HEADER_SIZE          12
+#define RTP_JPEG_HEADER_SIZE     8
+#define RTP_RESTART_HEADER_SIZE  4
+#define RTP_QTABLE_HEADER_SIZE   4
+
+/* RFC 2435 limits */
+#define RTP_JPEG_MAX_DIMENSION   2040
+#define RTP_JPEG_TYPE_422        0
+#define RTP_JPEG_TYPE_420        1
+#define RTP_JPEG_TYPE_RESTART    64
+#define RTP_JPEG_Q_DYNAMIC_MIN   128
+#define RTP_JPEG_Q_DYNAMIC_MAX   254
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+static uint16_t read_be16(const uint8_t* p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void write_be16(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void write_be32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/**
+ * Validate packetizer configuration
+ */
+static int validate_rtp_config(const RkmppRtpConfig* config)
+{
+    if (config->mtu && (config->mtu <= RKMPP_RTP_MAX_HEADER || config->mtu > 65535)) {
+        LOG_ERROR("Invalid RTP MTU: %u", config->mtu);
+        return -1;
+    }
+
+    if (config->payload_type > 127) {
+        LOG_ERROR("Invalid RTP payload type: %u", config->payload_type);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Whether a DHT table is the Annex K table of its class and slot, which
+ * RFC 2435 receivers rebuild instead of receiving
+ */
+static int is_annex_k_table(uint8_t class_id, const uint8_t* bits, const uint8_t* vals)
+{
+    const JpegHuffSpec* spec = NULL;
+
+    switch (class_id) {
+        case 0x00:
+            spec = &jpeg_std_dc_luma;
+            break;
+        case 0x01:
+            spec = &jpeg_std_dc_chroma;
+            break;
+        case 0x10:
+            spec = &jpeg_std_ac_luma;
+            break;
+        case 0x11:
+            spec = &jpeg_std_ac_chroma;
+            break;
+        default:
+            return 0;
+    }
+
+    return memcmp(bits, &spec->bits[1], 16) == 0 &&
+           memcmp(vals, spec->vals, jpeg_huff_spec_count(spec)) == 0;
+}
+
+/**
+ * Walk the JPEG marker segments up to SOS and fill in the frame state
+ */
+static int rtp_parse_jpeg(struct RkmppRtpPacketizer* p, const uint8_t* data, uint32_t len)
+{
+    const uint8_t* tables[4] = {NULL, NULL, NULL, NULL};
+    uint8_t table_precision[4] = {0, 0, 0, 0};
+    uint8_t table_ids[2] = {0, 0};
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t pos = 2;
+    int have_sof = 0;
+
+    if (len < 4 || data[0] != 0xFF || data[1] != JPEG_MARKER_SOI) {
+        LOG_ERROR("RTP packetizer input is not a JPEG");
+        return -1;
+    }
+
+    p->restart_interval = 0;
+
+    for (;;) {
+        uint8_t marker = 0;
+        uint32_t seg_len = 0;
+        const uint8_t* seg = NULL;
+
+        /* Skip fill bytes in front of the marker */
+        while (pos < len && data[pos] == 0xFF) {
+            pos++;
+        }
+        if (pos + 3 > len || data[pos - 1] != 0xFF) {
+            LOG_ERROR("truncated JPEG header");
+            return -1;
+        }
+
+        marker = data[pos];
+        seg_len = read_be16(&data[pos + 1]);
+        seg = &data[pos + 3];
+        if (seg_len < 2 || pos + 1 + seg_len > len) {
+            LOG_ERROR("bad JPEG segment length");
+            return -1;
+        }
+        seg_len -= 2;
+
+        switch (marker) {
+            case JPEG_MARKER_DQT:
+                for (uint32_t i = 0; i < seg_len;) {
+                    uint8_t pq = seg[i] >> 4;
+                    uint8_t tq = seg[i] & 0x0F;
+                    uint32_t size = pq ? 128 : 64;
+
+                    if (tq > 3 || i + 1 + size > seg_len) {
+                        LOG_ERROR("bad DQT segment");
+                        return -1;
+                    }
+                    tables[tq] = &seg[i + 1];
+                    table_precision[tq] = pq;
+                    i += 1 + size;
+                }
+                break;
+
+            case JPEG_MARKER_DHT:
+                for (uint32_t i = 0; i < seg_len;) {
+                    uint32_t count = 0;
+
+                    if (i + 17 > seg_len) {
+                        LOG_ERROR("bad DHT segment");
+                        return -1;
+                    }
+                    for (uint32_t n = 1; n <= 16; n++) {
+                        count += seg[i + n];
+                    }
+                    if (i + 17 + count > seg_len) {
+                        LOG_ERROR("bad DHT segment");
+                        return -1;
+                    }
+                    if (!is_annex_k_table(seg[i], &seg[i + 1], &seg[i + 17])) {
+                        LOG_ERROR("RTP/JPEG needs the Annex K Huffman tables");
+                        return -1;
+                    }
+                    i += 17 + count;
+                }
+                break;
+
+            case JPEG_MARKER_SOF0:
+            case JPEG_MARKER_SOF1:
+                if (seg_len < 6 + 3 * 3 || seg[0] != 8 || seg[5] != 3) {
+                    LOG_ERROR("RTP/JPEG needs 8-bit 3-component frames");
+                    return -1;
+                }
+                height = read_be16(&seg[1]);
+                width = read_be16(&seg[3]);
+
+                /* Luma 2x1 (4:2:2) or 2x2 (4:2:0), chroma 1x1 sharing a table */
+                if (seg[6 + 1] == 0x21) {
+                    p->type = RTP_JPEG_TYPE_422;
+                } else if (seg[6 + 1] == 0x22) {
+                    p->type = RTP_JPEG_TYPE_420;
+                } else {
+                    LOG_ERROR("unsupported RTP/JPEG sampling 0x%02x", seg[7]);
+                    return -1;
+                }
+                if (seg[9 + 1] != 0x11 || seg[12 + 1] != 0x11 || seg[9 + 2] != seg[12 + 2]) {
+                    LOG_ERROR("unsupported RTP/JPEG chroma layout");
+                    return -1;
+                }
+                table_ids[0] = seg[6 + 2] & 3;
+                table_ids[1] = seg[9 + 2] & 3;
+                have_sof = 1;
+                break;
+
+            case JPEG_MARKER_DRI:
+                if (seg_len >= 2) {
+                    p->restart_interval = read_be16(seg);
+                }
+                break;
+
+            case JPEG_MARKER_SOS:
+                if (!have_sof) {
+                    LOG_ERROR("JPEG scan before frame header");
+                    return -1;
+                }
+                pos += 1 + 2 + seg_len;
+                p->scan = &data[pos];
+                p->scan_len = len - pos;
+                if (p->scan_len >= 2 && data[len - 2] == 0xFF && data[len - 1] == JPEG_MARKER_EOI) {
+                    p->scan_len -= 2;
+                }
+                goto done;
+
+            default:
+                if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 &&
+                    marker != 0xCC) {
+                    LOG_ERROR("RTP/JPEG supports baseline frames only");
+                    return -1;
+                }
+                break;
+        }
+
+        pos += 1 + 2 + seg_len;
+    }
+
+done:
+    if (p->scan_len == 0) {
+        LOG_ERROR("JPEG has no scan data");
+        return -1;
+    }
+
+    if (width == 0 || height == 0 ||
+        width > RTP_JPEG_MAX_DIMENSION || height > RTP_JPEG_MAX_DIMENSION) {
+        LOG_ERROR("RTP/JPEG cannot carry %ux%u frames", width, height);
+        return -1;
+    }
+
+    if (!tables[table_ids[0]] || !tables[table_ids[1]]) {
+        LOG_ERROR("JPEG references a missing quantization table");
+        return -1;
+    }
+
+    p->width8 = (uint8_t)((width + 7) / 8);
+    p->height8 = (uint8_t)((height + 7) / 8);
+    if (p->restart_interval) {
+        p->type += RTP_JPEG_TYPE_RESTART;
+    }
+
+    /* Tables in component order: luma then chroma */
+    p->qtable_len = 0;
+    p->qtable_precision = 0;
+    for (int i = 0; i < 2; i++) {
+        uint32_t size = table_precision[table_ids[i]] ? 128 : 64;
+        memcpy(&p->qtables[p->qtable_len], tables[table_ids[i]], size);
+        p->qtable_len += (uint16_t)size;
+        p->qtable_precision |= (uint8_t)(table_precision[table_ids[i]] << i);
+    }
+
+    return 0;
+}
+
+/**
+ * Pick the Q value and decide whether the tables go on the wire
+ *
+ * Q 128-254 tells receivers to cache tables per Q, so identical tables are
+ * only resent on request (qtable_interval); a table change moves to a new Q.
+ */
+static void rtp_select_q(struct RkmppRtpPacketizer* p)
+{
+    int changed = p->sent_q == 0 ||
+                  p->qtable_len != p->sent_qtable_len ||
+                  p->qtable_precision != p->sent_qtable_precision ||
+                  memcmp(p->qtables, p->sent_qtables, p->qtable_len) != 0;
+
+    if (changed) {
+        p->sent_q = (p->sent_q >= RTP_JPEG_Q_DYNAMIC_MIN && p->sent_q < RTP_JPEG_Q_DYNAMIC_MAX) ?
+                    (uint8_t)(p->sent_q + 1) : RTP_JPEG_Q_DYNAMIC_MIN;
+        memcpy(p->sent_qtables, p->qtables, p->qtable_len);
+        p->sent_qtable_len = p->qtable_len;
+        p->sent_qtable_precision = p->qtable_precision;
+        p->send_tables = 1;
+    } else {
+        p->send_tables = p->qtable_interval &&
+                         p->frames_since_tables + 1 >= p->qtable_interval;
+    }
+
+    p->frames_since_tables = p->send_tables ? 0 : p->frames_since_tables + 1;
+    p->q = p->sent_q;
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+RkmppRtpPacketizer* rkmpp_rtp_packetizer_create(const RkmppRtpConfig* config)
+{
+    RkmppRtpConfig defaults;
+    RkmppRtpPacketizer* packetizer = NULL;
+
+    memset(&defaults, 0, sizeof(defaults));
+    if (!config) {
+        config = &defaults;
+    }
+
+    if (validate_rtp_config(config) != 0) {
+        LOG_ERROR("invalid RTP packetizer configuration");
+        return NULL;
+    }
+
+    packetizer = (RkmppRtpPacketizer*)malloc(sizeof(RkmppRtpPacketizer));
+    if (!packetizer) {
+        LOG_ERROR("failed to allocate RTP packetizer structure");
+        return NULL;
+    }
+
+    memset(packetizer, 0, sizeof(RkmppRtpPacketizer));
+
+    packetizer->mtu = config->mtu ? config->mtu : RTP_DEFAULT_MTU;
+    packetizer->payload_type = config->payload_type ? config->payload_type
+                                                    : RTP_DEFAULT_PAYLOAD_TYPE;
+    packetizer->ssrc = config->ssrc;
+    packetizer->sequence = (uint16_t)config->initial_sequence;
+    packetizer->qtable_interval = config->qtable_interval;
+
+    return packetizer;
+}
+
+RkmppStatus rkmpp_rtp_packetizer_destroy(RkmppRtpPacketizer* packetizer)
+{
+    if (!packetizer) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    free(packetizer);
+
+    return RKMPP_OK;
+}
+
+RkmppStatus rkmpp_rtp_packetizer_begin_frame(
+    RkmppRtpPacketizer* packetizer,
+    const uint8_t* jpeg_data,
+    uint32_t jpeg_len,
+    uint32_t timestamp)
+{
+    if (!packetizer || !jpeg_data) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    packetizer->frame_active = 0;
+
+    if (rtp_parse_jpeg(packetizer, jpeg_data, jpeg_len) != 0) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    rtp_select_q(packetizer);
+
+    packetizer->timestamp = timestamp;
+    packetizer->offset = 0;
+    packetizer->frame_active = 1;
+
+    return RKMPP_OK;
+}
+
+RkmppStatus rkmpp_rtp_packetizer_next_packet(
+    RkmppRtpPacketizer* packetizer,
+    RkmppRtpPacket* packet)
+{
+    uint8_t* h = NULL;
+    uint32_t header_len = RTP_HEADER_SIZE + RTP_JPEG_HEADER_SIZE;
+    uint32_t payload_len = 0;
+    int marker = 0;
+
+    if (!packetizer || !packet) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    if (!packetizer->frame_active) {
+        return RKMPP_ERR_NOT_READY;
+    }
+
+    h = packet->header;
+
+    /* Main JPEG header */
+    h[12] = 0;
+    h[13] = (uint8_t)(packetizer->offset >> 16);
+    h[14] = (uint8_t)(packetizer->offset >> 8);
+    h[15] = (uint8_t)packetizer->offset;
+    h[16] = packetizer->type;
+    h[17] = packetizer->q;
+    h[18] = packetizer->width8;
+    h[19] = packetizer->height8;
+
+    /* Restart marker header: fragments are not aligned to intervals */
+    if (packetizer->restart_interval) {
+        write_be16(&h[header_len], packetizer->restart_interval);
+        write_be16(&h[header_len + 2], 0xFFFF);
+        header_len += RTP_RESTART_HEADER_SIZE;
+    }
+
+    /* Quantization table header in the first packet */
+    if (packetizer->offset == 0) {
+        uint16_t qlen = packetizer->send_tables ? packetizer->qtable_len : 0;
+
+        h[header_len] = 0;
+        h[header_len + 1] = packetizer->qtable_precision;
+        write_be16(&h[header_len + 2], qlen);
+        memcpy(&h[header_len + RTP_QTABLE_HEADER_SIZE], packetizer->qtables, qlen);
+        header_len += RTP_QTABLE_HEADER_SIZE + qlen;
+    }
+
+    payload_len = packetizer->mtu - header_len;
+    if (payload_len >= packetizer->scan_len - packetizer->offset) {
+        payload_len = packetizer->scan_len - packetizer->offset;
+        marker = 1;
+    }
+
+    /* RTP header */
+    h[0] = 0x80;
+    h[1] = (uint8_t)((marker << 7) | packetizer->payload_type);
+    write_be16(&h[2], packetizer->sequence);
+    write_be32(&h[4], packetizer->timestamp);
+    write_be32(&h[8], packetizer->ssrc);
+
+    packet->iov[0].iov_base = h;
+    packet->iov[0].iov_len = header_len;
+    packet->iov[1].iov_base = (void*)(packetizer->scan + packetizer->offset);
+    packet->iov[1].iov_len = payload_len;
+    packet->iovcnt = 2;
+    packet->size = header_len + payload_len;
+    packet->marker = (uint32_t)marker;
+
+    packetizer->sequence++;
+    packetizer->offset += payload_len;
+    if (marker) {
+        packetizer->frame_active = 0;
+    }
+
+    return RKMPP_OK;
+}
@@ -0,0 +1,52 @@
+/*
+ * RTP/JPEG Packetizer Internal Implementation
+ */
+
+#ifndef RTP_JPEG_INTERNAL_H
+#define RTP_JPEG_INTERNAL_H
+
+#include <stdint.h>
+
+/* Two tables (luma, chroma) of up to 64 16-bit entries */
+#define RTP_QTABLE_MAX_BYTES 256
+
+/**
+ * Internal packetizer context structure
+ */
+struct RkmppRtpPacketizer {
+    /* Configuration */
+    uint32_t mtu;
+    uint32_t payload_type;
+    uint32_t ssrc;
+    uint32_t qtable_interval;
+
+    /* RTP state */
+    uint16_t sequence;
+
+    /* Current frame */
+    const uint8_t* scan;               /* Entropy-coded data inside the caller's JPEG */
+    uint32_t scan_len;
+    uint32_t offset;                   /* Fragment offset of the next packet */
+    uint32_t timestamp;
+    uint8_t type;                      /* RFC 2435 type (0/1, +64 with restart markers) */
+    uint8_t q;                         /* Q value (128-254: in-band tables) */
+    uint8_t width8;                    /* Width in 8-pixel units */
+    uint8_t height8;                   /* Height in 8-pixel units */
+    uint16_t restart_interval;
+    int send_tables;                   /* First packet carries the table data */
+    int frame_active;
+
+    /* Quantization tables of the current frame */
+    uint8_t qtables[RTP_QTABLE_MAX_BYTES];
+    uint16_t qtable_len;
+    uint8_t qtable_precision;
+
+    /* Tables last sent on the wire */
+    uint8_t sent_qtables[RTP_QTABLE_MAX_BYTES];
+    uint16_t sent_qtable_len;
+    uint8_t sent_qtable_precision;
+    uint8_t sent_q;                    /* 0 until tables have been sent */
+    uint32_t frames_since_tables;
+};
+
+#endif /* RTP_JPEG_INTERNAL_H */
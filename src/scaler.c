@@ -0,0 +1,158 @@
+/*
+ * Streaming Plane Scaler Implementation
+ *
+ * Area-averaging resampler used between the software decoder and encoder.
+ * Source rows are summed into one row of column accumulators as they
+ * arrive; as soon as the last source row an output row covers has been
+ * added, the sums are reduced horizontally and the output row is written.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "scaler_internal.h"
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+/**
+ * First source sample covered by output sample d
+ */
+static uint32_t span_start(uint32_t d, uint32_t src, uint32_t dst)
+{
+    return (uint32_t)((uint64_t)d * src / dst);
+}
+
+/**
+ * One past the last source sample covered by output sample d (at least one)
+ */
+static uint32_t span_end(uint32_t d, uint32_t src, uint32_t dst)
+{
+    uint32_t start = span_start(d, src, dst);
+    uint32_t end = span_start(d + 1, src, dst);
+
+    return end > start ? end : start + 1;
+}
+
+/**
+ * Write the mean of the accumulated rows as output row dst_y
+ */
+static void emit_row(const PlaneScaler* s)
+{
+    uint8_t* out = s->dst + (size_t)s->dst_y * s->row_step;
+    uint32_t last_n = 0;
+    double scale = 0.0;
+
+    for (uint32_t dx = 0; dx < s->dst_width; dx++) {
+        const uint32_t* acc = s->acc + s->x_start[dx];
+        uint32_t n = s->x_count[dx] * s->rows;
+        uint32_t sum = 0;
+
+        for (uint32_t i = 0; i < s->x_count[dx]; i++) {
+            sum += acc[i];
+        }
+
+        /* Footprints take at most two sizes per row: divide once per size */
+        if (n != last_n) {
+            last_n = n;
+            scale = 1.0 / n;
+        }
+        out[(size_t)dx * s->col_step] = (uint8_t)(sum * scale + 0.5);
+    }
+}
+
+/* ============================================================================
+ * Internal Implementation Functions
+ * ============================================================================ */
+
+int plane_scaler_setup(PlaneScaler* s, uint32_t src_width, uint32_t src_height,
+                       uint8_t* dst, uint32_t dst_width, uint32_t dst_height,
+                       uint32_t col_step, uint32_t row_step)
+{
+    if (dst_width > s->capacity) {
+        uint32_t* x_start = (uint32_t*)realloc(s->x_start, dst_width * sizeof(uint32_t));
+        uint32_t* x_count = NULL;
+
+        if (x_start) {
+            s->x_start = x_start;
+            x_count = (uint32_t*)realloc(s->x_count, dst_width * sizeof(uint32_t));
+        }
+        if (!x_count) {
+            return -1;
+        }
+        s->x_count = x_count;
+        s->capacity = dst_width;
+    }
+
+    if (src_width > s->acc_capacity) {
+        uint32_t* acc = (uint32_t*)realloc(s->acc, src_width * sizeof(uint32_t));
+
+        if (!acc) {
+            return -1;
+        }
+        s->acc = acc;
+        s->acc_capacity = src_width;
+    }
+
+    s->src_width = src_width;
+    s->src_height = src_height;
+    s->dst_width = dst_width;
+    s->dst_height = dst_height;
+    s->dst = dst;
+    s->col_step = col_step;
+    s->row_step = row_step;
+    s->src_y = 0;
+    s->dst_y = 0;
+    s->rows = 0;
+
+    for (uint32_t dx = 0; dx < dst_width; dx++) {
+        s->x_start[dx] = span_start(dx, src_width, dst_width);
+        s->x_count[dx] = span_end(dx, src_width, dst_width) - s->x_start[dx];
+    }
+
+    return 0;
+}
+
+void plane_scaler_push(PlaneScaler* s, const uint8_t* row)
+{
+    uint32_t* acc = s->acc;
+    uint32_t width = s->src_width;
+
+    if (s->src_y >= s->src_height) {
+        return;
+    }
+
+    /* Column sums at source width; the horizontal reduction runs once
+     * per output row */
+    if (s->rows == 0) {
+        for (uint32_t x = 0; x < width; x++) {
+            acc[x] = row[x];
+        }
+    } else {
+        for (uint32_t x = 0; x < width; x++) {
+            acc[x] += row[x];
+        }
+    }
+    s->rows++;
+    s->src_y++;
+
+    /* When enlarging, one source row completes several output rows */
+    if (s->dst_y < s->dst_height &&
+        span_end(s->dst_y, s->src_height, s->dst_height) == s->src_y) {
+        do {
+            emit_row(s);
+            s->dst_y++;
+        } while (s->dst_y < s->dst_height &&
+                 span_end(s->dst_y, s->src_height, s->dst_height) == s->src_y);
+        s->rows = 0;
+    }
+}
+
+void plane_scaler_release(PlaneScaler* s)
+{
+    free(s->x_start);
+    free(s->x_count);
+    free(s->acc);
+    memset(s, 0, sizeof(*s));
+}
@@ -0,0 +1,62 @@
+/*
+ * Streaming Plane Scaler Internal Implementation
+ */
+
+#ifndef SCALER_INTERNAL_H
+#define SCALER_INTERNAL_H
+
+#include <stdint.h>
+
+/**
+ * Area-averaging scaler for one 8-bit plane, fed one source row at a time
+ *
+ * Every output sample is the rounded mean of the source rectangle it
+ * covers, so downscaling never aliases; when enlarging, a rectangle is a
+ * single source sample (nearest neighbour). Only one row of column sums is
+ * kept, which is what lets a decoder feed rows straight from its MCU strip.
+ */
+typedef struct {
+    uint32_t src_width;
+    uint32_t src_height;
+    uint32_t dst_width;
+    uint32_t dst_height;
+
+    /* Output plane */
+    uint8_t* dst;
+    uint32_t col_step;                 /* Bytes between samples (2 for NV12 chroma) */
+    uint32_t row_step;                 /* Bytes between rows */
+
+    /* Horizontal footprint of each output column */
+    uint32_t* x_start;
+    uint32_t* x_count;
+    uint32_t capacity;                 /* Entries allocated per footprint array */
+
+    /* Column sums of the source rows pending for the next output row */
+    uint32_t* acc;
+    uint32_t acc_capacity;
+
+    uint32_t src_y;                    /* Next source row */
+    uint32_t dst_y;                    /* Next output row */
+    uint32_t rows;                     /* Source rows in acc */
+} PlaneScaler;
+
+/**
+ * Prepare a scaler for one frame (arrays are kept across frames)
+ *
+ * @return 0 on success, -1 on allocation failure
+ */
+int plane_scaler_setup(PlaneScaler* s, uint32_t src_width, uint32_t src_height,
+                       uint8_t* dst, uint32_t dst_width, uint32_t dst_height,
+                       uint32_t col_step, uint32_t row_step);
+
+/**
+ * Feed the next source row; output rows are written as they complete
+ */
+void plane_scaler_push(PlaneScaler* s, const uint8_t* row);
+
+/**
+ * Release the scaler's arrays
+ */
+void plane_scaler_release(PlaneScaler* s);
+
+#endif /* SCALER_INTERNAL_H */
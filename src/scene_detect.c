@@ -0,0 +1,123 @@
+/*
+ * Static Scene Detection Implementation
+ *
+ * A fast frame-difference pass for fixed cameras: luma is summed over 4x4
+ * blocks in one sequential read of the plane, and the sums are compared
+ * with those of the last encoded frame. The pass costs a small fraction
+ * of an encode, which a static frame then skips altogether.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "scene_detect_internal.h"
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+/**
+ * Add one row of samples to the block sums of its block row
+ */
+static void sum_row(const uint8_t* row, int32_t col_step, uint32_t width, uint16_t* sums)
+{
+    uint32_t full = width / SCENE_BLOCK;
+
+    if (col_step == 1) {
+        for (uint32_t b = 0; b < full; b++) {
+            const uint8_t* p = row + b * SCENE_BLOCK;
+
+            sums[b] = (uint16_t)(sums[b] + p[0] + p[1] + p[2] + p[3]);
+        }
+    } else {
+        for (uint32_t b = 0; b < full; b++) {
+            const uint8_t* p = row + (int64_t)b * SCENE_BLOCK * col_step;
+
+            sums[b] = (uint16_t)(sums[b] + p[0] + p[col_step] + p[2 * col_step] +
+                                 p[3 * col_step]);
+        }
+    }
+
+    for (uint32_t x = full * SCENE_BLOCK; x < width; x++) {
+        sums[full] = (uint16_t)(sums[full] + row[(int64_t)x * col_step]);
+    }
+}
+
+/* ============================================================================
+ * Internal Implementation Functions
+ * ============================================================================ */
+
+int scene_init(SceneDetector* scene, uint32_t width, uint32_t height, uint32_t threshold)
+{
+    size_t count = 0;
+
+    memset(scene, 0, sizeof(*scene));
+    scene->threshold = threshold;
+    scene->blocks_x = (width + SCENE_BLOCK - 1) / SCENE_BLOCK;
+    scene->blocks_y = (height + SCENE_BLOCK - 1) / SCENE_BLOCK;
+
+    count = (size_t)scene->blocks_x * scene->blocks_y;
+    scene->ref = (uint16_t*)malloc(count * sizeof(uint16_t));
+    scene->cur = (uint16_t*)malloc(count * sizeof(uint16_t));
+    if (!scene->ref || !scene->cur) {
+        scene_release(scene);
+        return -1;
+    }
+
+    return 0;
+}
+
+void scene_release(SceneDetector* scene)
+{
+    free(scene->ref);
+    free(scene->cur);
+    memset(scene, 0, sizeof(*scene));
+}
+
+int scene_check(SceneDetector* scene, const JpegPlane* luma)
+{
+    uint32_t last_w = luma->width - (scene->blocks_x - 1) * SCENE_BLOCK;
+    uint32_t last_h = luma->height - (scene->blocks_y - 1) * SCENE_BLOCK;
+
+    memset(scene->cur, 0, (size_t)scene->blocks_x * scene->blocks_y * sizeof(uint16_t));
+    for (uint32_t y = 0; y < luma->height; y++) {
+        sum_row(luma->base + (int64_t)y * luma->row_step, luma->col_step, luma->width,
+                scene->cur + (size_t)(y / SCENE_BLOCK) * scene->blocks_x);
+    }
+
+    if (!scene->ref_valid) {
+        return 0;
+    }
+
+    /* Edge blocks hold fewer samples, so their limit is scaled down */
+    for (uint32_t by = 0; by < scene->blocks_y; by++) {
+        uint32_t h = by + 1 < scene->blocks_y ? SCENE_BLOCK : last_h;
+        const uint16_t* ref = scene->ref + (size_t)by * scene->blocks_x;
+        const uint16_t* cur = scene->cur + (size_t)by * scene->blocks_x;
+
+        for (uint32_t bx = 0; bx < scene->blocks_x; bx++) {
+            uint32_t w = bx + 1 < scene->blocks_x ? SCENE_BLOCK : last_w;
+            int32_t diff = (int32_t)cur[bx] - (int32_t)ref[bx];
+
+            if ((uint32_t)(diff < 0 ? -diff : diff) >= scene->threshold * w * h) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+void scene_commit(SceneDetector* scene)
+{
+    uint16_t* ref = scene->ref;
+
+    scene->ref = scene->cur;
+    scene->cur = ref;
+    scene->ref_valid = 1;
+}
+
+void scene_reset(SceneDetector* scene)
+{
+    scene->ref_valid = 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * Static Scene Detection Internal Implementation
+ */
+
+#ifndef SCENE_DETECT_INTERNAL_H
+#define SCENE_DETECT_INTERNAL_H
+
+#include <stdint.h>
+
+#include "jpeg_internal.h"
+
+/* Luma is compared as sums over SCENE_BLOCK x SCENE_BLOCK samples */
+#define SCENE_BLOCK  4
+
+/**
+ * Static scene detector
+ *
+ * Every frame is reduced to the luma sums of its 4x4 blocks. A frame is
+ * static when no block average moved by threshold levels or more since
+ * the last frame that was actually encoded, so slow drift still adds up
+ * to a change. Comparing averages ignores sensor noise on flat areas
+ * while any object the size of a few pixels still shows.
+ */
+typedef struct {
+    uint32_t threshold;                /* Block average change that counts (levels) */
+    uint32_t blocks_x;
+    uint32_t blocks_y;
+    uint16_t* ref;                     /* Block sums of the last encoded frame */
+    uint16_t* cur;                     /* Block sums of the frame being checked */
+    int ref_valid;
+} SceneDetector;
+
+/**
+ * Allocate the block sums for a luma plane size
+ *
+ * @return 0 on success, -1 on allocation failure
+ */
+int scene_init(SceneDetector* scene, uint32_t width, uint32_t height, uint32_t threshold);
+
+/**
+ * Free the block sums
+ */
+void scene_release(SceneDetector* scene);
+
+/**
+ * Reduce a luma view and compare it with the last encoded frame
+ *
+ * @return 1 if the frame is static, 0 if it changed or there is no
+ *         reference yet
+ */
+int scene_check(SceneDetector* scene, const JpegPlane* luma);
+
+/**
+ * Make the frame last checked the reference (it was encoded)
+ */
+void scene_commit(SceneDetector* scene);
+
+/**
+ * Drop the reference, so the next frame is encoded in any case
+ */
+void scene_reset(SceneDetector* scene);
+
+#endif /* SCENE_DETECT_INTERNAL_H */
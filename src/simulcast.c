@@ -0,0 +1,264 @@
+/*
+ * MJPEG Simulcast Encoder Implementation
+ *
+ * Encodes one NV12 frame at full, half, quarter and eighth resolution in
+ * a single pass over the input. Each MCU row of the frame is transformed
+ * by the full-size encoder and, while it is still in cache, averaged 2x2
+ * into the next layer's row buffer; that layer is transformed and halved
+ * again whenever its buffer holds a complete MCU row. Entropy coding of
+ * every layer runs once all coefficients are in place.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "rkmpp_mjpeg.h"
+#include "simulcast_internal.h"
+#include "log_internal.h"
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+/**
+ * Validate simulcast configuration
+ */
+static int validate_simulcast_config(const RkmppSimulcastConfig* config)
+{
+    uint32_t align = 0;
+
+    if (config->num_layers < 1 || config->num_layers > RKMPP_SIMULCAST_MAX_LAYERS) {
+        LOG_ERROR("Invalid layer count: %u (should be 1-%d)",
+                  config->num_layers, RKMPP_SIMULCAST_MAX_LAYERS);
+        return -1;
+    }
+
+    /* The smallest layer must still have even chroma dimensions */
+    align = 1u << config->num_layers;
+    if (config->width > 4096 || config->height > 4096 ||
+        config->width % align != 0 || config->height % align != 0 ||
+        (config->width >> (config->num_layers - 1)) < 16 ||
+        (config->height >> (config->num_layers - 1)) < 16) {
+        LOG_ERROR("Invalid resolution for %u layers: %ux%u",
+                  config->num_layers, config->width, config->height);
+        return -1;
+    }
+
+    for (uint32_t k = 0; k < config->num_layers; k++) {
+        if (config->quality[k] > 100) {
+            LOG_ERROR("Invalid quality: %u (should be 0-100)", config->quality[k]);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Average 2x2 neighbourhoods of 2 * rows_out source rows into rows_out rows
+ *
+ * step is the distance between samples of one channel, so interleaved
+ * chroma is halved per channel.
+ */
+static void halve_rows(const uint8_t* src, uint32_t src_stride, uint8_t* dst,
+                       uint32_t dst_stride, uint32_t width_out, uint32_t rows_out,
+                       uint32_t step)
+{
+    for (uint32_t r = 0; r < rows_out; r++) {
+        const uint8_t* s0 = src + (size_t)2 * r * src_stride;
+        const uint8_t* s1 = s0 + src_stride;
+        uint8_t* d = dst + (size_t)r * dst_stride;
+
+        for (uint32_t x = 0; x < width_out; x++) {
+            for (uint32_t ch = 0; ch < step; ch++) {
+                uint32_t i = 2 * x * step + ch;
+
+                d[x * step + ch] = (uint8_t)((s0[i] + s0[i + step] +
+                                              s1[i] + s1[i + step] + 2) >> 2);
+            }
+        }
+    }
+}
+
+/**
+ * Transform one MCU row of layer k and pass its 2x2 average down
+ *
+ * y and uv point at the row's first luma and chroma rows, both with the
+ * layer width as stride; rows counts the luma rows that exist.
+ */
+static void encode_layer_row(RkmppSimulcast* simulcast, uint32_t k, const uint8_t* y,
+                             const uint8_t* uv, uint32_t rows)
+{
+    SimulcastLayer* layer = &simulcast->layers[k];
+    SimulcastLayer* next = NULL;
+    JpegPlane planes[JPEG_MAX_COMPONENTS];
+
+    jpeg_planes_nv12(y, layer->width, rows, planes);
+    planes[1].base = uv;
+    planes[2].base = uv + 1;
+    jpeg_encoder_transform_strip(layer->jpeg, planes, layer->mcu_row++);
+
+    if (k + 1 >= simulcast->num_layers) {
+        return;
+    }
+
+    /* Frame dimensions are multiples of 2^num_layers, so every row count
+     * here halves evenly, chroma included */
+    next = &simulcast->layers[k + 1];
+    halve_rows(y, layer->width, next->strip + (size_t)next->fill * next->width,
+               next->width, next->width, rows / 2, 1);
+    halve_rows(uv, layer->width,
+               next->strip + (size_t)(16 + next->fill / 2) * next->width,
+               next->width, next->width / 2, rows / 4, 2);
+    next->fill += rows / 2;
+
+    if (next->fill == 16 || layer->mcu_row == layer->jpeg->mcus_y) {
+        uint32_t fill = next->fill;
+
+        next->fill = 0;
+        encode_layer_row(simulcast, k + 1, next->strip,
+                         next->strip + (size_t)16 * next->width, fill);
+    }
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+RkmppSimulcast* rkmpp_simulcast_create(const RkmppSimulcastConfig* config)
+{
+    RkmppSimulcast* simulcast = NULL;
+
+    if (!config) {
+        LOG_ERROR("config is NULL");
+        return NULL;
+    }
+
+    if (validate_simulcast_config(config) != 0) {
+        LOG_ERROR("invalid simulcast configuration");
+        return NULL;
+    }
+
+    simulcast = (RkmppSimulcast*)malloc(sizeof(RkmppSimulcast));
+    if (!simulcast) {
+        LOG_ERROR("failed to allocate simulcast structure");
+        return NULL;
+    }
+
+    memset(simulcast, 0, sizeof(RkmppSimulcast));
+    pthread_mutex_init(&simulcast->lock, NULL);
+    simulcast->num_layers = config->num_layers;
+
+    for (uint32_t k = 0; k < config->num_layers; k++) {
+        SimulcastLayer* layer = &simulcast->layers[k];
+
+        layer->width = config->width >> k;
+        layer->height = config->height >> k;
+        layer->quality = config->quality[k] ? config->quality[k] : 80;
+
+        layer->jpeg = jpeg_encoder_create(layer->width, layer->height, JPEG_SAMPLING_420);
+        if (!layer->jpeg ||
+            jpeg_encoder_set_quality(layer->jpeg, layer->quality) != 0 ||
+            jpeg_encoder_set_huffman_refresh(layer->jpeg, config->huffman_refresh) != 0) {
+            LOG_ERROR("failed to create %ux%u layer encoder",
+                      layer->width, layer->height);
+            rkmpp_simulcast_destroy(simulcast);
+            return NULL;
+        }
+
+        if (k > 0) {
+            layer->strip = (uint8_t*)malloc(rkmpp_get_nv12_size(layer->width, 16));
+            if (!layer->strip) {
+                LOG_ERROR("failed to allocate simulcast row buffer");
+                rkmpp_simulcast_destroy(simulcast);
+                return NULL;
+            }
+        }
+    }
+
+    LOG_INFO("MJPEG Simulcast created: %ux%u, %u layers",
+             config->width, config->height, config->num_layers);
+
+    return simulcast;
+}
+
+RkmppStatus rkmpp_simulcast_destroy(RkmppSimulcast* simulcast)
+{
+    if (!simulcast) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    for (uint32_t k = 0; k < RKMPP_SIMULCAST_MAX_LAYERS; k++) {
+        jpeg_encoder_destroy(simulcast->layers[k].jpeg);
+        free(simulcast->layers[k].strip);
+    }
+    pthread_mutex_destroy(&simulcast->lock);
+
+    free(simulcast);
+
+    return RKMPP_OK;
+}
+
+RkmppStatus rkmpp_simulcast_encode(
+    RkmppSimulcast* simulcast,
+    const uint8_t* nv12_data,
+    uint32_t nv12_size,
+    RkmppSimulcastOutput* outputs)
+{
+    SimulcastLayer* full = NULL;
+    const uint8_t* uv = NULL;
+    RkmppStatus status = RKMPP_OK;
+
+    if (!simulcast || !nv12_data || !outputs) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    full = &simulcast->layers[0];
+    if (nv12_size < rkmpp_get_nv12_size(full->width, full->height)) {
+        LOG_ERROR("NV12 frame too small: %u bytes for %ux%u",
+                  nv12_size, full->width, full->height);
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    for (uint32_t k = 0; k < simulcast->num_layers; k++) {
+        if (!outputs[k].data) {
+            return RKMPP_ERR_INVALID_PARAM;
+        }
+    }
+
+    pthread_mutex_lock(&simulcast->lock);
+
+    for (uint32_t k = 0; k < simulcast->num_layers; k++) {
+        jpeg_encoder_begin_coefs(simulcast->layers[k].jpeg);
+        simulcast->layers[k].fill = 0;
+        simulcast->layers[k].mcu_row = 0;
+    }
+
+    /* The only pass over the input: smaller layers follow row by row */
+    uv = nv12_data + (size_t)full->width * full->height;
+    for (uint32_t my = 0; my < full->jpeg->mcus_y; my++) {
+        uint32_t rows = full->height - my * 16;
+
+        encode_layer_row(simulcast, 0, nv12_data + (size_t)my * 16 * full->width,
+                         uv + (size_t)my * 8 * full->width, rows < 16 ? rows : 16);
+    }
+
+    /* Write every layer, so each undersized output reports what it needs */
+    for (uint32_t k = 0; k < simulcast->num_layers; k++) {
+        SimulcastLayer* layer = &simulcast->layers[k];
+
+        outputs[k].width = layer->width;
+        outputs[k].height = layer->height;
+        if (jpeg_encoder_write(layer->jpeg, outputs[k].data, outputs[k].size,
+                               &outputs[k].len) != 0) {
+            LOG_ERROR("%ux%u layer does not fit in %u bytes",
+                      layer->width, layer->height, outputs[k].size);
+            status = RKMPP_ERR_ENCODE;
+        }
+    }
+
+    pthread_mutex_unlock(&simulcast->lock);
+
+    return status;
+}
@@ -0,0 +1,44 @@
+/*
+ * MJPEG Simulcast Encoder Internal Implementation
+ */
+
+#ifndef SIMULCAST_INTERNAL_H
+#define SIMULCAST_INTERNAL_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "rkmpp_mjpeg.h"
+#include "jpeg_internal.h"
+#include "jpeg_encoder_internal.h"
+
+/**
+ * One resolution layer
+ *
+ * Every layer below the first collects the 2x2 averages of its parent's
+ * MCU rows in a one-MCU-row NV12 strip (16 luma rows, then 8 interleaved
+ * chroma rows) and is transformed as soon as the strip is full.
+ */
+typedef struct {
+    JpegEncoder* jpeg;                 /* Software encoder at the layer size */
+    uint32_t width;
+    uint32_t height;
+    uint32_t quality;
+
+    uint8_t* strip;                    /* Row buffer (NULL for the full-size layer) */
+    uint32_t fill;                     /* Luma rows in the strip */
+    uint32_t mcu_row;                  /* Next MCU row to transform */
+} SimulcastLayer;
+
+/**
+ * Internal simulcast encoder context structure
+ */
+struct RkmppSimulcast {
+    SimulcastLayer layers[RKMPP_SIMULCAST_MAX_LAYERS];
+    uint32_t num_layers;
+
+    /* Synchronization */
+    pthread_mutex_t lock;
+};
+
+#endif /* SIMULCAST_INTERNAL_H */
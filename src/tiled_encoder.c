@@ -0,0 +1,501 @@
+/*
+ * MJPEG Tiled Encoder Implementation
+ *
+ * Frames larger than one encoder instance accepts are cut into tiles on
+ * the MCU grid. Every tile is transformed and entropy coded by its own
+ * software encoder, tiles run in parallel on worker threads, and the
+ * stitcher interleaves their restart intervals into one scan: each
+ * interval starts with a fresh DC prediction, so a tile's coded rows
+ * decode the same wherever they are placed in the image.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "rkmpp_mjpeg.h"
+#include "tiled_encoder_internal.h"
+#include "log_internal.h"
+
+/* Default tile size: the largest frame one encoder instance accepts */
+#define TILE_DEFAULT_SIZE  4096
+
+/* Thread handles on the stack of an encode call */
+#define TILE_MAX_THREADS   64
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+/**
+ * Validate tiled encoder configuration
+ */
+static int validate_tiled_config(const RkmppTiledEncoderConfig* config)
+{
+    if (config->width < 16 || config->width > 16384 ||
+        config->height < 16 || config->height > 16384) {
+        LOG_ERROR("Invalid resolution: %ux%u", config->width, config->height);
+        return -1;
+    }
+
+    if (config->input_format > RKMPP_FORMAT_BGRA8888) {
+        LOG_ERROR("Invalid input format: %u", config->input_format);
+        return -1;
+    }
+
+    if (config->quality > 100) {
+        LOG_ERROR("Invalid quality: %u (should be 0-100)", config->quality);
+        return -1;
+    }
+
+    if (config->tile_width > TILE_DEFAULT_SIZE || config->tile_height > TILE_DEFAULT_SIZE) {
+        LOG_ERROR("Invalid tile size: %ux%u", config->tile_width, config->tile_height);
+        return -1;
+    }
+
+    if (config->num_threads > TILE_MAX_THREADS) {
+        LOG_ERROR("Invalid thread count: %u (should be 0-%d)",
+                  config->num_threads, TILE_MAX_THREADS);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * JPEG sampling the encoder uses for an input format
+ */
+static JpegSampling format_sampling(uint32_t format)
+{
+    if (format == RKMPP_FORMAT_GRAY) {
+        return JPEG_SAMPLING_GRAY;
+    }
+    if (format == RKMPP_FORMAT_NV16 || format == RKMPP_FORMAT_YUYV) {
+        return JPEG_SAMPLING_422;
+    }
+
+    return JPEG_SAMPLING_420;
+}
+
+/**
+ * Largest divisor of n that is at most limit
+ */
+static uint32_t largest_divisor(uint32_t n, uint32_t limit)
+{
+    for (uint32_t d = limit < n ? limit : n; d > 1; d--) {
+        if (n % d == 0) {
+            return d;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Lay out the tile grid and create one encoder per tile
+ */
+static int create_tiles(RkmppTiledEncoder* encoder, uint32_t tile_width, uint32_t tile_height)
+{
+    JpegSampling sampling = encoder->sampling;
+    uint32_t mcu_width = sampling == JPEG_SAMPLING_420 || sampling == JPEG_SAMPLING_422 ? 16 : 8;
+    uint32_t mcu_height = sampling == JPEG_SAMPLING_420 ? 16 : 8;
+    uint32_t max_cols = tile_width / mcu_width ? tile_width / mcu_width : 1;
+    uint32_t max_rows = tile_height / mcu_height ? tile_height / mcu_height : 1;
+    uint32_t intervals = 0;
+    uint32_t per_tile = 0;
+
+    encoder->mcus_x = (encoder->width + mcu_width - 1) / mcu_width;
+    encoder->mcus_y = (encoder->height + mcu_height - 1) / mcu_height;
+
+    /* One interval length must divide every tile width and hence the
+     * MCU row; the longest one keeps the RST markers fewest */
+    encoder->restart_interval = largest_divisor(encoder->mcus_x, max_cols);
+    intervals = encoder->mcus_x / encoder->restart_interval;
+    per_tile = max_cols / encoder->restart_interval;
+    encoder->tiles_x = (intervals + per_tile - 1) / per_tile;
+
+    /* Cut more bands than size alone needs so every thread has a tile */
+    encoder->tiles_y = (encoder->mcus_y + max_rows - 1) / max_rows;
+    if (encoder->tiles_x * encoder->tiles_y < encoder->num_threads) {
+        encoder->tiles_y = (encoder->num_threads + encoder->tiles_x - 1) / encoder->tiles_x;
+        if (encoder->tiles_y > encoder->mcus_y) {
+            encoder->tiles_y = encoder->mcus_y;
+        }
+    }
+
+    encoder->tiles = (EncoderTile*)calloc((size_t)encoder->tiles_x * encoder->tiles_y,
+                                          sizeof(EncoderTile));
+    if (!encoder->tiles) {
+        return -1;
+    }
+
+    for (uint32_t ty = 0; ty < encoder->tiles_y; ty++) {
+        uint32_t row0 = encoder->mcus_y * ty / encoder->tiles_y;
+        uint32_t row1 = encoder->mcus_y * (ty + 1) / encoder->tiles_y;
+
+        for (uint32_t tx = 0; tx < encoder->tiles_x; tx++) {
+            EncoderTile* tile = &encoder->tiles[ty * encoder->tiles_x + tx];
+            uint32_t col0 = intervals * tx / encoder->tiles_x * encoder->restart_interval;
+            uint32_t col1 = intervals * (tx + 1) / encoder->tiles_x * encoder->restart_interval;
+            uint32_t x1 = col1 * mcu_width < encoder->width ? col1 * mcu_width : encoder->width;
+            uint32_t y1 = row1 * mcu_height < encoder->height ? row1 * mcu_height
+                                                              : encoder->height;
+            uint32_t width = x1 - col0 * mcu_width;
+            uint32_t height = y1 - row0 * mcu_height;
+
+            tile->mcu_x = col0;
+            tile->mcu_y = row0;
+            tile->jpeg = jpeg_encoder_create(width, height, sampling);
+            if (!tile->jpeg || jpeg_encoder_set_quality(tile->jpeg, encoder->quality) != 0) {
+                return -1;
+            }
+
+            /* About one byte per pixel; a tile that needs more grows it */
+            tile->size = width * height + 4096;
+            tile->data = (uint8_t*)malloc(tile->size);
+            tile->ends = (uint32_t*)malloc((size_t)(row1 - row0) * (col1 - col0) /
+                                           encoder->restart_interval * sizeof(uint32_t));
+            if (!tile->data || !tile->ends) {
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * View of a plane starting at sample (x0, y0); an origin past an odd
+ * edge starts at the last sample, which the whole frame would replicate
+ */
+static void crop_plane(const JpegPlane* plane, uint32_t x0, uint32_t y0, JpegPlane* view)
+{
+    uint32_t sx = x0 < plane->width ? x0 : plane->width - 1;
+    uint32_t sy = y0 < plane->height ? y0 : plane->height - 1;
+
+    *view = *plane;
+    view->base += (int64_t)sy * plane->row_step + (int64_t)sx * plane->col_step;
+    view->width = plane->width - sx;
+    view->height = plane->height - sy;
+}
+
+/**
+ * Transform and code one tile, growing its buffer until the intervals fit
+ */
+static void encode_tile(RkmppTiledEncoder* encoder, EncoderTile* tile)
+{
+    JpegEncoder* jpeg = tile->jpeg;
+    uint32_t len = 0;
+
+    if (encoder->input_format >= RKMPP_FORMAT_RGB888) {
+        JpegRgbFrame view = encoder->rgb;
+        uint32_t x0 = tile->mcu_x * jpeg->mcu_width;
+        uint32_t y0 = tile->mcu_y * jpeg->mcu_height;
+
+        view.base += (int64_t)y0 * view.row_step + (int64_t)x0 * view.pixel_step;
+        view.width -= x0;
+        view.height -= y0;
+        jpeg_encoder_transform_rgb(jpeg, &view, NULL);
+    } else {
+        JpegPlane views[JPEG_MAX_COMPONENTS];
+
+        for (uint32_t c = 0; c < jpeg->num_components; c++) {
+            crop_plane(&encoder->planes[c], tile->mcu_x * 8 * jpeg->comp[c].h_samp,
+                       tile->mcu_y * 8 * jpeg->comp[c].v_samp, &views[c]);
+        }
+        jpeg_encoder_transform(jpeg, views, NULL);
+    }
+
+    while (jpeg_encoder_write_intervals(jpeg, encoder->restart_interval, tile->data,
+                                        tile->size, tile->ends, &len) != 0) {
+        uint32_t size = len > tile->size ? len + len / 4 : tile->size * 2;
+        uint8_t* data = (uint8_t*)realloc(tile->data, size);
+
+        if (!data) {
+            tile->status = -1;
+            return;
+        }
+        tile->data = data;
+        tile->size = size;
+    }
+
+    tile->status = 0;
+}
+
+/**
+ * Worker loop: claim and encode tiles until none are left
+ */
+static void* tile_worker(void* arg)
+{
+    RkmppTiledEncoder* encoder = (RkmppTiledEncoder*)arg;
+    uint32_t count = encoder->tiles_x * encoder->tiles_y;
+
+    for (;;) {
+        uint32_t index = 0;
+
+        pthread_mutex_lock(&encoder->work_lock);
+        index = encoder->next_tile++;
+        pthread_mutex_unlock(&encoder->work_lock);
+
+        if (index >= count) {
+            return NULL;
+        }
+        encode_tile(encoder, &encoder->tiles[index]);
+    }
+}
+
+/**
+ * Point the shared views at the input frame
+ */
+static void set_frame(RkmppTiledEncoder* encoder, const uint8_t* data)
+{
+    if (encoder->input_format >= RKMPP_FORMAT_RGB888) {
+        int bgr = encoder->input_format == RKMPP_FORMAT_BGR888 ||
+                  encoder->input_format == RKMPP_FORMAT_BGRA8888;
+
+        encoder->rgb.base = data;
+        encoder->rgb.pixel_step = encoder->input_format >= RKMPP_FORMAT_RGBA8888 ? 4 : 3;
+        encoder->rgb.row_step = (int32_t)encoder->width * encoder->rgb.pixel_step;
+        encoder->rgb.offset[0] = (uint8_t)(bgr ? 2 : 0);
+        encoder->rgb.offset[1] = 1;
+        encoder->rgb.offset[2] = (uint8_t)(bgr ? 0 : 2);
+        encoder->rgb.width = encoder->width;
+        encoder->rgb.height = encoder->height;
+        return;
+    }
+
+    switch (encoder->input_format) {
+        case RKMPP_FORMAT_NV16:
+            jpeg_planes_nv16(data, encoder->width, encoder->height, encoder->planes);
+            break;
+        case RKMPP_FORMAT_YUYV:
+            jpeg_planes_yuyv(data, encoder->width, encoder->height, encoder->planes);
+            break;
+        default:
+            /* GRAY only reads the Y plane view */
+            jpeg_planes_nv12(data, encoder->width, encoder->height, encoder->planes);
+            break;
+    }
+}
+
+/**
+ * Size of the stitched JPEG
+ */
+static uint32_t stitched_size(const RkmppTiledEncoder* encoder, uint32_t header_len)
+{
+    uint64_t size = header_len + 6 + 2;
+    uint32_t intervals = encoder->mcus_x / encoder->restart_interval * encoder->mcus_y;
+
+    for (uint32_t t = 0; t < encoder->tiles_x * encoder->tiles_y; t++) {
+        const EncoderTile* tile = &encoder->tiles[t];
+        uint32_t count = tile->jpeg->mcus_x / encoder->restart_interval * tile->jpeg->mcus_y;
+
+        size += tile->ends[count - 1];
+    }
+
+    /* An RST marker between consecutive intervals */
+    size += 2 * (uint64_t)(intervals - 1);
+
+    return size > UINT32_MAX ? UINT32_MAX : (uint32_t)size;
+}
+
+/**
+ * Write header, interleaved intervals and EOI (out holds stitched_size())
+ */
+static uint32_t stitch(const RkmppTiledEncoder* encoder, uint8_t* out)
+{
+    const JpegHeaderTemplate* header = encoder->tiles[0].jpeg->header;
+    uint32_t pos = header->sos_offset;
+    uint32_t rst = 0;
+    uint32_t last = encoder->mcus_x / encoder->restart_interval * encoder->mcus_y - 1;
+
+    memcpy(out, header->data, header->sos_offset);
+    out[header->dims_offset] = (uint8_t)(encoder->height >> 8);
+    out[header->dims_offset + 1] = (uint8_t)encoder->height;
+    out[header->dims_offset + 2] = (uint8_t)(encoder->width >> 8);
+    out[header->dims_offset + 3] = (uint8_t)encoder->width;
+
+    out[pos++] = 0xFF;
+    out[pos++] = JPEG_MARKER_DRI;
+    out[pos++] = 0;
+    out[pos++] = 4;
+    out[pos++] = (uint8_t)(encoder->restart_interval >> 8);
+    out[pos++] = (uint8_t)encoder->restart_interval;
+
+    memcpy(out + pos, header->data + header->sos_offset, header->len - header->sos_offset);
+    pos += header->len - header->sos_offset;
+
+    for (uint32_t ty = 0; ty < encoder->tiles_y; ty++) {
+        const EncoderTile* band = &encoder->tiles[ty * encoder->tiles_x];
+
+        for (uint32_t row = 0; row < band->jpeg->mcus_y; row++) {
+            for (uint32_t tx = 0; tx < encoder->tiles_x; tx++) {
+                const EncoderTile* tile = &band[tx];
+                uint32_t per_row = tile->jpeg->mcus_x / encoder->restart_interval;
+
+                for (uint32_t k = row * per_row; k < (row + 1) * per_row; k++) {
+                    uint32_t start = k > 0 ? tile->ends[k - 1] : 0;
+
+                    memcpy(out + pos, tile->data + start, tile->ends[k] - start);
+                    pos += tile->ends[k] - start;
+
+                    if (rst != last) {
+                        out[pos++] = 0xFF;
+                        out[pos++] = (uint8_t)(JPEG_MARKER_RST0 + (rst & 7));
+                    }
+                    rst++;
+                }
+            }
+        }
+    }
+
+    out[pos++] = 0xFF;
+    out[pos++] = JPEG_MARKER_EOI;
+
+    return pos;
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+RkmppTiledEncoder* rkmpp_tiled_encoder_create(const RkmppTiledEncoderConfig* config)
+{
+    RkmppTiledEncoder* encoder = NULL;
+    long cpus = 0;
+
+    if (!config) {
+        LOG_ERROR("config is NULL");
+        return NULL;
+    }
+
+    if (validate_tiled_config(config) != 0) {
+        LOG_ERROR("invalid tiled encoder configuration");
+        return NULL;
+    }
+
+    encoder = (RkmppTiledEncoder*)malloc(sizeof(RkmppTiledEncoder));
+    if (!encoder) {
+        LOG_ERROR("failed to allocate tiled encoder structure");
+        return NULL;
+    }
+
+    memset(encoder, 0, sizeof(RkmppTiledEncoder));
+    pthread_mutex_init(&encoder->lock, NULL);
+    pthread_mutex_init(&encoder->work_lock, NULL);
+
+    encoder->width = config->width;
+    encoder->height = config->height;
+    encoder->input_format = config->input_format;
+    encoder->quality = config->quality ? config->quality : 80;
+    encoder->sampling = format_sampling(config->input_format);
+
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    encoder->num_threads = config->num_threads ? config->num_threads
+                                               : (uint32_t)(cpus > 0 ? cpus : 1);
+    if (encoder->num_threads > TILE_MAX_THREADS) {
+        encoder->num_threads = TILE_MAX_THREADS;
+    }
+
+    if (create_tiles(encoder,
+                     config->tile_width ? config->tile_width : TILE_DEFAULT_SIZE,
+                     config->tile_height ? config->tile_height : TILE_DEFAULT_SIZE) != 0) {
+        LOG_ERROR("failed to create tile encoders");
+        rkmpp_tiled_encoder_destroy(encoder);
+        return NULL;
+    }
+
+    LOG_INFO("MJPEG Tiled Encoder created: %ux%u in %ux%u tiles, %u threads",
+             encoder->width, encoder->height, encoder->tiles_x, encoder->tiles_y,
+             encoder->num_threads);
+
+    return encoder;
+}
+
+RkmppStatus rkmpp_tiled_encoder_destroy(RkmppTiledEncoder* encoder)
+{
+    if (!encoder) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    if (encoder->tiles) {
+        for (uint32_t t = 0; t < encoder->tiles_x * encoder->tiles_y; t++) {
+            jpeg_encoder_destroy(encoder->tiles[t].jpeg);
+            free(encoder->tiles[t].data);
+            free(encoder->tiles[t].ends);
+        }
+        free(encoder->tiles);
+    }
+    pthread_mutex_destroy(&encoder->work_lock);
+    pthread_mutex_destroy(&encoder->lock);
+
+    free(encoder);
+
+    return RKMPP_OK;
+}
+
+RkmppStatus rkmpp_tiled_encoder_encode(
+    RkmppTiledEncoder* encoder,
+    const uint8_t* frame_data,
+    uint32_t frame_size,
+    uint8_t* jpeg_out,
+    uint32_t out_size,
+    uint32_t* out_len)
+{
+    pthread_t threads[TILE_MAX_THREADS];
+    uint32_t count = 0;
+    uint32_t started = 0;
+    uint32_t needed = 0;
+
+    if (!encoder || !frame_data || !jpeg_out || !out_len) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    if (frame_size < rkmpp_get_frame_size(encoder->input_format, encoder->width,
+                                          encoder->height)) {
+        LOG_ERROR("frame too small: %u bytes for %ux%u",
+                  frame_size, encoder->width, encoder->height);
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&encoder->lock);
+
+    set_frame(encoder, frame_data);
+    count = encoder->tiles_x * encoder->tiles_y;
+    encoder->next_tile = 0;
+
+    /* The calling thread is one of the workers; a thread that fails to
+     * start only leaves more tiles to the others */
+    while (started + 1 < encoder->num_threads && started + 1 < count &&
+           pthread_create(&threads[started], NULL, tile_worker, encoder) == 0) {
+        started++;
+    }
+    tile_worker(encoder);
+    for (uint32_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (uint32_t t = 0; t < count; t++) {
+        if (encoder->tiles[t].status != 0) {
+            LOG_ERROR("failed to allocate tile output");
+            pthread_mutex_unlock(&encoder->lock);
+            return RKMPP_ERR_MEMORY;
+        }
+    }
+
+    needed = stitched_size(encoder, encoder->tiles[0].jpeg->header->len);
+    if (needed > out_size) {
+        LOG_ERROR("output buffer too small: %u bytes, need %u",
+                  out_size, needed);
+        *out_len = needed;
+        pthread_mutex_unlock(&encoder->lock);
+        return RKMPP_ERR_ENCODE;
+    }
+
+    *out_len = stitch(encoder, jpeg_out);
+
+    pthread_mutex_unlock(&encoder->lock);
+
+    return RKMPP_OK;
+}
@@ -0,0 +1,63 @@
+/*
+ * MJPEG Tiled Encoder Internal Implementation
+ */
+
+#ifndef TILED_ENCODER_INTERNAL_H
+#define TILED_ENCODER_INTERNAL_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "rkmpp_mjpeg.h"
+#include "jpeg_internal.h"
+#include "jpeg_encoder_internal.h"
+
+/**
+ * One tile and its encoded restart intervals
+ */
+typedef struct {
+    JpegEncoder* jpeg;                 /* Software encoder at the tile size */
+    uint32_t mcu_x;                    /* Tile origin in MCUs */
+    uint32_t mcu_y;
+
+    uint8_t* data;                     /* Entropy-coded intervals, back to back */
+    uint32_t size;
+    uint32_t* ends;                    /* End of each interval in data */
+    int status;                        /* 0, or -1 if the tile could not be coded */
+} EncoderTile;
+
+/**
+ * Internal tiled encoder context structure
+ *
+ * Tiles span whole restart intervals: every interval is restart_interval
+ * MCUs of one tile row, so the stitched scan takes each MCU row's
+ * intervals from the tiles left to right.
+ */
+struct RkmppTiledEncoder {
+    /* Configuration */
+    uint32_t width;
+    uint32_t height;
+    uint32_t input_format;             /* RkmppFormat */
+    uint32_t quality;
+    JpegSampling sampling;
+    uint32_t num_threads;
+
+    /* Tile grid */
+    uint32_t mcus_x;
+    uint32_t mcus_y;
+    uint32_t restart_interval;         /* MCUs per interval */
+    uint32_t tiles_x;
+    uint32_t tiles_y;
+    EncoderTile* tiles;                /* Row-major */
+
+    /* Frame being encoded, shared by the workers */
+    JpegPlane planes[JPEG_MAX_COMPONENTS];
+    JpegRgbFrame rgb;
+    uint32_t next_tile;                /* Next tile to claim (work_lock held) */
+    pthread_mutex_t work_lock;
+
+    /* Synchronization */
+    pthread_mutex_t lock;
+};
+
+#endif /* TILED_ENCODER_INTERNAL_H */
@@ -0,0 +1,598 @@
+/*
+ * MJPEG Transcoder Implementation
+ *
+ * Decode, scale and re-encode in one pass: the software decoder hands over
+ * each MCU row as soon as it is reconstructed, every component is
+ * area-averaged into the output-sized NV12 frame, and the encoder
+ * compresses that frame. Only one source MCU row is ever in memory.
+ *
+ * Requantization stays in the DCT domain: coefficients are entropy-decoded
+ * into a software encoder of the source geometry and re-quantized and
+ * re-coded from there, with no inverse or forward DCT. Lossless transforms
+ * rearrange those coefficients into a second encoder that keeps the
+ * source's quantization tables.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "rkmpp_mjpeg.h"
+#include "transcoder_internal.h"
+#include "decoder_internal.h"
+#include "encoder_internal.h"
+#include "jpeg_decoder_internal.h"
+#include "jpeg_transform_internal.h"
+#include "log_internal.h"
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+/**
+ * Monotonic clock in microseconds
+ */
+static uint64_t transcoder_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+/**
+ * Validate transcoder configuration (the encoder checks the output side)
+ */
+static int validate_transcoder_config(const RkmppTranscoderConfig* config)
+{
+    if (config->max_width < 16 || config->max_width > 4096 ||
+        config->max_height < 16 || config->max_height > 4096) {
+        LOG_ERROR("Invalid max source resolution: %ux%u",
+                  config->max_width, config->max_height);
+        return -1;
+    }
+
+    if (config->output.quality > 100) {
+        LOG_ERROR("Invalid quality: %u (should be 0-100)", config->output.quality);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Parse the source header and check it against the configured maximum
+ * (lock held)
+ */
+static RkmppStatus read_source(RkmppTranscoder* transcoder, const uint8_t* jpeg_in,
+                               uint32_t in_size)
+{
+    JpegDecoder* jpeg = transcoder->decoder->jpeg;
+
+    if (jpeg_decoder_read_header(jpeg, jpeg_in, in_size) != 0) {
+        LOG_ERROR("unsupported or corrupt JPEG header");
+        return RKMPP_ERR_DECODE;
+    }
+
+    if (jpeg->width > transcoder->decoder->max_width ||
+        jpeg->height > transcoder->decoder->max_height) {
+        LOG_ERROR("JPEG %ux%u exceeds max resolution %ux%u",
+                  jpeg->width, jpeg->height,
+                  transcoder->decoder->max_width, transcoder->decoder->max_height);
+        return RKMPP_ERR_DECODE;
+    }
+
+    return RKMPP_OK;
+}
+
+/**
+ * Account a completed frame and fill in its result (lock held)
+ */
+static void record_frame(RkmppTranscoder* transcoder, uint32_t in_size, uint32_t out_len,
+                         uint32_t width, uint32_t height, uint32_t quality,
+                         uint64_t start, uint64_t decoded, RkmppTranscodeResult* result)
+{
+    const JpegDecoder* jpeg = transcoder->decoder->jpeg;
+    uint64_t end = transcoder_now_us();
+    uint64_t latency = end - start;
+
+    transcoder->frames_transcoded++;
+    transcoder->bytes_in += in_size;
+    transcoder->bytes_out += out_len;
+    transcoder->latency_sum_us += latency;
+    if (transcoder->frames_transcoded == 1 || latency < transcoder->latency_min_us) {
+        transcoder->latency_min_us = latency;
+    }
+    if (latency > transcoder->latency_max_us) {
+        transcoder->latency_max_us = latency;
+    }
+
+    if (result) {
+        result->src_width = jpeg->width;
+        result->src_height = jpeg->height;
+        result->width = width;
+        result->height = height;
+        result->quality = quality;
+        result->decode_us = decoded - start;
+        result->encode_us = end - decoded;
+        result->latency_us = latency;
+    }
+}
+
+/**
+ * Encoder sampling matching the source's component layout, -1 if the
+ * encoder has no such layout
+ */
+static int requant_sampling(const JpegDecoder* jpeg)
+{
+    if (jpeg->num_components == 1) {
+        return jpeg->comp[0].h_samp * jpeg->comp[0].v_samp == 1 ? JPEG_SAMPLING_GRAY : -1;
+    }
+
+    /* Blocks are handed over in scan order, which must be Y, Cb, Cr */
+    for (uint32_t s = 0; s < jpeg->scan_components; s++) {
+        if (jpeg->scan_comp[s] != s) {
+            return -1;
+        }
+    }
+    if (jpeg->scan_components != 3) {
+        return -1;
+    }
+
+    if (jpeg->max_h == 2 && jpeg->max_v == 2) {
+        return JPEG_SAMPLING_420;
+    }
+    if (jpeg->max_h == 2 && jpeg->max_v == 1) {
+        return JPEG_SAMPLING_422;
+    }
+    if (jpeg->max_h == 1 && jpeg->max_v == 1) {
+        return JPEG_SAMPLING_444;
+    }
+
+    return -1;
+}
+
+/**
+ * Keep *slot an encoder of the given geometry (lock held)
+ */
+static int ensure_encoder(RkmppTranscoder* transcoder, JpegEncoder** slot, uint32_t width,
+                          uint32_t height, JpegSampling sampling)
+{
+    JpegEncoder* enc = *slot;
+
+    if (enc && enc->width == width && enc->height == height && enc->sampling == sampling) {
+        return 0;
+    }
+
+    jpeg_encoder_destroy(enc);
+    *slot = NULL;
+
+    enc = jpeg_encoder_create(width, height, sampling);
+    if (!enc || jpeg_encoder_set_huffman_refresh(enc, transcoder->huffman_refresh) != 0) {
+        jpeg_encoder_destroy(enc);
+        return -1;
+    }
+    *slot = enc;
+
+    return 0;
+}
+
+/**
+ * Hand the source's quantization tables to an encoder, -1 if its chroma
+ * components do not share one table or a table is not 8-bit
+ */
+static int use_source_tables(JpegEncoder* enc, const JpegDecoder* jpeg)
+{
+    const uint16_t* luma = jpeg->quant[jpeg->comp[0].quant_table];
+    const uint16_t* chroma = luma;
+
+    if (jpeg->num_components > 1) {
+        if (jpeg->comp[1].quant_table != jpeg->comp[2].quant_table) {
+            return -1;
+        }
+        chroma = jpeg->quant[jpeg->comp[1].quant_table];
+    }
+
+    return jpeg_encoder_set_quant_tables(enc, luma, chroma);
+}
+
+/**
+ * Point the scalers at the output frame for a source of the decoded size
+ */
+static int setup_scalers(RkmppTranscoder* transcoder, const JpegDecoder* jpeg)
+{
+    uint8_t* uv = transcoder->frame + (size_t)transcoder->width * transcoder->height;
+
+    for (uint32_t c = 0; c < jpeg->num_components; c++) {
+        uint32_t src_width = 0;
+        uint32_t src_height = 0;
+        int ret = 0;
+
+        jpeg_decoder_component_size(jpeg, c, &src_width, &src_height);
+        if (c == 0) {
+            ret = plane_scaler_setup(&transcoder->scaler[0], src_width, src_height,
+                                     transcoder->frame, transcoder->width, transcoder->height,
+                                     1, transcoder->width);
+        } else {
+            ret = plane_scaler_setup(&transcoder->scaler[c], src_width, src_height,
+                                     uv + (c - 1), transcoder->width / 2,
+                                     transcoder->height / 2, 2, transcoder->width);
+        }
+        if (ret != 0) {
+            return -1;
+        }
+    }
+
+    /* Grayscale sources get neutral chroma */
+    if (jpeg->num_components == 1) {
+        memset(uv, 128, (size_t)transcoder->width * (transcoder->height / 2));
+    }
+
+    return 0;
+}
+
+/**
+ * Feed one decoded MCU row of every component to its scaler
+ */
+static void scale_row(void* opaque, const JpegDecoder* jpeg, uint32_t mcu_row)
+{
+    RkmppTranscoder* transcoder = (RkmppTranscoder*)opaque;
+
+    for (uint32_t c = 0; c < jpeg->num_components; c++) {
+        uint32_t rows = 8 * jpeg->comp[c].v_samp;
+
+        /* Scalers ignore the padding rows below the image */
+        for (uint32_t y = 0; y < rows; y++) {
+            plane_scaler_push(&transcoder->scaler[c],
+                              jpeg->strip[c] + (size_t)y * jpeg->strip_stride[c]);
+        }
+    }
+
+    (void)mcu_row;
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+RkmppTranscoder* rkmpp_transcoder_create(const RkmppTranscoderConfig* config)
+{
+    RkmppTranscoder* transcoder = NULL;
+    RkmppDecoderConfig dec_config;
+    RkmppEncoderConfig enc_config;
+
+    if (!config) {
+        LOG_ERROR("config is NULL");
+        return NULL;
+    }
+
+    if (validate_transcoder_config(config) != 0) {
+        LOG_ERROR("invalid transcoder configuration");
+        return NULL;
+    }
+
+    transcoder = (RkmppTranscoder*)malloc(sizeof(RkmppTranscoder));
+    if (!transcoder) {
+        LOG_ERROR("failed to allocate transcoder structure");
+        return NULL;
+    }
+
+    memset(transcoder, 0, sizeof(RkmppTranscoder));
+    pthread_mutex_init(&transcoder->lock, NULL);
+
+    /* Both ends run on the software codec, which exposes decoded rows */
+    memset(&dec_config, 0, sizeof(dec_config));
+    dec_config.max_width = config->max_width;
+    dec_config.max_height = config->max_height;
+    dec_config.output_format = RKMPP_FORMAT_NV12;
+    dec_config.backend = RKMPP_BACKEND_CPU;
+
+    enc_config = config->output;
+    enc_config.input_format = RKMPP_FORMAT_NV12;
+    enc_config.backend = RKMPP_BACKEND_CPU;
+    transcoder->huffman_refresh = config->output.huffman_refresh;
+
+    transcoder->decoder = rkmpp_decoder_create(&dec_config);
+    if (!transcoder->decoder) {
+        LOG_ERROR("failed to create transcoder decoder");
+        goto fail;
+    }
+
+    /* A 0x0 output only requantizes and needs no scaling pipeline */
+    if (enc_config.width != 0 || enc_config.height != 0) {
+        transcoder->encoder = rkmpp_encoder_create(&enc_config);
+        if (!transcoder->encoder) {
+            LOG_ERROR("failed to create transcoder encoder");
+            goto fail;
+        }
+
+        transcoder->width = enc_config.width;
+        transcoder->height = enc_config.height;
+        transcoder->frame_size = rkmpp_get_nv12_size(transcoder->width, transcoder->height);
+        transcoder->frame = (uint8_t*)malloc(transcoder->frame_size);
+        if (!transcoder->frame) {
+            LOG_ERROR("failed to allocate transcoder frame");
+            goto fail;
+        }
+    }
+
+    LOG_INFO("MJPEG Transcoder created: up to %ux%u -> %ux%u",
+             config->max_width, config->max_height, transcoder->width, transcoder->height);
+
+    return transcoder;
+
+fail:
+    if (transcoder->encoder) {
+        rkmpp_encoder_destroy(transcoder->encoder);
+    }
+    if (transcoder->decoder) {
+        rkmpp_decoder_destroy(transcoder->decoder);
+    }
+    pthread_mutex_destroy(&transcoder->lock);
+    free(transcoder);
+    return NULL;
+}
+
+RkmppStatus rkmpp_transcoder_destroy(RkmppTranscoder* transcoder)
+{
+    if (!transcoder) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    for (int c = 0; c < JPEG_MAX_COMPONENTS; c++) {
+        plane_scaler_release(&transcoder->scaler[c]);
+    }
+    free(transcoder->frame);
+    jpeg_encoder_destroy(transcoder->requant);
+    jpeg_encoder_destroy(transcoder->transformed);
+    if (transcoder->encoder) {
+        rkmpp_encoder_destroy(transcoder->encoder);
+    }
+    rkmpp_decoder_destroy(transcoder->decoder);
+    pthread_mutex_destroy(&transcoder->lock);
+
+    free(transcoder);
+
+    return RKMPP_OK;
+}
+
+RkmppStatus rkmpp_transcoder_transcode(
+    RkmppTranscoder* transcoder,
+    const uint8_t* jpeg_in,
+    uint32_t in_size,
+    uint8_t* jpeg_out,
+    uint32_t out_size,
+    uint32_t* out_len,
+    RkmppTranscodeResult* result)
+{
+    RkmppEncodeResult encoded;
+    JpegDecoder* jpeg = NULL;
+    RkmppStatus status = RKMPP_OK;
+    uint64_t start = 0;
+    uint64_t decoded = 0;
+
+    if (!transcoder || !jpeg_in || in_size == 0 || !jpeg_out || !out_len) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    if (!transcoder->encoder) {
+        LOG_ERROR("transcoder has no output size");
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&transcoder->lock);
+
+    start = transcoder_now_us();
+    jpeg = transcoder->decoder->jpeg;
+
+    status = read_source(transcoder, jpeg_in, in_size);
+    if (status != RKMPP_OK) {
+        pthread_mutex_unlock(&transcoder->lock);
+        return status;
+    }
+
+    if (setup_scalers(transcoder, jpeg) != 0) {
+        LOG_ERROR("failed to allocate scaler rows");
+        pthread_mutex_unlock(&transcoder->lock);
+        return RKMPP_ERR_MEMORY;
+    }
+
+    if (jpeg_decoder_decode_rows(jpeg, jpeg_in, in_size, 0, scale_row, transcoder) != 0) {
+        LOG_ERROR("corrupt JPEG entropy-coded data");
+        pthread_mutex_unlock(&transcoder->lock);
+        return RKMPP_ERR_DECODE;
+    }
+    decoded = transcoder_now_us();
+
+    status = rkmpp_encoder_encode_ex(transcoder->encoder, transcoder->frame,
+                                     transcoder->frame_size, jpeg_out, out_size, out_len,
+                                     NULL, &encoded);
+    if (status == RKMPP_OK) {
+        /* An output transform may have swapped the scaled frame's axes */
+        record_frame(transcoder, in_size, *out_len, transcoder->encoder->jpeg->width,
+                     transcoder->encoder->jpeg->height, encoded.quality, start, decoded,
+                     result);
+    }
+
+    pthread_mutex_unlock(&transcoder->lock);
+
+    return status;
+}
+
+RkmppStatus rkmpp_transcoder_requantize(
+    RkmppTranscoder* transcoder,
+    const uint8_t* jpeg_in,
+    uint32_t in_size,
+    uint32_t quality,
+    uint8_t* jpeg_out,
+    uint32_t out_size,
+    uint32_t* out_len,
+    RkmppTranscodeResult* result)
+{
+    JpegDecoder* jpeg = NULL;
+    JpegEncoder* enc = NULL;
+    RkmppStatus status = RKMPP_OK;
+    int sampling = 0;
+    uint64_t start = 0;
+    uint64_t decoded = 0;
+
+    if (!transcoder || !jpeg_in || in_size == 0 || !jpeg_out || !out_len ||
+        quality < 1 || quality > 100) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&transcoder->lock);
+
+    start = transcoder_now_us();
+    jpeg = transcoder->decoder->jpeg;
+
+    status = read_source(transcoder, jpeg_in, in_size);
+    if (status != RKMPP_OK) {
+        pthread_mutex_unlock(&transcoder->lock);
+        return status;
+    }
+
+    sampling = requant_sampling(jpeg);
+    if (sampling < 0) {
+        LOG_ERROR("JPEG component layout cannot be requantized");
+        pthread_mutex_unlock(&transcoder->lock);
+        return RKMPP_ERR_DECODE;
+    }
+
+    if (ensure_encoder(transcoder, &transcoder->requant, jpeg->width, jpeg->height,
+                       (JpegSampling)sampling) != 0 ||
+        jpeg_encoder_set_quality(transcoder->requant, quality) != 0) {
+        LOG_ERROR("failed to create requantization encoder");
+        pthread_mutex_unlock(&transcoder->lock);
+        return RKMPP_ERR_MEMORY;
+    }
+    enc = transcoder->requant;
+
+    if (jpeg_decoder_decode_coefs(jpeg, jpeg_in, in_size, jpeg_encoder_begin_coefs(enc)) != 0) {
+        LOG_ERROR("corrupt JPEG entropy-coded data");
+        pthread_mutex_unlock(&transcoder->lock);
+        return RKMPP_ERR_DECODE;
+    }
+    decoded = transcoder_now_us();
+
+    if (jpeg_encoder_write(enc, jpeg_out, out_size, out_len) != 0) {
+        LOG_ERROR("JPEG output buffer too small: %u", out_size);
+        pthread_mutex_unlock(&transcoder->lock);
+        return RKMPP_ERR_ENCODE;
+    }
+
+    record_frame(transcoder, in_size, *out_len, jpeg->width, jpeg->height, quality,
+                 start, decoded, result);
+
+    pthread_mutex_unlock(&transcoder->lock);
+
+    return RKMPP_OK;
+}
+
+RkmppStatus rkmpp_transcoder_transform(
+    RkmppTranscoder* transcoder,
+    const uint8_t* jpeg_in,
+    uint32_t in_size,
+    uint32_t transform,
+    uint8_t* jpeg_out,
+    uint32_t out_size,
+    uint32_t* out_len,
+    RkmppTranscodeResult* result)
+{
+    JpegDecoder* jpeg = NULL;
+    JpegEncoder* enc = NULL;
+    RkmppStatus status = RKMPP_OK;
+    int sampling = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint64_t start = 0;
+    uint64_t decoded = 0;
+
+    if (!transcoder || !jpeg_in || in_size == 0 || !jpeg_out || !out_len ||
+        transform >= JPEG_TRANSFORM_COUNT) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&transcoder->lock);
+
+    start = transcoder_now_us();
+    jpeg = transcoder->decoder->jpeg;
+
+    status = read_source(transcoder, jpeg_in, in_size);
+    if (status != RKMPP_OK) {
+        pthread_mutex_unlock(&transcoder->lock);
+        return status;
+    }
+
+    /* RkmppTransform and JpegTransform share their values */
+    sampling = requant_sampling(jpeg);
+    if (sampling < 0 ||
+        jpeg_transform_size((JpegTransform)transform, (JpegSampling)sampling,
+                            jpeg->width, jpeg->height, &width, &height) != 0) {
+        LOG_ERROR("JPEG layout cannot be transformed losslessly");
+        pthread_mutex_unlock(&transcoder->lock);
+        return RKMPP_ERR_DECODE;
+    }
+
+    if (ensure_encoder(transcoder, &transcoder->requant, jpeg->width, jpeg->height,
+                       (JpegSampling)sampling) != 0 ||
+        ensure_encoder(transcoder, &transcoder->transformed, width, height,
+                       (JpegSampling)sampling) != 0) {
+        LOG_ERROR("failed to create transform encoders");
+        pthread_mutex_unlock(&transcoder->lock);
+        return RKMPP_ERR_MEMORY;
+    }
+    enc = transcoder->transformed;
+
+    if (use_source_tables(enc, jpeg) != 0) {
+        LOG_ERROR("JPEG quantization tables cannot be kept");
+        pthread_mutex_unlock(&transcoder->lock);
+        return RKMPP_ERR_DECODE;
+    }
+
+    if (jpeg_decoder_decode_coefs(jpeg, jpeg_in, in_size,
+                                  jpeg_encoder_begin_coefs(transcoder->requant)) != 0) {
+        LOG_ERROR("corrupt JPEG entropy-coded data");
+        pthread_mutex_unlock(&transcoder->lock);
+        return RKMPP_ERR_DECODE;
+    }
+    jpeg_transform_coefs((JpegTransform)transform, transcoder->requant, enc);
+    decoded = transcoder_now_us();
+
+    if (jpeg_encoder_write(enc, jpeg_out, out_size, out_len) != 0) {
+        LOG_ERROR("JPEG output buffer too small: %u", out_size);
+        pthread_mutex_unlock(&transcoder->lock);
+        return RKMPP_ERR_ENCODE;
+    }
+
+    record_frame(transcoder, in_size, *out_len, width, height, 0, start, decoded, result);
+
+    pthread_mutex_unlock(&transcoder->lock);
+
+    return RKMPP_OK;
+}
+
+RkmppStatus rkmpp_transcoder_get_stats(
+    RkmppTranscoder* transcoder,
+    RkmppTranscoderStats* stats)
+{
+    if (!transcoder || !stats) {
+        return RKMPP_ERR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&transcoder->lock);
+
+    memset(stats, 0, sizeof(*stats));
+    stats->frames_transcoded = transcoder->frames_transcoded;
+    stats->bytes_in = transcoder->bytes_in;
+    stats->bytes_out = transcoder->bytes_out;
+    stats->latency_min_us = transcoder->latency_min_us;
+    stats->latency_max_us = transcoder->latency_max_us;
+    if (transcoder->frames_transcoded) {
+        stats->latency_avg_us = transcoder->latency_sum_us / transcoder->frames_transcoded;
+    }
+
+    pthread_mutex_unlock(&transcoder->lock);
+
+    return RKMPP_OK;
+}
@@ -0,0 +1,59 @@
+/*
+ * MJPEG Transcoder Internal Implementation
+ */
+
+#ifndef TRANSCODER_INTERNAL_H
+#define TRANSCODER_INTERNAL_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "rkmpp_mjpeg.h"
+#include "jpeg_internal.h"
+#include "jpeg_encoder_internal.h"
+#include "scaler_internal.h"
+
+/**
+ * Internal transcoder context structure
+ *
+ * The source is decoded by the software decoder one MCU row at a time and
+ * each row is scaled straight into the output-sized NV12 frame, which the
+ * encoder then compresses. The full-size decoded frame never exists.
+ * Requantization and lossless transforms bypass pixels altogether:
+ * entropy-decoded coefficients go straight into a software encoder of the
+ * source geometry.
+ */
+struct RkmppTranscoder {
+    /* Codecs (CPU backend) */
+    RkmppDecoder* decoder;             /* Source side, rows or coefficients */
+    RkmppEncoder* encoder;             /* NV12 input at the output size (NULL when
+                                          the transcoder only requantizes) */
+
+    /* DCT-domain paths: coefficients of the last source geometry, and
+     * their rotated or flipped arrangement */
+    JpegEncoder* requant;
+    JpegEncoder* transformed;
+    uint32_t huffman_refresh;
+
+    /* Output geometry */
+    uint32_t width;
+    uint32_t height;
+
+    /* Scaled frame handed to the encoder */
+    uint8_t* frame;
+    uint32_t frame_size;
+    PlaneScaler scaler[JPEG_MAX_COMPONENTS];
+
+    /* Statistics */
+    uint64_t frames_transcoded;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint64_t latency_sum_us;
+    uint64_t latency_min_us;
+    uint64_t latency_max_us;
+
+    /* Synchronization */
+    pthread_mutex_t lock;
+};
+
+#endif /* TRANSCODER_INTERNAL_H */
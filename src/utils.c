@@ -22,6 +22,38 @@ uint32_t rkmpp_get_nv12_size(uint32_t width, uint32_t height)
     return (width * height * 3) / 2;
 }
 
+/**
+ * Get required raw frame buffer size
+ * NV12: width * height * 3 / 2
+ * NV16, YUYV: width * height * 2
+ * GRAY: width * height
+ * RGB888, BGR888: width * height * 3
+ * RGBA8888, BGRA8888: width * height * 4
+ * RGB_F32_PLANAR: width * height * 3 * sizeof(float)
+ */
+uint32_t rkmpp_get_frame_size(uint32_t format, uint32_t width, uint32_t height)
+{
+    switch (format) {
+        case RKMPP_FORMAT_NV12:
+            return rkmpp_get_nv12_size(width, height);
+        case RKMPP_FORMAT_NV16:
+        case RKMPP_FORMAT_YUYV:
+            return width * height * 2;
+        case RKMPP_FORMAT_GRAY:
+            return width * height;
+        case RKMPP_FORMAT_RGB888:
+        case RKMPP_FORMAT_BGR888:
+            return width * height * 3;
+        case RKMPP_FORMAT_RGBA8888:
+        case RKMPP_FORMAT_BGRA8888:
+            return width * height * 4;
+        case RKMPP_FORMAT_RGB_F32_PLANAR:
+            return width * height * 3 * (uint32_t)sizeof(float);
+        default:
+            return 0;
+    }
+}
+
 /**
  * Get error message string
  */
@@ -0,0 +1,311 @@
+/*
+ * Entropy Coding Microbenchmarks
+ *
+ * Measures the CPU backend bit writer on its own, the complete quantize +
+ * Huffman + bit writing stage and the decoder (NV12, luma-only and RGB
+ * output) on camera-like content.
+ * Results are reported as coded bits per cycle (TSC cycles on x86,
+ * nanoseconds elsewhere). Not part of the test suite; run bench_entropy
+ * directly.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "jpeg_encoder_internal.h"
+#include "jpeg_decoder_internal.h"
+#include "jpeg_bit_writer_internal.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "cycle"
+static uint64_t bench_clock(void)
+{
+    return __rdtsc();
+}
+#else
+#define BENCH_UNIT "ns"
+static uint64_t bench_clock(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+#define BENCH_SYMBOLS   (1u << 20)
+#define BENCH_REPEAT    20
+
+/**
+ * One (code, size) pair as the encoder emits them
+ */
+typedef struct {
+    uint32_t code;
+    int size;
+} BenchSymbol;
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+static uint32_t bench_rand(uint32_t* state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+/**
+ * Camera-like NV12 content: lit gradients, textured areas, sensor noise
+ */
+static void fill_content(uint8_t* nv12, uint32_t width, uint32_t height)
+{
+    uint32_t state = 12345;
+    uint8_t* uv = nv12 + (size_t)width * height;
+
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            double base = 90.0 + 60.0 * sin(x * 0.011) * cos(y * 0.017);
+            double texture = x > width / 2 ? 25.0 * sin(x * 0.9) * sin(y * 0.7) : 0.0;
+            int noise = (int)(bench_rand(&state) % 9) - 4;
+            int value = (int)(base + texture) + noise;
+
+            nv12[(size_t)y * width + x] = (uint8_t)(value < 0 ? 0 : value > 255 ? 255 : value);
+        }
+    }
+
+    for (uint32_t y = 0; y < height / 2; y++) {
+        for (uint32_t x = 0; x < width / 2; x++) {
+            uv[(size_t)y * width + 2 * x] = (uint8_t)(118 + (x * 20) / width);
+            uv[(size_t)y * width + 2 * x + 1] = (uint8_t)(136 - (y * 20) / height);
+        }
+    }
+}
+
+/**
+ * Bit writer alone: code lengths of typical Huffman output (2-27 bits)
+ */
+static void bench_bit_writer(const char* name, const BenchSymbol* symbols, uint8_t* buf,
+                             uint32_t buf_size)
+{
+    uint64_t best = UINT64_MAX;
+    uint64_t bits = 0;
+    uint32_t len = 0;
+
+    for (uint32_t i = 0; i < BENCH_SYMBOLS; i++) {
+        bits += (uint64_t)symbols[i].size;
+    }
+
+    for (int r = 0; r < BENCH_REPEAT; r++) {
+        JpegBitWriter w;
+        uint64_t start = bench_clock();
+
+        jpeg_bw_init(&w, buf, buf_size);
+        for (uint32_t i = 0; i < BENCH_SYMBOLS; i++) {
+            jpeg_bw_put_bits(&w, symbols[i].code, symbols[i].size);
+        }
+        jpeg_bw_flush(&w);
+
+        start = bench_clock() - start;
+        if (start < best) {
+            best = start;
+        }
+        len = w.pos;
+    }
+
+    printf("  %-28s %8.2f bits/%s  (%u bytes)\n", name, (double)bits / (double)best,
+           BENCH_UNIT, len);
+}
+
+/**
+ * Quantization, Huffman coding and bit writing of one transformed frame
+ */
+static void bench_entropy_stage(const uint8_t* nv12, uint32_t width, uint32_t height,
+                                uint32_t quality, uint32_t huffman_refresh)
+{
+    JpegEncoder* enc = jpeg_encoder_create(width, height, JPEG_SAMPLING_420);
+    JpegPlane planes[JPEG_MAX_COMPONENTS];
+    uint32_t out_size = width * height * 2;
+    uint8_t* out = (uint8_t*)malloc(out_size);
+    uint64_t best = UINT64_MAX;
+    uint32_t len = 0;
+
+    if (!enc || !out || jpeg_encoder_set_quality(enc, quality) != 0 ||
+        jpeg_encoder_set_huffman_refresh(enc, huffman_refresh) != 0) {
+        printf("  setup failed\n");
+        jpeg_encoder_destroy(enc);
+        free(out);
+        return;
+    }
+
+    jpeg_planes_nv12(nv12, width, height, planes);
+    jpeg_encoder_transform(enc, planes, NULL);
+
+    for (int r = 0; r < BENCH_REPEAT; r++) {
+        uint64_t start = bench_clock();
+
+        if (jpeg_encoder_write(enc, out, out_size, &len) != 0) {
+            printf("  encode failed\n");
+            break;
+        }
+
+        start = bench_clock() - start;
+        if (start < best) {
+            best = start;
+        }
+    }
+
+    printf("  %ux%u q%-3u %-14s %8.2f bits/%s  (%u bytes)\n", width, height, quality,
+           huffman_refresh ? "optimal tables" : "Annex K tables",
+           (double)len * 8.0 / (double)best, BENCH_UNIT, len);
+
+    free(out);
+    jpeg_encoder_destroy(enc);
+}
+
+/**
+ * Huffman decoding, inverse DCT and NV12, luma-only or RGB output of one frame
+ */
+static void bench_decode(const uint8_t* nv12, uint32_t width, uint32_t height,
+                         uint32_t quality, JpegOutputFormat format)
+{
+    JpegEncoder* enc = jpeg_encoder_create(width, height, JPEG_SAMPLING_420);
+    JpegDecoder* dec = jpeg_decoder_create();
+    JpegPlane planes[JPEG_MAX_COMPONENTS];
+    uint32_t jpeg_size = width * height * 2;
+    uint8_t* jpeg = (uint8_t*)malloc(jpeg_size);
+    uint8_t* out = (uint8_t*)malloc((size_t)width * height * 3);
+    uint64_t best = UINT64_MAX;
+    uint32_t len = 0;
+
+    if (!enc || !dec || !jpeg || !out || jpeg_encoder_set_quality(enc, quality) != 0) {
+        printf("  setup failed\n");
+        goto done;
+    }
+
+    jpeg_planes_nv12(nv12, width, height, planes);
+    jpeg_encoder_transform(enc, planes, NULL);
+    if (jpeg_encoder_write(enc, jpeg, jpeg_size, &len) != 0) {
+        printf("  encode failed\n");
+        goto done;
+    }
+
+    for (int r = 0; r < BENCH_REPEAT; r++) {
+        uint64_t start = bench_clock();
+
+        if (jpeg_decoder_read_header(dec, jpeg, len) != 0 ||
+            jpeg_decoder_decode(dec, jpeg, len, format, out) != 0) {
+            printf("  decode failed\n");
+            goto done;
+        }
+
+        start = bench_clock() - start;
+        if (start < best) {
+            best = start;
+        }
+    }
+
+    printf("  %ux%u q%-3u %-4s %8.2f bits/%s  %6.2f %s/pixel\n", width, height, quality,
+           format == JPEG_OUTPUT_GRAY ? "Y" : format == JPEG_OUTPUT_RGB888 ? "RGB" : "NV12",
+           (double)len * 8.0 / (double)best, BENCH_UNIT,
+           (double)best / ((double)width * height), BENCH_UNIT);
+
+done:
+    free(out);
+    free(jpeg);
+    jpeg_decoder_destroy(dec);
+    jpeg_encoder_destroy(enc);
+}
+
+/* ============================================================================
+ * Benchmarks
+ * ============================================================================ */
+
+int main(int argc, char* argv[])
+{
+    static const uint32_t sizes[][2] = { { 1280, 720 }, { 1920, 1080 } };
+    static const uint32_t qualities[] = { 50, 85 };
+    BenchSymbol* symbols = (BenchSymbol*)malloc(BENCH_SYMBOLS * sizeof(BenchSymbol));
+    uint32_t buf_size = BENCH_SYMBOLS * 8;
+    uint8_t* buf = (uint8_t*)malloc(buf_size);
+    uint32_t state = 1;
+
+    (void)argc;
+    (void)argv;
+
+    if (!symbols || !buf) {
+        fprintf(stderr, "Error: failed to allocate benchmark buffers\n");
+        free(symbols);
+        free(buf);
+        return 1;
+    }
+
+    printf("=== Entropy Coding Benchmarks ===\n\n");
+    printf("Bit writer (%u symbols, best of %d):\n", BENCH_SYMBOLS, BENCH_REPEAT);
+
+    /* Short codes with leading zero bits rarely form 0xFF bytes */
+    for (uint32_t i = 0; i < BENCH_SYMBOLS; i++) {
+        symbols[i].size = 2 + (int)(bench_rand(&state) % 26);
+        symbols[i].code = bench_rand(&state) & 0x7FFF;
+    }
+    bench_bit_writer("typical codes", symbols, buf, buf_size);
+
+    for (uint32_t i = 0; i < BENCH_SYMBOLS; i++) {
+        symbols[i].code = bench_rand(&state) ^ (bench_rand(&state) << 16);
+    }
+    bench_bit_writer("random bits", symbols, buf, buf_size);
+
+    /* Every byte needs stuffing: slow path only */
+    for (uint32_t i = 0; i < BENCH_SYMBOLS; i++) {
+        symbols[i].code = 0xFFFFFFFFu;
+    }
+    bench_bit_writer("all ones (stuffing)", symbols, buf, buf_size);
+
+    printf("\nQuantize + Huffman + bit writer (best of %d):\n", BENCH_REPEAT);
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        uint32_t width = sizes[s][0];
+        uint32_t height = sizes[s][1];
+        uint8_t* nv12 = (uint8_t*)malloc((size_t)width * height * 3 / 2);
+
+        if (!nv12) {
+            break;
+        }
+        fill_content(nv12, width, height);
+
+        for (size_t q = 0; q < sizeof(qualities) / sizeof(qualities[0]); q++) {
+            bench_entropy_stage(nv12, width, height, qualities[q], 0);
+            bench_entropy_stage(nv12, width, height, qualities[q], 1);
+        }
+
+        free(nv12);
+    }
+
+    printf("\nDecode: Huffman + IDCT + NV12, Y-only or RGB output (best of %d):\n",
+           BENCH_REPEAT);
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        uint32_t width = sizes[s][0];
+        uint32_t height = sizes[s][1];
+        uint8_t* nv12 = (uint8_t*)malloc((size_t)width * height * 3 / 2);
+
+        if (!nv12) {
+            break;
+        }
+        fill_content(nv12, width, height);
+
+        for (size_t q = 0; q < sizeof(qualities) / sizeof(qualities[0]); q++) {
+            bench_decode(nv12, width, height, qualities[q], JPEG_OUTPUT_NV12);
+            bench_decode(nv12, width, height, qualities[q], JPEG_OUTPUT_GRAY);
+            bench_decode(nv12, width, height, qualities[q], JPEG_OUTPUT_RGB888);
+        }
+
+        free(nv12);
+    }
+
+    free(buf);
+    free(symbols);
+
+    return 0;
+}
@@ -8,6 +8,7 @@
 #include <assert.h>
 
 #include "rkmpp_mjpeg.h"
+#include "test_util.h"
 
 /* Test utilities */
 #define TEST_PASS(name) printf("✓ PASS: %s\n", name)
@@ -368,9 +369,644 @@ void test_decoder_multiple_resolutions(void)
     TEST_PASS("decoder_multiple_resolutions");
 }
 
+/**
+ * Test 8: CPU backend decodes CPU backend output
+ */
+void test_decoder_cpu_roundtrip(void)
+{
+    RkmppEncoderConfig enc_config = {
+        .width = 200,
+        .height = 120,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 90,
+        .gop = 0,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    RkmppDecoderConfig dec_config = {
+        .max_width = 1920,
+        .max_height = 1080,
+        .output_format = 0,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    
+    RkmppEncoder* encoder = rkmpp_encoder_create(&enc_config);
+    RkmppDecoder* decoder = rkmpp_decoder_create(&dec_config);
+    if (!encoder || !decoder) {
+        TEST_FAIL("decoder_cpu_roundtrip");
+        if (encoder) rkmpp_encoder_destroy(encoder);
+        if (decoder) rkmpp_decoder_destroy(decoder);
+        return;
+    }
+    
+    uint32_t nv12_size = enc_config.width * enc_config.height * 3 / 2;
+    uint8_t* source = (uint8_t*)malloc(nv12_size);
+    uint8_t* jpeg_data = (uint8_t*)malloc(nv12_size);
+    uint8_t* decoded = (uint8_t*)malloc(nv12_size);
+    uint32_t jpeg_len = 0;
+    uint32_t nv12_len = 0;
+    RkmppFrameInfo frame_info;
+    int max_diff = 0;
+    
+    fill_ramp_frame(source, enc_config.width, enc_config.height, 0);
+    
+    int ok = rkmpp_encoder_encode(encoder, source, nv12_size,
+                                  jpeg_data, nv12_size, &jpeg_len) == RKMPP_OK &&
+             rkmpp_decoder_decode(decoder, jpeg_data, jpeg_len, decoded, nv12_size,
+                                  &nv12_len, &frame_info) == RKMPP_OK &&
+             nv12_len == nv12_size &&
+             frame_info.width == enc_config.width &&
+             frame_info.height == enc_config.height;
+    
+    for (uint32_t i = 0; ok && i < nv12_size; i++) {
+        int diff = abs((int)decoded[i] - (int)source[i]);
+        if (diff > max_diff) {
+            max_diff = diff;
+        }
+    }
+    ok = ok && max_diff <= 8;
+    
+    /* An output buffer smaller than the frame is rejected */
+    ok = ok && rkmpp_decoder_decode(decoder, jpeg_data, jpeg_len, decoded, nv12_size - 1,
+                                    &nv12_len, &frame_info) == RKMPP_ERR_INVALID_PARAM;
+    
+    free(decoded);
+    free(jpeg_data);
+    free(source);
+    rkmpp_decoder_destroy(decoder);
+    rkmpp_encoder_destroy(encoder);
+    
+    if (!ok) {
+        TEST_FAIL("decoder_cpu_roundtrip");
+        return;
+    }
+    
+    TEST_PASS("decoder_cpu_roundtrip");
+}
+
+/**
+ * Test 9: CPU backend rejects non-JPEG and truncated data
+ */
+void test_decoder_cpu_corrupt(void)
+{
+    RkmppEncoderConfig enc_config = {
+        .width = 64,
+        .height = 64,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 80,
+        .gop = 0,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    RkmppDecoderConfig dec_config = {
+        .max_width = 1920,
+        .max_height = 1080,
+        .output_format = 0,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    
+    RkmppEncoder* encoder = rkmpp_encoder_create(&enc_config);
+    RkmppDecoder* decoder = rkmpp_decoder_create(&dec_config);
+    if (!encoder || !decoder) {
+        TEST_FAIL("decoder_cpu_corrupt");
+        if (encoder) rkmpp_encoder_destroy(encoder);
+        if (decoder) rkmpp_decoder_destroy(decoder);
+        return;
+    }
+    
+    uint32_t nv12_size = enc_config.width * enc_config.height * 3 / 2;
+    uint8_t* source = (uint8_t*)malloc(nv12_size);
+    uint8_t* jpeg_data = (uint8_t*)malloc(nv12_size);
+    uint8_t* decoded = (uint8_t*)malloc(nv12_size);
+    uint32_t jpeg_len = 0;
+    uint32_t nv12_len = 0;
+    RkmppFrameInfo frame_info;
+    
+    fill_ramp_frame(source, enc_config.width, enc_config.height, 0);
+    memset(decoded, 0xAB, nv12_size);
+    
+    int ok = rkmpp_encoder_encode(encoder, source, nv12_size,
+                                  jpeg_data, nv12_size, &jpeg_len) == RKMPP_OK;
+    
+    /* Garbage has no SOI; a cut-off header has no scan */
+    ok = ok && rkmpp_decoder_decode(decoder, decoded, 1024, source, nv12_size,
+                                    &nv12_len, &frame_info) == RKMPP_ERR_DECODE;
+    ok = ok && rkmpp_decoder_decode(decoder, jpeg_data, 100, decoded, nv12_size,
+                                    &nv12_len, &frame_info) == RKMPP_ERR_DECODE;
+    
+    /* The decoder still works afterwards */
+    ok = ok && rkmpp_decoder_decode(decoder, jpeg_data, jpeg_len, decoded, nv12_size,
+                                    &nv12_len, &frame_info) == RKMPP_OK;
+    
+    free(decoded);
+    free(jpeg_data);
+    free(source);
+    rkmpp_decoder_destroy(decoder);
+    rkmpp_encoder_destroy(encoder);
+    
+    if (!ok) {
+        TEST_FAIL("decoder_cpu_corrupt");
+        return;
+    }
+    
+    TEST_PASS("decoder_cpu_corrupt");
+}
+
 /**
  * Run all decoder tests
  */
+/**
+ * Test 10: 4:2:2 JPEG decodes to NV16 and down-converts to NV12 (CPU backend)
+ */
+void test_decoder_cpu_422(void)
+{
+    RkmppEncoderConfig enc_config = {
+        .width = 200,
+        .height = 120,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 90,
+        .gop = 0,
+        .backend = RKMPP_BACKEND_CPU,
+        .input_format = RKMPP_FORMAT_NV16
+    };
+    RkmppDecoderConfig dec_config = {
+        .max_width = 1920,
+        .max_height = 1080,
+        .output_format = RKMPP_FORMAT_NV16,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    
+    RkmppEncoder* encoder = rkmpp_encoder_create(&enc_config);
+    RkmppDecoder* nv16_decoder = rkmpp_decoder_create(&dec_config);
+    dec_config.output_format = RKMPP_FORMAT_NV12;
+    RkmppDecoder* nv12_decoder = rkmpp_decoder_create(&dec_config);
+    dec_config.output_format = RKMPP_FORMAT_YUYV;
+    RkmppDecoder* yuyv_decoder = rkmpp_decoder_create(&dec_config);
+    if (!encoder || !nv16_decoder || !nv12_decoder || yuyv_decoder) {
+        TEST_FAIL("decoder_cpu_422");
+        if (encoder) rkmpp_encoder_destroy(encoder);
+        if (nv16_decoder) rkmpp_decoder_destroy(nv16_decoder);
+        if (nv12_decoder) rkmpp_decoder_destroy(nv12_decoder);
+        if (yuyv_decoder) rkmpp_decoder_destroy(yuyv_decoder);
+        return;
+    }
+    
+    uint32_t width = enc_config.width;
+    uint32_t height = enc_config.height;
+    uint32_t nv16_size = width * height * 2;
+    uint32_t nv12_size = width * height * 3 / 2;
+    uint8_t* source = (uint8_t*)malloc(nv16_size);
+    uint8_t* jpeg_data = (uint8_t*)malloc(nv16_size);
+    uint8_t* nv16 = (uint8_t*)malloc(nv16_size);
+    uint8_t* nv12 = (uint8_t*)malloc(nv12_size);
+    uint32_t jpeg_len = 0;
+    uint32_t out_len = 0;
+    RkmppFrameInfo frame_info;
+    int max_diff = 0;
+    
+    /* Smooth luma, chroma with a CbCr row per luma row */
+    fill_ramp_frame(source, width, height, 0);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width / 2; x++) {
+            source[width * height + y * width + 2 * x] = (uint8_t)(96 + (x * 64) / width);
+            source[width * height + y * width + 2 * x + 1] = (uint8_t)(160 - (y * 32) / height);
+        }
+    }
+    
+    int ok = rkmpp_encoder_encode(encoder, source, nv16_size,
+                                  jpeg_data, nv16_size, &jpeg_len) == RKMPP_OK &&
+             rkmpp_decoder_decode(nv16_decoder, jpeg_data, jpeg_len, nv16, nv16_size,
+                                  &out_len, &frame_info) == RKMPP_OK &&
+             out_len == nv16_size && frame_info.format == RKMPP_FORMAT_NV16;
+    
+    for (uint32_t i = 0; ok && i < nv16_size; i++) {
+        int diff = abs((int)nv16[i] - (int)source[i]);
+        if (diff > max_diff) {
+            max_diff = diff;
+        }
+    }
+    ok = ok && max_diff <= 8;
+    
+    /* NV12 output: same luma, chroma rows averaged in pairs */
+    ok = ok && rkmpp_decoder_decode(nv12_decoder, jpeg_data, jpeg_len, nv12, nv12_size,
+                                    &out_len, &frame_info) == RKMPP_OK &&
+         out_len == nv12_size && frame_info.format == RKMPP_FORMAT_NV12 &&
+         memcmp(nv12, nv16, width * height) == 0;
+    
+    for (uint32_t y = 0; ok && y < height / 2; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            const uint8_t* pair = nv16 + width * height + 2 * y * width + x;
+            int expected = (pair[0] + pair[width] + 1) / 2;
+            
+            if (nv12[width * height + y * width + x] != expected) {
+                ok = 0;
+                break;
+            }
+        }
+    }
+    
+    /* An NV12-sized buffer is too small for NV16 output */
+    ok = ok && rkmpp_decoder_decode(nv16_decoder, jpeg_data, jpeg_len, nv16, nv12_size,
+                                    &out_len, &frame_info) == RKMPP_ERR_INVALID_PARAM;
+    
+    free(nv12);
+    free(nv16);
+    free(jpeg_data);
+    free(source);
+    rkmpp_decoder_destroy(nv12_decoder);
+    rkmpp_decoder_destroy(nv16_decoder);
+    rkmpp_encoder_destroy(encoder);
+    
+    if (!ok) {
+        TEST_FAIL("decoder_cpu_422");
+        return;
+    }
+    
+    TEST_PASS("decoder_cpu_422");
+}
+
+/**
+ * Test 11: Grayscale output matches the luma of a color decode (CPU backend)
+ */
+void test_decoder_cpu_grayscale(void)
+{
+    RkmppEncoderConfig enc_config = {
+        .width = 200,
+        .height = 120,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 90,
+        .gop = 0,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    RkmppDecoderConfig dec_config = {
+        .max_width = 1920,
+        .max_height = 1080,
+        .output_format = RKMPP_FORMAT_NV12,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    
+    RkmppEncoder* color_encoder = rkmpp_encoder_create(&enc_config);
+    enc_config.input_format = RKMPP_FORMAT_GRAY;
+    RkmppEncoder* gray_encoder = rkmpp_encoder_create(&enc_config);
+    RkmppDecoder* nv12_decoder = rkmpp_decoder_create(&dec_config);
+    dec_config.output_format = RKMPP_FORMAT_GRAY;
+    RkmppDecoder* gray_decoder = rkmpp_decoder_create(&dec_config);
+    if (!color_encoder || !gray_encoder || !nv12_decoder || !gray_decoder) {
+        TEST_FAIL("decoder_cpu_grayscale");
+        if (color_encoder) rkmpp_encoder_destroy(color_encoder);
+        if (gray_encoder) rkmpp_encoder_destroy(gray_encoder);
+        if (nv12_decoder) rkmpp_decoder_destroy(nv12_decoder);
+        if (gray_decoder) rkmpp_decoder_destroy(gray_decoder);
+        return;
+    }
+    
+    uint32_t width = enc_config.width;
+    uint32_t height = enc_config.height;
+    uint32_t nv12_size = width * height * 3 / 2;
+    uint32_t gray_size = width * height;
+    uint8_t* source = (uint8_t*)malloc(nv12_size);
+    uint8_t* jpeg_data = (uint8_t*)malloc(nv12_size);
+    uint8_t* nv12 = (uint8_t*)malloc(nv12_size);
+    uint8_t* gray = (uint8_t*)malloc(gray_size);
+    uint32_t jpeg_len = 0;
+    uint32_t out_len = 0;
+    RkmppFrameInfo frame_info;
+    
+    fill_ramp_frame(source, width, height, 0);
+    
+    /* Color JPEG: chroma is skipped, luma is identical */
+    int ok = rkmpp_encoder_encode(color_encoder, source, nv12_size,
+                                  jpeg_data, nv12_size, &jpeg_len) == RKMPP_OK &&
+             rkmpp_decoder_decode(nv12_decoder, jpeg_data, jpeg_len, nv12, nv12_size,
+                                  &out_len, &frame_info) == RKMPP_OK &&
+             rkmpp_decoder_decode(gray_decoder, jpeg_data, jpeg_len, gray, gray_size,
+                                  &out_len, &frame_info) == RKMPP_OK &&
+             out_len == gray_size && frame_info.format == RKMPP_FORMAT_GRAY &&
+             memcmp(gray, nv12, gray_size) == 0;
+    
+    /* Grayscale JPEG to grayscale output */
+    ok = ok && rkmpp_encoder_encode(gray_encoder, source, gray_size,
+                                    jpeg_data, nv12_size, &jpeg_len) == RKMPP_OK &&
+         rkmpp_decoder_decode(gray_decoder, jpeg_data, jpeg_len, gray, gray_size,
+                              &out_len, &frame_info) == RKMPP_OK &&
+         out_len == gray_size;
+    
+    for (uint32_t i = 0; ok && i < gray_size; i++) {
+        ok = abs((int)gray[i] - (int)source[i]) <= 8;
+    }
+    
+    free(gray);
+    free(nv12);
+    free(jpeg_data);
+    free(source);
+    rkmpp_decoder_destroy(gray_decoder);
+    rkmpp_decoder_destroy(nv12_decoder);
+    rkmpp_encoder_destroy(gray_encoder);
+    rkmpp_encoder_destroy(color_encoder);
+    
+    if (!ok) {
+        TEST_FAIL("decoder_cpu_grayscale");
+        return;
+    }
+    
+    TEST_PASS("decoder_cpu_grayscale");
+}
+
+/**
+ * Test 12: Direct RGB, BGRA and planar float output (CPU backend)
+ */
+void test_decoder_cpu_rgb(void)
+{
+    RkmppEncoderConfig enc_config = {
+        .width = 160,
+        .height = 96,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 90,
+        .gop = 0,
+        .backend = RKMPP_BACKEND_CPU,
+        .input_format = RKMPP_FORMAT_RGB888
+    };
+    RkmppDecoderConfig dec_config = {
+        .max_width = 1920,
+        .max_height = 1080,
+        .output_format = RKMPP_FORMAT_RGB888,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    
+    RkmppEncoder* encoder = rkmpp_encoder_create(&enc_config);
+    RkmppDecoder* rgb_decoder = rkmpp_decoder_create(&dec_config);
+    dec_config.output_format = RKMPP_FORMAT_BGRA8888;
+    RkmppDecoder* bgra_decoder = rkmpp_decoder_create(&dec_config);
+    dec_config.output_format = RKMPP_FORMAT_RGB_F32_PLANAR;
+    RkmppDecoder* float_decoder = rkmpp_decoder_create(&dec_config);
+    if (!encoder || !rgb_decoder || !bgra_decoder || !float_decoder) {
+        TEST_FAIL("decoder_cpu_rgb");
+        if (encoder) rkmpp_encoder_destroy(encoder);
+        if (rgb_decoder) rkmpp_decoder_destroy(rgb_decoder);
+        if (bgra_decoder) rkmpp_decoder_destroy(bgra_decoder);
+        if (float_decoder) rkmpp_decoder_destroy(float_decoder);
+        return;
+    }
+    
+    uint32_t width = enc_config.width;
+    uint32_t height = enc_config.height;
+    uint32_t pixels = width * height;
+    uint32_t float_size = rkmpp_get_frame_size(RKMPP_FORMAT_RGB_F32_PLANAR, width, height);
+    uint8_t* source = (uint8_t*)malloc(pixels * 3);
+    uint8_t* jpeg_data = (uint8_t*)malloc(pixels * 3);
+    uint8_t* rgb = (uint8_t*)malloc(pixels * 3);
+    uint8_t* bgra = (uint8_t*)malloc(pixels * 4);
+    float* planes = (float*)malloc(float_size);
+    uint32_t jpeg_len = 0;
+    uint32_t out_len = 0;
+    RkmppFrameInfo frame_info;
+    
+    /* Gray ramp on the left, pure red on the right */
+    for (uint32_t i = 0; i < pixels; i++) {
+        uint32_t x = i % width;
+        uint8_t level = (uint8_t)(64 + x);
+        
+        source[i * 3] = x < width / 2 ? level : 255;
+        source[i * 3 + 1] = x < width / 2 ? level : 0;
+        source[i * 3 + 2] = x < width / 2 ? level : 0;
+    }
+    
+    int ok = float_size == pixels * 3 * sizeof(float) &&
+             rkmpp_encoder_encode(encoder, source, pixels * 3,
+                                  jpeg_data, pixels * 3, &jpeg_len) == RKMPP_OK &&
+             rkmpp_decoder_decode(rgb_decoder, jpeg_data, jpeg_len, rgb, pixels * 3,
+                                  &out_len, &frame_info) == RKMPP_OK &&
+             out_len == pixels * 3 && frame_info.format == RKMPP_FORMAT_RGB888 &&
+             rkmpp_decoder_decode(bgra_decoder, jpeg_data, jpeg_len, bgra, pixels * 4,
+                                  &out_len, &frame_info) == RKMPP_OK &&
+             out_len == pixels * 4 &&
+             rkmpp_decoder_decode(float_decoder, jpeg_data, jpeg_len, (uint8_t*)planes,
+                                  float_size, &out_len, &frame_info) == RKMPP_OK &&
+             out_len == float_size;
+    
+    for (uint32_t i = 0; ok && i < pixels; i++) {
+        uint32_t x = i % width;
+        
+        /* Colors away from the red edge survive, all layouts agree */
+        for (uint32_t c = 0; ok && c < 3; c++) {
+            if ((x < width / 2 - 8 || x >= width / 2 + 8) &&
+                abs((int)rgb[i * 3 + c] - (int)source[i * 3 + c]) > 6) {
+                ok = 0;
+            }
+            ok = ok && bgra[i * 4 + 2 - c] == rgb[i * 3 + c] &&
+                 planes[c * pixels + i] == rgb[i * 3 + c] * (1.0f / 255.0f);
+        }
+        ok = ok && bgra[i * 4 + 3] == 255;
+    }
+    
+    /* A buffer sized for NV12 is too small for RGB */
+    ok = ok && rkmpp_decoder_decode(rgb_decoder, jpeg_data, jpeg_len, rgb, pixels * 3 / 2,
+                                    &out_len, &frame_info) == RKMPP_ERR_INVALID_PARAM;
+    
+    free(planes);
+    free(bgra);
+    free(rgb);
+    free(jpeg_data);
+    free(source);
+    rkmpp_decoder_destroy(float_decoder);
+    rkmpp_decoder_destroy(bgra_decoder);
+    rkmpp_decoder_destroy(rgb_decoder);
+    rkmpp_encoder_destroy(encoder);
+    
+    if (!ok) {
+        TEST_FAIL("decoder_cpu_rgb");
+        return;
+    }
+    
+    TEST_PASS("decoder_cpu_rgb");
+}
+
+/**
+ * Test 13: Resolution changes mid-stream are reported and decoded
+ */
+void test_decoder_resolution_change(void)
+{
+    static const uint32_t sizes[][3] = {
+        /* width, height, info_change expected */
+        { 320, 240, 1 },                   /* First frame */
+        { 320, 240, 0 },
+        { 640, 480, 1 },                   /* Beyond max_width: the pool grows */
+        { 176, 144, 1 },                   /* Smaller: the pool is reused */
+        { 176, 144, 0 },
+        { 640, 480, 1 }
+    };
+    RkmppDecoderConfig config = {
+        .max_width = 320,
+        .max_height = 240,
+        .output_format = 0,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    RkmppTiledEncoderConfig wide = {
+        .width = 4112,
+        .height = 16,
+        .input_format = RKMPP_FORMAT_GRAY,
+        .quality = 80
+    };
+    uint32_t out_size = rkmpp_get_nv12_size(640, 480);
+    uint8_t* source = (uint8_t*)malloc(out_size);
+    uint8_t* jpeg = (uint8_t*)malloc(out_size);
+    uint8_t* decoded = (uint8_t*)malloc(out_size);
+    uint8_t* gray = (uint8_t*)calloc(1, wide.width * wide.height);
+    uint32_t jpeg_len = 0;
+    uint32_t nv12_len = 0;
+    RkmppFrameInfo frame_info;
+    RkmppDecoder* decoder = rkmpp_decoder_create(&config);
+    RkmppTiledEncoder* tiled = NULL;
+    int ok = decoder && source && jpeg && decoded && gray;
+    
+    for (uint32_t i = 0; ok && i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        fill_ramp_frame(source, sizes[i][0], sizes[i][1], 0);
+        ok = encode_frame(source, RKMPP_FORMAT_NV12, sizes[i][0], sizes[i][1], 80,
+                          jpeg, out_size, &jpeg_len) == 0 &&
+             rkmpp_decoder_decode(decoder, jpeg, jpeg_len, decoded, out_size, &nv12_len,
+                                  &frame_info) == RKMPP_OK &&
+             frame_info.width == sizes[i][0] && frame_info.height == sizes[i][1] &&
+             frame_info.info_change == sizes[i][2] &&
+             nv12_len == rkmpp_get_nv12_size(sizes[i][0], sizes[i][1]);
+    }
+    
+    /* A buffer too small for the new size reports the size to retry with */
+    fill_ramp_frame(source, 320, 240, 0);
+    ok = ok && encode_frame(source, RKMPP_FORMAT_NV12, 320, 240, 80, jpeg, out_size,
+                            &jpeg_len) == 0 &&
+         rkmpp_decoder_decode(decoder, jpeg, jpeg_len, decoded,
+                              rkmpp_get_nv12_size(176, 144), &nv12_len,
+                              &frame_info) == RKMPP_ERR_INVALID_PARAM &&
+         frame_info.width == 320 && frame_info.height == 240 && frame_info.info_change == 1 &&
+         rkmpp_decoder_decode(decoder, jpeg, jpeg_len, decoded, out_size, &nv12_len,
+                              &frame_info) == RKMPP_OK &&
+         frame_info.info_change == 1;
+    
+    /* Frames past 4096 pixels are still refused */
+    tiled = ok ? rkmpp_tiled_encoder_create(&wide) : NULL;
+    ok = ok && tiled &&
+         rkmpp_tiled_encoder_encode(tiled, gray, wide.width * wide.height, jpeg, out_size,
+                                    &jpeg_len) == RKMPP_OK &&
+         rkmpp_decoder_decode(decoder, jpeg, jpeg_len, decoded, out_size, &nv12_len,
+                              &frame_info) == RKMPP_ERR_DECODE;
+    
+    if (tiled) rkmpp_tiled_encoder_destroy(tiled);
+    if (decoder) rkmpp_decoder_destroy(decoder);
+    free(gray);
+    free(decoded);
+    free(jpeg);
+    free(source);
+    
+    if (!ok) {
+        TEST_FAIL("decoder_resolution_change");
+        return;
+    }
+    
+    TEST_PASS("decoder_resolution_change");
+}
+
+/**
+ * Remove the DQT segments of a JPEG in place
+ */
+static uint32_t strip_dqt(uint8_t* jpeg, uint32_t len)
+{
+    uint32_t pos = 2;
+    
+    while (pos + 4 <= len && jpeg[pos] == 0xFF && jpeg[pos + 1] != 0xDA) {
+        uint32_t seg = 2 + ((uint32_t)jpeg[pos + 2] << 8 | jpeg[pos + 3]);
+        
+        if (jpeg[pos + 1] == 0xDB) {
+            memmove(jpeg + pos, jpeg + pos + seg, len - pos - seg);
+            len -= seg;
+        } else {
+            pos += seg;
+        }
+    }
+    
+    return len;
+}
+
+/**
+ * Test 14: A reused decoder starts without the previous stream's tables
+ */
+void test_decoder_context_cache(void)
+{
+    RkmppDecoderConfig config = {
+        .max_width = 320,
+        .max_height = 240,
+        .output_format = 0,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    uint32_t out_size = rkmpp_get_nv12_size(320, 240);
+    uint8_t* jpeg = (uint8_t*)malloc(out_size);
+    uint8_t* bare = (uint8_t*)malloc(out_size);
+    uint8_t* decoded = (uint8_t*)malloc(out_size);
+    uint8_t* expected = (uint8_t*)malloc(out_size);
+    uint32_t jpeg_len = 0;
+    uint32_t bare_len = 0;
+    uint32_t nv12_len = 0;
+    uint64_t frames = 1;
+    RkmppFrameInfo frame_info;
+    RkmppDecoder* first = NULL;
+    RkmppDecoder* decoder = NULL;
+    int ok = jpeg && bare && decoded && expected;
+    
+    if (ok) {
+        fill_ramp_frame(decoded, 320, 240, 0);
+        ok = encode_frame(decoded, RKMPP_FORMAT_NV12, 320, 240, 80, jpeg, out_size,
+                          &jpeg_len) == 0;
+    }
+    if (ok) {
+        memcpy(bare, jpeg, jpeg_len);
+        bare_len = strip_dqt(bare, jpeg_len);
+        ok = bare_len < jpeg_len;
+    }
+    
+    /* What a decoder that never saw a DQT makes of the bare image */
+    ok = ok && rkmpp_set_context_cache_size(0) == RKMPP_OK;
+    if (ok) {
+        decoder = rkmpp_decoder_create(&config);
+        ok = decoder && rkmpp_decoder_decode(decoder, bare, bare_len, expected, out_size,
+                                             &nv12_len, &frame_info) == RKMPP_OK;
+        if (decoder) rkmpp_decoder_destroy(decoder);
+    }
+    
+    /* A stream that defines tables, then a reuse of its context */
+    ok = ok && rkmpp_set_context_cache_size(4) == RKMPP_OK;
+    if (ok) {
+        first = rkmpp_decoder_create(&config);
+        ok = first && rkmpp_decoder_decode(first, jpeg, jpeg_len, decoded, out_size,
+                                           &nv12_len, &frame_info) == RKMPP_OK;
+        if (first) rkmpp_decoder_destroy(first);
+    }
+    if (ok) {
+        decoder = rkmpp_decoder_create(&config);
+        ok = decoder == first &&
+             rkmpp_decoder_get_stats(decoder, &frames, NULL) == RKMPP_OK && frames == 0 &&
+             rkmpp_decoder_decode(decoder, bare, bare_len, decoded, out_size, &nv12_len,
+                                  &frame_info) == RKMPP_OK &&
+             frame_info.info_change == 1 && memcmp(decoded, expected, nv12_len) == 0;
+        if (decoder) rkmpp_decoder_destroy(decoder);
+    }
+    
+    ok = rkmpp_set_context_cache_size(0) == RKMPP_OK && ok;
+    
+    free(expected);
+    free(decoded);
+    free(bare);
+    free(jpeg);
+    
+    if (!ok) {
+        TEST_FAIL("decoder_context_cache");
+        return;
+    }
+    
+    TEST_PASS("decoder_context_cache");
+}
+
 int main(int argc, char* argv[])
 {
     printf("=== RKMPP MJPEG Decoder Test Suite ===\n\n");
@@ -382,6 +1018,13 @@ int main(int argc, char* argv[])
     test_decoder_get_stats();
     test_decoder_frame_info();
     test_decoder_multiple_resolutions();
+    test_decoder_cpu_roundtrip();
+    test_decoder_cpu_corrupt();
+    test_decoder_cpu_422();
+    test_decoder_cpu_grayscale();
+    test_decoder_cpu_rgb();
+    test_decoder_resolution_change();
+    test_decoder_context_cache();
     
     printf("\n=== Tests Complete ===\n");
     
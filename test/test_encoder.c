@@ -336,9 +336,1315 @@ void test_encoder_multiple_resolutions(void)
     TEST_PASS("encoder_multiple_resolutions");
 }
 
+/**
+ * Fill an NV12 frame with a textured test pattern
+ */
+static void fill_test_pattern(uint8_t* nv12, uint32_t width, uint32_t height, uint32_t seed)
+{
+    uint32_t state = seed * 2654435761u + 1;
+    
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            state = state * 1103515245u + 12345u;
+            nv12[y * width + x] = (uint8_t)(((x + seed) * 3 + y * 2) / 4 + ((state >> 16) & 31));
+        }
+    }
+    
+    for (uint32_t i = 0; i < width * height / 2; i++) {
+        nv12[width * height + i] = (uint8_t)(96 + (i % width) / 8);
+    }
+}
+
+/**
+ * Test 7: Quality changes between frames (CPU backend)
+ */
+void test_encoder_set_quality(void)
+{
+    RkmppEncoderConfig config = {
+        .width = 320,
+        .height = 240,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 90,
+        .gop = 0,
+        .rc_mode = RKMPP_RC_MODE_FIXQP,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    
+    RkmppEncoder* encoder = rkmpp_encoder_create(&config);
+    if (!encoder) {
+        TEST_FAIL("encoder_set_quality");
+        return;
+    }
+    
+    uint32_t nv12_size = config.width * config.height * 3 / 2;
+    uint8_t* nv12_data = (uint8_t*)malloc(nv12_size);
+    uint8_t* jpeg_data = (uint8_t*)malloc(nv12_size);
+    uint32_t high_len = 0;
+    uint32_t low_len = 0;
+    uint32_t quality = 0;
+    
+    fill_test_pattern(nv12_data, config.width, config.height, 0);
+    
+    int encoded = rkmpp_encoder_encode(encoder, nv12_data, nv12_size,
+                                       jpeg_data, nv12_size, &high_len) == RKMPP_OK &&
+                  rkmpp_encoder_set_quality(encoder, 30) == RKMPP_OK &&
+                  rkmpp_encoder_encode(encoder, nv12_data, nv12_size,
+                                       jpeg_data, nv12_size, &low_len) == RKMPP_OK;
+    
+    /* Complete JFIF image, smaller at the lower quality */
+    int ok = encoded &&
+             jpeg_data[0] == 0xFF && jpeg_data[1] == 0xD8 &&
+             jpeg_data[low_len - 2] == 0xFF && jpeg_data[low_len - 1] == 0xD9 &&
+             low_len < high_len &&
+             rkmpp_encoder_get_quality(encoder, &quality) == RKMPP_OK && quality == 30 &&
+             rkmpp_encoder_set_quality(encoder, 0) == RKMPP_ERR_INVALID_PARAM &&
+             rkmpp_encoder_set_quality(encoder, 101) == RKMPP_ERR_INVALID_PARAM;
+    
+    free(jpeg_data);
+    free(nv12_data);
+    rkmpp_encoder_destroy(encoder);
+    
+    if (!ok) {
+        TEST_FAIL("encoder_set_quality");
+        return;
+    }
+    
+    TEST_PASS("encoder_set_quality");
+}
+
+/**
+ * Test 8: Rate control holds the target bitrate (CPU backend)
+ */
+void test_encoder_rate_control(void)
+{
+    RkmppEncoderConfig config = {
+        .width = 320,
+        .height = 240,
+        .fps = 30,
+        .bitrate = 30 * 8 * 6000,
+        .quality = 95,
+        .gop = 0,
+        .rc_mode = RKMPP_RC_MODE_CBR,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    
+    RkmppEncoder* encoder = rkmpp_encoder_create(&config);
+    if (!encoder) {
+        TEST_FAIL("encoder_rate_control");
+        return;
+    }
+    
+    uint32_t nv12_size = config.width * config.height * 3 / 2;
+    uint8_t* nv12_data = (uint8_t*)malloc(nv12_size);
+    uint8_t* jpeg_data = (uint8_t*)malloc(nv12_size);
+    uint64_t settled_bytes = 0;
+    uint32_t jpeg_len = 0;
+    uint32_t quality = 0;
+    int ok = 1;
+    
+    for (uint32_t i = 0; i < 90 && ok; i++) {
+        fill_test_pattern(nv12_data, config.width, config.height, i);
+        
+        ok = rkmpp_encoder_encode(encoder, nv12_data, nv12_size,
+                                  jpeg_data, nv12_size, &jpeg_len) == RKMPP_OK;
+        if (i >= 30) {
+            settled_bytes += jpeg_len;
+        }
+    }
+    
+    /* Within 15% of 6000 bytes per frame once settled */
+    if (ok && (settled_bytes < 60 * 6000 * 85 / 100 || settled_bytes > 60 * 6000 * 115 / 100)) {
+        printf("  average %llu bytes/frame\n", (unsigned long long)(settled_bytes / 60));
+        ok = 0;
+    }
+    
+    /* Dropping the bitrate returns to the fixed quality */
+    ok = ok &&
+         rkmpp_encoder_set_bitrate(encoder, 0) == RKMPP_OK &&
+         rkmpp_encoder_get_quality(encoder, &quality) == RKMPP_OK &&
+         quality == 95;
+    
+    free(jpeg_data);
+    free(nv12_data);
+    rkmpp_encoder_destroy(encoder);
+    
+    if (!ok) {
+        TEST_FAIL("encoder_rate_control");
+        return;
+    }
+    
+    TEST_PASS("encoder_rate_control");
+}
+
+/**
+ * Test 9: Target-size encoding (CPU backend)
+ */
+void test_encoder_target_size(void)
+{
+    RkmppEncoderConfig config = {
+        .width = 320,
+        .height = 240,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 90,
+        .gop = 0,
+        .rc_mode = RKMPP_RC_MODE_FIXQP,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    
+    RkmppEncoder* encoder = rkmpp_encoder_create(&config);
+    if (!encoder) {
+        TEST_FAIL("encoder_target_size");
+        return;
+    }
+    
+    uint32_t nv12_size = config.width * config.height * 3 / 2;
+    uint8_t* nv12_data = (uint8_t*)malloc(nv12_size);
+    uint8_t* jpeg_data = (uint8_t*)malloc(nv12_size);
+    RkmppEncodeParams params = { .max_size = 8000 };
+    RkmppEncodeResult result;
+    uint32_t jpeg_len = 0;
+    int ok = 1;
+    
+    /* Every frame fits, below the configured quality, in at most 3 passes */
+    for (uint32_t i = 0; i < 5 && ok; i++) {
+        fill_test_pattern(nv12_data, config.width, config.height, i);
+        
+        ok = rkmpp_encoder_encode_ex(encoder, nv12_data, nv12_size, jpeg_data, nv12_size,
+                                     &jpeg_len, &params, &result) == RKMPP_OK &&
+             jpeg_len <= params.max_size &&
+             result.quality < config.quality &&
+             result.passes >= 1 && result.passes <= 3 &&
+             jpeg_data[jpeg_len - 2] == 0xFF && jpeg_data[jpeg_len - 1] == 0xD9;
+    }
+    
+    /* A generous budget keeps the configured quality */
+    params.max_size = nv12_size;
+    ok = ok &&
+         rkmpp_encoder_encode_ex(encoder, nv12_data, nv12_size, jpeg_data, nv12_size,
+                                 &jpeg_len, &params, &result) == RKMPP_OK &&
+         result.quality == config.quality;
+    
+    /* Smaller than the headers: nothing fits */
+    params.max_size = 200;
+    ok = ok &&
+         rkmpp_encoder_encode_ex(encoder, nv12_data, nv12_size, jpeg_data, nv12_size,
+                                 &jpeg_len, &params, &result) == RKMPP_ERR_ENCODE;
+    
+    free(jpeg_data);
+    free(nv12_data);
+    rkmpp_encoder_destroy(encoder);
+    
+    if (!ok) {
+        TEST_FAIL("encoder_target_size");
+        return;
+    }
+    
+    TEST_PASS("encoder_target_size");
+}
+
+/**
+ * Test 10: Quality switches reuse the shared tables (CPU backend)
+ */
+void test_encoder_shared_tables(void)
+{
+    RkmppEncoderConfig config = {
+        .width = 176,
+        .height = 144,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 50,
+        .gop = 0,
+        .rc_mode = RKMPP_RC_MODE_FIXQP,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    
+    RkmppEncoder* fixed = rkmpp_encoder_create(&config);
+    config.quality = 90;
+    RkmppEncoder* switched = rkmpp_encoder_create(&config);
+    if (!fixed || !switched) {
+        TEST_FAIL("encoder_shared_tables");
+        if (fixed) rkmpp_encoder_destroy(fixed);
+        if (switched) rkmpp_encoder_destroy(switched);
+        return;
+    }
+    
+    uint32_t nv12_size = config.width * config.height * 3 / 2;
+    uint8_t* nv12_data = (uint8_t*)malloc(nv12_size);
+    uint8_t* expected = (uint8_t*)malloc(nv12_size);
+    uint8_t* jpeg_data = (uint8_t*)malloc(nv12_size);
+    uint32_t expected_len = 0;
+    uint32_t jpeg_len = 0;
+    
+    fill_test_pattern(nv12_data, config.width, config.height, 7);
+    
+    /* 90 -> 10 -> 50 must produce the same bytes as a fresh quality-50 encoder */
+    int ok = rkmpp_encoder_encode(fixed, nv12_data, nv12_size,
+                                  expected, nv12_size, &expected_len) == RKMPP_OK &&
+             rkmpp_encoder_encode(switched, nv12_data, nv12_size,
+                                  jpeg_data, nv12_size, &jpeg_len) == RKMPP_OK &&
+             rkmpp_encoder_set_quality(switched, 10) == RKMPP_OK &&
+             rkmpp_encoder_encode(switched, nv12_data, nv12_size,
+                                  jpeg_data, nv12_size, &jpeg_len) == RKMPP_OK &&
+             rkmpp_encoder_set_quality(switched, 50) == RKMPP_OK &&
+             rkmpp_encoder_encode(switched, nv12_data, nv12_size,
+                                  jpeg_data, nv12_size, &jpeg_len) == RKMPP_OK &&
+             jpeg_len == expected_len &&
+             memcmp(jpeg_data, expected, jpeg_len) == 0;
+    
+    free(jpeg_data);
+    free(expected);
+    free(nv12_data);
+    rkmpp_encoder_destroy(switched);
+    rkmpp_encoder_destroy(fixed);
+    
+    if (!ok) {
+        TEST_FAIL("encoder_shared_tables");
+        return;
+    }
+    
+    TEST_PASS("encoder_shared_tables");
+}
+
+/**
+ * Test 11: Optimized Huffman tables shrink the output (CPU backend)
+ */
+void test_encoder_optimized_huffman(void)
+{
+    RkmppEncoderConfig config = {
+        .width = 320,
+        .height = 240,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 75,
+        .gop = 0,
+        .rc_mode = RKMPP_RC_MODE_FIXQP,
+        .backend = RKMPP_BACKEND_CPU,
+        .huffman_refresh = 0
+    };
+    
+    RkmppEncoder* standard = rkmpp_encoder_create(&config);
+    config.huffman_refresh = 1;
+    RkmppEncoder* per_frame = rkmpp_encoder_create(&config);
+    config.huffman_refresh = 4;
+    RkmppEncoder* periodic = rkmpp_encoder_create(&config);
+    if (!standard || !per_frame || !periodic) {
+        TEST_FAIL("encoder_optimized_huffman");
+        if (standard) rkmpp_encoder_destroy(standard);
+        if (per_frame) rkmpp_encoder_destroy(per_frame);
+        if (periodic) rkmpp_encoder_destroy(periodic);
+        return;
+    }
+    
+    uint32_t nv12_size = config.width * config.height * 3 / 2;
+    uint8_t* nv12_data = (uint8_t*)malloc(nv12_size);
+    uint8_t* jpeg_data = (uint8_t*)malloc(nv12_size);
+    uint32_t standard_len = 0;
+    uint32_t optimized_len = 0;
+    int ok = 1;
+    
+    for (uint32_t frame = 0; frame < 6 && ok; frame++) {
+        fill_test_pattern(nv12_data, config.width, config.height, frame);
+        
+        ok = rkmpp_encoder_encode(standard, nv12_data, nv12_size,
+                                  jpeg_data, nv12_size, &standard_len) == RKMPP_OK;
+        
+        /* Per-frame tables must beat the standard ones on every frame */
+        ok = ok && rkmpp_encoder_encode(per_frame, nv12_data, nv12_size,
+                                        jpeg_data, nv12_size, &optimized_len) == RKMPP_OK &&
+             optimized_len < standard_len &&
+             jpeg_data[optimized_len - 2] == 0xFF && jpeg_data[optimized_len - 1] == 0xD9;
+        
+        /* Reused tables must still code frames they were not built from */
+        ok = ok && rkmpp_encoder_encode(periodic, nv12_data, nv12_size,
+                                        jpeg_data, nv12_size, &optimized_len) == RKMPP_OK &&
+             jpeg_data[optimized_len - 2] == 0xFF && jpeg_data[optimized_len - 1] == 0xD9;
+    }
+    
+    free(jpeg_data);
+    free(nv12_data);
+    rkmpp_encoder_destroy(periodic);
+    rkmpp_encoder_destroy(per_frame);
+    rkmpp_encoder_destroy(standard);
+    
+    if (!ok) {
+        TEST_FAIL("encoder_optimized_huffman");
+        return;
+    }
+    
+    TEST_PASS("encoder_optimized_huffman");
+}
+
 /**
  * Run all encoder tests
  */
+/**
+ * Test 12: NV16 and YUYV input encode to the same 4:2:2 JPEG (CPU backend)
+ */
+void test_encoder_422_input(void)
+{
+    RkmppEncoderConfig config = {
+        .width = 320,
+        .height = 240,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 75,
+        .gop = 0,
+        .rc_mode = RKMPP_RC_MODE_FIXQP,
+        .backend = RKMPP_BACKEND_CPU,
+        .input_format = RKMPP_FORMAT_NV16
+    };
+    
+    RkmppEncoder* nv16_encoder = rkmpp_encoder_create(&config);
+    config.input_format = RKMPP_FORMAT_YUYV;
+    RkmppEncoder* yuyv_encoder = rkmpp_encoder_create(&config);
+    config.width = 321;
+    RkmppEncoder* odd_encoder = rkmpp_encoder_create(&config);
+    config.width = 320;
+    if (!nv16_encoder || !yuyv_encoder || odd_encoder) {
+        TEST_FAIL("encoder_422_input");
+        if (nv16_encoder) rkmpp_encoder_destroy(nv16_encoder);
+        if (yuyv_encoder) rkmpp_encoder_destroy(yuyv_encoder);
+        if (odd_encoder) rkmpp_encoder_destroy(odd_encoder);
+        return;
+    }
+    
+    uint32_t width = config.width;
+    uint32_t height = config.height;
+    uint32_t frame_size = rkmpp_get_frame_size(RKMPP_FORMAT_NV16, width, height);
+    uint8_t* nv16_data = (uint8_t*)malloc(frame_size);
+    uint8_t* yuyv_data = (uint8_t*)malloc(frame_size);
+    uint8_t* nv16_jpeg = (uint8_t*)malloc(frame_size);
+    uint8_t* yuyv_jpeg = (uint8_t*)malloc(frame_size);
+    uint32_t nv16_len = 0;
+    uint32_t yuyv_len = 0;
+    int ok = frame_size == width * height * 2 &&
+             rkmpp_get_frame_size(RKMPP_FORMAT_YUYV, width, height) == frame_size;
+    
+    /* Luma from the NV12 pattern, chroma varying along both axes */
+    fill_test_pattern(nv16_data, width, height, 3);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            nv16_data[width * height + y * width + x] = (uint8_t)(x & 1 ? 160 - y / 4 : 96 + x / 8);
+        }
+    }
+    
+    /* Same samples packed as Y0 Cb Y1 Cr */
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x += 2) {
+            uint8_t* dst = yuyv_data + y * width * 2 + x * 2;
+            const uint8_t* uv = nv16_data + width * height + y * width + x;
+            
+            dst[0] = nv16_data[y * width + x];
+            dst[1] = uv[0];
+            dst[2] = nv16_data[y * width + x + 1];
+            dst[3] = uv[1];
+        }
+    }
+    
+    ok = ok && rkmpp_encoder_encode(nv16_encoder, nv16_data, frame_size,
+                                    nv16_jpeg, frame_size, &nv16_len) == RKMPP_OK;
+    ok = ok && rkmpp_encoder_encode(yuyv_encoder, yuyv_data, frame_size,
+                                    yuyv_jpeg, frame_size, &yuyv_len) == RKMPP_OK;
+    ok = ok && nv16_len == yuyv_len && memcmp(nv16_jpeg, yuyv_jpeg, nv16_len) == 0;
+    
+    /* Luma is sampled 2x1 in the frame header */
+    if (ok) {
+        uint32_t pos = 2;
+        
+        while (pos + 12 < nv16_len && !(nv16_jpeg[pos] == 0xFF && nv16_jpeg[pos + 1] == 0xC0)) {
+            pos++;
+        }
+        ok = pos + 12 < nv16_len && nv16_jpeg[pos + 11] == 0x21;
+    }
+    
+    /* An NV12-sized buffer is too small for 4:2:2 input */
+    ok = ok && rkmpp_encoder_encode(nv16_encoder, nv16_data, width * height * 3 / 2,
+                                    nv16_jpeg, frame_size, &nv16_len) == RKMPP_ERR_INVALID_PARAM;
+    
+    free(yuyv_jpeg);
+    free(nv16_jpeg);
+    free(yuyv_data);
+    free(nv16_data);
+    rkmpp_encoder_destroy(yuyv_encoder);
+    rkmpp_encoder_destroy(nv16_encoder);
+    
+    if (!ok) {
+        TEST_FAIL("encoder_422_input");
+        return;
+    }
+    
+    TEST_PASS("encoder_422_input");
+}
+
+/**
+ * Test 13: Grayscale encoding from the Y plane (CPU backend)
+ */
+void test_encoder_grayscale(void)
+{
+    RkmppEncoderConfig config = {
+        .width = 320,
+        .height = 240,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 75,
+        .gop = 0,
+        .rc_mode = RKMPP_RC_MODE_FIXQP,
+        .backend = RKMPP_BACKEND_CPU,
+        .input_format = RKMPP_FORMAT_NV12
+    };
+    
+    RkmppEncoder* color_encoder = rkmpp_encoder_create(&config);
+    config.input_format = RKMPP_FORMAT_GRAY;
+    RkmppEncoder* gray_encoder = rkmpp_encoder_create(&config);
+    if (!color_encoder || !gray_encoder) {
+        TEST_FAIL("encoder_grayscale");
+        if (color_encoder) rkmpp_encoder_destroy(color_encoder);
+        if (gray_encoder) rkmpp_encoder_destroy(gray_encoder);
+        return;
+    }
+    
+    uint32_t nv12_size = config.width * config.height * 3 / 2;
+    uint32_t gray_size = rkmpp_get_frame_size(RKMPP_FORMAT_GRAY, config.width, config.height);
+    uint8_t* nv12_data = (uint8_t*)malloc(nv12_size);
+    uint8_t* jpeg_data = (uint8_t*)malloc(nv12_size);
+    uint32_t color_len = 0;
+    uint32_t gray_len = 0;
+    uint32_t pos = 2;
+    
+    fill_test_pattern(nv12_data, config.width, config.height, 5);
+    
+    /* A whole NV12 frame and its Y plane alone are both valid input */
+    int ok = gray_size == config.width * config.height &&
+             rkmpp_encoder_encode(color_encoder, nv12_data, nv12_size,
+                                  jpeg_data, nv12_size, &color_len) == RKMPP_OK &&
+             rkmpp_encoder_encode(gray_encoder, nv12_data, gray_size,
+                                  jpeg_data, nv12_size, &gray_len) == RKMPP_OK &&
+             gray_len < color_len &&
+             jpeg_data[gray_len - 2] == 0xFF && jpeg_data[gray_len - 1] == 0xD9;
+    
+    /* Single-component frame header */
+    while (ok && pos + 10 < gray_len && !(jpeg_data[pos] == 0xFF && jpeg_data[pos + 1] == 0xC0)) {
+        pos++;
+    }
+    ok = ok && pos + 10 < gray_len && jpeg_data[pos + 9] == 1;
+    
+    free(jpeg_data);
+    free(nv12_data);
+    rkmpp_encoder_destroy(gray_encoder);
+    rkmpp_encoder_destroy(color_encoder);
+    
+    if (!ok) {
+        TEST_FAIL("encoder_grayscale");
+        return;
+    }
+    
+    TEST_PASS("encoder_grayscale");
+}
+
+/**
+ * Test 14: Packed RGB input is converted while encoding (CPU backend)
+ */
+void test_encoder_rgb_input(void)
+{
+    RkmppEncoderConfig enc_config = {
+        .width = 160,
+        .height = 96,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 90,
+        .gop = 0,
+        .rc_mode = RKMPP_RC_MODE_FIXQP,
+        .backend = RKMPP_BACKEND_CPU,
+        .input_format = RKMPP_FORMAT_RGB888
+    };
+    RkmppDecoderConfig dec_config = {
+        .max_width = 1920,
+        .max_height = 1080,
+        .output_format = RKMPP_FORMAT_NV12,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    
+    RkmppEncoder* rgb_encoder = rkmpp_encoder_create(&enc_config);
+    enc_config.input_format = RKMPP_FORMAT_BGRA8888;
+    RkmppEncoder* bgra_encoder = rkmpp_encoder_create(&enc_config);
+    RkmppDecoder* decoder = rkmpp_decoder_create(&dec_config);
+    if (!rgb_encoder || !bgra_encoder || !decoder) {
+        TEST_FAIL("encoder_rgb_input");
+        if (rgb_encoder) rkmpp_encoder_destroy(rgb_encoder);
+        if (bgra_encoder) rkmpp_encoder_destroy(bgra_encoder);
+        if (decoder) rkmpp_decoder_destroy(decoder);
+        return;
+    }
+    
+    uint32_t width = enc_config.width;
+    uint32_t height = enc_config.height;
+    uint32_t rgb_size = rkmpp_get_frame_size(RKMPP_FORMAT_RGB888, width, height);
+    uint32_t bgra_size = rkmpp_get_frame_size(RKMPP_FORMAT_BGRA8888, width, height);
+    uint32_t nv12_size = width * height * 3 / 2;
+    uint8_t* rgb_data = (uint8_t*)malloc(rgb_size);
+    uint8_t* bgra_data = (uint8_t*)malloc(bgra_size);
+    uint8_t* rgb_jpeg = (uint8_t*)malloc(bgra_size);
+    uint8_t* bgra_jpeg = (uint8_t*)malloc(bgra_size);
+    uint8_t* nv12 = (uint8_t*)malloc(nv12_size);
+    uint32_t rgb_len = 0;
+    uint32_t bgra_len = 0;
+    uint32_t nv12_len = 0;
+    RkmppFrameInfo frame_info;
+    
+    /* Gray ramp on the left, pure red on the right */
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint8_t* rgb = rgb_data + (y * width + x) * 3;
+            uint8_t* bgra = bgra_data + (y * width + x) * 4;
+            uint8_t level = (uint8_t)(64 + x);
+            
+            rgb[0] = x < width / 2 ? level : 255;
+            rgb[1] = x < width / 2 ? level : 0;
+            rgb[2] = x < width / 2 ? level : 0;
+            bgra[0] = rgb[2];
+            bgra[1] = rgb[1];
+            bgra[2] = rgb[0];
+            bgra[3] = 0x5A;
+        }
+    }
+    
+    int ok = rgb_size == width * height * 3 && bgra_size == width * height * 4 &&
+             rkmpp_encoder_encode(rgb_encoder, rgb_data, rgb_size,
+                                  rgb_jpeg, bgra_size, &rgb_len) == RKMPP_OK &&
+             rkmpp_encoder_encode(bgra_encoder, bgra_data, bgra_size,
+                                  bgra_jpeg, bgra_size, &bgra_len) == RKMPP_OK &&
+             rgb_len == bgra_len && memcmp(rgb_jpeg, bgra_jpeg, rgb_len) == 0 &&
+             rkmpp_decoder_decode(decoder, rgb_jpeg, rgb_len, nv12, nv12_size,
+                                  &nv12_len, &frame_info) == RKMPP_OK;
+    
+    /* Gray keeps its level with neutral chroma; red is Y 76, Cb 85, Cr 255 */
+    for (uint32_t y = 8; ok && y < height - 8; y += 8) {
+        uint32_t x = 24;
+        const uint8_t* uv = nv12 + width * height + (y / 2) * width;
+        
+        ok = abs((int)nv12[y * width + x] - (64 + (int)x)) <= 4 &&
+             abs((int)uv[x] - 128) <= 4 && abs((int)uv[x + 1] - 128) <= 4;
+        
+        x = width - 24;
+        ok = ok && abs((int)nv12[y * width + x] - 76) <= 4 &&
+             abs((int)uv[x] - 85) <= 4 && abs((int)uv[x + 1] - 255) <= 4;
+    }
+    
+    free(nv12);
+    free(bgra_jpeg);
+    free(rgb_jpeg);
+    free(bgra_data);
+    free(rgb_data);
+    rkmpp_decoder_destroy(decoder);
+    rkmpp_encoder_destroy(bgra_encoder);
+    rkmpp_encoder_destroy(rgb_encoder);
+    
+    if (!ok) {
+        TEST_FAIL("encoder_rgb_input");
+        return;
+    }
+    
+    TEST_PASS("encoder_rgb_input");
+}
+
+/**
+ * Copy a frame of width x height samples of size bytes into its
+ * transformed orientation
+ */
+static void orient_samples(const uint8_t* src, uint32_t width, uint32_t height,
+                           uint32_t size, uint32_t stride, uint32_t transform,
+                           uint8_t* dst, uint32_t dst_stride)
+{
+    int swap = transform == RKMPP_TRANSFORM_TRANSPOSE || transform == RKMPP_TRANSFORM_ROT90 ||
+               transform == RKMPP_TRANSFORM_ROT270;
+    uint32_t out_width = swap ? height : width;
+    uint32_t out_height = swap ? width : height;
+    
+    for (uint32_t y = 0; y < out_height; y++) {
+        for (uint32_t x = 0; x < out_width; x++) {
+            uint32_t sx = x;
+            uint32_t sy = y;
+            
+            switch (transform) {
+                case RKMPP_TRANSFORM_HFLIP:     sx = width - 1 - x;  break;
+                case RKMPP_TRANSFORM_VFLIP:     sy = height - 1 - y; break;
+                case RKMPP_TRANSFORM_TRANSPOSE: sx = y; sy = x;      break;
+                case RKMPP_TRANSFORM_ROT90:     sx = y; sy = height - 1 - x; break;
+                case RKMPP_TRANSFORM_ROT180:    sx = width - 1 - x; sy = height - 1 - y; break;
+                case RKMPP_TRANSFORM_ROT270:    sx = width - 1 - y; sy = x; break;
+                default:                        break;
+            }
+            memcpy(dst + y * dst_stride + x * size, src + sy * stride + sx * size, size);
+        }
+    }
+}
+
+/**
+ * Test 15: Input orientation matches encoding a rotated copy (CPU backend)
+ */
+void test_encoder_orientation(void)
+{
+    RkmppEncoderConfig config = {
+        .width = 160,
+        .height = 96,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 90,
+        .gop = 0,
+        .rc_mode = RKMPP_RC_MODE_FIXQP,
+        .backend = RKMPP_BACKEND_CPU,
+        .input_format = RKMPP_FORMAT_NV12
+    };
+    uint32_t width = config.width;
+    uint32_t height = config.height;
+    uint32_t frame_size = rkmpp_get_frame_size(RKMPP_FORMAT_RGB888, width, height);
+    uint8_t* source = (uint8_t*)malloc(frame_size);
+    uint8_t* rotated = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg = (uint8_t*)malloc(frame_size);
+    uint8_t* expected = (uint8_t*)malloc(frame_size);
+    uint32_t jpeg_len = 0;
+    uint32_t expected_len = 0;
+    int ok = source && rotated && jpeg && expected;
+    
+    if (ok) {
+        fill_test_pattern(source, width, height, 7);
+    }
+    
+    for (uint32_t op = RKMPP_TRANSFORM_HFLIP; ok && op <= RKMPP_TRANSFORM_ROT270; op++) {
+        int swap = op == RKMPP_TRANSFORM_TRANSPOSE || op == RKMPP_TRANSFORM_ROT90 ||
+                   op == RKMPP_TRANSFORM_ROT270;
+        RkmppEncoderConfig plain = config;
+        
+        /* Reference: rotate the NV12 frame, then encode it as is */
+        plain.transform = RKMPP_TRANSFORM_NONE;
+        plain.width = swap ? height : width;
+        plain.height = swap ? width : height;
+        orient_samples(source, width, height, 1, width, op, rotated, plain.width);
+        orient_samples(source + width * height, width / 2, height / 2, 2, width, op,
+                       rotated + plain.width * plain.height, plain.width);
+        
+        config.transform = op;
+        RkmppEncoder* oriented = rkmpp_encoder_create(&config);
+        RkmppEncoder* reference = rkmpp_encoder_create(&plain);
+        
+        ok = oriented && reference &&
+             rkmpp_encoder_encode(oriented, source, width * height * 3 / 2,
+                                  jpeg, frame_size, &jpeg_len) == RKMPP_OK &&
+             rkmpp_encoder_encode(reference, rotated, width * height * 3 / 2,
+                                  expected, frame_size, &expected_len) == RKMPP_OK &&
+             jpeg_len == expected_len && memcmp(jpeg, expected, jpeg_len) == 0;
+        
+        if (oriented) rkmpp_encoder_destroy(oriented);
+        if (reference) rkmpp_encoder_destroy(reference);
+    }
+    
+    /* Packed RGB is read through the same oriented view */
+    if (ok) {
+        RkmppEncoderConfig plain = config;
+        
+        for (uint32_t i = 0; i < width * height * 3; i++) {
+            source[i] = (uint8_t)(i * 7 / 5 + (i / (width * 3)) * 3);
+        }
+        config.input_format = RKMPP_FORMAT_RGB888;
+        config.transform = RKMPP_TRANSFORM_ROT90;
+        plain.input_format = RKMPP_FORMAT_RGB888;
+        plain.transform = RKMPP_TRANSFORM_NONE;
+        plain.width = height;
+        plain.height = width;
+        orient_samples(source, width, height, 3, width * 3, RKMPP_TRANSFORM_ROT90,
+                       rotated, plain.width * 3);
+        
+        RkmppEncoder* oriented = rkmpp_encoder_create(&config);
+        RkmppEncoder* reference = rkmpp_encoder_create(&plain);
+        
+        ok = oriented && reference &&
+             rkmpp_encoder_encode(oriented, source, frame_size,
+                                  jpeg, frame_size, &jpeg_len) == RKMPP_OK &&
+             rkmpp_encoder_encode(reference, rotated, frame_size,
+                                  expected, frame_size, &expected_len) == RKMPP_OK &&
+             jpeg_len == expected_len && memcmp(jpeg, expected, jpeg_len) == 0;
+        
+        if (oriented) rkmpp_encoder_destroy(oriented);
+        if (reference) rkmpp_encoder_destroy(reference);
+    }
+    
+    /* 4:2:2 cannot be transposed; the MPP backend has no orientation */
+    config.input_format = RKMPP_FORMAT_NV16;
+    config.transform = RKMPP_TRANSFORM_ROT270;
+    RkmppEncoder* invalid = rkmpp_encoder_create(&config);
+    ok = ok && !invalid;
+    if (invalid) rkmpp_encoder_destroy(invalid);
+    
+    config.input_format = RKMPP_FORMAT_NV12;
+    config.transform = RKMPP_TRANSFORM_VFLIP;
+    config.backend = RKMPP_BACKEND_MPP;
+    invalid = rkmpp_encoder_create(&config);
+    ok = ok && !invalid;
+    if (invalid) rkmpp_encoder_destroy(invalid);
+    
+    free(expected);
+    free(jpeg);
+    free(rotated);
+    free(source);
+    
+    if (!ok) {
+        TEST_FAIL("encoder_orientation");
+        return;
+    }
+    
+    TEST_PASS("encoder_orientation");
+}
+
+/**
+ * Test 16: Static frames repeat the last JPEG instead of being encoded
+ */
+void test_encoder_static_scene(void)
+{
+    RkmppEncoderConfig config = {
+        .width = 320,
+        .height = 240,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 80,
+        .gop = 0,
+        .backend = RKMPP_BACKEND_CPU,
+        .input_format = RKMPP_FORMAT_NV12,
+        .static_threshold = 2
+    };
+    uint32_t frame_size = rkmpp_get_nv12_size(config.width, config.height);
+    uint8_t* frame = (uint8_t*)malloc(frame_size);
+    uint8_t* first = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg = (uint8_t*)malloc(frame_size);
+    uint32_t first_len = 0;
+    uint32_t jpeg_len = 0;
+    uint64_t frames = 0;
+    RkmppEncodeParams params = { 0 };
+    RkmppEncodeResult result;
+    RkmppEncoder* encoder = rkmpp_encoder_create(&config);
+    int ok = encoder && frame && first && jpeg;
+    
+    if (ok) {
+        fill_test_pattern(frame, config.width, config.height, 3);
+        
+        /* First frame is encoded, the identical second one repeated */
+        ok = rkmpp_encoder_encode_ex(encoder, frame, frame_size, first, frame_size,
+                                     &first_len, NULL, &result) == RKMPP_OK &&
+             result.duplicate == 0 && result.passes == 1 &&
+             rkmpp_encoder_encode_ex(encoder, frame, frame_size, jpeg, frame_size,
+                                     &jpeg_len, NULL, &result) == RKMPP_OK &&
+             result.duplicate == 1 && result.passes == 0 && result.quality == 80 &&
+             jpeg_len == first_len && memcmp(jpeg, first, first_len) == 0;
+    }
+    
+    /* Sensor noise of one level is still static */
+    for (uint32_t i = 0; ok && i < config.width * config.height; i++) {
+        frame[i] = (uint8_t)(i & 1 ? frame[i] - (frame[i] > 0) : frame[i] + (frame[i] < 255));
+    }
+    ok = ok && rkmpp_encoder_encode_ex(encoder, frame, frame_size, jpeg, frame_size,
+                                       &jpeg_len, NULL, &result) == RKMPP_OK &&
+         result.duplicate == 1;
+    
+    /* A 3x3 object appearing is a change, and the new frame the reference */
+    for (uint32_t y = 100; ok && y < 103; y++) {
+        memset(frame + y * config.width + 200, 255, 3);
+    }
+    ok = ok && rkmpp_encoder_encode_ex(encoder, frame, frame_size, jpeg, frame_size,
+                                       &jpeg_len, NULL, &result) == RKMPP_OK &&
+         result.duplicate == 0 &&
+         rkmpp_encoder_encode_ex(encoder, frame, frame_size, jpeg, frame_size,
+                                 &jpeg_len, NULL, &result) == RKMPP_OK &&
+         result.duplicate == 1;
+    
+    /* A repeat that exceeds the byte budget is encoded to fit instead */
+    params.max_size = jpeg_len - 1;
+    ok = ok && rkmpp_encoder_encode_ex(encoder, frame, frame_size, jpeg, frame_size,
+                                       &jpeg_len, &params, &result) == RKMPP_OK &&
+         result.duplicate == 0 && jpeg_len <= params.max_size;
+    
+    /* New settings always produce a new frame */
+    ok = ok && rkmpp_encoder_set_quality(encoder, 60) == RKMPP_OK &&
+         rkmpp_encoder_encode_ex(encoder, frame, frame_size, jpeg, frame_size,
+                                 &jpeg_len, NULL, &result) == RKMPP_OK &&
+         result.duplicate == 0 && result.quality == 60 &&
+         rkmpp_encoder_get_stats(encoder, &frames, NULL) == RKMPP_OK && frames == 7;
+    
+    if (encoder) rkmpp_encoder_destroy(encoder);
+    
+    config.static_threshold = 256;
+    encoder = rkmpp_encoder_create(&config);
+    ok = ok && !encoder;
+    if (encoder) rkmpp_encoder_destroy(encoder);
+    
+    free(jpeg);
+    free(first);
+    free(frame);
+    
+    if (!ok) {
+        TEST_FAIL("encoder_static_scene");
+        return;
+    }
+    
+    TEST_PASS("encoder_static_scene");
+}
+
+/**
+ * Change a rectangle of pixels in an NV12 or packed RGB frame
+ */
+static void change_rect(uint8_t* frame, uint32_t format, uint32_t width, uint32_t height,
+                        uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint8_t value)
+{
+    for (uint32_t y = y0; y < y1; y++) {
+        if (format == RKMPP_FORMAT_RGB888) {
+            memset(frame + (y * width + x0) * 3, value, (x1 - x0) * 3);
+        } else {
+            memset(frame + y * width + x0, value, x1 - x0);
+            memset(frame + width * height + (y / 2) * width + (x0 & ~1u), value ^ 0x55,
+                   (x1 - x0 + 1) & ~1u);
+        }
+    }
+}
+
+/**
+ * Test 17: Re-encoding only the MCUs a dirty map flags matches a full encode
+ */
+void test_encoder_dirty_map(void)
+{
+    static const uint32_t formats[] = { RKMPP_FORMAT_NV12, RKMPP_FORMAT_RGB888 };
+    RkmppEncoderConfig config = {
+        .width = 320,
+        .height = 240,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 80,
+        .gop = 0,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    uint32_t frame_size = rkmpp_get_frame_size(RKMPP_FORMAT_RGB888, config.width, config.height);
+    uint8_t* frame = (uint8_t*)malloc(frame_size);
+    uint8_t* partial = (uint8_t*)malloc(frame_size);
+    uint8_t* full = (uint8_t*)malloc(frame_size);
+    uint8_t* map = (uint8_t*)calloc(1, 40 * 30);
+    int ok = frame && partial && full && map;
+    
+    for (uint32_t f = 0; ok && f < 2; f++) {
+        RkmppEncoder* patched = NULL;
+        RkmppEncoder* reference = NULL;
+        RkmppEncodeParams params = { 0 };
+        uint32_t mcu_width = 0;
+        uint32_t mcu_height = 0;
+        uint32_t mcus_x = 0;
+        uint32_t mcus_y = 0;
+        uint32_t partial_len = 0;
+        uint32_t full_len = 0;
+        
+        config.input_format = formats[f];
+        config.huffman_refresh = f;
+        patched = rkmpp_encoder_create(&config);
+        reference = rkmpp_encoder_create(&config);
+        ok = patched && reference &&
+             rkmpp_encoder_get_mcu_grid(patched, &mcu_width, &mcu_height,
+                                        &mcus_x, &mcus_y) == RKMPP_OK &&
+             mcus_x == (config.width + mcu_width - 1) / mcu_width &&
+             mcus_y == (config.height + mcu_height - 1) / mcu_height;
+        
+        for (uint32_t i = 0; ok && i < frame_size; i++) {
+            frame[i] = (uint8_t)((i * 7 + (i / 960) * 13) & 0xFF);
+        }
+        memset(map, 0, 40 * 30);
+        params.dirty_map = map;
+        
+        /* Frame 1 has nothing to patch and is encoded whole; frame 2 changes
+         * a rectangle; frame 3 changes it again under new tables */
+        for (uint32_t n = 0; ok && n < 3; n++) {
+            if (n > 0) {
+                change_rect(frame, config.input_format, config.width, config.height,
+                            100, 40 + n, 140, 70, (uint8_t)(n * 90));
+                for (uint32_t my = (40 + n) / mcu_height; my <= 69 / mcu_height; my++) {
+                    for (uint32_t mx = 100 / mcu_width; mx <= 139 / mcu_width; mx++) {
+                        map[my * mcus_x + mx] = 1;
+                    }
+                }
+            }
+            if (n == 2) {
+                ok = rkmpp_encoder_set_quality(patched, 60) == RKMPP_OK &&
+                     rkmpp_encoder_set_quality(reference, 60) == RKMPP_OK;
+            }
+            
+            ok = ok && rkmpp_encoder_encode_ex(patched, frame, frame_size, partial, frame_size,
+                                               &partial_len, &params, NULL) == RKMPP_OK &&
+                 rkmpp_encoder_encode(reference, frame, frame_size, full, frame_size,
+                                      &full_len) == RKMPP_OK &&
+                 partial_len == full_len && memcmp(partial, full, full_len) == 0;
+            memset(map, 0, 40 * 30);
+        }
+        
+        if (patched) rkmpp_encoder_destroy(patched);
+        if (reference) rkmpp_encoder_destroy(reference);
+    }
+    
+    free(map);
+    free(full);
+    free(partial);
+    free(frame);
+    
+    if (!ok) {
+        TEST_FAIL("encoder_dirty_map");
+        return;
+    }
+    
+    TEST_PASS("encoder_dirty_map");
+}
+
+/**
+ * Test 18: A reconfigured encoder matches one created at the new settings
+ */
+void test_encoder_reconfigure(void)
+{
+    static const uint32_t sizes[][3] = {
+        { 640, 480, 60 },                  /* Grow */
+        { 176, 144, 0 },                   /* Shrink into the kept buffers */
+        { 320, 240, 90 }
+    };
+    RkmppEncoderConfig config = {
+        .width = 320,
+        .height = 240,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 80,
+        .gop = 0,
+        .backend = RKMPP_BACKEND_CPU,
+        .input_format = RKMPP_FORMAT_NV12,
+        .static_threshold = 2
+    };
+    uint32_t frame_size = rkmpp_get_nv12_size(640, 480);
+    uint8_t* frame = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg = (uint8_t*)malloc(frame_size);
+    uint8_t* expected = (uint8_t*)malloc(frame_size);
+    uint8_t* map = (uint8_t*)calloc(1, 40 * 30);
+    uint32_t jpeg_len = 0;
+    uint32_t expected_len = 0;
+    uint32_t mcus_x = 0;
+    uint32_t mcus_y = 0;
+    uint64_t frames = 0;
+    RkmppEncodeParams params = { 0 };
+    RkmppEncodeResult result;
+    RkmppEncoder* encoder = rkmpp_encoder_create(&config);
+    int ok = encoder && frame && jpeg && expected && map;
+    
+    if (ok) {
+        fill_test_pattern(frame, config.width, config.height, 5);
+        ok = rkmpp_encoder_encode(encoder, frame, frame_size, jpeg, frame_size,
+                                  &jpeg_len) == RKMPP_OK;
+    }
+    
+    for (uint32_t n = 0; ok && n < 3; n++) {
+        RkmppEncoder* fresh = NULL;
+        uint32_t size = 0;
+        
+        config.width = sizes[n][0];
+        config.height = sizes[n][1];
+        if (sizes[n][2] > 0) {
+            config.quality = sizes[n][2];
+        }
+        size = rkmpp_get_nv12_size(config.width, config.height);
+        fill_test_pattern(frame, config.width, config.height, 5 + n);
+        
+        /* A dirty map cannot patch a frame of another size: all is encoded */
+        params.dirty_map = map;
+        fresh = rkmpp_encoder_create(&config);
+        ok = fresh &&
+             rkmpp_encoder_reconfigure(encoder, config.width, config.height,
+                                       sizes[n][2]) == RKMPP_OK &&
+             rkmpp_encoder_get_mcu_grid(encoder, NULL, NULL, &mcus_x, &mcus_y) == RKMPP_OK &&
+             mcus_x == (config.width + 15) / 16 && mcus_y == (config.height + 15) / 16 &&
+             rkmpp_encoder_encode_ex(encoder, frame, size, jpeg, frame_size, &jpeg_len,
+                                     &params, &result) == RKMPP_OK &&
+             result.duplicate == 0 && result.quality == config.quality &&
+             rkmpp_encoder_encode(fresh, frame, size, expected, frame_size,
+                                  &expected_len) == RKMPP_OK &&
+             jpeg_len == expected_len && memcmp(jpeg, expected, jpeg_len) == 0;
+        
+        if (fresh) rkmpp_encoder_destroy(fresh);
+    }
+    
+    /* Rejected sizes leave the encoder as it was */
+    ok = ok && rkmpp_encoder_reconfigure(encoder, 8, 240, 0) == RKMPP_ERR_INVALID_PARAM &&
+         rkmpp_encoder_reconfigure(encoder, 320, 240, 101) == RKMPP_ERR_INVALID_PARAM &&
+         rkmpp_encoder_reconfigure(NULL, 320, 240, 0) == RKMPP_ERR_INVALID_PARAM &&
+         rkmpp_encoder_encode_ex(encoder, frame, rkmpp_get_nv12_size(320, 240), jpeg,
+                                 frame_size, &jpeg_len, NULL, &result) == RKMPP_OK &&
+         result.duplicate == 1 &&
+         rkmpp_encoder_get_stats(encoder, &frames, NULL) == RKMPP_OK && frames == 5;
+    
+    if (encoder) rkmpp_encoder_destroy(encoder);
+    
+    /* Sizes create rejects for the input format are rejected here too */
+    if (ok) {
+        config.width = 320;
+        config.input_format = RKMPP_FORMAT_YUYV;
+        config.static_threshold = 0;
+        encoder = rkmpp_encoder_create(&config);
+        ok = encoder &&
+             rkmpp_encoder_reconfigure(encoder, 321, 240, 0) == RKMPP_ERR_INVALID_PARAM &&
+             rkmpp_encoder_reconfigure(encoder, 322, 240, 0) == RKMPP_OK;
+        if (encoder) rkmpp_encoder_destroy(encoder);
+    }
+    
+    free(map);
+    free(expected);
+    free(jpeg);
+    free(frame);
+    
+    if (!ok) {
+        TEST_FAIL("encoder_reconfigure");
+        return;
+    }
+    
+    TEST_PASS("encoder_reconfigure");
+}
+
+/**
+ * Test 19: Destroyed encoders are reused by creates with the same setup
+ */
+void test_encoder_context_cache(void)
+{
+    RkmppEncoderConfig config = {
+        .width = 320,
+        .height = 240,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 50,
+        .gop = 0,
+        .backend = RKMPP_BACKEND_CPU,
+        .input_format = RKMPP_FORMAT_NV12,
+        .huffman_refresh = 4
+    };
+    uint32_t frame_size = rkmpp_get_nv12_size(config.width, config.height);
+    uint8_t* frame = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg = (uint8_t*)malloc(frame_size);
+    uint8_t* expected = (uint8_t*)malloc(frame_size);
+    uint32_t jpeg_len = 0;
+    uint32_t expected_len = 0;
+    uint64_t frames = 1;
+    RkmppEncoder* first = NULL;
+    RkmppEncoder* other = NULL;
+    RkmppEncoder* encoder = NULL;
+    int ok = frame && jpeg && expected &&
+             rkmpp_set_context_cache_size(17) == RKMPP_ERR_INVALID_PARAM;
+    
+    /* Reference from a context that never served another stream */
+    ok = ok && rkmpp_set_context_cache_size(0) == RKMPP_OK;
+    if (ok) {
+        fill_test_pattern(frame, config.width, config.height, 9);
+        encoder = rkmpp_encoder_create(&config);
+        ok = encoder && rkmpp_encoder_encode(encoder, frame, frame_size, expected, frame_size,
+                                             &expected_len) == RKMPP_OK;
+        if (encoder) rkmpp_encoder_destroy(encoder);
+    }
+    
+    /* A stream at another quality, with its own Huffman statistics */
+    ok = ok && rkmpp_set_context_cache_size(4) == RKMPP_OK;
+    if (ok) {
+        config.quality = 90;
+        first = rkmpp_encoder_create(&config);
+        fill_test_pattern(frame, config.width, config.height, 10);
+        ok = first && rkmpp_encoder_encode(first, frame, frame_size, jpeg, frame_size,
+                                           &jpeg_len) == RKMPP_OK;
+        if (first) rkmpp_encoder_destroy(first);
+    }
+    
+    /* The parked context comes back with nothing of that stream left */
+    if (ok) {
+        config.quality = 50;
+        fill_test_pattern(frame, config.width, config.height, 9);
+        encoder = rkmpp_encoder_create(&config);
+        ok = encoder == first &&
+             rkmpp_encoder_get_stats(encoder, &frames, NULL) == RKMPP_OK && frames == 0 &&
+             rkmpp_encoder_encode(encoder, frame, frame_size, jpeg, frame_size,
+                                  &jpeg_len) == RKMPP_OK &&
+             jpeg_len == expected_len && memcmp(jpeg, expected, jpeg_len) == 0;
+        if (encoder) rkmpp_encoder_destroy(encoder);
+    }
+    
+    /* Another geometry needs a context of its own */
+    if (ok) {
+        config.height = 256;
+        other = rkmpp_encoder_create(&config);
+        ok = other && other != first;
+        if (other) rkmpp_encoder_destroy(other);
+    }
+    
+    ok = rkmpp_set_context_cache_size(0) == RKMPP_OK && ok;
+    
+    free(expected);
+    free(jpeg);
+    free(frame);
+    
+    if (!ok) {
+        TEST_FAIL("encoder_context_cache");
+        return;
+    }
+    
+    TEST_PASS("encoder_context_cache");
+}
+
+/* Messages seen by count_messages, per level */
+static uint32_t log_counts[RKMPP_LOG_DEBUG + 1];
+
+static void count_messages(RkmppLogLevel level, const char* message, void* opaque)
+{
+    (void)opaque;
+    if (level <= RKMPP_LOG_DEBUG && message[0] != '\0') {
+        log_counts[level]++;
+    }
+}
+
+/**
+ * Test 20: Log messages reach the callback only at the configured level
+ */
+void test_encoder_logging(void)
+{
+    RkmppEncoderConfig config = {
+        .width = 320,
+        .height = 240,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 50,
+        .gop = 0
+    };
+    RkmppEncoder* encoder = NULL;
+    uint64_t emitted = 0;
+    uint64_t suppressed = 0;
+    uint64_t before = 0;
+    int ok = rkmpp_set_log_level((RkmppLogLevel)(RKMPP_LOG_DEBUG + 1)) == RKMPP_ERR_INVALID_PARAM &&
+             rkmpp_get_log_stats(RKMPP_LOG_NONE, &emitted, &suppressed) == RKMPP_ERR_INVALID_PARAM;
+    
+    memset(log_counts, 0, sizeof(log_counts));
+    rkmpp_set_log_callback(count_messages, NULL);
+    
+    /* Creation is reported at INFO */
+    ok = ok && rkmpp_set_log_level(RKMPP_LOG_INFO) == RKMPP_OK;
+    if (ok) {
+        encoder = rkmpp_encoder_create(&config);
+        ok = encoder && log_counts[RKMPP_LOG_INFO] > 0;
+        if (encoder) rkmpp_encoder_destroy(encoder);
+    }
+    
+    /* Below the level nothing is delivered, only counted */
+    ok = ok && rkmpp_set_log_level(RKMPP_LOG_ERROR) == RKMPP_OK &&
+         rkmpp_get_log_stats(RKMPP_LOG_INFO, NULL, &before) == RKMPP_OK;
+    if (ok) {
+        memset(log_counts, 0, sizeof(log_counts));
+        encoder = rkmpp_encoder_create(&config);
+        ok = encoder && log_counts[RKMPP_LOG_INFO] == 0 &&
+             rkmpp_get_log_stats(RKMPP_LOG_INFO, &emitted, &suppressed) == RKMPP_OK &&
+             suppressed > before;
+        if (encoder) rkmpp_encoder_destroy(encoder);
+    }
+    
+    /* Errors still get through */
+    if (ok) {
+        config.quality = 101;
+        encoder = rkmpp_encoder_create(&config);
+        ok = !encoder && log_counts[RKMPP_LOG_ERROR] > 0;
+        if (encoder) rkmpp_encoder_destroy(encoder);
+    }
+    
+    rkmpp_set_log_callback(NULL, NULL);
+    ok = rkmpp_set_log_level(RKMPP_LOG_WARN) == RKMPP_OK && ok;
+    
+    if (!ok) {
+        TEST_FAIL("encoder_logging");
+        return;
+    }
+    
+    TEST_PASS("encoder_logging");
+}
+
+/**
+ * Test 21: A frame skipped as static does not leave stale blocks behind
+ * for a dirty map that only covers changes since the skipped frame
+ */
+void test_encoder_dirty_map_static(void)
+{
+    RkmppEncoderConfig config = {
+        .width = 320,
+        .height = 240,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = 80,
+        .gop = 0,
+        .backend = RKMPP_BACKEND_CPU,
+        .input_format = RKMPP_FORMAT_NV12
+    };
+    uint32_t frame_size = rkmpp_get_nv12_size(config.width, config.height);
+    uint8_t* frame = (uint8_t*)malloc(frame_size);
+    uint8_t* partial = (uint8_t*)malloc(frame_size);
+    uint8_t* full = (uint8_t*)malloc(frame_size);
+    uint8_t* map = (uint8_t*)calloc(1, 20 * 15);
+    RkmppEncodeParams params = { .max_size = 0, .dirty_map = map };
+    RkmppEncodeResult result = { 0 };
+    RkmppEncoder* patched = NULL;
+    RkmppEncoder* reference = NULL;
+    uint32_t partial_len = 0;
+    uint32_t full_len = 0;
+    int ok = frame && partial && full && map;
+    
+    if (ok) {
+        reference = rkmpp_encoder_create(&config);
+        config.static_threshold = 16;
+        patched = rkmpp_encoder_create(&config);
+        ok = patched && reference;
+    }
+    
+    for (uint32_t n = 0; ok && n < 3; n++) {
+        if (n == 1) {
+            /* Drift below the threshold: the frame is repeated */
+            for (uint32_t y = 32; y < 64; y++) {
+                for (uint32_t x = 96; x < 128; x++) {
+                    uint8_t* p = frame + y * config.width + x;
+                    *p = (uint8_t)(*p < 128 ? *p + 4 : *p - 4);
+                }
+            }
+        } else if (n == 2) {
+            /* A real change elsewhere, and only it in the map */
+            change_rect(frame, config.input_format, config.width, config.height,
+                        192, 128, 224, 160, 200);
+            for (uint32_t my = 8; my < 10; my++) {
+                map[my * 20 + 12] = 1;
+                map[my * 20 + 13] = 1;
+            }
+        } else {
+            fill_test_pattern(frame, config.width, config.height, 11);
+        }
+        
+        ok = rkmpp_encoder_encode_ex(patched, frame, frame_size, partial, frame_size,
+                                     &partial_len, &params, &result) == RKMPP_OK &&
+             result.duplicate == (n == 1) &&
+             rkmpp_encoder_encode(reference, frame, frame_size, full, frame_size,
+                                  &full_len) == RKMPP_OK &&
+             (n == 1 || (partial_len == full_len && memcmp(partial, full, full_len) == 0));
+        memset(map, 0, 20 * 15);
+    }
+    
+    if (patched) rkmpp_encoder_destroy(patched);
+    if (reference) rkmpp_encoder_destroy(reference);
+    
+    free(map);
+    free(full);
+    free(partial);
+    free(frame);
+    
+    if (!ok) {
+        TEST_FAIL("encoder_dirty_map_static");
+        return;
+    }
+    
+    TEST_PASS("encoder_dirty_map_static");
+}
+
 int main(int argc, char* argv[])
 {
     printf("=== RKMPP MJPEG Encoder Test Suite ===\n\n");
@@ -349,6 +1655,21 @@ int main(int argc, char* argv[])
     test_encoder_encode_invalid();
     test_encoder_get_stats();
     test_encoder_multiple_resolutions();
+    test_encoder_set_quality();
+    test_encoder_rate_control();
+    test_encoder_target_size();
+    test_encoder_shared_tables();
+    test_encoder_optimized_huffman();
+    test_encoder_422_input();
+    test_encoder_grayscale();
+    test_encoder_rgb_input();
+    test_encoder_orientation();
+    test_encoder_static_scene();
+    test_encoder_dirty_map();
+    test_encoder_reconfigure();
+    test_encoder_context_cache();
+    test_encoder_logging();
+    test_encoder_dirty_map_static();
     
     printf("\n=== Tests Complete ===\n");
     
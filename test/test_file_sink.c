@@ -0,0 +1,215 @@
+/*
+ * Batched File Sink Test Cases
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "rkmpp_mjpeg.h"
+
+/* Test utilities */
+#define TEST_PASS(name) printf("✓ PASS: %s\n", name)
+#define TEST_FAIL(name) printf("✗ FAIL: %s\n", name)
+
+/**
+ * Check that a file holds exactly the expected bytes
+ */
+static int file_matches(const char* path, const uint8_t* data, uint32_t length)
+{
+    FILE* fp = fopen(path, "rb");
+    uint8_t* contents = (uint8_t*)malloc(length + 1);
+    size_t got = 0;
+    int ok = 0;
+
+    if (fp && contents) {
+        got = fread(contents, 1, length + 1, fp);
+        ok = (got == length && memcmp(contents, data, length) == 0);
+    }
+
+    if (fp) {
+        fclose(fp);
+    }
+    free(contents);
+
+    return ok;
+}
+
+/**
+ * Write a batch of files through a sink and verify them
+ */
+static void run_sink_batch(const char* name, uint32_t engine)
+{
+    char dir[] = "/tmp/rkmpp_sink_XXXXXX";
+    char path[256];
+    uint8_t payload[4096];
+    int num_files = 40;
+
+    if (!mkdtemp(dir)) {
+        TEST_FAIL(name);
+        return;
+    }
+
+    RkmppFileSinkConfig config = {
+        .engine = engine,
+        .num_buffers = 8,
+        .buffer_size = sizeof(payload),
+        .batch_size = 4,
+        .num_threads = 2
+    };
+
+    RkmppFileSink* sink = rkmpp_file_sink_create(&config);
+    if (!sink) {
+        TEST_FAIL(name);
+        rmdir(dir);
+        return;
+    }
+
+    /* Zero-copy path: fill the sink's own buffer and submit it */
+    for (int i = 0; i < num_files; i++) {
+        uint8_t* buffer = NULL;
+        uint32_t capacity = 0;
+        uint32_t length = 100 + (uint32_t)i * 50;
+
+        if (rkmpp_file_sink_get_buffer(sink, &buffer, &capacity) != RKMPP_OK ||
+            capacity < length) {
+            TEST_FAIL(name);
+            rkmpp_file_sink_destroy(sink);
+            return;
+        }
+
+        memset(buffer, i, length);
+        snprintf(path, sizeof(path), "%s/frame_%03d.jpg", dir, i);
+
+        if (rkmpp_file_sink_submit(sink, path, buffer, length) != RKMPP_OK) {
+            TEST_FAIL(name);
+            rkmpp_file_sink_destroy(sink);
+            return;
+        }
+    }
+
+    if (rkmpp_file_sink_flush(sink) != RKMPP_OK) {
+        TEST_FAIL(name);
+        rkmpp_file_sink_destroy(sink);
+        return;
+    }
+
+    RkmppFileSinkStats stats;
+    if (rkmpp_file_sink_get_stats(sink, &stats) != RKMPP_OK ||
+        stats.files_written != (uint64_t)num_files ||
+        stats.write_errors != 0 ||
+        stats.submissions == 0 ||
+        stats.latency_max_us < stats.latency_min_us ||
+        (engine != RKMPP_SINK_ENGINE_AUTO && stats.engine != engine)) {
+        TEST_FAIL(name);
+        rkmpp_file_sink_destroy(sink);
+        return;
+    }
+
+    rkmpp_file_sink_destroy(sink);
+
+    /* Verify and clean up */
+    int ok = 1;
+    for (int i = 0; i < num_files; i++) {
+        uint32_t length = 100 + (uint32_t)i * 50;
+
+        memset(payload, i, length);
+        snprintf(path, sizeof(path), "%s/frame_%03d.jpg", dir, i);
+
+        if (!file_matches(path, payload, length)) {
+            ok = 0;
+        }
+        unlink(path);
+    }
+    rmdir(dir);
+
+    if (!ok) {
+        TEST_FAIL(name);
+        return;
+    }
+
+    TEST_PASS(name);
+}
+
+/**
+ * Test 1: Default engine (io_uring when the kernel supports it)
+ */
+void test_file_sink_auto(void)
+{
+    run_sink_batch("file_sink_auto", RKMPP_SINK_ENGINE_AUTO);
+}
+
+/**
+ * Test 2: Thread-pool fallback engine
+ */
+void test_file_sink_threads(void)
+{
+    run_sink_batch("file_sink_threads", RKMPP_SINK_ENGINE_THREADS);
+}
+
+/**
+ * Test 3: Copying write and error reporting
+ */
+void test_file_sink_write_errors(void)
+{
+    uint8_t data[64];
+    RkmppFileSinkStats stats;
+
+    memset(data, 0xAB, sizeof(data));
+
+    RkmppFileSink* sink = rkmpp_file_sink_create(NULL);
+    if (!sink) {
+        TEST_FAIL("file_sink_write_errors");
+        return;
+    }
+
+    /* Directory does not exist: the write must fail and be counted */
+    if (rkmpp_file_sink_write(sink, "/nonexistent/rkmpp/frame.jpg",
+                              data, sizeof(data)) != RKMPP_OK) {
+        TEST_FAIL("file_sink_write_errors (queue)");
+        rkmpp_file_sink_destroy(sink);
+        return;
+    }
+
+    if (rkmpp_file_sink_flush(sink) == RKMPP_OK) {
+        TEST_FAIL("file_sink_write_errors (flush status)");
+        rkmpp_file_sink_destroy(sink);
+        return;
+    }
+
+    if (rkmpp_file_sink_get_stats(sink, &stats) != RKMPP_OK ||
+        stats.write_errors != 1 || stats.files_written != 0) {
+        TEST_FAIL("file_sink_write_errors (stats)");
+        rkmpp_file_sink_destroy(sink);
+        return;
+    }
+
+    /* Buffers not owned by the sink are rejected */
+    if (rkmpp_file_sink_submit(sink, "/tmp/x.jpg", data, sizeof(data)) !=
+        RKMPP_ERR_INVALID_PARAM) {
+        TEST_FAIL("file_sink_write_errors (foreign buffer)");
+        rkmpp_file_sink_destroy(sink);
+        return;
+    }
+
+    rkmpp_file_sink_destroy(sink);
+
+    TEST_PASS("file_sink_write_errors");
+}
+
+/**
+ * Run all file sink tests
+ */
+int main(int argc, char* argv[])
+{
+    printf("=== RKMPP MJPEG File Sink Test Suite ===\n\n");
+
+    test_file_sink_auto();
+    test_file_sink_threads();
+    test_file_sink_write_errors();
+
+    printf("\n=== Tests Complete ===\n");
+
+    return 0;
+}
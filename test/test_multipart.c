@@ -0,0 +1,300 @@
+/*
+ * Multipart Writer Test Cases
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "rkmpp_mjpeg.h"
+
+/* Test utilities */
+#define TEST_PASS(name) printf("✓ PASS: %s\n", name)
+#define TEST_FAIL(name) printf("✗ FAIL: %s\n", name)
+
+/**
+ * Read exactly length bytes from a descriptor
+ */
+static int read_all(int fd, uint8_t* out, size_t length)
+{
+    size_t got = 0;
+
+    while (got < length) {
+        ssize_t ret = read(fd, out + got, length - got);
+        if (ret <= 0) {
+            return -1;
+        }
+        got += (size_t)ret;
+    }
+
+    return 0;
+}
+
+/**
+ * Test 1: Part layout and content type
+ */
+void test_multipart_build_frame(void)
+{
+    static const uint8_t jpeg[] = { 0xFF, 0xD8, 0x01, 0x02, 0xFF, 0xD9 };
+    RkmppMultipartFrame frame;
+
+    RkmppMultipartConfig config = {
+        .boundary = "frameboundary",
+        .content_type = NULL
+    };
+
+    RkmppMultipartWriter* writer = rkmpp_multipart_create(&config);
+    if (!writer) {
+        TEST_FAIL("multipart_build_frame");
+        return;
+    }
+
+    const char* content_type = rkmpp_multipart_get_content_type(writer);
+    if (!content_type ||
+        strcmp(content_type, "multipart/x-mixed-replace; boundary=frameboundary") != 0) {
+        TEST_FAIL("multipart_build_frame (content type)");
+        rkmpp_multipart_destroy(writer);
+        return;
+    }
+
+    if (rkmpp_multipart_build_frame(writer, jpeg, sizeof(jpeg), &frame) != RKMPP_OK) {
+        TEST_FAIL("multipart_build_frame");
+        rkmpp_multipart_destroy(writer);
+        return;
+    }
+
+    const char* expected = "--frameboundary\r\nContent-Type: image/jpeg\r\n"
+                           "Content-Length: 6\r\n\r\n";
+
+    /* The JPEG is referenced, not copied */
+    if (frame.iovcnt != 3 ||
+        frame.iov[0].iov_len != strlen(expected) ||
+        memcmp(frame.iov[0].iov_base, expected, strlen(expected)) != 0 ||
+        frame.iov[1].iov_base != (const void*)jpeg ||
+        frame.iov[1].iov_len != sizeof(jpeg) ||
+        frame.size != strlen(expected) + sizeof(jpeg) + 2) {
+        TEST_FAIL("multipart_build_frame (layout)");
+        rkmpp_multipart_destroy(writer);
+        return;
+    }
+
+    rkmpp_multipart_destroy(writer);
+
+    TEST_PASS("multipart_build_frame");
+}
+
+/**
+ * Test 2: One frame pushed to several viewers over socketpairs
+ */
+void test_multipart_send_viewers(void)
+{
+    uint8_t jpeg[2000];
+    RkmppMultipartFrame frame;
+    int viewers[3][2];
+    int ok = 1;
+
+    for (size_t i = 0; i < sizeof(jpeg); i++) {
+        jpeg[i] = (uint8_t)(i * 7);
+    }
+
+    RkmppMultipartWriter* writer = rkmpp_multipart_create(NULL);
+    if (!writer || rkmpp_multipart_build_frame(writer, jpeg, sizeof(jpeg), &frame) != RKMPP_OK) {
+        TEST_FAIL("multipart_send_viewers");
+        rkmpp_multipart_destroy(writer);
+        return;
+    }
+
+    uint8_t* expected = (uint8_t*)malloc(frame.size);
+    uint8_t* received = (uint8_t*)malloc(frame.size);
+    uint32_t pos = 0;
+    for (uint32_t i = 0; i < frame.iovcnt; i++) {
+        memcpy(expected + pos, frame.iov[i].iov_base, frame.iov[i].iov_len);
+        pos += (uint32_t)frame.iov[i].iov_len;
+    }
+
+    for (int v = 0; v < 3; v++) {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, viewers[v]) != 0) {
+            TEST_FAIL("multipart_send_viewers (socketpair)");
+            free(received);
+            free(expected);
+            rkmpp_multipart_destroy(writer);
+            return;
+        }
+    }
+
+    for (int v = 0; v < 3; v++) {
+        uint32_t offset = 0;
+
+        if (rkmpp_multipart_send(&frame, viewers[v][0], &offset) != RKMPP_OK ||
+            offset != frame.size ||
+            read_all(viewers[v][1], received, frame.size) != 0 ||
+            memcmp(received, expected, frame.size) != 0) {
+            ok = 0;
+        }
+
+        close(viewers[v][0]);
+        close(viewers[v][1]);
+    }
+
+    free(received);
+    free(expected);
+    rkmpp_multipart_destroy(writer);
+
+    if (!ok) {
+        TEST_FAIL("multipart_send_viewers");
+        return;
+    }
+
+    TEST_PASS("multipart_send_viewers");
+}
+
+/**
+ * Test 3: Non-blocking viewer resumes a partially sent part
+ */
+void test_multipart_send_partial(void)
+{
+    uint32_t jpeg_len = 512 * 1024;
+    uint8_t* jpeg = (uint8_t*)malloc(jpeg_len);
+    RkmppMultipartFrame frame;
+    int fds[2];
+    int sndbuf = 4096;
+    int would_block = 0;
+
+    RkmppMultipartWriter* writer = rkmpp_multipart_create(NULL);
+    if (!jpeg || !writer || socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        TEST_FAIL("multipart_send_partial");
+        rkmpp_multipart_destroy(writer);
+        free(jpeg);
+        return;
+    }
+
+    memset(jpeg, 0x42, jpeg_len);
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    rkmpp_multipart_build_frame(writer, jpeg, jpeg_len, &frame);
+
+    uint8_t* received = (uint8_t*)malloc(frame.size);
+    uint32_t offset = 0;
+    size_t got = 0;
+    RkmppStatus status = RKMPP_ERR_NOT_READY;
+
+    while (status == RKMPP_ERR_NOT_READY) {
+        status = rkmpp_multipart_send(&frame, fds[0], &offset);
+        if (status == RKMPP_ERR_NOT_READY) {
+            would_block = 1;
+        }
+
+        /* Drain whatever the viewer has received so far */
+        while (got < offset) {
+            ssize_t ret = read(fds[1], received + got, offset - got);
+            if (ret <= 0) {
+                break;
+            }
+            got += (size_t)ret;
+        }
+    }
+
+    int ok = status == RKMPP_OK && would_block && got == frame.size &&
+             received[frame.size - 1] == '\n' &&
+             memcmp(received + frame.iov[0].iov_len, jpeg, jpeg_len) == 0;
+
+    close(fds[0]);
+    close(fds[1]);
+    free(received);
+    rkmpp_multipart_destroy(writer);
+    free(jpeg);
+
+    if (!ok) {
+        TEST_FAIL("multipart_send_partial");
+        return;
+    }
+
+    TEST_PASS("multipart_send_partial");
+}
+
+/**
+ * Test 4: Invalid configuration
+ */
+void test_multipart_invalid(void)
+{
+    RkmppMultipartConfig config = {
+        .boundary = "bad\r\nboundary",
+        .content_type = NULL
+    };
+
+    RkmppMultipartWriter* writer = rkmpp_multipart_create(&config);
+    if (writer) {
+        TEST_FAIL("multipart_invalid (boundary)");
+        rkmpp_multipart_destroy(writer);
+        return;
+    }
+
+    if (rkmpp_multipart_send(NULL, 1, NULL) != RKMPP_ERR_INVALID_PARAM) {
+        TEST_FAIL("multipart_invalid (send)");
+        return;
+    }
+
+    TEST_PASS("multipart_invalid");
+}
+
+/**
+ * Test 5: Boundaries that are not tokens are quoted in the content type
+ * but not in the delimiter lines
+ */
+void test_multipart_quoted_boundary(void)
+{
+    static const uint8_t jpeg[] = { 0xFF, 0xD8, 0xFF, 0xD9 };
+    static const char* const expected_types[] = {
+        "multipart/x-mixed-replace; boundary=\"frame 1\"",
+        "multipart/x-mixed-replace; boundary=\"a/b\"",
+        "multipart/x-mixed-replace; boundary=a.b_c-d"
+    };
+    static const char* const boundaries[] = { "frame 1", "a/b", "a.b_c-d" };
+    RkmppMultipartFrame frame;
+    char expected[64];
+
+    for (int i = 0; i < 3; i++) {
+        RkmppMultipartConfig config = {
+            .boundary = boundaries[i],
+            .content_type = NULL
+        };
+        RkmppMultipartWriter* writer = rkmpp_multipart_create(&config);
+        const char* content_type = writer ? rkmpp_multipart_get_content_type(writer) : NULL;
+        int ok = content_type && strcmp(content_type, expected_types[i]) == 0 &&
+                 rkmpp_multipart_build_frame(writer, jpeg, sizeof(jpeg), &frame) == RKMPP_OK;
+
+        snprintf(expected, sizeof(expected), "--%s\r\n", boundaries[i]);
+        ok = ok && memcmp(frame.iov[0].iov_base, expected, strlen(expected)) == 0;
+        if (writer) rkmpp_multipart_destroy(writer);
+
+        if (!ok) {
+            TEST_FAIL("multipart_quoted_boundary");
+            return;
+        }
+    }
+
+    TEST_PASS("multipart_quoted_boundary");
+}
+
+/**
+ * Run all multipart writer tests
+ */
+int main(int argc, char* argv[])
+{
+    printf("=== RKMPP MJPEG Multipart Writer Test Suite ===\n\n");
+
+    test_multipart_build_frame();
+    test_multipart_send_viewers();
+    test_multipart_send_partial();
+    test_multipart_invalid();
+    test_multipart_quoted_boundary();
+
+    printf("\n=== Tests Complete ===\n");
+
+    return 0;
+}
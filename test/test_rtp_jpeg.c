@@ -0,0 +1,403 @@
+/*
+ * RTP/JPEG Packetizer Test Cases
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rkmpp_mjpeg.h"
+#include "test_util.h"
+
+/* Test utilities */
+#define TEST_PASS(name) printf("✓ PASS: %s\n", name)
+#define TEST_FAIL(name) printf("✗ FAIL: %s\n", name)
+
+#define SCAN_LEN 5000
+
+/**
+ * Build a minimal baseline JPEG: SOI, DQT, SOF0, [DRI], SOS, scan, EOI
+ */
+static uint32_t build_jpeg(uint8_t* out, uint32_t width, uint32_t height,
+                           uint8_t luma_hv, uint8_t qbase, uint16_t restart,
+                           const uint8_t* scan, uint32_t scan_len)
+{
+    uint32_t n = 0;
+
+    out[n++] = 0xFF; out[n++] = 0xD8;
+
+    /* DQT with tables 0 and 1 */
+    out[n++] = 0xFF; out[n++] = 0xDB; out[n++] = 0x00; out[n++] = 2 + 2 * 65;
+    for (int t = 0; t < 2; t++) {
+        out[n++] = (uint8_t)t;
+        for (int i = 0; i < 64; i++) {
+            out[n++] = (uint8_t)(qbase + t * 64 + i);
+        }
+    }
+
+    /* SOF0, three components */
+    out[n++] = 0xFF; out[n++] = 0xC0; out[n++] = 0x00; out[n++] = 17;
+    out[n++] = 8;
+    out[n++] = (uint8_t)(height >> 8); out[n++] = (uint8_t)height;
+    out[n++] = (uint8_t)(width >> 8); out[n++] = (uint8_t)width;
+    out[n++] = 3;
+    out[n++] = 1; out[n++] = luma_hv; out[n++] = 0;
+    out[n++] = 2; out[n++] = 0x11; out[n++] = 1;
+    out[n++] = 3; out[n++] = 0x11; out[n++] = 1;
+
+    if (restart) {
+        out[n++] = 0xFF; out[n++] = 0xDD; out[n++] = 0x00; out[n++] = 4;
+        out[n++] = (uint8_t)(restart >> 8); out[n++] = (uint8_t)restart;
+    }
+
+    /* SOS */
+    out[n++] = 0xFF; out[n++] = 0xDA; out[n++] = 0x00; out[n++] = 12;
+    out[n++] = 3;
+    out[n++] = 1; out[n++] = 0x00;
+    out[n++] = 2; out[n++] = 0x11;
+    out[n++] = 3; out[n++] = 0x11;
+    out[n++] = 0; out[n++] = 63; out[n++] = 0;
+
+    memcpy(&out[n], scan, scan_len);
+    n += scan_len;
+
+    out[n++] = 0xFF; out[n++] = 0xD9;
+
+    return n;
+}
+
+/**
+ * Packetize one frame, checking framing and reassembling the scan
+ *
+ * @return Quantization table length carried in the first packet, -1 on error
+ */
+static int packetize_frame(RkmppRtpPacketizer* p, const uint8_t* jpeg, uint32_t len,
+                           uint32_t mtu, const uint8_t* scan, uint32_t scan_len,
+                           uint8_t expected_type, uint8_t* q_out, uint16_t* seq)
+{
+    uint8_t* reassembled = (uint8_t*)malloc(scan_len);
+    RkmppRtpPacket packet;
+    uint32_t received = 0;
+    int qtable_len = -1;
+    int packets = 0;
+
+    if (!reassembled ||
+        rkmpp_rtp_packetizer_begin_frame(p, jpeg, len, 9000) != RKMPP_OK) {
+        free(reassembled);
+        return -1;
+    }
+
+    while (rkmpp_rtp_packetizer_next_packet(p, &packet) == RKMPP_OK) {
+        const uint8_t* h = (const uint8_t*)packet.iov[0].iov_base;
+        uint32_t offset = ((uint32_t)h[13] << 16) | ((uint32_t)h[14] << 8) | h[15];
+        uint32_t hdr = 20;
+
+        if (packet.size > mtu || packet.iovcnt != 2 || h[0] != 0x80 ||
+            (h[1] & 0x7F) != 26 || h[16] != expected_type || offset != received) {
+            free(reassembled);
+            return -1;
+        }
+
+        if (packets > 0 && (uint16_t)((h[2] << 8) | h[3]) != (uint16_t)(*seq + 1)) {
+            free(reassembled);
+            return -1;
+        }
+        *seq = (uint16_t)((h[2] << 8) | h[3]);
+
+        if (expected_type >= 64) {
+            hdr += 4;
+        }
+        if (offset == 0) {
+            *q_out = h[17];
+            qtable_len = (h[hdr + 2] << 8) | h[hdr + 3];
+            hdr += 4 + (uint32_t)qtable_len;
+        }
+
+        if (packet.iov[0].iov_len != hdr ||
+            received + packet.iov[1].iov_len > scan_len) {
+            free(reassembled);
+            return -1;
+        }
+
+        memcpy(reassembled + received, packet.iov[1].iov_base, packet.iov[1].iov_len);
+        received += (uint32_t)packet.iov[1].iov_len;
+        packets++;
+
+        if (packet.marker != (received == scan_len)) {
+            free(reassembled);
+            return -1;
+        }
+    }
+
+    if (received != scan_len || memcmp(reassembled, scan, scan_len) != 0) {
+        qtable_len = -1;
+    }
+
+    free(reassembled);
+    return qtable_len;
+}
+
+/**
+ * Test 1: Fragmentation and quantization table caching
+ */
+void test_rtp_fragmentation(void)
+{
+    uint8_t* scan = (uint8_t*)malloc(SCAN_LEN);
+    uint8_t* jpeg = (uint8_t*)malloc(SCAN_LEN + 1024);
+    uint16_t seq = 0;
+    uint8_t q1 = 0, q2 = 0, q3 = 0;
+
+    for (int i = 0; i < SCAN_LEN; i++) {
+        scan[i] = (uint8_t)(i % 251);
+    }
+
+    RkmppRtpConfig config = {
+        .mtu = 1000,
+        .payload_type = 0,
+        .ssrc = 0x12345678,
+        .initial_sequence = 65530,
+        .qtable_interval = 0
+    };
+
+    RkmppRtpPacketizer* p = rkmpp_rtp_packetizer_create(&config);
+    if (!p || !scan || !jpeg) {
+        TEST_FAIL("rtp_fragmentation");
+        rkmpp_rtp_packetizer_destroy(p);
+        free(jpeg);
+        free(scan);
+        return;
+    }
+
+    /* First frame sends both tables */
+    uint32_t len = build_jpeg(jpeg, 640, 480, 0x22, 1, 0, scan, SCAN_LEN);
+    if (packetize_frame(p, jpeg, len, 1000, scan, SCAN_LEN, 1, &q1, &seq) != 128 ||
+        q1 < 128) {
+        TEST_FAIL("rtp_fragmentation (first frame)");
+        goto out;
+    }
+
+    /* Same tables: no table data, same Q */
+    if (packetize_frame(p, jpeg, len, 1000, scan, SCAN_LEN, 1, &q2, &seq) != 0 ||
+        q2 != q1) {
+        TEST_FAIL("rtp_fragmentation (cached tables)");
+        goto out;
+    }
+
+    /* Changed tables: new Q and table data */
+    len = build_jpeg(jpeg, 640, 480, 0x22, 2, 0, scan, SCAN_LEN);
+    if (packetize_frame(p, jpeg, len, 1000, scan, SCAN_LEN, 1, &q3, &seq) != 128 ||
+        q3 == q1) {
+        TEST_FAIL("rtp_fragmentation (changed tables)");
+        goto out;
+    }
+
+    TEST_PASS("rtp_fragmentation");
+
+out:
+    rkmpp_rtp_packetizer_destroy(p);
+    free(jpeg);
+    free(scan);
+}
+
+/**
+ * Test 2: 4:2:2 with restart markers
+ */
+void test_rtp_restart_422(void)
+{
+    uint8_t scan[777];
+    uint8_t jpeg[2048];
+    uint16_t seq = 0;
+    uint8_t q = 0;
+
+    memset(scan, 0x5A, sizeof(scan));
+
+    RkmppRtpConfig config = {
+        .mtu = 400,
+        .qtable_interval = 1
+    };
+
+    RkmppRtpPacketizer* p = rkmpp_rtp_packetizer_create(&config);
+    if (!p) {
+        TEST_FAIL("rtp_restart_422");
+        return;
+    }
+
+    uint32_t len = build_jpeg(jpeg, 320, 240, 0x21, 1, 20, scan, sizeof(scan));
+
+    /* qtable_interval = 1 resends the tables on every frame */
+    if (packetize_frame(p, jpeg, len, 400, scan, sizeof(scan), 64, &q, &seq) != 128 ||
+        packetize_frame(p, jpeg, len, 400, scan, sizeof(scan), 64, &q, &seq) != 128) {
+        TEST_FAIL("rtp_restart_422");
+        rkmpp_rtp_packetizer_destroy(p);
+        return;
+    }
+
+    rkmpp_rtp_packetizer_destroy(p);
+
+    TEST_PASS("rtp_restart_422");
+}
+
+/**
+ * Test 3: Unsupported input
+ */
+void test_rtp_invalid(void)
+{
+    uint8_t scan[16];
+    uint8_t jpeg[512];
+    RkmppRtpPacket packet;
+
+    memset(scan, 0, sizeof(scan));
+
+    RkmppRtpPacketizer* p = rkmpp_rtp_packetizer_create(NULL);
+    if (!p) {
+        TEST_FAIL("rtp_invalid");
+        return;
+    }
+
+    /* Not a JPEG */
+    if (rkmpp_rtp_packetizer_begin_frame(p, scan, sizeof(scan), 0) == RKMPP_OK) {
+        TEST_FAIL("rtp_invalid (garbage)");
+        rkmpp_rtp_packetizer_destroy(p);
+        return;
+    }
+
+    /* Wider than RFC 2435 can signal */
+    uint32_t len = build_jpeg(jpeg, 4096, 480, 0x22, 1, 0, scan, sizeof(scan));
+    if (rkmpp_rtp_packetizer_begin_frame(p, jpeg, len, 0) == RKMPP_OK) {
+        TEST_FAIL("rtp_invalid (too wide)");
+        rkmpp_rtp_packetizer_destroy(p);
+        return;
+    }
+
+    /* 4:4:4 has no RFC 2435 type */
+    len = build_jpeg(jpeg, 640, 480, 0x11, 1, 0, scan, sizeof(scan));
+    if (rkmpp_rtp_packetizer_begin_frame(p, jpeg, len, 0) == RKMPP_OK ||
+        rkmpp_rtp_packetizer_next_packet(p, &packet) != RKMPP_ERR_NOT_READY) {
+        TEST_FAIL("rtp_invalid (4:4:4)");
+        rkmpp_rtp_packetizer_destroy(p);
+        return;
+    }
+
+    /* MTU too small for the headers */
+    RkmppRtpConfig config = { .mtu = 100 };
+    RkmppRtpPacketizer* bad = rkmpp_rtp_packetizer_create(&config);
+    if (bad) {
+        TEST_FAIL("rtp_invalid (mtu)");
+        rkmpp_rtp_packetizer_destroy(bad);
+        rkmpp_rtp_packetizer_destroy(p);
+        return;
+    }
+
+    rkmpp_rtp_packetizer_destroy(p);
+
+    TEST_PASS("rtp_invalid");
+}
+
+/**
+ * Locate the scan of a JPEG and its restart interval
+ *
+ * @return Offset of the scan data, 0 if there is no scan
+ */
+static uint32_t find_scan(const uint8_t* jpeg, uint32_t len, uint32_t* scan_len,
+                          uint16_t* restart)
+{
+    uint32_t pos = 2;
+
+    *restart = 0;
+    while (pos + 4 <= len && jpeg[pos] == 0xFF) {
+        uint8_t marker = jpeg[pos + 1];
+        uint32_t seg = (uint32_t)(jpeg[pos + 2] << 8 | jpeg[pos + 3]);
+
+        if (marker == 0xDD) {
+            *restart = (uint16_t)(jpeg[pos + 4] << 8 | jpeg[pos + 5]);
+        }
+        pos += 2 + seg;
+        if (marker == 0xDA) {
+            *scan_len = len - pos - 2;
+            return pos;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Test 4: Encoder output with the Annex K tables is carried as is, and
+ * optimized Huffman tables are refused
+ */
+void test_rtp_encoder_output(void)
+{
+    RkmppEncoderConfig config = {
+        .width = 320,
+        .height = 240,
+        .fps = 30,
+        .quality = 80,
+        .backend = RKMPP_BACKEND_CPU,
+        .input_format = RKMPP_FORMAT_NV12,
+        .huffman_refresh = 1
+    };
+    uint32_t frame_size = rkmpp_get_nv12_size(config.width, config.height);
+    uint8_t* frame = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg = (uint8_t*)malloc(frame_size);
+    RkmppRtpPacketizer* p = rkmpp_rtp_packetizer_create(NULL);
+    RkmppEncoder* encoder = NULL;
+    uint32_t jpeg_len = 0;
+    uint32_t scan = 0;
+    uint32_t scan_len = 0;
+    uint16_t restart = 0;
+    uint16_t seq = 0;
+    uint8_t q = 0;
+    int ok = frame && jpeg && p;
+
+    if (ok) {
+        fill_ramp_frame(frame, config.width, config.height, 1);
+        ok = encode_frame(frame, RKMPP_FORMAT_NV12, config.width, config.height, 80,
+                          jpeg, frame_size, &jpeg_len) == 0;
+    }
+
+    /* The receiver rebuilds the header the encoder wrote */
+    if (ok) {
+        scan = find_scan(jpeg, jpeg_len, &scan_len, &restart);
+        ok = scan > 0 &&
+             packetize_frame(p, jpeg, jpeg_len, 1400, jpeg + scan, scan_len,
+                             restart ? 65 : 1, &q, &seq) == 128;
+    }
+
+    /* Per-image Huffman tables cannot be signalled */
+    if (ok) {
+        encoder = rkmpp_encoder_create(&config);
+        ok = encoder &&
+             rkmpp_encoder_encode(encoder, frame, frame_size, jpeg, frame_size,
+                                  &jpeg_len) == RKMPP_OK &&
+             rkmpp_rtp_packetizer_begin_frame(p, jpeg, jpeg_len, 0) == RKMPP_ERR_INVALID_PARAM;
+    }
+
+    if (encoder) rkmpp_encoder_destroy(encoder);
+    rkmpp_rtp_packetizer_destroy(p);
+    free(jpeg);
+    free(frame);
+
+    if (!ok) {
+        TEST_FAIL("rtp_encoder_output");
+        return;
+    }
+
+    TEST_PASS("rtp_encoder_output");
+}
+
+/**
+ * Run all RTP packetizer tests
+ */
+int main(int argc, char* argv[])
+{
+    printf("=== RKMPP MJPEG RTP Packetizer Test Suite ===\n\n");
+
+    test_rtp_fragmentation();
+    test_rtp_restart_422();
+    test_rtp_invalid();
+    test_rtp_encoder_output();
+
+    printf("\n=== Tests Complete ===\n");
+
+    return 0;
+}
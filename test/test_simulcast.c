@@ -0,0 +1,266 @@
+/*
+ * MJPEG Simulcast Encoder Test Cases
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rkmpp_mjpeg.h"
+#include "test_util.h"
+
+/* Test utilities */
+#define TEST_PASS(name) printf("✓ PASS: %s\n", name)
+#define TEST_FAIL(name) printf("✗ FAIL: %s\n", name)
+
+/**
+ * Halve an NV12 frame with rounded 2x2 averages
+ */
+static void halve_frame(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst)
+{
+    uint32_t out_width = width / 2;
+    uint32_t out_height = height / 2;
+    const uint8_t* src_uv = src + width * height;
+    uint8_t* dst_uv = dst + out_width * out_height;
+
+    for (uint32_t y = 0; y < out_height; y++) {
+        for (uint32_t x = 0; x < out_width; x++) {
+            const uint8_t* p = src + 2 * y * width + 2 * x;
+
+            dst[y * out_width + x] = (uint8_t)((p[0] + p[1] + p[width] + p[width + 1] + 2) >> 2);
+        }
+    }
+
+    for (uint32_t y = 0; y < out_height / 2; y++) {
+        for (uint32_t x = 0; x < out_width; x++) {
+            /* x indexes interleaved bytes: channel x & 1 of pair x / 2 */
+            const uint8_t* p = src_uv + 2 * y * width + 4 * (x / 2) + (x & 1);
+
+            dst_uv[y * out_width + x] =
+                (uint8_t)((p[0] + p[2] + p[width] + p[width + 2] + 2) >> 2);
+        }
+    }
+}
+
+/**
+ * Encode width x height with num_layers layers and compare every layer
+ * with a separate encode of the downscaled frame
+ */
+static int check_layers(uint32_t width, uint32_t height, uint32_t num_layers)
+{
+    RkmppSimulcastConfig config = {
+        .width = width,
+        .height = height,
+        .num_layers = num_layers,
+        .quality = { 90, 80, 70, 0 }
+    };
+    RkmppSimulcastOutput outputs[RKMPP_SIMULCAST_MAX_LAYERS];
+    uint32_t frame_size = rkmpp_get_nv12_size(width, height);
+    uint8_t* frames[RKMPP_SIMULCAST_MAX_LAYERS] = { NULL };
+    uint8_t* expected = (uint8_t*)malloc(frame_size);
+    RkmppSimulcast* simulcast = rkmpp_simulcast_create(&config);
+    int ok = simulcast != NULL && expected != NULL;
+
+    memset(outputs, 0, sizeof(outputs));
+    for (uint32_t k = 0; k < num_layers; k++) {
+        frames[k] = (uint8_t*)malloc(frame_size);
+        outputs[k].data = (uint8_t*)malloc(frame_size);
+        outputs[k].size = frame_size;
+        ok = ok && frames[k] && outputs[k].data;
+    }
+
+    if (ok) {
+        fill_ramp_frame(frames[0], width, height, 1);
+        for (uint32_t k = 1; k < num_layers; k++) {
+            halve_frame(frames[k - 1], width >> (k - 1), height >> (k - 1), frames[k]);
+        }
+
+        ok = rkmpp_simulcast_encode(simulcast, frames[0], frame_size, outputs) == RKMPP_OK;
+    }
+
+    for (uint32_t k = 0; ok && k < num_layers; k++) {
+        uint32_t expected_len = 0;
+
+        ok = outputs[k].width == width >> k && outputs[k].height == height >> k &&
+             encode_frame(frames[k], RKMPP_FORMAT_NV12, width >> k, height >> k,
+                          config.quality[k] ? config.quality[k] : 80,
+                          expected, frame_size, &expected_len) == 0 &&
+             outputs[k].len == expected_len &&
+             memcmp(outputs[k].data, expected, expected_len) == 0;
+        if (!ok) {
+            printf("  layer %u (%ux%u) differs from a separate encode\n",
+                   k, width >> k, height >> k);
+        }
+    }
+
+    for (uint32_t k = 0; k < num_layers; k++) {
+        free(frames[k]);
+        free(outputs[k].data);
+    }
+    free(expected);
+    if (simulcast) {
+        rkmpp_simulcast_destroy(simulcast);
+    }
+
+    return ok ? 0 : -1;
+}
+
+/**
+ * Test 1: Create, destroy and invalid configuration
+ */
+void test_simulcast_create_destroy(void)
+{
+    RkmppSimulcastConfig config = {
+        .width = 640,
+        .height = 360,
+        .num_layers = 3,
+        .quality = { 90, 80, 70 }
+    };
+    RkmppSimulcastConfig bad = config;
+
+    RkmppSimulcast* simulcast = rkmpp_simulcast_create(NULL);
+    if (simulcast) {
+        TEST_FAIL("simulcast_create_destroy (NULL config)");
+        rkmpp_simulcast_destroy(simulcast);
+        return;
+    }
+
+    /* 360 is not a multiple of 16, so the eighth-size layer cannot exist */
+    bad.num_layers = 4;
+    simulcast = rkmpp_simulcast_create(&bad);
+    if (simulcast) {
+        TEST_FAIL("simulcast_create_destroy (resolution)");
+        rkmpp_simulcast_destroy(simulcast);
+        return;
+    }
+
+    /* Smallest layer below one MCU */
+    bad = config;
+    bad.width = 64;
+    bad.height = 48;
+    simulcast = rkmpp_simulcast_create(&bad);
+    if (simulcast) {
+        TEST_FAIL("simulcast_create_destroy (layer size)");
+        rkmpp_simulcast_destroy(simulcast);
+        return;
+    }
+
+    bad = config;
+    bad.num_layers = 0;
+    simulcast = rkmpp_simulcast_create(&bad);
+    if (simulcast) {
+        TEST_FAIL("simulcast_create_destroy (layer count)");
+        rkmpp_simulcast_destroy(simulcast);
+        return;
+    }
+
+    bad = config;
+    bad.quality[1] = 101;
+    simulcast = rkmpp_simulcast_create(&bad);
+    if (simulcast) {
+        TEST_FAIL("simulcast_create_destroy (quality)");
+        rkmpp_simulcast_destroy(simulcast);
+        return;
+    }
+
+    simulcast = rkmpp_simulcast_create(&config);
+    if (!simulcast || rkmpp_simulcast_destroy(simulcast) != RKMPP_OK) {
+        TEST_FAIL("simulcast_create_destroy");
+        return;
+    }
+
+    if (rkmpp_simulcast_destroy(NULL) != RKMPP_ERR_INVALID_PARAM) {
+        TEST_FAIL("simulcast_create_destroy (NULL handle)");
+        return;
+    }
+
+    TEST_PASS("simulcast_create_destroy");
+}
+
+/**
+ * Test 2: Every layer is byte-identical to encoding the 2x2-averaged frame
+ * on its own, including layers whose last MCU row is partial
+ */
+void test_simulcast_layers(void)
+{
+    /* 360 -> 180 -> 90 rows and 240 -> ... -> 30 rows end mid-MCU */
+    if (check_layers(640, 360, 3) != 0 || check_layers(320, 240, 4) != 0 ||
+        check_layers(64, 48, 1) != 0) {
+        TEST_FAIL("simulcast_layers");
+        return;
+    }
+
+    TEST_PASS("simulcast_layers");
+}
+
+/**
+ * Test 3: Invalid parameters and undersized outputs
+ */
+void test_simulcast_errors(void)
+{
+    RkmppSimulcastConfig config = {
+        .width = 320,
+        .height = 240,
+        .num_layers = 2
+    };
+    RkmppSimulcastOutput outputs[2];
+    uint32_t frame_size = rkmpp_get_nv12_size(config.width, config.height);
+    uint8_t* frame = (uint8_t*)malloc(frame_size);
+    uint8_t* full = (uint8_t*)malloc(frame_size);
+    uint8_t small[64];
+    RkmppSimulcast* simulcast = rkmpp_simulcast_create(&config);
+    int ok = simulcast != NULL && frame != NULL && full != NULL;
+
+    if (ok) {
+        fill_ramp_frame(frame, config.width, config.height, 1);
+        memset(outputs, 0, sizeof(outputs));
+        outputs[0].data = full;
+        outputs[0].size = frame_size;
+
+        /* Missing layer buffer, NULL arguments, short frame */
+        ok = rkmpp_simulcast_encode(simulcast, frame, frame_size, outputs) ==
+                 RKMPP_ERR_INVALID_PARAM &&
+             rkmpp_simulcast_encode(NULL, frame, frame_size, outputs) ==
+                 RKMPP_ERR_INVALID_PARAM &&
+             rkmpp_simulcast_encode(simulcast, frame, frame_size, NULL) ==
+                 RKMPP_ERR_INVALID_PARAM;
+
+        outputs[1].data = small;
+        outputs[1].size = sizeof(small);
+        ok = ok && rkmpp_simulcast_encode(simulcast, frame, frame_size - 1, outputs) ==
+                       RKMPP_ERR_INVALID_PARAM;
+
+        /* The full-size layer still completes; the other reports its need */
+        ok = ok && rkmpp_simulcast_encode(simulcast, frame, frame_size, outputs) ==
+                       RKMPP_ERR_ENCODE &&
+             outputs[0].len > 0 && full[0] == 0xFF && full[1] == 0xD8 &&
+             outputs[1].width == 160 && outputs[1].height == 120 &&
+             outputs[1].len > sizeof(small);
+    }
+
+    free(frame);
+    free(full);
+    if (simulcast) {
+        rkmpp_simulcast_destroy(simulcast);
+    }
+
+    if (!ok) {
+        TEST_FAIL("simulcast_errors");
+        return;
+    }
+
+    TEST_PASS("simulcast_errors");
+}
+
+int main(int argc, char* argv[])
+{
+    printf("=== RKMPP MJPEG Simulcast Test Suite ===\n\n");
+
+    test_simulcast_create_destroy();
+    test_simulcast_layers();
+    test_simulcast_errors();
+
+    printf("\n=== Tests Complete ===\n");
+
+    return 0;
+}
@@ -0,0 +1,264 @@
+/*
+ * MJPEG Tiled Encoder Test Cases
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rkmpp_mjpeg.h"
+#include "test_util.h"
+
+/* Test utilities */
+#define TEST_PASS(name) printf("✓ PASS: %s\n", name)
+#define TEST_FAIL(name) printf("✗ FAIL: %s\n", name)
+
+/**
+ * Walk a JPEG: SOF0 size, restart interval and the RST markers of the
+ * scan, which must count up modulo 8 and be followed by EOI
+ *
+ * @return Number of RST markers, -1 if the stream is malformed
+ */
+static int scan_markers(const uint8_t* jpeg, uint32_t len, uint32_t* width,
+                        uint32_t* height, uint32_t* interval)
+{
+    uint32_t pos = 2;
+    int rst = 0;
+
+    *interval = 0;
+    while (pos + 4 <= len && jpeg[pos] == 0xFF && jpeg[pos + 1] != 0xDA) {
+        uint32_t seg = (uint32_t)(jpeg[pos + 2] << 8 | jpeg[pos + 3]);
+
+        if (jpeg[pos + 1] == 0xC0) {
+            *height = (uint32_t)(jpeg[pos + 5] << 8 | jpeg[pos + 6]);
+            *width = (uint32_t)(jpeg[pos + 7] << 8 | jpeg[pos + 8]);
+        } else if (jpeg[pos + 1] == 0xDD) {
+            *interval = (uint32_t)(jpeg[pos + 4] << 8 | jpeg[pos + 5]);
+        }
+        pos += 2 + seg;
+    }
+
+    for (; pos + 1 < len; pos++) {
+        if (jpeg[pos] != 0xFF || jpeg[pos + 1] == 0x00) {
+            continue;
+        }
+        if (jpeg[pos + 1] == 0xD9) {
+            return pos + 2 == len ? rst : -1;
+        }
+        if (jpeg[pos + 1] >= 0xD0 && jpeg[pos + 1] <= 0xD7) {
+            if (jpeg[pos + 1] != 0xD0 + (rst & 7)) {
+                return -1;
+            }
+            rst++;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Encode a frame tiled and whole; both must decode to the same samples
+ */
+static int check_format(uint32_t format, uint32_t width, uint32_t height)
+{
+    RkmppTiledEncoderConfig config = {
+        .width = width,
+        .height = height,
+        .input_format = format,
+        .quality = 85,
+        .tile_width = 256,
+        .tile_height = 128,
+        .num_threads = 3
+    };
+    uint32_t frame_size = rkmpp_get_frame_size(format, width, height);
+    uint32_t nv12_size = rkmpp_get_nv12_size(width, height);
+    uint8_t* frame = (uint8_t*)malloc(frame_size);
+    uint8_t* tiled = (uint8_t*)malloc(frame_size + 65536);
+    uint8_t* whole = (uint8_t*)malloc(frame_size + 65536);
+    uint8_t* tiled_nv12 = (uint8_t*)malloc(nv12_size);
+    uint8_t* whole_nv12 = (uint8_t*)malloc(nv12_size);
+    uint32_t tiled_len = 0;
+    uint32_t whole_len = 0;
+    uint32_t jpeg_width = 0;
+    uint32_t jpeg_height = 0;
+    uint32_t interval = 0;
+    RkmppTiledEncoder* encoder = rkmpp_tiled_encoder_create(&config);
+    int ok = encoder && frame && tiled && whole && tiled_nv12 && whole_nv12;
+
+    if (ok) {
+        fill_noise_frame(frame, frame_size);
+        ok = rkmpp_tiled_encoder_encode(encoder, frame, frame_size, tiled, frame_size + 65536,
+                                        &tiled_len) == RKMPP_OK &&
+             encode_frame(frame, format, width, height, 85, whole, frame_size + 65536,
+                          &whole_len) == 0 &&
+             scan_markers(tiled, tiled_len, &jpeg_width, &jpeg_height, &interval) > 0 &&
+             jpeg_width == width && jpeg_height == height && interval > 0 &&
+             decode_frame(tiled, tiled_len, tiled_nv12, nv12_size, NULL) == 0 &&
+             decode_frame(whole, whole_len, whole_nv12, nv12_size, NULL) == 0 &&
+             memcmp(tiled_nv12, whole_nv12, nv12_size) == 0;
+    }
+
+    if (!ok) {
+        printf("  format %u at %ux%u differs from a whole-frame encode\n", format, width, height);
+    }
+
+    free(frame);
+    free(tiled);
+    free(whole);
+    free(tiled_nv12);
+    free(whole_nv12);
+    if (encoder) {
+        rkmpp_tiled_encoder_destroy(encoder);
+    }
+
+    return ok ? 0 : -1;
+}
+
+/**
+ * Test 1: Create, destroy and invalid configuration
+ */
+void test_tiled_create_destroy(void)
+{
+    RkmppTiledEncoderConfig config = {
+        .width = 8192,
+        .height = 2048,
+        .input_format = RKMPP_FORMAT_NV12,
+        .quality = 80
+    };
+    RkmppTiledEncoderConfig bad = config;
+
+    RkmppTiledEncoder* encoder = rkmpp_tiled_encoder_create(NULL);
+    if (encoder) {
+        TEST_FAIL("tiled_create_destroy (NULL config)");
+        rkmpp_tiled_encoder_destroy(encoder);
+        return;
+    }
+
+    bad.width = 16400;
+    encoder = rkmpp_tiled_encoder_create(&bad);
+    if (encoder) {
+        TEST_FAIL("tiled_create_destroy (resolution)");
+        rkmpp_tiled_encoder_destroy(encoder);
+        return;
+    }
+
+    bad = config;
+    bad.tile_width = 8192;
+    encoder = rkmpp_tiled_encoder_create(&bad);
+    if (encoder) {
+        TEST_FAIL("tiled_create_destroy (tile size)");
+        rkmpp_tiled_encoder_destroy(encoder);
+        return;
+    }
+
+    bad = config;
+    bad.input_format = RKMPP_FORMAT_RGB_F32_PLANAR;
+    encoder = rkmpp_tiled_encoder_create(&bad);
+    if (encoder) {
+        TEST_FAIL("tiled_create_destroy (input format)");
+        rkmpp_tiled_encoder_destroy(encoder);
+        return;
+    }
+
+    encoder = rkmpp_tiled_encoder_create(&config);
+    if (!encoder || rkmpp_tiled_encoder_destroy(encoder) != RKMPP_OK) {
+        TEST_FAIL("tiled_create_destroy");
+        return;
+    }
+
+    if (rkmpp_tiled_encoder_destroy(NULL) != RKMPP_ERR_INVALID_PARAM) {
+        TEST_FAIL("tiled_create_destroy (NULL handle)");
+        return;
+    }
+
+    TEST_PASS("tiled_create_destroy");
+}
+
+/**
+ * Test 2: Stitched tiles decode exactly like a whole-frame encode, with
+ * partial MCUs on the right and bottom edges
+ */
+void test_tiled_matches_whole(void)
+{
+    if (check_format(RKMPP_FORMAT_NV12, 1000, 602) != 0 ||
+        check_format(RKMPP_FORMAT_YUYV, 848, 484) != 0 ||
+        check_format(RKMPP_FORMAT_GRAY, 500, 300) != 0 ||
+        check_format(RKMPP_FORMAT_BGRA8888, 600, 340) != 0) {
+        TEST_FAIL("tiled_matches_whole");
+        return;
+    }
+
+    TEST_PASS("tiled_matches_whole");
+}
+
+/**
+ * Test 3: An 8192x2048 panorama becomes one JPEG with a restart marker at
+ * every tile edge
+ */
+void test_tiled_oversize(void)
+{
+    RkmppTiledEncoderConfig config = {
+        .width = 8192,
+        .height = 2048,
+        .input_format = RKMPP_FORMAT_NV12,
+        .quality = 80,
+        .num_threads = 4
+    };
+    uint32_t frame_size = rkmpp_get_nv12_size(config.width, config.height);
+    uint8_t* frame = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg = (uint8_t*)malloc(frame_size);
+    uint8_t small[1024];
+    uint32_t jpeg_len = 0;
+    uint32_t small_len = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t interval = 0;
+    RkmppTiledEncoder* encoder = rkmpp_tiled_encoder_create(&config);
+    int ok = encoder && frame && jpeg;
+
+    if (ok) {
+        fill_noise_frame(frame, frame_size);
+
+        /* 4096-pixel tiles: two restart intervals per MCU row */
+        ok = rkmpp_tiled_encoder_encode(encoder, frame, frame_size, jpeg, frame_size,
+                                        &jpeg_len) == RKMPP_OK &&
+             scan_markers(jpeg, jpeg_len, &width, &height, &interval) == 2 * 128 - 1 &&
+             width == 8192 && height == 2048 && interval == 256;
+
+        /* Undersized output reports the exact size needed */
+        ok = ok && rkmpp_tiled_encoder_encode(encoder, frame, frame_size, small,
+                                              sizeof(small), &small_len) == RKMPP_ERR_ENCODE &&
+             small_len == jpeg_len;
+
+        ok = ok && rkmpp_tiled_encoder_encode(encoder, frame, frame_size - 1, jpeg,
+                                              frame_size, &jpeg_len) == RKMPP_ERR_INVALID_PARAM &&
+             rkmpp_tiled_encoder_encode(NULL, frame, frame_size, jpeg, frame_size,
+                                        &jpeg_len) == RKMPP_ERR_INVALID_PARAM;
+    }
+
+    free(frame);
+    free(jpeg);
+    if (encoder) {
+        rkmpp_tiled_encoder_destroy(encoder);
+    }
+
+    if (!ok) {
+        TEST_FAIL("tiled_oversize");
+        return;
+    }
+
+    TEST_PASS("tiled_oversize");
+}
+
+int main(int argc, char* argv[])
+{
+    printf("=== RKMPP MJPEG Tiled Encoder Test Suite ===\n\n");
+
+    test_tiled_create_destroy();
+    test_tiled_matches_whole();
+    test_tiled_oversize();
+
+    printf("\n=== Tests Complete ===\n");
+
+    return 0;
+}
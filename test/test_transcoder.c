@@ -0,0 +1,592 @@
+/*
+ * MJPEG Transcoder Test Cases
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rkmpp_mjpeg.h"
+#include "test_util.h"
+
+/* Test utilities */
+#define TEST_PASS(name) printf("✓ PASS: %s\n", name)
+#define TEST_FAIL(name) printf("✗ FAIL: %s\n", name)
+
+/**
+ * Source position of output pixel (x, y) of a transformed width x height
+ * frame (output size)
+ */
+static void transform_point(uint32_t op, uint32_t width, uint32_t height, uint32_t x,
+                            uint32_t y, uint32_t* sx, uint32_t* sy)
+{
+    switch (op) {
+    case RKMPP_TRANSFORM_HFLIP:     *sx = width - 1 - x;  *sy = y;               break;
+    case RKMPP_TRANSFORM_VFLIP:     *sx = x;              *sy = height - 1 - y;  break;
+    case RKMPP_TRANSFORM_TRANSPOSE: *sx = y;              *sy = x;               break;
+    case RKMPP_TRANSFORM_ROT90:     *sx = y;              *sy = width - 1 - x;   break;
+    case RKMPP_TRANSFORM_ROT180:    *sx = width - 1 - x;  *sy = height - 1 - y;  break;
+    case RKMPP_TRANSFORM_ROT270:    *sx = height - 1 - y; *sy = x;               break;
+    default:                        *sx = x;              *sy = y;               break;
+    }
+}
+
+/**
+ * Transcoder scaling a source to width x height
+ */
+static RkmppTranscoder* create_transcoder(uint32_t width, uint32_t height)
+{
+    RkmppTranscoderConfig config = {
+        .max_width = 1920,
+        .max_height = 1080,
+        .output = {
+            .width = width,
+            .height = height,
+            .fps = 30,
+            .bitrate = 0,
+            .quality = 95,
+            .gop = 0
+        }
+    };
+
+    return rkmpp_transcoder_create(&config);
+}
+
+/**
+ * Test 1: Create, destroy and invalid configuration
+ */
+void test_transcoder_create_destroy(void)
+{
+    RkmppTranscoderConfig config = {
+        .max_width = 8,
+        .max_height = 8,
+        .output = {
+            .width = 640,
+            .height = 360,
+            .fps = 30
+        }
+    };
+
+    RkmppTranscoder* transcoder = rkmpp_transcoder_create(NULL);
+    if (transcoder) {
+        TEST_FAIL("transcoder_create_destroy (NULL config)");
+        rkmpp_transcoder_destroy(transcoder);
+        return;
+    }
+
+    /* Source limit too small */
+    transcoder = rkmpp_transcoder_create(&config);
+    if (transcoder) {
+        TEST_FAIL("transcoder_create_destroy (max resolution)");
+        rkmpp_transcoder_destroy(transcoder);
+        return;
+    }
+
+    /* Output rejected by the encoder */
+    config.max_width = 1920;
+    config.max_height = 1080;
+    config.output.fps = 0;
+    transcoder = rkmpp_transcoder_create(&config);
+    if (transcoder) {
+        TEST_FAIL("transcoder_create_destroy (output config)");
+        rkmpp_transcoder_destroy(transcoder);
+        return;
+    }
+
+    transcoder = create_transcoder(640, 360);
+    if (!transcoder || rkmpp_transcoder_destroy(transcoder) != RKMPP_OK) {
+        TEST_FAIL("transcoder_create_destroy");
+        return;
+    }
+
+    if (rkmpp_transcoder_destroy(NULL) != RKMPP_ERR_INVALID_PARAM) {
+        TEST_FAIL("transcoder_create_destroy (NULL handle)");
+        return;
+    }
+
+    TEST_PASS("transcoder_create_destroy");
+}
+
+/**
+ * Test 2: 2:1 downscale matches an averaged full-size decode
+ */
+void test_transcoder_downscale(void)
+{
+    uint32_t width = 320;
+    uint32_t height = 240;
+    uint32_t out_width = width / 2;
+    uint32_t out_height = height / 2;
+    uint32_t frame_size = rkmpp_get_nv12_size(width, height);
+    uint8_t* source = (uint8_t*)malloc(frame_size);
+    uint8_t* full = (uint8_t*)malloc(frame_size);
+    uint8_t* scaled = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg_in = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg_out = (uint8_t*)malloc(frame_size);
+    uint32_t in_len = 0;
+    uint32_t out_len = 0;
+    RkmppFrameInfo frame_info;
+    RkmppTranscodeResult result;
+    RkmppTranscoderStats stats;
+
+    RkmppTranscoder* transcoder = create_transcoder(out_width, out_height);
+    if (!transcoder || !source || !full || !scaled || !jpeg_in || !jpeg_out) {
+        TEST_FAIL("transcoder_downscale");
+        if (transcoder) rkmpp_transcoder_destroy(transcoder);
+        free(source);
+        free(full);
+        free(scaled);
+        free(jpeg_in);
+        free(jpeg_out);
+        return;
+    }
+
+    fill_ramp_frame(source, width, height, 0);
+
+    int ok = encode_frame(source, RKMPP_FORMAT_NV12, width, height, 95,
+                          jpeg_in, frame_size, &in_len) == 0 &&
+             decode_frame(jpeg_in, in_len, full, frame_size, &frame_info) == 0 &&
+             rkmpp_transcoder_transcode(transcoder, jpeg_in, in_len, jpeg_out, frame_size,
+                                        &out_len, &result) == RKMPP_OK &&
+             result.src_width == width && result.src_height == height &&
+             result.quality == 95 &&
+             result.latency_us == result.decode_us + result.encode_us &&
+             decode_frame(jpeg_out, out_len, scaled, frame_size, &frame_info) == 0 &&
+             frame_info.width == out_width && frame_info.height == out_height;
+
+    /* Each output luma sample is the mean of a 2x2 source block */
+    for (uint32_t y = 0; ok && y < out_height; y++) {
+        for (uint32_t x = 0; ok && x < out_width; x++) {
+            const uint8_t* s = full + (2 * y) * width + 2 * x;
+            int mean = (s[0] + s[1] + s[width] + s[width + 1] + 2) / 4;
+
+            ok = abs((int)scaled[y * out_width + x] - mean) <= 4;
+        }
+    }
+
+    /* Chroma is carried over */
+    for (uint32_t y = 0; ok && y < out_height / 2; y++) {
+        for (uint32_t x = 0; ok && x < out_width / 2; x++) {
+            const uint8_t* s = full + width * height + (2 * y) * width + 4 * x;
+            int mean = (s[0] + s[2] + s[width] + s[width + 2] + 2) / 4;
+            uint8_t cb = scaled[out_width * out_height + y * out_width + 2 * x];
+
+            ok = abs((int)cb - mean) <= 4;
+        }
+    }
+
+    ok = ok && rkmpp_transcoder_get_stats(transcoder, &stats) == RKMPP_OK &&
+         stats.frames_transcoded == 1 && stats.bytes_in == in_len &&
+         stats.bytes_out == out_len && stats.latency_avg_us == result.latency_us;
+
+    free(source);
+    free(full);
+    free(scaled);
+    free(jpeg_in);
+    free(jpeg_out);
+    rkmpp_transcoder_destroy(transcoder);
+
+    if (!ok) {
+        TEST_FAIL("transcoder_downscale");
+        return;
+    }
+
+    TEST_PASS("transcoder_downscale");
+}
+
+/**
+ * Test 3: Non-integer ratios, 4:2:2 and grayscale sources
+ */
+void test_transcoder_ratios(void)
+{
+    uint32_t width = 336;
+    uint32_t height = 200;
+    uint32_t frame_size = 400 * 300 * 2;           /* Largest frame involved */
+    uint8_t* source = (uint8_t*)malloc(frame_size);
+    uint8_t* scaled = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg_in = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg_out = (uint8_t*)malloc(frame_size);
+    uint32_t in_len = 0;
+    uint32_t out_len = 0;
+    RkmppFrameInfo frame_info;
+
+    RkmppTranscoder* shrink = create_transcoder(200, 150);
+    RkmppTranscoder* enlarge = create_transcoder(400, 300);
+    if (!shrink || !enlarge || !source || !scaled || !jpeg_in || !jpeg_out) {
+        TEST_FAIL("transcoder_ratios");
+        if (shrink) rkmpp_transcoder_destroy(shrink);
+        if (enlarge) rkmpp_transcoder_destroy(enlarge);
+        free(source);
+        free(scaled);
+        free(jpeg_in);
+        free(jpeg_out);
+        return;
+    }
+
+    /* Flat mid-gray 4:2:2 frame with neutral chroma */
+    memset(source, 128, frame_size);
+    memset(source, 100, width * height);
+
+    int ok = encode_frame(source, RKMPP_FORMAT_NV16, width, height, 95,
+                          jpeg_in, frame_size, &in_len) == 0 &&
+             rkmpp_transcoder_transcode(shrink, jpeg_in, in_len, jpeg_out, frame_size,
+                                        &out_len, NULL) == RKMPP_OK &&
+             decode_frame(jpeg_out, out_len, scaled, frame_size, &frame_info) == 0 &&
+             frame_info.width == 200 && frame_info.height == 150;
+
+    for (uint32_t i = 0; ok && i < 200 * 150 * 3 / 2; i++) {
+        ok = abs((int)scaled[i] - (i < 200 * 150 ? 100 : 128)) <= 2;
+    }
+
+    /* Grayscale source, enlarged: neutral chroma is filled in */
+    ok = ok && encode_frame(source, RKMPP_FORMAT_GRAY, width, height, 95,
+                            jpeg_in, frame_size, &in_len) == 0 &&
+         rkmpp_transcoder_transcode(enlarge, jpeg_in, in_len, jpeg_out, frame_size,
+                                    &out_len, NULL) == RKMPP_OK &&
+         decode_frame(jpeg_out, out_len, scaled, frame_size, &frame_info) == 0 &&
+         frame_info.width == 400 && frame_info.height == 300;
+
+    for (uint32_t i = 0; ok && i < 400 * 300 * 3 / 2; i++) {
+        ok = abs((int)scaled[i] - (i < 400 * 300 ? 100 : 128)) <= 2;
+    }
+
+    free(source);
+    free(scaled);
+    free(jpeg_in);
+    free(jpeg_out);
+    rkmpp_transcoder_destroy(enlarge);
+    rkmpp_transcoder_destroy(shrink);
+
+    if (!ok) {
+        TEST_FAIL("transcoder_ratios");
+        return;
+    }
+
+    TEST_PASS("transcoder_ratios");
+}
+
+/**
+ * Test 4: Oversized, corrupt and unfitting frames
+ */
+void test_transcoder_errors(void)
+{
+    RkmppTranscoderConfig config = {
+        .max_width = 160,
+        .max_height = 120,
+        .output = {
+            .width = 80,
+            .height = 60,
+            .fps = 30,
+            .quality = 90
+        }
+    };
+    uint32_t width = 320;
+    uint32_t height = 240;
+    uint32_t frame_size = rkmpp_get_nv12_size(width, height);
+    uint8_t* source = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg_in = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg_out = (uint8_t*)malloc(frame_size);
+    uint32_t in_len = 0;
+    uint32_t out_len = 0;
+    RkmppTranscoderStats stats;
+
+    RkmppTranscoder* transcoder = rkmpp_transcoder_create(&config);
+    if (!transcoder || !source || !jpeg_in || !jpeg_out) {
+        TEST_FAIL("transcoder_errors");
+        if (transcoder) rkmpp_transcoder_destroy(transcoder);
+        free(source);
+        free(jpeg_in);
+        free(jpeg_out);
+        return;
+    }
+
+    fill_ramp_frame(source, width, height, 0);
+
+    /* Source larger than max_width x max_height */
+    int ok = encode_frame(source, RKMPP_FORMAT_NV12, width, height, 95,
+                          jpeg_in, frame_size, &in_len) == 0 &&
+             rkmpp_transcoder_transcode(transcoder, jpeg_in, in_len, jpeg_out, frame_size,
+                                        &out_len, NULL) == RKMPP_ERR_DECODE;
+
+    /* Not a JPEG */
+    ok = ok && rkmpp_transcoder_transcode(transcoder, source, 64, jpeg_out, frame_size,
+                                          &out_len, NULL) == RKMPP_ERR_DECODE;
+
+    /* Output buffer too small */
+    ok = ok && encode_frame(source, RKMPP_FORMAT_NV12, 160, 120, 95,
+                            jpeg_in, frame_size, &in_len) == 0 &&
+         rkmpp_transcoder_transcode(transcoder, jpeg_in, in_len, jpeg_out, 16,
+                                    &out_len, NULL) == RKMPP_ERR_ENCODE &&
+         rkmpp_transcoder_transcode(NULL, jpeg_in, in_len, jpeg_out, frame_size,
+                                    &out_len, NULL) == RKMPP_ERR_INVALID_PARAM;
+
+    /* Failures are not counted; the transcoder still works */
+    ok = ok && rkmpp_transcoder_get_stats(transcoder, &stats) == RKMPP_OK &&
+         stats.frames_transcoded == 0 &&
+         rkmpp_transcoder_transcode(transcoder, jpeg_in, in_len, jpeg_out, frame_size,
+                                    &out_len, NULL) == RKMPP_OK &&
+         rkmpp_transcoder_get_stats(transcoder, &stats) == RKMPP_OK &&
+         stats.frames_transcoded == 1;
+
+    free(source);
+    free(jpeg_in);
+    free(jpeg_out);
+    rkmpp_transcoder_destroy(transcoder);
+
+    if (!ok) {
+        TEST_FAIL("transcoder_errors");
+        return;
+    }
+
+    TEST_PASS("transcoder_errors");
+}
+
+/**
+ * Test 5: Requantization keeps geometry and content at a smaller size
+ */
+void test_transcoder_requantize(void)
+{
+    RkmppTranscoderConfig config = {
+        .max_width = 1920,
+        .max_height = 1080,
+        .output = {
+            .width = 0,
+            .height = 0,
+            .quality = 0
+        }
+    };
+    uint32_t width = 320;
+    uint32_t height = 240;
+    uint32_t frame_size = width * height * 2;
+    uint8_t* source = (uint8_t*)malloc(frame_size);
+    uint8_t* decoded = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg_in = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg_out = (uint8_t*)malloc(frame_size);
+    uint32_t in_len = 0;
+    uint32_t out_len = 0;
+    RkmppTranscodeResult result;
+    RkmppFrameInfo frame_info;
+
+    RkmppTranscoder* transcoder = rkmpp_transcoder_create(&config);
+    if (!transcoder || !source || !decoded || !jpeg_in || !jpeg_out) {
+        TEST_FAIL("transcoder_requantize");
+        if (transcoder) rkmpp_transcoder_destroy(transcoder);
+        free(source);
+        free(decoded);
+        free(jpeg_in);
+        free(jpeg_out);
+        return;
+    }
+
+    fill_ramp_frame(source, width, height, 0);
+
+    /* 4:2:0 at quality 95 down to 50 */
+    int ok = encode_frame(source, RKMPP_FORMAT_NV12, width, height, 95,
+                          jpeg_in, frame_size, &in_len) == 0 &&
+             rkmpp_transcoder_requantize(transcoder, jpeg_in, in_len, 50, jpeg_out,
+                                         frame_size, &out_len, &result) == RKMPP_OK &&
+             out_len < in_len && result.quality == 50 &&
+             result.src_width == width && result.src_height == height &&
+             decode_frame(jpeg_out, out_len, decoded, frame_size, &frame_info) == 0 &&
+             frame_info.width == width && frame_info.height == height;
+
+    for (uint32_t i = 0; ok && i < width * height * 3 / 2; i++) {
+        ok = abs((int)decoded[i] - (int)source[i]) <= 6;
+    }
+
+    /* 4:2:2 and grayscale sources keep their layout */
+    ok = ok && encode_frame(source, RKMPP_FORMAT_NV16, width, height, 95,
+                            jpeg_in, frame_size, &in_len) == 0 &&
+         rkmpp_transcoder_requantize(transcoder, jpeg_in, in_len, 50, jpeg_out,
+                                     frame_size, &out_len, NULL) == RKMPP_OK &&
+         out_len < in_len &&
+         decode_frame(jpeg_out, out_len, decoded, frame_size, &frame_info) == 0 &&
+         frame_info.width == width && frame_info.height == height;
+
+    ok = ok && encode_frame(source, RKMPP_FORMAT_GRAY, width, height, 95,
+                            jpeg_in, frame_size, &in_len) == 0 &&
+         rkmpp_transcoder_requantize(transcoder, jpeg_in, in_len, 50, jpeg_out,
+                                     frame_size, &out_len, NULL) == RKMPP_OK &&
+         out_len < in_len &&
+         decode_frame(jpeg_out, out_len, decoded, frame_size, &frame_info) == 0 &&
+         frame_info.width == width && frame_info.height == height;
+
+    for (uint32_t i = 0; ok && i < width * height; i++) {
+        ok = abs((int)decoded[i] - (int)source[i]) <= 6;
+    }
+
+    /* No output size to scale to; quality out of range */
+    ok = ok && rkmpp_transcoder_transcode(transcoder, jpeg_in, in_len, jpeg_out, frame_size,
+                                          &out_len, NULL) == RKMPP_ERR_INVALID_PARAM &&
+         rkmpp_transcoder_requantize(transcoder, jpeg_in, in_len, 0, jpeg_out,
+                                     frame_size, &out_len, NULL) == RKMPP_ERR_INVALID_PARAM &&
+         rkmpp_transcoder_requantize(transcoder, jpeg_in, in_len, 50, jpeg_out,
+                                     16, &out_len, NULL) == RKMPP_ERR_ENCODE;
+
+    free(source);
+    free(decoded);
+    free(jpeg_in);
+    free(jpeg_out);
+    rkmpp_transcoder_destroy(transcoder);
+
+    if (!ok) {
+        TEST_FAIL("transcoder_requantize");
+        return;
+    }
+
+    TEST_PASS("transcoder_requantize");
+}
+
+/**
+ * Test 6: Lossless transforms rearrange pixels exactly
+ */
+void test_transcoder_transform(void)
+{
+    RkmppTranscoderConfig config = {
+        .max_width = 1920,
+        .max_height = 1080
+    };
+    uint32_t width = 320;
+    uint32_t height = 240;
+    uint32_t frame_size = width * height * 2;
+    uint8_t* source = (uint8_t*)malloc(frame_size);
+    uint8_t* reference = (uint8_t*)malloc(frame_size);
+    uint8_t* decoded = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg_in = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg_out = (uint8_t*)malloc(frame_size);
+    uint8_t* jpeg_twice = (uint8_t*)malloc(frame_size);
+    uint32_t in_len = 0;
+    uint32_t out_len = 0;
+    uint32_t twice_len = 0;
+    RkmppTranscodeResult result;
+    RkmppFrameInfo frame_info;
+
+    RkmppTranscoder* transcoder = rkmpp_transcoder_create(&config);
+    if (!transcoder || !source || !reference || !decoded || !jpeg_in || !jpeg_out ||
+        !jpeg_twice) {
+        TEST_FAIL("transcoder_transform");
+        if (transcoder) rkmpp_transcoder_destroy(transcoder);
+        free(source);
+        free(reference);
+        free(decoded);
+        free(jpeg_in);
+        free(jpeg_out);
+        free(jpeg_twice);
+        return;
+    }
+
+    /* Content that no flip or rotation maps onto itself */
+    fill_ramp_frame(source, width, height, 0);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            source[y * width + x] = (uint8_t)(source[y * width + x] / 2 + x * x / 1024 +
+                                              ((x / 16 + y / 40) % 3) * 20);
+        }
+    }
+
+    int ok = encode_frame(source, RKMPP_FORMAT_NV12, width, height, 95,
+                          jpeg_in, frame_size, &in_len) == 0 &&
+             decode_frame(jpeg_in, in_len, reference, frame_size, &frame_info) == 0;
+
+    for (uint32_t op = RKMPP_TRANSFORM_HFLIP; ok && op <= RKMPP_TRANSFORM_ROT270; op++) {
+        int swap = op == RKMPP_TRANSFORM_TRANSPOSE || op == RKMPP_TRANSFORM_ROT90 ||
+                   op == RKMPP_TRANSFORM_ROT270;
+        uint32_t out_width = swap ? height : width;
+        uint32_t out_height = swap ? width : height;
+        const uint8_t* ref_uv = reference + width * height;
+        const uint8_t* out_uv = decoded + out_width * out_height;
+
+        ok = rkmpp_transcoder_transform(transcoder, jpeg_in, in_len, op, jpeg_out,
+                                        frame_size, &out_len, &result) == RKMPP_OK &&
+             result.width == out_width && result.height == out_height &&
+             decode_frame(jpeg_out, out_len, decoded, frame_size, &frame_info) == 0 &&
+             frame_info.width == out_width && frame_info.height == out_height;
+
+        /* Same samples up to IDCT rounding */
+        for (uint32_t y = 0; ok && y < out_height; y++) {
+            for (uint32_t x = 0; ok && x < out_width; x++) {
+                uint32_t sx = 0;
+                uint32_t sy = 0;
+
+                transform_point(op, out_width, out_height, x, y, &sx, &sy);
+                ok = abs((int)decoded[y * out_width + x] - (int)reference[sy * width + sx]) <= 1;
+            }
+        }
+
+        for (uint32_t y = 0; ok && y < out_height / 2; y++) {
+            for (uint32_t x = 0; ok && x < out_width / 2; x++) {
+                uint32_t sx = 0;
+                uint32_t sy = 0;
+
+                transform_point(op, out_width / 2, out_height / 2, x, y, &sx, &sy);
+                for (uint32_t c = 0; ok && c < 2; c++) {
+                    ok = abs((int)out_uv[y * out_width + 2 * x + c] -
+                             (int)ref_uv[sy * width + 2 * sx + c]) <= 1;
+                }
+            }
+        }
+    }
+
+    /* Flipping twice restores the coefficients bit for bit */
+    ok = ok && rkmpp_transcoder_transform(transcoder, jpeg_in, in_len, RKMPP_TRANSFORM_NONE,
+                                          jpeg_twice, frame_size, &twice_len,
+                                          NULL) == RKMPP_OK &&
+         rkmpp_transcoder_transform(transcoder, jpeg_in, in_len, RKMPP_TRANSFORM_HFLIP,
+                                    jpeg_out, frame_size, &out_len, NULL) == RKMPP_OK &&
+         rkmpp_transcoder_transform(transcoder, jpeg_out, out_len, RKMPP_TRANSFORM_HFLIP,
+                                    jpeg_in, frame_size, &in_len, NULL) == RKMPP_OK &&
+         in_len == twice_len && memcmp(jpeg_in, jpeg_twice, in_len) == 0;
+
+    /* Partial MCUs moved to the top are trimmed */
+    ok = ok && encode_frame(source, RKMPP_FORMAT_NV12, 328, 200, 95,
+                            jpeg_in, frame_size, &in_len) == 0 &&
+         rkmpp_transcoder_transform(transcoder, jpeg_in, in_len, RKMPP_TRANSFORM_ROT90,
+                                    jpeg_out, frame_size, &out_len, &result) == RKMPP_OK &&
+         result.width == 192 && result.height == 328 &&
+         decode_frame(jpeg_out, out_len, decoded, frame_size, &frame_info) == 0 &&
+         frame_info.width == 192 && frame_info.height == 328;
+
+    /* 4:2:2 flips but cannot be transposed; unknown transform */
+    ok = ok && encode_frame(source, RKMPP_FORMAT_NV16, width, height, 95,
+                            jpeg_in, frame_size, &in_len) == 0 &&
+         rkmpp_transcoder_transform(transcoder, jpeg_in, in_len, RKMPP_TRANSFORM_ROT180,
+                                    jpeg_out, frame_size, &out_len, NULL) == RKMPP_OK &&
+         rkmpp_transcoder_transform(transcoder, jpeg_in, in_len, RKMPP_TRANSFORM_ROT90,
+                                    jpeg_out, frame_size, &out_len, NULL) == RKMPP_ERR_DECODE &&
+         rkmpp_transcoder_transform(transcoder, jpeg_in, in_len, 7,
+                                    jpeg_out, frame_size, &out_len,
+                                    NULL) == RKMPP_ERR_INVALID_PARAM;
+
+    free(source);
+    free(reference);
+    free(decoded);
+    free(jpeg_in);
+    free(jpeg_out);
+    free(jpeg_twice);
+    rkmpp_transcoder_destroy(transcoder);
+
+    if (!ok) {
+        TEST_FAIL("transcoder_transform");
+        return;
+    }
+
+    TEST_PASS("transcoder_transform");
+}
+
+/**
+ * Run all transcoder tests
+ */
+int main(int argc, char* argv[])
+{
+    printf("=== RKMPP MJPEG Transcoder Test Suite ===\n\n");
+
+    test_transcoder_create_destroy();
+    test_transcoder_downscale();
+    test_transcoder_ratios();
+    test_transcoder_errors();
+    test_transcoder_requantize();
+    test_transcoder_transform();
+
+    printf("\n=== Tests Complete ===\n");
+
+    return 0;
+}
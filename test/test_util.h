@@ -0,0 +1,122 @@
+/*
+ * Shared Test Helpers
+ *
+ * Frame content and one-shot CPU backend encodes and decodes used by
+ * several test programs. Each test is a single translation unit, so the
+ * helpers are defined here.
+ */
+
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <stdint.h>
+
+#include "rkmpp_mjpeg.h"
+
+/**
+ * Smooth NV12 content: luma ramps, chroma ramps
+ *
+ * With texture set, a checker pattern and small chroma ripples are added
+ * so that downscaling has detail to average.
+ */
+static inline void fill_ramp_frame(uint8_t* nv12, uint32_t width, uint32_t height, int texture)
+{
+    uint8_t* uv = nv12 + width * height;
+
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t checker = texture && (((x / 3) ^ (y / 5)) & 1) ? 24 : 0;
+
+            nv12[y * width + x] = (uint8_t)(64 + (x * 128) / width + (y * 48) / height +
+                                            checker);
+        }
+    }
+
+    for (uint32_t y = 0; y < height / 2; y++) {
+        for (uint32_t x = 0; x < width / 2; x++) {
+            uv[y * width + 2 * x] = (uint8_t)(96 + (x * 64) / width + (texture ? y & 7 : 0));
+            uv[y * width + 2 * x + 1] = (uint8_t)(160 - (y * 64) / height +
+                                                  (texture ? x & 3 : 0));
+        }
+    }
+}
+
+/**
+ * Textured content in any input format: a slow ramp with pseudo-random
+ * noise on every byte
+ */
+static inline void fill_noise_frame(uint8_t* data, uint32_t size)
+{
+    uint32_t seed = 12345;
+
+    for (uint32_t i = 0; i < size; i++) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (uint8_t)((i / 7 % 200) + ((seed >> 16) & 31));
+    }
+}
+
+/**
+ * Encode a frame with a fresh CPU backend encoder
+ *
+ * @return 0 on success, -1 on failure
+ */
+static inline int encode_frame(const uint8_t* data, uint32_t format, uint32_t width,
+                               uint32_t height, uint32_t quality, uint8_t* jpeg,
+                               uint32_t jpeg_size, uint32_t* jpeg_len)
+{
+    RkmppEncoderConfig config = {
+        .width = width,
+        .height = height,
+        .fps = 30,
+        .bitrate = 0,
+        .quality = quality,
+        .gop = 0,
+        .backend = RKMPP_BACKEND_CPU,
+        .input_format = format
+    };
+    RkmppEncoder* encoder = rkmpp_encoder_create(&config);
+    RkmppStatus status = RKMPP_ERR_INIT;
+
+    if (!encoder) {
+        return -1;
+    }
+
+    status = rkmpp_encoder_encode(encoder, data, rkmpp_get_frame_size(format, width, height),
+                                  jpeg, jpeg_size, jpeg_len);
+    rkmpp_encoder_destroy(encoder);
+
+    return status == RKMPP_OK ? 0 : -1;
+}
+
+/**
+ * Decode a JPEG to NV12 with a fresh CPU backend decoder
+ *
+ * @param frame_info Output: frame information (may be NULL)
+ * @return 0 on success, -1 on failure
+ */
+static inline int decode_frame(const uint8_t* jpeg, uint32_t jpeg_len, uint8_t* nv12,
+                               uint32_t nv12_size, RkmppFrameInfo* frame_info)
+{
+    RkmppDecoderConfig config = {
+        .max_width = 4096,
+        .max_height = 4096,
+        .output_format = RKMPP_FORMAT_NV12,
+        .backend = RKMPP_BACKEND_CPU
+    };
+    RkmppFrameInfo info;
+    RkmppDecoder* decoder = rkmpp_decoder_create(&config);
+    RkmppStatus status = RKMPP_ERR_INIT;
+    uint32_t nv12_len = 0;
+
+    if (!decoder) {
+        return -1;
+    }
+
+    status = rkmpp_decoder_decode(decoder, jpeg, jpeg_len, nv12, nv12_size, &nv12_len,
+                                  frame_info ? frame_info : &info);
+    rkmpp_decoder_destroy(decoder);
+
+    return status == RKMPP_OK ? 0 : -1;
+}
+
+#endif /* TEST_UTIL_H */